@@ -0,0 +1,908 @@
+#include "bignum.h"
+#include "number.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* magnitudes are little-endian arrays of 32-bit limbs, so that the product
+ * of two limbs plus two carries fits in a 64-bit double limb
+ * fixnums are longs of 64 bits, i.e. at most 2 limbs */
+typedef uint32_t limb;
+typedef uint64_t dlimb;
+
+typedef struct scm_bignum_st {
+    scm_object base;
+    int neg;
+    long len;   /* without leading zero limbs */
+    limb d[];
+} scm_bignum;
+
+/* operands of either representation, the magnitude of a fixnum is kept in
+ * the inline buffer */
+typedef struct big_view_st {
+    const limb *d;
+    long len;
+    int neg;
+    limb buf[2];
+} big_view;
+
+static void view(scm_object *obj, big_view *v) {
+    long x;
+    unsigned long m;
+
+    if (obj->type == scm_type_bignum) {
+        scm_bignum *b = (scm_bignum *)obj;
+        v->d = b->d;
+        v->len = b->len;
+        v->neg = b->neg;
+        return;
+    }
+    x = scm_integer_get_val(obj);
+    m = x < 0 ? 0UL - (unsigned long)x : (unsigned long)x;
+    v->neg = x < 0;
+    v->buf[0] = (limb)m;
+    v->buf[1] = (limb)(m >> 32);
+    v->d = v->buf;
+    v->len = v->buf[1] ? 2 : v->buf[0] ? 1 : 0;
+}
+
+static long trim(const limb *d, long n) {
+    while (n > 0 && d[n - 1] == 0)
+        --n;
+    return n;
+}
+
+static int clz32(limb x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+    while (!(x & 0x80000000u)) {
+        x <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+static int ctzl(unsigned long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzl(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+static scm_bignum *big_alloc(long n) {
+    scm_bignum *b = malloc(sizeof(scm_bignum) + (n ? n : 1) * sizeof(limb));
+    b->base.type = scm_type_bignum;
+    b->neg = 0;
+    b->len = n;
+    return b;
+}
+
+/* the result computed into @b, a fixnum when it fits */
+static scm_object *big_finish(scm_bignum *b, long n, int neg) {
+    unsigned long m;
+
+    n = trim(b->d, n);
+    if (n <= 2) {
+        m = n == 0 ? 0 : n == 1 ? b->d[0] : (unsigned long)b->d[1] << 32 | b->d[0];
+        /* LONG_MIN has no positive counterpart */
+        if (m <= (unsigned long)LONG_MAX + (neg ? 1 : 0)) {
+            free(b);
+            return INTEGER(neg ? (long)(0UL - m) : (long)m);
+        }
+    }
+    b->len = n;
+    b->neg = neg;
+    return (scm_object *)b;
+}
+
+/* magnitude arithmetic */
+static int mag_cmp(const limb *a, long an, const limb *b, long bn) {
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    while (an-- > 0) {
+        if (a[an] != b[an])
+            return a[an] < b[an] ? -1 : 1;
+    }
+    return 0;
+}
+
+/* r = a + b for an >= bn, r has room for an + 1 limbs */
+static void mag_add(limb *r, const limb *a, long an, const limb *b, long bn) {
+    dlimb c = 0;
+    long i;
+
+    for (i = 0; i < bn; ++i) {
+        c += (dlimb)a[i] + b[i];
+        r[i] = (limb)c;
+        c >>= 32;
+    }
+    for (; i < an; ++i) {
+        c += a[i];
+        r[i] = (limb)c;
+        c >>= 32;
+    }
+    r[i] = (limb)c;
+}
+
+/* r = a - b for a >= b, r may be a */
+static void mag_sub(limb *r, const limb *a, long an, const limb *b, long bn) {
+    dlimb t, borrow = 0;
+    long i;
+
+    for (i = 0; i < bn; ++i) {
+        t = (dlimb)a[i] - b[i] - borrow;
+        r[i] = (limb)t;
+        borrow = (t >> 32) & 1;
+    }
+    for (; i < an; ++i) {
+        t = (dlimb)a[i] - borrow;
+        r[i] = (limb)t;
+        borrow = (t >> 32) & 1;
+    }
+}
+
+/* r += t, where the sum fits in the rn limbs of r */
+static void mag_add_to(limb *r, long rn, const limb *t, long tn) {
+    dlimb c = 0;
+    long i;
+
+    for (i = 0; i < tn; ++i) {
+        c += (dlimb)r[i] + t[i];
+        r[i] = (limb)c;
+        c >>= 32;
+    }
+    for (; c && i < rn; ++i) {
+        c += r[i];
+        r[i] = (limb)c;
+        c >>= 32;
+    }
+}
+
+/* r = r * m + a, returns the new length, r has room for one more limb */
+static long mag_mul_1_add(limb *r, long n, limb m, limb a) {
+    dlimb c = a;
+    long i;
+
+    for (i = 0; i < n; ++i) {
+        c += (dlimb)r[i] * m;
+        r[i] = (limb)c;
+        c >>= 32;
+    }
+    if (c)
+        r[n++] = (limb)c;
+    return n;
+}
+
+/* q = a / y, returns the remainder, q may be a */
+static limb mag_divmod_1(limb *q, const limb *a, long an, limb y) {
+    dlimb r = 0;
+    long i;
+
+    for (i = an - 1; i >= 0; --i) {
+        r = r << 32 | a[i];
+        q[i] = (limb)(r / y);
+        r %= y;
+    }
+    return (limb)r;
+}
+
+/* multiplication
+ * schoolbook below the threshold, Karatsuba above, where the three half-size
+ * products a0*b0, a1*b1 and (a0+a1)*(b0+b1) replace four; operands of very
+ * different sizes are cut into slices of the shorter one */
+#define KARATSUBA_THRESHOLD 40
+
+static void mag_mul(limb *r, const limb *a, long an, const limb *b, long bn);
+
+static void mag_mul_basecase(limb *r, const limb *a, long an, const limb *b, long bn) {
+    dlimb c;
+    long i, j;
+
+    memset(r, 0, (an + bn) * sizeof(limb));
+    for (j = 0; j < bn; ++j) {
+        if (b[j] == 0)
+            continue;
+        c = 0;
+        for (i = 0; i < an; ++i) {
+            c += (dlimb)a[i] * b[j] + r[i + j];
+            r[i + j] = (limb)c;
+            c >>= 32;
+        }
+        r[j + an] = (limb)c;
+    }
+}
+
+/* for an >= bn > an / 2 */
+static void mag_mul_karatsuba(limb *r, const limb *a, long an, const limb *b, long bn) {
+    long m = an / 2, a0n, b0n, a1n = an - m, b1n = bn - m;
+    long san, sbn, z0n, z2n, z1n;
+    limb *sa, *sb, *z1;
+
+    a0n = trim(a, m);
+    b0n = trim(b, m);
+
+    /* z0 = a0 * b0 in the low 2m limbs, z2 = a1 * b1 above */
+    mag_mul(r, a, a0n, b, b0n);
+    memset(r + a0n + b0n, 0, (2 * m - a0n - b0n) * sizeof(limb));
+    mag_mul(r + 2 * m, a + m, a1n, b + m, b1n);
+
+    /* z1 = (a0 + a1) * (b0 + b1) - z0 - z2 */
+    sa = malloc((a1n + 1 + (b1n > m ? b1n : m) + 1) * sizeof(limb));
+    sb = sa + a1n + 1;
+    mag_add(sa, a + m, a1n, a, a0n);
+    san = trim(sa, a1n + 1);
+    if (b1n >= b0n) {
+        mag_add(sb, b + m, b1n, b, b0n);
+        sbn = trim(sb, b1n + 1);
+    }
+    else {
+        mag_add(sb, b, b0n, b + m, b1n);
+        sbn = trim(sb, b0n + 1);
+    }
+    z1n = san + sbn;
+    z1 = malloc(z1n * sizeof(limb));
+    mag_mul(z1, sa, san, sb, sbn);
+
+    z0n = trim(r, 2 * m);
+    z2n = trim(r + 2 * m, an + bn - 2 * m);
+    mag_sub(z1, z1, z1n, r, z0n);
+    mag_sub(z1, z1, z1n, r + 2 * m, z2n);
+    z1n = trim(z1, z1n);
+    mag_add_to(r + m, an + bn - m, z1, z1n);
+
+    free(z1);
+    free(sa);
+}
+
+/* r = a * b, r has an + bn limbs and overlaps neither */
+static void mag_mul(limb *r, const limb *a, long an, const limb *b, long bn) {
+    const limb *t;
+    limb *p;
+    long i, k, kn;
+
+    if (an < bn) {
+        t = a, a = b, b = t;
+        k = an, an = bn, bn = k;
+    }
+    if (bn == 0) {
+        memset(r, 0, an * sizeof(limb));
+        return;
+    }
+    if (bn < KARATSUBA_THRESHOLD) {
+        mag_mul_basecase(r, a, an, b, bn);
+        return;
+    }
+    if (an < 2 * bn) {
+        mag_mul_karatsuba(r, a, an, b, bn);
+        return;
+    }
+
+    memset(r, 0, (an + bn) * sizeof(limb));
+    p = malloc(2 * bn * sizeof(limb));
+    for (i = 0; i < an; i += bn) {
+        k = an - i < bn ? an - i : bn;
+        kn = trim(a + i, k);
+        mag_mul(p, a + i, kn, b, bn);
+        mag_add_to(r + i, an + bn - i, p, kn + bn);
+    }
+    free(p);
+}
+
+/* division, Knuth's algorithm D
+ * q = u / v and r = u % v for m >= n >= 2 and v[n - 1] != 0, q has
+ * m - n + 1 limbs and r has n, either may be NULL */
+static void mag_divmod(limb *q, limb *r, const limb *u, long m, const limb *v, long n) {
+    int s = clz32(v[n - 1]);
+    limb *vn = malloc((n + m + 1) * sizeof(limb)), *un = vn + n;
+    dlimb num, qhat, rhat, p;
+    int64_t t, k;
+    long i, j;
+
+    /* normalize so that the top limb of the divisor has its high bit set */
+    for (i = n - 1; i > 0; --i)
+        vn[i] = v[i] << s | (s ? v[i - 1] >> (32 - s) : 0);
+    vn[0] = v[0] << s;
+    un[m] = s ? u[m - 1] >> (32 - s) : 0;
+    for (i = m - 1; i > 0; --i)
+        un[i] = u[i] << s | (s ? u[i - 1] >> (32 - s) : 0);
+    un[0] = u[0] << s;
+
+    for (j = m - n; j >= 0; --j) {
+        /* estimate the quotient limb, off by at most 2 */
+        num = (dlimb)un[j + n] << 32 | un[j + n - 1];
+        qhat = num / vn[n - 1];
+        rhat = num % vn[n - 1];
+        while (qhat >> 32 || qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >> 32)
+                break;
+        }
+
+        /* multiply and subtract */
+        k = 0;
+        for (i = 0; i < n; ++i) {
+            p = qhat * vn[i];
+            t = (int64_t)un[i + j] - k - (int64_t)(p & 0xffffffff);
+            un[i + j] = (limb)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)un[j + n] - k;
+        un[j + n] = (limb)t;
+
+        /* subtracted too much, add back */
+        if (t < 0) {
+            --qhat;
+            k = 0;
+            for (i = 0; i < n; ++i) {
+                t = (int64_t)un[i + j] + vn[i] + k;
+                un[i + j] = (limb)t;
+                k = t >> 32;
+            }
+            un[j + n] += (limb)k;
+        }
+        if (q)
+            q[j] = (limb)qhat;
+    }
+
+    if (r) {
+        for (i = 0; i < n - 1; ++i)
+            r[i] = un[i] >> s | (s ? un[i + 1] << (32 - s) : 0);
+        r[n - 1] = un[n - 1] >> s;
+    }
+    free(vn);
+}
+
+/* decimal conversion
+ * divide and conquer on the powers 10^(9*2^k): a number is split by the
+ * power of about half its size, so that the conversion costs a few
+ * multiplications or divisions of balanced sizes instead of a quadratic
+ * number of single limb steps */
+#define DEC_CHUNK 1000000000u
+#define DEC_CHUNK_DIGITS 9
+#define DEC_BASECASE 40     /* limbs */
+#define DEC_LEVELS 48
+
+typedef struct pow10_table_st {
+    limb *d[DEC_LEVELS];
+    long n[DEC_LEVELS];
+    int count;
+} pow10_table;
+
+/* make the levels up to 10^(9*2^k) */
+static void pow10_table_extend(pow10_table *p, int k) {
+    long n;
+
+    if (p->count == 0) {
+        p->d[0] = malloc(sizeof(limb));
+        p->d[0][0] = DEC_CHUNK;
+        p->n[0] = 1;
+        p->count = 1;
+    }
+    for (; p->count <= k; ++p->count) {
+        n = p->n[p->count - 1];
+        p->d[p->count] = malloc(2 * n * sizeof(limb));
+        mag_mul(p->d[p->count], p->d[p->count - 1], n, p->d[p->count - 1], n);
+        p->n[p->count] = trim(p->d[p->count], 2 * n);
+    }
+}
+
+static void pow10_table_free(pow10_table *p) {
+    int i;
+    for (i = 0; i < p->count; ++i)
+        free(p->d[i]);
+}
+
+/* x into chunks of 9 digits by repeated division, x is destroyed
+ * with @width the digits are left padded with zeros to that many */
+static char *dec_basecase(char *out, limb *x, long n, long width) {
+    limb *chunks = malloc((2 * n + 1) * sizeof(limb));
+    long c = 0, digits = 0, i;
+    limb top;
+
+    n = trim(x, n);
+    while (n > 0) {
+        chunks[c++] = mag_divmod_1(x, x, n, DEC_CHUNK);
+        n = trim(x, n);
+    }
+    if (c > 0) {
+        digits = DEC_CHUNK_DIGITS * (c - 1);
+        for (top = chunks[c - 1]; top; top /= 10)
+            ++digits;
+    }
+    for (; width > digits; --width)
+        *out++ = '0';
+
+    if (c > 0)
+        out += sprintf(out, "%u", (unsigned)chunks[c - 1]);
+    for (i = c - 2; i >= 0; --i) {
+        for (top = chunks[i], digits = DEC_CHUNK_DIGITS - 1; digits >= 0; --digits, top /= 10)
+            out[digits] = '0' + top % 10;
+        out += DEC_CHUNK_DIGITS;
+    }
+    free(chunks);
+    return out;
+}
+
+static char *dec_rec(char *out, limb *x, long n, long width, pow10_table *p, int k) {
+    limb *q, *r;
+    long pn, span;
+
+    n = trim(x, n);
+    /* the divisor about half the size of x */
+    while (k >= 0 && 2 * p->n[k] > n + 1)
+        --k;
+    if (k < 0 || n <= DEC_BASECASE || p->n[k] < 2)
+        return dec_basecase(out, x, n, width);
+
+    pn = p->n[k];
+    span = (long)DEC_CHUNK_DIGITS << k;
+    q = malloc((n - pn + 1 + pn) * sizeof(limb));
+    r = q + n - pn + 1;
+    mag_divmod(q, r, x, n, p->d[k], pn);
+    out = dec_rec(out, q, n - pn + 1, width ? width - span : 0, p, k);
+    out = dec_rec(out, r, pn, span, p, k);
+    free(q);
+    return out;
+}
+
+static limb *dec_parse(const char *s, long len, long *rn, pow10_table *p) {
+    limb *r, *hi, *lo;
+    long n = 0, hn, ln, span, i, c;
+    int k;
+    limb chunk;
+
+    if (len <= DEC_CHUNK_DIGITS * DEC_BASECASE) {
+        r = malloc((len / DEC_CHUNK_DIGITS + 2) * sizeof(limb));
+        for (i = 0; i < len; i += c) {
+            c = i == 0 && len % DEC_CHUNK_DIGITS ? len % DEC_CHUNK_DIGITS : DEC_CHUNK_DIGITS;
+            chunk = 0;
+            for (k = 0; k < c; ++k)
+                chunk = chunk * 10 + (s[i + k] - '0');
+            n = mag_mul_1_add(r, n, DEC_CHUNK, chunk);
+        }
+        *rn = trim(r, n);
+        return r;
+    }
+
+    for (k = 0; ((long)DEC_CHUNK_DIGITS << (k + 1)) < len; ++k)
+        ;
+    span = (long)DEC_CHUNK_DIGITS << k;
+    pow10_table_extend(p, k);
+
+    /* s = hi * 10^span + lo */
+    hi = dec_parse(s, len - span, &hn, p);
+    lo = dec_parse(s + len - span, span, &ln, p);
+    r = malloc((hn + p->n[k] + 1) * sizeof(limb));
+    mag_mul(r, hi, hn, p->d[k], p->n[k]);
+    n = hn + p->n[k];
+    r[n] = 0;
+    mag_add_to(r, n + 1, lo, ln);
+    free(hi);
+    free(lo);
+    *rn = trim(r, n + 1);
+    return r;
+}
+
+/* other radices */
+static int digit_value(int c) {
+    if (c <= '9')
+        return c - '0';
+    return (c | 0x20) - 'a' + 10;
+}
+
+static limb *radix_parse(const char *s, long len, int radix, long *rn) {
+    limb *r = malloc((len / 2 + 2) * sizeof(limb));
+    limb chunk, m;
+    long n = 0, i;
+    int c;
+
+    /* as many digits at a time as fit a limb */
+    for (i = 0; i < len; i += c) {
+        chunk = 0;
+        m = 1;
+        for (c = 0; i + c < len && m <= UINT32_MAX / radix; ++c) {
+            chunk = chunk * radix + digit_value(s[i + c]);
+            m *= radix;
+        }
+        n = mag_mul_1_add(r, n, m, chunk);
+    }
+    *rn = n;
+    return r;
+}
+
+static const char chars[] = "0123456789abcdef";
+
+/* radix 2, 8, 16: the digits are read directly off the bits */
+static char *pow2_to_string(char *out, const limb *d, long n, int radix) {
+    int bits = radix == 2 ? 1 : radix == 8 ? 3 : 4;
+    long total = n * 32 - clz32(d[n - 1]), ndigits = (total + bits - 1) / bits, i, pos, w;
+    int s;
+    dlimb v;
+
+    for (i = ndigits - 1; i >= 0; --i) {
+        pos = i * bits;
+        w = pos / 32;
+        s = pos % 32;
+        v = d[w] >> s;
+        if (s + bits > 32 && w + 1 < n)
+            v |= (dlimb)d[w + 1] << (32 - s);
+        *out++ = chars[v & ((1u << bits) - 1)];
+    }
+    return out;
+}
+
+scm_object *scm_bignum_from_string(const char *s, long len, int radix) {
+    scm_bignum *b;
+    pow10_table p;
+    limb *d;
+    long n;
+    int neg = 0;
+
+    if (len > 0 && (*s == '+' || *s == '-')) {
+        neg = *s == '-';
+        ++s;
+        --len;
+    }
+    while (len > 1 && *s == '0') {
+        ++s;
+        --len;
+    }
+
+    if (radix == 10) {
+        p.count = 0;
+        d = dec_parse(s, len, &n, &p);
+        pow10_table_free(&p);
+    }
+    else {
+        d = radix_parse(s, len, radix, &n);
+    }
+
+    b = big_alloc(n);
+    memcpy(b->d, d, n * sizeof(limb));
+    free(d);
+    return big_finish(b, n, neg);
+}
+
+scm_object *scm_bignum_from_double(double d) {
+    scm_bignum *b;
+    uint64_t mant;
+    long shift, n, pos;
+    int e, i;
+
+    if (d >= -0x1p63 && d < 0x1p63)
+        return INTEGER((long)d);
+
+    /* |d| = mant * 2^shift with a 64-bit mant */
+    mant = (uint64_t)ldexp(frexp(fabs(d), &e), 64);
+    shift = e - 64;
+    n = (shift + 64 + 31) / 32;
+    b = big_alloc(n);
+    memset(b->d, 0, n * sizeof(limb));
+    for (i = 0; i < 64; ++i) {
+        if (mant >> i & 1) {
+            pos = shift + i;
+            b->d[pos / 32] |= (limb)1 << (pos % 32);
+        }
+    }
+    return big_finish(b, n, d < 0);
+}
+
+double scm_bignum_to_double(scm_object *obj) {
+    scm_bignum *b;
+    long bits, shift, w, i;
+    uint64_t top;
+    int s, sticky = 0;
+    dlimb lo, mid, hi;
+
+    if (obj->type != scm_type_bignum)
+        return (double)scm_integer_get_val(obj);
+
+    b = (scm_bignum *)obj;
+    bits = b->len * 32 - clz32(b->d[b->len - 1]);
+    if (bits > 1100)
+        return b->neg ? -HUGE_VAL : HUGE_VAL;
+
+    /* the top 64 bits, with the lowest one standing for all the bits below,
+     * so that the conversion of those rounds correctly */
+    shift = bits - 64;
+    w = shift / 32;
+    s = shift % 32;
+    lo = b->d[w];
+    mid = w + 1 < b->len ? b->d[w + 1] : 0;
+    hi = w + 2 < b->len ? b->d[w + 2] : 0;
+    top = lo >> s | mid << (32 - s) | (s ? hi << (64 - s) : 0);
+    for (i = 0; i < w && !sticky; ++i)
+        sticky = b->d[i] != 0;
+    if (s && (b->d[w] & (((limb)1 << s) - 1)))
+        sticky = 1;
+    if (sticky)
+        top |= 1;
+
+    return ldexp(b->neg ? -(double)top : (double)top, (int)shift);
+}
+
+char *scm_bignum_to_string(scm_object *obj, int radix) {
+    scm_bignum *b;
+    pow10_table p;
+    limb *x;
+    char *buf, *end;
+    int k;
+
+    if (obj->type != scm_type_bignum)
+        return scm_number_to_string(obj, radix);
+
+    b = (scm_bignum *)obj;
+    /* 32 * log10(2) < 9.64 digits per limb */
+    buf = malloc(b->len * 32 + 3);
+    end = buf;
+    if (b->neg)
+        *end++ = '-';
+
+    if (radix == 10) {
+        for (k = 0; 2 * ((long)1 << k) <= b->len + 1 && k < DEC_LEVELS - 1; ++k)
+            ;
+        p.count = 0;
+        pow10_table_extend(&p, k);
+        x = malloc(b->len * sizeof(limb));
+        memcpy(x, b->d, b->len * sizeof(limb));
+        end = dec_rec(end, x, b->len, 0, &p, k);
+        free(x);
+        pow10_table_free(&p);
+    }
+    else {
+        end = pow2_to_string(end, b->d, b->len, radix);
+    }
+    *end = '\0';
+    return buf;
+}
+
+/* a + b, with the signs given apart for subtraction */
+static scm_object *add_views(big_view *a, int aneg, big_view *b, int bneg) {
+    scm_bignum *r;
+    big_view *t;
+    int tneg;
+
+    if (a->len < b->len) {
+        t = a, a = b, b = t;
+        tneg = aneg, aneg = bneg, bneg = tneg;
+    }
+    r = big_alloc(a->len + 1);
+    if (aneg == bneg) {
+        mag_add(r->d, a->d, a->len, b->d, b->len);
+        return big_finish(r, a->len + 1, aneg);
+    }
+    if (mag_cmp(a->d, a->len, b->d, b->len) >= 0) {
+        mag_sub(r->d, a->d, a->len, b->d, b->len);
+        return big_finish(r, a->len, aneg);
+    }
+    mag_sub(r->d, b->d, b->len, a->d, a->len);
+    return big_finish(r, b->len, bneg);
+}
+
+scm_object *scm_bignum_add(scm_object *a, scm_object *b) {
+    big_view x, y;
+    view(a, &x);
+    view(b, &y);
+    return add_views(&x, x.neg, &y, y.neg);
+}
+
+scm_object *scm_bignum_sub(scm_object *a, scm_object *b) {
+    big_view x, y;
+    view(a, &x);
+    view(b, &y);
+    return add_views(&x, x.neg, &y, !y.neg);
+}
+
+scm_object *scm_bignum_mul(scm_object *a, scm_object *b) {
+    big_view x, y;
+    scm_bignum *r;
+
+    view(a, &x);
+    view(b, &y);
+    r = big_alloc(x.len + y.len);
+    mag_mul(r->d, x.d, x.len, y.d, y.len);
+    return big_finish(r, x.len + y.len, x.neg != y.neg);
+}
+
+scm_object *scm_bignum_neg(scm_object *a) {
+    big_view x;
+    scm_bignum *r;
+
+    view(a, &x);
+    r = big_alloc(x.len);
+    memcpy(r->d, x.d, x.len * sizeof(limb));
+    return big_finish(r, x.len, !x.neg);
+}
+
+void scm_bignum_divmod(scm_object *a, scm_object *b, scm_object **q, scm_object **r) {
+    big_view x, y;
+    scm_bignum *qb, *rb = NULL;
+    limb rem;
+
+    view(a, &x);
+    view(b, &y);
+    if (mag_cmp(x.d, x.len, y.d, y.len) < 0) {
+        if (q)
+            *q = INTEGER(0);
+        if (r)
+            *r = a;
+        return;
+    }
+
+    qb = big_alloc(x.len);
+    if (y.len == 1) {
+        rem = mag_divmod_1(qb->d, x.d, x.len, y.d[0]);
+        if (r)
+            *r = INTEGER(x.neg ? -(long)rem : (long)rem);
+    }
+    else {
+        if (r)
+            rb = big_alloc(y.len);
+        mag_divmod(qb->d, rb ? rb->d : NULL, x.d, x.len, y.d, y.len);
+        if (r)
+            *r = big_finish(rb, y.len, x.neg);
+    }
+    if (q)
+        *q = big_finish(qb, x.len - y.len + 1, x.neg != y.neg);
+    else
+        free(qb);
+}
+
+scm_object *scm_bignum_shift(scm_object *a, long k) {
+    big_view x;
+    scm_bignum *r;
+    long w, n, i;
+    int s;
+
+    view(a, &x);
+    if (k >= 0) {
+        w = k / 32;
+        s = k % 32;
+        n = x.len + w + 1;
+        r = big_alloc(n);
+        memset(r->d, 0, w * sizeof(limb));
+        r->d[n - 1] = 0;
+        for (i = 0; i < x.len; ++i) {
+            r->d[i + w] = x.d[i] << s;
+            if (i > 0 && s)
+                r->d[i + w] |= x.d[i - 1] >> (32 - s);
+        }
+        if (s && x.len > 0)
+            r->d[x.len + w] = x.d[x.len - 1] >> (32 - s);
+        return big_finish(r, n, x.neg);
+    }
+
+    w = -k / 32;
+    s = -k % 32;
+    n = x.len - w;
+    if (n <= 0)
+        return INTEGER(0);
+    r = big_alloc(n);
+    for (i = 0; i < n; ++i) {
+        r->d[i] = x.d[i + w] >> s;
+        if (s && i + w + 1 < x.len)
+            r->d[i] |= x.d[i + w + 1] << (32 - s);
+    }
+    return big_finish(r, n, x.neg);
+}
+
+long scm_bignum_bit_length(scm_object *a) {
+    big_view x;
+
+    view(a, &x);
+    if (x.len == 0)
+        return 0;
+    return x.len * 32 - clz32(x.d[x.len - 1]);
+}
+
+/* binary gcd, shifts and subtractions instead of divisions */
+unsigned long scm_ulong_gcd(unsigned long a, unsigned long b) {
+    unsigned long t;
+    int shift;
+
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    shift = ctzl(a | b);
+    a >>= ctzl(a);
+    do {
+        b >>= ctzl(b);
+        if (a > b) {
+            t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    } while (b);
+    return a << shift;
+}
+
+/* euclid's remainders bring bignums down to fixnums */
+scm_object *scm_bignum_gcd(scm_object *a, scm_object *b) {
+    scm_object *r;
+    unsigned long g;
+
+    if (scm_bignum_sign(a) < 0)
+        a = scm_bignum_neg(a);
+    if (scm_bignum_sign(b) < 0)
+        b = scm_bignum_neg(b);
+    while (a->type == scm_type_bignum || b->type == scm_type_bignum) {
+        if (scm_bignum_sign(b) == 0)
+            return a;
+        scm_bignum_divmod(a, b, NULL, &r);
+        a = b;
+        b = r;
+    }
+    g = scm_ulong_gcd(scm_integer_get_val(a), scm_integer_get_val(b));
+    /* only for gcd(LONG_MIN, LONG_MIN) or with 0 */
+    return g > LONG_MAX ? scm_bignum_neg(INTEGER(LONG_MIN)) : INTEGER(g);
+}
+
+int scm_bignum_cmp(scm_object *a, scm_object *b) {
+    big_view x, y;
+    int c;
+
+    view(a, &x);
+    view(b, &y);
+    if (x.neg != y.neg)
+        return x.neg ? -1 : 1;
+    c = mag_cmp(x.d, x.len, y.d, y.len);
+    return x.neg ? -c : c;
+}
+
+int scm_bignum_sign(scm_object *a) {
+    long x;
+
+    if (a->type == scm_type_bignum)
+        return ((scm_bignum *)a)->neg ? -1 : 1;
+    x = scm_integer_get_val(a);
+    return (x > 0) - (x < 0);
+}
+
+int scm_bignum_is_odd(scm_object *a) {
+    if (a->type == scm_type_bignum)
+        return ((scm_bignum *)a)->d[0] & 1;
+    return scm_integer_get_val(a) & 1;
+}
+
+static void bignum_free(scm_object *obj) {
+    free(obj);
+}
+
+static int bignum_eqv(scm_object *o1, scm_object *o2) {
+    scm_bignum *a = (scm_bignum *)o1, *b = (scm_bignum *)o2;
+    return a->neg == b->neg && mag_cmp(a->d, a->len, b->d, b->len) == 0;
+}
+
+static size_t bignum_hash(scm_object *obj) {
+    scm_bignum *a = (scm_bignum *)obj;
+    return scm_hash_bytes(a->d, a->len * sizeof(limb)) ^ (size_t)a->neg;
+}
+
+static scm_object_methods bignum_methods = { bignum_free, bignum_eqv, bignum_eqv, bignum_hash, NULL };
+
+static int initialized = 0;
+
+int scm_bignum_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_bignum, &bignum_methods);
+
+    initialized = 1;
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef SCHEME_BIGNUM_H
+#define SCHEME_BIGNUM_H
+#include "object.h"
+
+/* exact integers beyond the range of a long
+ * the operations take exact integers of either representation and demote
+ * their results to fixnums whenever they fit, so a bignum never holds a
+ * value a fixnum could */
+
+/* @s is an optionally signed digit string of @len chars in @radix */
+scm_object *scm_bignum_from_string(const char *s, long len, int radix);
+/* @d must be finite and integral */
+scm_object *scm_bignum_from_double(double d);
+/* rounded to the nearest */
+double scm_bignum_to_double(scm_object *obj);
+/* radix 2, 8, 10 or 16, the result should be free'd by the caller */
+char *scm_bignum_to_string(scm_object *obj, int radix);
+
+scm_object *scm_bignum_add(scm_object *a, scm_object *b);
+scm_object *scm_bignum_sub(scm_object *a, scm_object *b);
+scm_object *scm_bignum_mul(scm_object *a, scm_object *b);
+scm_object *scm_bignum_neg(scm_object *a);
+/* truncating division by a non-zero @b, @q or @r may be NULL */
+void scm_bignum_divmod(scm_object *a, scm_object *b, scm_object **q, scm_object **r);
+/* a * 2^k, truncated toward zero for negative @k */
+scm_object *scm_bignum_shift(scm_object *a, long k);
+/* the number of bits of the magnitude */
+long scm_bignum_bit_length(scm_object *a);
+/* non-negative */
+scm_object *scm_bignum_gcd(scm_object *a, scm_object *b);
+unsigned long scm_ulong_gcd(unsigned long a, unsigned long b);
+int scm_bignum_cmp(scm_object *a, scm_object *b);
+int scm_bignum_sign(scm_object *a);
+int scm_bignum_is_odd(scm_object *a);
+
+int scm_bignum_init(void);
+
+#endif /* SCHEME_BIGNUM_H */
@@ -0,0 +1,308 @@
+#include "bytevector.h"
+#include "err.h"
+#include "char.h"
+#include "number.h"
+#include "string.h"
+#include "symbol.h"
+#include "pair.h"
+#include "proc.h"
+#include "env.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct scm_bytevector_st {
+    scm_object base;
+    uint8_t *buf;
+    long size;
+} scm_bytevector;
+
+#define data(obj) (((scm_bytevector *)(obj))->buf)
+#define size(obj) (((scm_bytevector *)(obj))->size)
+
+scm_object *pred_bytevector = NULL;
+
+/* the buffer isn't copied */
+static scm_object *bytevector_alloc(uint8_t *buf, long size) {
+    scm_bytevector *bv = malloc(sizeof(scm_bytevector));
+
+    bv->base.type = scm_type_bytevector;
+    bv->buf = buf;
+    bv->size = size;
+
+    return (scm_object *)bv;
+}
+
+scm_object *scm_bytevector_new(long size) {
+    return bytevector_alloc(calloc(size ? size : 1, 1), size);
+}
+
+scm_object *scm_bytevector_copy_new(const void *buf, long size) {
+    uint8_t *p = malloc(size ? size : 1);
+    if (size)
+        memcpy(p, buf, size);
+    return bytevector_alloc(p, size);
+}
+
+long scm_bytevector_size(scm_object *bv) {
+    return size(bv);
+}
+
+uint8_t *scm_bytevector_data(scm_object *bv) {
+    return data(bv);
+}
+
+static void bytevector_free(scm_object *obj) {
+    free(data(obj));
+    free(obj);
+}
+
+static int bytevector_equal(scm_object *o1, scm_object *o2) {
+    return size(o1) == size(o2) && !memcmp(data(o1), data(o2), size(o1));
+}
+
+static size_t bytevector_equal_hash(scm_object *obj, int *budget) {
+    (void)budget;
+    return scm_hash_bytes((const char *)data(obj), size(obj));
+}
+
+/* arguments */
+static long value_arg(const char *name, int i, scm_object *obj, long max, const char *expected) {
+    if (obj->type != scm_type_integer || scm_integer_get_val(obj) < 0 || scm_integer_get_val(obj) > max)
+        scm_contract_violation(name, i, expected, obj);
+    return scm_integer_get_val(obj);
+}
+
+#define byte_arg(name, i, obj) value_arg(name, i, obj, UINT8_MAX, "byte?")
+
+/* @width bytes at @k */
+static void check_index(const char *name, scm_object *bv, long k, int width) {
+    if (size(bv) < width)
+        scm_error_object(bv, "%s: index is out of range for a bytevector this short\nindex: %ld\n"
+                         "bytevector: ", name, k);
+    /* k + width could overflow */
+    if (k > size(bv) - width)
+        scm_error_object(bv, "%s: index is out of range\nindex: %ld\n"
+                         "valid range: [0, %ld]\nbytevector: ", name, k, size(bv) - width);
+}
+
+/* bytevector primitives */
+static scm_object *scm_is_bytevector(scm_object *obj) {
+    return scm_boolean(obj->type == scm_type_bytevector);
+}
+define_primitive_1(is_bytevector);
+
+static scm_object *prim_make_bytevector(int n, scm_object **args) {
+    long k = scm_index_arg("make-bytevector", 1, args[0]);
+    scm_object *bv = scm_bytevector_new(k);
+    if (n > 1)
+        memset(data(bv), byte_arg("make-bytevector", 2, args[1]), k);
+    return bv;
+}
+
+static scm_object *prim_bytevector(int n, scm_object **args) {
+    scm_object *bv = scm_bytevector_new(n);
+    for (int i = 0; i < n; ++i)
+        data(bv)[i] = byte_arg("bytevector", i + 1, args[i]);
+    return bv;
+}
+
+static scm_object *prim_bytevector_length(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(size(args[0]));
+}
+
+static scm_object *prim_bytevector_u8_ref(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long k = scm_index_arg("bytevector-u8-ref", 2, args[1]);
+    (void)n;
+    check_index("bytevector-u8-ref", bv, k, 1);
+    return INTEGER(data(bv)[k]);
+}
+
+static scm_object *prim_bytevector_u8_set(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long k = scm_index_arg("bytevector-u8-set!", 2, args[1]);
+    long b = byte_arg("bytevector-u8-set!", 3, args[2]);
+    (void)n;
+    check_index("bytevector-u8-set!", bv, k, 1);
+    data(bv)[k] = b;
+    return scm_void;
+}
+
+/* native endianness at any alignment, memcpy makes single loads and stores */
+#define define_native_accessors(name, type, max, expected) \
+    static scm_object *prim_bytevector_##name##_ref(int n, scm_object **args) { \
+        scm_object *bv = args[0]; \
+        long k = scm_index_arg("bytevector-" #name "-native-ref", 2, args[1]); \
+        type v; \
+        (void)n; \
+        check_index("bytevector-" #name "-native-ref", bv, k, sizeof(type)); \
+        memcpy(&v, data(bv) + k, sizeof(type)); \
+        return INTEGER((long)v); \
+    } \
+    static scm_object *prim_bytevector_##name##_set(int n, scm_object **args) { \
+        scm_object *bv = args[0]; \
+        long k = scm_index_arg("bytevector-" #name "-native-set!", 2, args[1]); \
+        type v = (type)value_arg("bytevector-" #name "-native-set!", 3, args[2], max, expected); \
+        (void)n; \
+        check_index("bytevector-" #name "-native-set!", bv, k, sizeof(type)); \
+        memcpy(data(bv) + k, &v, sizeof(type)); \
+        return scm_void; \
+    }
+
+define_native_accessors(u16, uint16_t, UINT16_MAX, "(integer-in 0 65535)")
+define_native_accessors(u32, uint32_t, (long)UINT32_MAX, "(integer-in 0 4294967295)")
+
+static scm_object *prim_bytevector_f64_ref(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long k = scm_index_arg("bytevector-ieee-double-native-ref", 2, args[1]);
+    double v;
+    (void)n;
+    check_index("bytevector-ieee-double-native-ref", bv, k, sizeof(double));
+    memcpy(&v, data(bv) + k, sizeof(double));
+    return FLOAT(v);
+}
+
+static scm_object *prim_bytevector_f64_set(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long k = scm_index_arg("bytevector-ieee-double-native-set!", 2, args[1]);
+    double v = scm_number_to_double(args[2]);
+    (void)n;
+    check_index("bytevector-ieee-double-native-set!", bv, k, sizeof(double));
+    memcpy(data(bv) + k, &v, sizeof(double));
+    return scm_void;
+}
+
+static scm_object *prim_bytevector_copy(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long start, end;
+
+    scm_range_args("bytevector-copy", n, 2, args, bv, "bytevector", size(bv), &start, &end);
+    return scm_bytevector_copy_new(data(bv) + start, end - start);
+}
+
+/* (bytevector-copy! to at from [start [end]]), the ranges may overlap */
+static scm_object *prim_bytevector_copy_to(int n, scm_object **args) {
+    scm_object *to = args[0], *from = args[2];
+    long at = scm_index_arg("bytevector-copy!", 2, args[1]), start, end;
+
+    scm_range_args("bytevector-copy!", n, 4, args, from, "bytevector", size(from), &start, &end);
+    if (at > size(to) || end - start > size(to) - at)
+        scm_error_object(to, "bytevector-copy!: not enough room in the destination\nindex: %ld\n"
+                         "bytes: %ld\nbytevector: ", at, end - start);
+    memmove(data(to) + at, data(from) + start, end - start);
+    return scm_void;
+}
+
+static scm_object *prim_bytevector_append(int n, scm_object **args) {
+    scm_object *bv;
+    long total = 0, off = 0;
+    int i;
+
+    for (i = 0; i < n; ++i)
+        total += size(args[i]);
+    bv = scm_bytevector_new(total);
+    for (i = 0; i < n; ++i) {
+        memcpy(data(bv) + off, data(args[i]), size(args[i]));
+        off += size(args[i]);
+    }
+    return bv;
+}
+
+/* (bytevector-fill! bytevector byte [start [end]]) */
+static scm_object *prim_bytevector_fill(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long b = byte_arg("bytevector-fill!", 2, args[1]), start, end;
+
+    scm_range_args("bytevector-fill!", n, 3, args, bv, "bytevector", size(bv), &start, &end);
+    memset(data(bv) + start, b, end - start);
+    return scm_void;
+}
+
+/* lexicographic by unsigned bytes, a prefix first */
+static int bytevector_compare(scm_object *a, scm_object *b) {
+    long len = size(a) < size(b) ? size(a) : size(b);
+    int d = len ? memcmp(data(a), data(b), len) : 0;
+
+    if (d)
+        return d < 0 ? -1 : 1;
+    return (size(a) > size(b)) - (size(a) < size(b));
+}
+
+static scm_object *prim_bytevector_eq(int n, scm_object **args) {
+    for (int i = 1; i < n; ++i) {
+        if (!bytevector_equal(args[i - 1], args[i]))
+            return scm_false;
+    }
+    return scm_true;
+}
+
+static scm_object *prim_bytevector_compare(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(bytevector_compare(args[0], args[1]));
+}
+
+/* strings are UTF-8 already, these are copies of the bytes */
+static scm_object *prim_utf8_to_string(int n, scm_object **args) {
+    scm_object *bv = args[0];
+    long start, end;
+    char *buf;
+
+    scm_range_args("utf8->string", n, 2, args, bv, "bytevector", size(bv), &start, &end);
+    buf = malloc(end - start + 1);
+    memcpy(buf, data(bv) + start, end - start);
+    buf[end - start] = '\0';
+    return scm_string_new(buf, end - start);
+}
+
+static scm_object *prim_string_to_utf8(int n, scm_object **args) {
+    scm_object *str = args[0];
+    (void)n;
+    return scm_bytevector_copy_new(scm_string_get_str(str), scm_string_size(str));
+}
+
+static scm_object_methods bytevector_methods = { bytevector_free, same_object, bytevector_equal, NULL,
+                                                 bytevector_equal_hash };
+
+static int initialized = 0;
+
+int scm_bytevector_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_bytevector, &bytevector_methods);
+    pred_bytevector = scm_type_predicate_new("bytevector?", prim_is_bytevector,
+                                             SCM_TYPE_BIT(scm_type_bytevector));
+
+    initialized = 1;
+    return 0;
+}
+
+int scm_bytevector_init_env(scm_object *env) {
+    scm_object *pred_bv = scm_list(1, pred_bytevector);
+
+    scm_env_define_var(env, scm_symbol_new("bytevector?", -1), pred_bytevector);
+    scm_env_add_prim(env, "make-bytevector", prim_make_bytevector, 1, 2, NULL);
+    scm_env_add_prim(env, "bytevector", prim_bytevector, 0, -1, NULL);
+    scm_env_add_prim(env, "bytevector-length", prim_bytevector_length, 1, 1, pred_bv);
+    scm_env_add_prim(env, "bytevector-u8-ref", prim_bytevector_u8_ref, 2, 2, pred_bv);
+    scm_env_add_prim(env, "bytevector-u8-set!", prim_bytevector_u8_set, 3, 3, pred_bv);
+    scm_env_add_prim(env, "bytevector-u16-native-ref", prim_bytevector_u16_ref, 2, 2, pred_bv);
+    scm_env_add_prim(env, "bytevector-u16-native-set!", prim_bytevector_u16_set, 3, 3, pred_bv);
+    scm_env_add_prim(env, "bytevector-u32-native-ref", prim_bytevector_u32_ref, 2, 2, pred_bv);
+    scm_env_add_prim(env, "bytevector-u32-native-set!", prim_bytevector_u32_set, 3, 3, pred_bv);
+    scm_env_add_prim(env, "bytevector-ieee-double-native-ref", prim_bytevector_f64_ref, 2, 2, pred_bv);
+    scm_env_add_prim(env, "bytevector-ieee-double-native-set!", prim_bytevector_f64_set, 3, 3,
+                     scm_list(3, pred_bytevector, pred_exact_integer, pred_real));
+    scm_env_add_prim(env, "bytevector-copy", prim_bytevector_copy, 1, 3, pred_bv);
+    scm_env_add_prim(env, "bytevector-copy!", prim_bytevector_copy_to, 3, 5,
+                     scm_list(3, pred_bytevector, pred_exact_integer, pred_bytevector));
+    scm_env_add_prim(env, "bytevector-append", prim_bytevector_append, 0, -1, pred_bytevector);
+    scm_env_add_prim(env, "bytevector-fill!", prim_bytevector_fill, 2, 4, pred_bv);
+    scm_env_add_prim(env, "bytevector=?", prim_bytevector_eq, 1, -1, pred_bytevector);
+    scm_env_add_prim(env, "bytevector-compare", prim_bytevector_compare, 2, 2, pred_bytevector);
+    scm_env_add_prim(env, "utf8->string", prim_utf8_to_string, 1, 3, pred_bv);
+    scm_env_add_prim(env, "string->utf8", prim_string_to_utf8, 1, 1, pred_string);
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef SCHEME_BYTEVECTOR_H
+#define SCHEME_BYTEVECTOR_H
+#include "object.h"
+
+#include <stdint.h>
+
+/* bytevectors hold raw bytes (R7RS), with the multi-byte accessors of R6RS
+ * in native endianness
+ * the bulk operations are memcpy, memmove, memset and memcmp, which the C
+ * library vectorizes */
+
+extern scm_object *pred_bytevector;
+
+/* zeroed */
+scm_object *scm_bytevector_new(long size);
+scm_object *scm_bytevector_copy_new(const void *buf, long size);
+long scm_bytevector_size(scm_object *bv);
+/* for loops which keep within the size themselves */
+uint8_t *scm_bytevector_data(scm_object *bv);
+
+int scm_bytevector_init(void);
+int scm_bytevector_init_env(scm_object *env);
+
+#endif /* SCHEME_BYTEVECTOR_H */
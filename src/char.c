@@ -1,22 +1,370 @@
 #include "char.h"
+#include "number.h"
+#include "proc.h"
+#include "err.h"
 #include "env.h"
 #include <stdlib.h>
 
 typedef struct scm_char_st {
     scm_object base;
-    char c;
+    int c;      /* code point */
 } scm_char;
 
+/* the ASCII characters are singletons, the others are made as needed */
 #define CHAR_NUM 128
 static scm_char scm_chars_arr[CHAR_NUM];
 scm_object *scm_chars[CHAR_NUM];
 
+#define char_val(obj) (((scm_char *)(obj))->c)
+
+scm_object *scm_char_new(int c) {
+    scm_char *ch;
+
+    if (c >= 0 && c < CHAR_NUM)
+        return scm_chars[c];
+
+    ch = malloc(sizeof(scm_char));
+    ch->base.type = scm_type_char;
+    ch->c = c;
+    return (scm_object *)ch;
+}
+
 char scm_char_get_char(scm_object *obj) {
-    scm_char *c = (scm_char *)obj;
-    return c->c;
+    return (char)char_val(obj);
+}
+
+int scm_char_get_codepoint(scm_object *obj) {
+    return char_val(obj);
+}
+
+int scm_char_is_valid(long c) {
+    return c >= 0 && c <= 0x10ffff && (c < 0xd800 || c > 0xdfff);
+}
+
+/* UTF-8 */
+int scm_utf8_encode(int c, char *buf) {
+    unsigned char *p = (unsigned char *)buf;
+
+    if (c < 0x80) {
+        p[0] = c;
+        return 1;
+    }
+    if (c < 0x800) {
+        p[0] = 0xc0 | (c >> 6);
+        p[1] = 0x80 | (c & 0x3f);
+        return 2;
+    }
+    if (c < 0x10000) {
+        p[0] = 0xe0 | (c >> 12);
+        p[1] = 0x80 | ((c >> 6) & 0x3f);
+        p[2] = 0x80 | (c & 0x3f);
+        return 3;
+    }
+    p[0] = 0xf0 | (c >> 18);
+    p[1] = 0x80 | ((c >> 12) & 0x3f);
+    p[2] = 0x80 | ((c >> 6) & 0x3f);
+    p[3] = 0x80 | (c & 0x3f);
+    return 4;
+}
+
+int scm_utf8_length(int c) {
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+/* the length of the sequence led by @b, 0 for a byte that can't lead */
+static int lead_length(unsigned char b) {
+    if (b < 0x80)
+        return 1;
+    if (b < 0xc2)
+        return 0;
+    if (b < 0xe0)
+        return 2;
+    if (b < 0xf0)
+        return 3;
+    if (b < 0xf5)
+        return 4;
+    return 0;
+}
+
+/* the length of the well-formed sequence at @s, 0 if it isn't (Unicode
+ * table 3-7: no overlong forms, surrogates or code points over 10FFFF) */
+static int sequence_length(const unsigned char *s, long n) {
+    int len = lead_length(s[0]);
+
+    if (len == 0 || len > n)
+        return 0;
+    if (len == 1)
+        return 1;
+    if ((s[1] & 0xc0) != 0x80 ||
+        (s[0] == 0xe0 && s[1] < 0xa0) || (s[0] == 0xed && s[1] > 0x9f) ||
+        (s[0] == 0xf0 && s[1] < 0x90) || (s[0] == 0xf4 && s[1] > 0x8f))
+        return 0;
+    for (int i = 2; i < len; ++i) {
+        if ((s[i] & 0xc0) != 0x80)
+            return 0;
+    }
+    return len;
+}
+
+int scm_utf8_decode(const char *buf, int *c) {
+    const unsigned char *p = (const unsigned char *)buf;
+
+    switch (lead_length(p[0])) {
+    case 1:
+        *c = p[0];
+        return 1;
+    case 2:
+        *c = ((p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+        return 2;
+    case 3:
+        *c = ((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+        return 3;
+    default:
+        *c = ((p[0] & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+        return 4;
+    }
+}
+
+long scm_utf8_count(const char *buf, long n) {
+    const unsigned char *p = (const unsigned char *)buf;
+    long count = 0;
+
+    /* every byte but the continuation ones starts a character */
+    for (long i = 0; i < n; ++i)
+        count += (p[i] & 0xc0) != 0x80;
+    return count;
+}
+
+long scm_utf8_validate(const char *buf, long n) {
+    const unsigned char *p = (const unsigned char *)buf;
+    long count = 0;
+    int len;
+
+    for (long i = 0; i < n; i += len, ++count) {
+        /* the common case */
+        if (p[i] < 0x80) {
+            len = 1;
+            continue;
+        }
+        if (!(len = sequence_length(p + i, n - i)))
+            return -1;
+    }
+    return count;
+}
+
+char *scm_utf8_repair(const char *buf, long n, long *size) {
+    const unsigned char *p = (const unsigned char *)buf;
+    char *out = malloc(3 * n + 1), *q = out;
+    int len;
+
+    for (long i = 0; i < n; i += len) {
+        if ((len = sequence_length(p + i, n - i))) {
+            for (int k = 0; k < len; ++k)
+                *q++ = p[i + k];
+        } else {
+            /* a maximal subpart of an ill-formed sequence is one U+FFFD */
+            len = 1;
+            while (len < 4 && i + len < n && (p[i + len] & 0xc0) == 0x80 && lead_length(p[i]) > len)
+                ++len;
+            q += scm_utf8_encode(0xfffd, q);
+        }
+    }
+    *q = '\0';
+    *size = q - out;
+    return out;
+}
+
+/* case mappings and classes
+ * the ASCII ones and the simple one-to-one case pairs of the Latin, Greek,
+ * Cyrillic and Armenian blocks and of the full-width forms, enough for the
+ * languages these scripts write without the tables of the whole UCD */
+typedef struct {
+    int lo, hi;     /* the upper-case range */
+    int delta;      /* to lower case */
+    int step;       /* 1 for a range, 2 for alternating upper and lower */
+} case_range;
+
+static const case_range case_ranges[] = {
+    { 0x0041, 0x005a, 32, 1 },
+    { 0x00c0, 0x00d6, 32, 1 },
+    { 0x00d8, 0x00de, 32, 1 },
+    { 0x0100, 0x012f, 1, 2 },
+    { 0x0132, 0x0137, 1, 2 },
+    { 0x0139, 0x0148, 1, 2 },
+    { 0x014a, 0x0177, 1, 2 },
+    { 0x0179, 0x017e, 1, 2 },
+    { 0x0386, 0x0386, 38, 1 },
+    { 0x0388, 0x038a, 37, 1 },
+    { 0x038c, 0x038c, 64, 1 },
+    { 0x038e, 0x038f, 63, 1 },
+    { 0x0391, 0x03a1, 32, 1 },
+    { 0x03a3, 0x03ab, 32, 1 },
+    { 0x0400, 0x040f, 80, 1 },
+    { 0x0410, 0x042f, 32, 1 },
+    { 0x0460, 0x0481, 1, 2 },
+    { 0x048a, 0x04bf, 1, 2 },
+    { 0x04d0, 0x052f, 1, 2 },
+    { 0x0531, 0x0556, 48, 1 },
+    { 0x1e00, 0x1e95, 1, 2 },
+    { 0x1ea0, 0x1eff, 1, 2 },
+    { 0xff21, 0xff3a, 32, 1 },
+};
+
+#define CASE_RANGE_NUM (int)(sizeof(case_ranges) / sizeof(case_ranges[0]))
+
+/* the range of @c as an upper-case letter, or as a lower-case one */
+static const case_range *upper_range(int c) {
+    for (int i = 0; i < CASE_RANGE_NUM; ++i) {
+        const case_range *r = case_ranges + i;
+        if (c >= r->lo && c <= r->hi && (c - r->lo) % r->step == 0)
+            return r;
+    }
+    return NULL;
+}
+
+static const case_range *lower_range(int c) {
+    for (int i = 0; i < CASE_RANGE_NUM; ++i) {
+        const case_range *r = case_ranges + i;
+        int u = c - r->delta;
+        if (u >= r->lo && u <= r->hi && (u - r->lo) % r->step == 0)
+            return r;
+    }
+    return NULL;
+}
+
+int scm_char_upcase(int c) {
+    const case_range *r;
+    if (c < CHAR_NUM)
+        return c >= 'a' && c <= 'z' ? c - 32 : c;
+    r = lower_range(c);
+    return r ? c - r->delta : c;
+}
+
+int scm_char_downcase(int c) {
+    const case_range *r;
+    if (c < CHAR_NUM)
+        return c >= 'A' && c <= 'Z' ? c + 32 : c;
+    r = upper_range(c);
+    return r ? c + r->delta : c;
+}
+
+static int is_upper_case(int c) {
+    return upper_range(c) != NULL;
+}
+
+static int is_lower_case(int c) {
+    /* lower case without an upper case of its own here */
+    return lower_range(c) != NULL || c == 0xdf || c == 0xff || c == 0x3c2;
+}
+
+/* the letters of the scripts above and the ideographs and syllabaries of
+ * the CJK blocks */
+static int is_alphabetic(int c) {
+    if (c < CHAR_NUM)
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    return is_upper_case(c) || is_lower_case(c) || c == 0xaa || c == 0xba ||
+           (c >= 0x180 && c <= 0x24f) || (c >= 0x5d0 && c <= 0x5ea) ||
+           (c >= 0x620 && c <= 0x64a) || (c >= 0x3041 && c <= 0x30ff) ||
+           (c >= 0x3400 && c <= 0x4dbf) || (c >= 0x4e00 && c <= 0x9fff) ||
+           (c >= 0xac00 && c <= 0xd7a3);
+}
+
+/* the decimal digits of ASCII, Arabic-Indic, Devanagari and full width */
+static int digit_value(int c) {
+    static const int zeros[] = { '0', 0x660, 0x6f0, 0x966, 0xff10 };
+    for (int i = 0; i < (int)(sizeof(zeros) / sizeof(zeros[0])); ++i) {
+        if (c >= zeros[i] && c <= zeros[i] + 9)
+            return c - zeros[i];
+    }
+    return -1;
+}
+
+static int is_whitespace(int c) {
+    return c == ' ' || (c >= '\t' && c <= '\r') || c == 0x85 || c == 0xa0 ||
+           c == 0x1680 || (c >= 0x2000 && c <= 0x200a) || c == 0x2028 ||
+           c == 0x2029 || c == 0x202f || c == 0x205f || c == 0x3000;
+}
+
+static void char_free(scm_object *obj) {
+    if (char_val(obj) >= CHAR_NUM)
+        free(obj);
+}
+
+static int char_eqv(scm_object *o1, scm_object *o2) {
+    return char_val(o1) == char_val(o2);
+}
+
+static size_t char_hash(scm_object *obj) {
+    return scm_hash_mix(char_val(obj));
+}
+
+/* char primitives */
+static scm_object *prim_char_to_integer(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(char_val(args[0]));
+}
+
+static scm_object *prim_integer_to_char(int n, scm_object **args) {
+    scm_object *obj = args[0];
+    (void)n;
+    if (obj->type != scm_type_integer || !scm_char_is_valid(scm_integer_get_val(obj)))
+        scm_contract_violation("integer->char", 1, "valid code point", obj);
+    return scm_char_new((int)scm_integer_get_val(obj));
+}
+
+/* whether the order holds pairwise along the arguments */
+#define define_compare_primitive(name, fold, op) \
+    static scm_object *prim_##name(int n, scm_object **args) { \
+        for (int i = 1; i < n; ++i) { \
+            if (!(fold(char_val(args[i - 1])) op fold(char_val(args[i])))) \
+                return scm_false; \
+        } \
+        return scm_true; \
+    }
+
+#define same(c) (c)
+
+define_compare_primitive(char_eq, same, ==)
+define_compare_primitive(char_lt, same, <)
+define_compare_primitive(char_gt, same, >)
+define_compare_primitive(char_le, same, <=)
+define_compare_primitive(char_ge, same, >=)
+define_compare_primitive(char_ci_eq, scm_char_downcase, ==)
+define_compare_primitive(char_ci_lt, scm_char_downcase, <)
+define_compare_primitive(char_ci_gt, scm_char_downcase, >)
+define_compare_primitive(char_ci_le, scm_char_downcase, <=)
+define_compare_primitive(char_ci_ge, scm_char_downcase, >=)
+
+#define define_class_primitive(name, exp) \
+    static scm_object *prim_##name(int n, scm_object **args) { \
+        int c = char_val(args[0]); \
+        (void)n; \
+        return scm_boolean(exp); \
+    }
+
+define_class_primitive(is_alphabetic, is_alphabetic(c))
+define_class_primitive(is_numeric, digit_value(c) >= 0)
+define_class_primitive(is_whitespace, is_whitespace(c))
+define_class_primitive(is_upper_case, is_upper_case(c))
+define_class_primitive(is_lower_case, is_lower_case(c))
+
+static scm_object *prim_digit_value(int n, scm_object **args) {
+    int d = digit_value(char_val(args[0]));
+    (void)n;
+    return d < 0 ? scm_false : INTEGER(d);
+}
+
+static scm_object *prim_char_upcase(int n, scm_object **args) {
+    (void)n;
+    return scm_char_new(scm_char_upcase(char_val(args[0])));
+}
+
+static scm_object *prim_char_downcase(int n, scm_object **args) {
+    (void)n;
+    return scm_char_new(scm_char_downcase(char_val(args[0])));
 }
 
-static scm_object_methods char_methods = { NULL, same_object, same_object};
+static scm_object_methods char_methods = { char_free, char_eqv, char_eqv, char_hash, NULL };
 
 static int initialized = 0;
 
@@ -28,7 +376,7 @@ int scm_char_init(void) {
 
     for (i = 0; i < CHAR_NUM; ++i) {
         scm_chars_arr[i].base.type = scm_type_char;
-        scm_chars_arr[i].c = (char)i;
+        scm_chars_arr[i].c = i;
         scm_chars[i] = (scm_object *)(scm_chars_arr + i);
     }
 
@@ -39,6 +387,25 @@ int scm_char_init(void) {
 }
 
 int scm_char_init_env(scm_object *env) {
-    (void)env;
+    scm_env_add_prim(env, "char->integer", prim_char_to_integer, 1, 1, pred_char);
+    scm_env_add_prim(env, "integer->char", prim_integer_to_char, 1, 1, NULL);
+    scm_env_add_prim(env, "char=?", prim_char_eq, 1, -1, pred_char);
+    scm_env_add_prim(env, "char<?", prim_char_lt, 1, -1, pred_char);
+    scm_env_add_prim(env, "char>?", prim_char_gt, 1, -1, pred_char);
+    scm_env_add_prim(env, "char<=?", prim_char_le, 1, -1, pred_char);
+    scm_env_add_prim(env, "char>=?", prim_char_ge, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-ci=?", prim_char_ci_eq, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-ci<?", prim_char_ci_lt, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-ci>?", prim_char_ci_gt, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-ci<=?", prim_char_ci_le, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-ci>=?", prim_char_ci_ge, 1, -1, pred_char);
+    scm_env_add_prim(env, "char-alphabetic?", prim_is_alphabetic, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-numeric?", prim_is_numeric, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-whitespace?", prim_is_whitespace, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-upper-case?", prim_is_upper_case, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-lower-case?", prim_is_lower_case, 1, 1, pred_char);
+    scm_env_add_prim(env, "digit-value", prim_digit_value, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-upcase", prim_char_upcase, 1, 1, pred_char);
+    scm_env_add_prim(env, "char-downcase", prim_char_downcase, 1, 1, pred_char);
     return 0;
 }
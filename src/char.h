@@ -2,12 +2,38 @@
 #define SCHEME_CHAR_H
 #include "object.h"
 
+/* characters are Unicode code points, and strings hold them in UTF-8 */
+
+/* the ASCII characters */
 extern scm_object *scm_chars[];
 
+/* @c is a valid code point */
+scm_object *scm_char_new(int c);
+/* the low byte of the code point, for ASCII characters */
 char scm_char_get_char(scm_object *obj);
+int scm_char_get_codepoint(scm_object *obj);
+/* a Unicode scalar value, i.e. a code point but a surrogate */
+int scm_char_is_valid(long c);
+int scm_char_upcase(int c);
+int scm_char_downcase(int c);
+
+#define SCM_UTF8_MAX 4
+
+/* the bytes written to @buf, at most SCM_UTF8_MAX */
+int scm_utf8_encode(int c, char *buf);
+/* the bytes of the encoding of @c */
+int scm_utf8_length(int c);
+/* the bytes read of a well-formed sequence at @buf */
+int scm_utf8_decode(const char *buf, int *c);
+/* the code points of well-formed UTF-8 */
+long scm_utf8_count(const char *buf, long n);
+/* the code points, or -1 if the @n bytes at @buf aren't well-formed UTF-8 */
+long scm_utf8_validate(const char *buf, long n);
+/* a NUL terminated copy with each ill-formed sequence replaced by U+FFFD,
+ * and its length in bytes in @size */
+char *scm_utf8_repair(const char *buf, long n, long *size);
 
 int scm_char_init(void);
 int scm_char_init_env(scm_object *env);
 
 #endif /* SCHEME_CHAR_H */
-
@@ -7,6 +7,13 @@
 #include "symbol.h"
 #include "pair.h"
 #include "vector.h"
+#include "hashtable.h"
+#include "bytevector.h"
+#include "numvector.h"
+#include "pmap.h"
+#include "pvector.h"
+#include "sort.h"
+#include "write.h"
 #include "eval.h"
 
 #include <stdlib.h>
@@ -75,6 +82,34 @@ err:
     return NULL;
 }
 
+/* as frame_new, of the @n values in @vals, a rest parameter takes a list
+ * of its own */
+static scm_object *frame_new_args(scm_object *vars, int n, scm_object **vals) {
+    scm_object *frame = scm_null, *rest = scm_null;
+    int i = 0;
+
+    for (; vars->type == scm_type_pair; vars = scm_cdr(vars), ++i) {
+        if (i == n)
+            goto err;   /* too few arguments */
+        frame = frame_add_binding(frame, scm_car(vars), vals[i]);
+    }
+
+    if (vars == scm_null) {
+        if (i != n)
+            goto err;   /* too many arguments */
+    }
+    else {  /* improper list */
+        for (int k = n - 1; k >= i; --k)
+            rest = scm_cons(vals[k], rest);
+        frame = frame_add_binding(frame, vars, rest);
+    }
+
+    return frame;
+err:
+    scm_object_free(frame);
+    return NULL;
+}
+
 static scm_object *env_first_frame(scm_object *env) {
     return scm_car(env);
 }
@@ -133,6 +168,16 @@ scm_object *scm_env_extend(scm_object *env, scm_object *vars, scm_object *vals)
     }
 }
 
+scm_object *scm_env_extend_args(scm_object *env, scm_object *vars, int n, scm_object **vals) {
+    scm_object *frame = frame_new_args(vars, n, vals);
+    if (frame) {
+        return scm_cons(frame, env);
+    }
+    else {
+        return NULL;
+    }
+}
+
 scm_object *scm_env_lookup_var(scm_object *env, scm_object *var) {
     if (IS_EXTENDED_IDENTIFIER(var)) {
         env = scm_esymbol_get_env(var);
@@ -193,6 +238,13 @@ scm_object *scm_global_env() {
     scm_symbol_init_env(global_env);
     scm_pair_init_env(global_env);
     scm_vector_init_env(global_env);
+    scm_hashtable_init_env(global_env);
+    scm_bytevector_init_env(global_env);
+    scm_numvector_init_env(global_env);
+    scm_pmap_init_env(global_env);
+    scm_pvector_init_env(global_env);
+    scm_sort_init_env(global_env);
+    scm_write_init_env(global_env);
     scm_eval_init_env(global_env);
     return global_env;
 }
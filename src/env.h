@@ -5,6 +5,8 @@
 
 scm_object *scm_env_new();
 scm_object *scm_env_extend(scm_object *env, scm_object *vars, scm_object *vals);
+/* of the @n values in @vals */
+scm_object *scm_env_extend_args(scm_object *env, scm_object *vars, int n, scm_object **vals);
 scm_object *scm_env_lookup_var(scm_object *env, scm_object *var);
 int scm_env_set_var(scm_object *env, scm_object *var, scm_object *val);
 void scm_env_define_var(scm_object *env, scm_object *var, scm_object *val);
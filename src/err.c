@@ -3,28 +3,65 @@
 #include "write.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-#define msg_size 4096
-static char msg[msg_size];
-static int pos = 0;
+/* messages start in the static buffer and move to the heap
+ * when they don't fit in it */
+#define msg_init_size 4096
+static _Thread_local char msg_buf[msg_init_size];
+static _Thread_local char *msg_heap = NULL;
+static _Thread_local size_t msg_size = msg_init_size;
+static _Thread_local size_t pos = 0;
 
-jmp_buf *scm_jmp = NULL;
+#define msg (msg_heap ? msg_heap : msg_buf)
+
+_Thread_local jmp_buf *scm_jmp = NULL;
+
+/* keep room for @len more bytes and the terminating NUL */
+static void msg_reserve(size_t len) {
+    size_t size = msg_size;
+    if (pos + len < size)
+        return;
+
+    while (pos + len >= size)
+        size *= 2;
+    if (msg_heap == NULL) {
+        msg_heap = malloc(size);
+        memcpy(msg_heap, msg_buf, pos);
+    }
+    else {
+        msg_heap = realloc(msg_heap, size);
+    }
+    msg_size = size;
+}
+
+void scm_error_vadd(const char *fmt, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(msg + pos, msg_size - pos, fmt, copy);
+    va_end(copy);
+
+    if (n < 0)
+        return;
+    if (pos + n >= msg_size) {
+        msg_reserve(n);
+        vsnprintf(msg + pos, msg_size - pos, fmt, args);
+    }
+    pos += n;
+}
 
 void scm_error_add(const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    pos += vsnprintf(msg + pos, msg_size - pos, fmt, args);
+    scm_error_vadd(fmt, args);
     va_end(args);
 }
 
-void scm_error_vadd(const char *fmt, va_list args) {
-    pos += vsnprintf(msg + pos, msg_size - pos, fmt, args);
-}
-
 void scm_error(const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(msg + pos, msg_size - pos, fmt, args);
+    scm_error_vadd(fmt, args);
     va_end(args);
 
     pos = 0;
@@ -34,7 +71,7 @@ void scm_error(const char *fmt, ...) {
 void scm_error_free(scm_error_free_fn fn, void *p, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    vsnprintf(msg + pos, msg_size - pos, fmt, args);
+    scm_error_vadd(fmt, args);
     va_end(args);
 
     fn(p);
@@ -45,12 +82,16 @@ void scm_error_free(scm_error_free_fn fn, void *p, const char *fmt, ...) {
 void scm_error_object(scm_object *obj, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    pos += vsnprintf(msg + pos, msg_size - pos, fmt, args);
+    scm_error_vadd(fmt, args);
     va_end(args);
 
-    scm_object *port = string_output_port_new(msg + pos, msg_size - pos - 1);
-    int m = scm_write(port, obj);
-    msg[pos+m] = '\0';
+    long len;
+    scm_object *port = string_output_port_open();
+    scm_write(port, obj);
+    const char *s = scm_output_port_string(port, &len);
+    msg_reserve(len);
+    memcpy(msg + pos, s, len + 1);
+    scm_object_free(port);
 
     pos = 0;
     SCM_THROW;
@@ -5,7 +5,8 @@
 #include <stdarg.h>
 #include <setjmp.h>
 
-extern jmp_buf *scm_jmp;
+/* the error state is per thread, so that readers can run on several threads */
+extern _Thread_local jmp_buf *scm_jmp;
 
 /* NOTE: there'll be a problem if `break` is used inside the try-catch block
  * to jump out the loop outside the try-catch block. It will actually jump out
@@ -6,6 +6,7 @@
 #include "pair.h"
 #include "vector.h"
 #include "proc.h"
+#include "record.h"
 #include "env.h"
 #include "exp.h"
 #include "xform.h"
@@ -346,28 +347,70 @@ static scm_object *eval_define_syntax(scm_object *exp, scm_object *env) {
     return scm_void;
 }
 
-static scm_object *eval_operands(scm_object *exp, scm_object *env, int *n) {
-    scm_object *head = scm_null;
-    scm_object *tail = NULL;
-    scm_object *obj = NULL;
-    scm_object *pair = NULL;
-    int i = 0;
-    scm_object *opds = scm_exp_get_application_operands(exp);
-    while (opds->type == scm_type_pair) {
-        obj = scm_eval(scm_car(opds), env);
-        pair = scm_cons(obj, scm_null);
-        if (i == 0) {
-            head = pair;
-        }
-        else {
+/* defines the type, then its procedures */
+static scm_object *eval_define_record_type(scm_object *exp, scm_object *env) {
+    scm_exp_check_define_record_type(exp);
+    scm_object *specs = scm_exp_get_record_field_specs(exp);
+    scm_object *ctor_fields = scm_exp_get_record_constructor_fields(exp);
+    scm_object *fields = scm_null, *tail = NULL, *pair, *rtd, *l, *modifier;
+    long i = 0;
+
+    l = specs;
+    FOREACH_LIST(spec, l) {
+        pair = scm_cons(scm_exp_get_field_spec_field(spec), scm_null);
+        if (tail)
             scm_set_cdr(tail, pair);
-        }
+        else
+            fields = pair;
         tail = pair;
-        opds = scm_cdr(opds);
+    }
+    rtd = scm_record_type_new(scm_exp_get_record_type_name(exp), fields);
+    l = fields;
+    FOREACH_LIST(field, l) {
+        if (scm_record_type_field_index(rtd, field) != i++)
+            scm_error_object(field, "define-record-type: duplicate field in: ");
+    }
+    l = ctor_fields;
+    FOREACH_LIST(field, l) {
+        if (scm_record_type_field_index(rtd, field) < 0)
+            scm_error_object(field, "define-record-type: not a field of the record type in: ");
+    }
+
+    scm_env_define_var(env, scm_exp_get_record_type_name(exp), rtd);
+    scm_env_define_var(env, scm_exp_get_record_constructor(exp),
+                       scm_record_constructor(rtd, scm_exp_get_record_constructor(exp), ctor_fields));
+    scm_env_define_var(env, scm_exp_get_record_predicate(exp),
+                       scm_record_predicate(rtd, scm_exp_get_record_predicate(exp)));
+    i = 0;
+    FOREACH_LIST(spec, specs) {
+        scm_env_define_var(env, scm_exp_get_field_spec_accessor(spec),
+                           scm_record_accessor(rtd, scm_exp_get_field_spec_accessor(spec), i));
+        modifier = scm_exp_get_field_spec_modifier(spec);
+        if (modifier)
+            scm_env_define_var(env, modifier, scm_record_modifier(rtd, modifier, i));
         ++i;
     }
-    *n = i;
-    return head;
+    return scm_void;
+}
+
+/* the arguments of most calls fit on the stack */
+#define ARGS_SMALL  8
+
+static int count_operands(scm_object *exp) {
+    scm_object *p = scm_exp_get_application_operands(exp);
+    int n = 0;
+
+    for (; p->type == scm_type_pair; p = scm_cdr(p))
+        ++n;
+    return n;
+}
+
+static void eval_operands(scm_object *exp, scm_object *env, scm_object **args) {
+    scm_object *p = scm_exp_get_application_operands(exp);
+    int i = 0;
+
+    for (; p->type == scm_type_pair; p = scm_cdr(p))
+        args[i++] = scm_eval(scm_car(p), env);
 }
 
 static scm_object *eval_core_syntax(scm_object *o, scm_object *exp, scm_object *env) {
@@ -393,10 +436,24 @@ static scm_object *eval_application(scm_object *opt, scm_object *exp, scm_object
         scm_error_object(exp, "#%%app: not a procedure;\nexpected a procedure "
                          "that can be applied to arguments\ngiven: ");
 
-    int n = 0;
-    scm_object *opds = eval_operands(exp, env, &n);
-    
-    return scm_apply(opt, n, opds);
+    scm_object *small[ARGS_SMALL], **args, *val = NULL;
+    int n = count_operands(exp);
+
+    if (n <= ARGS_SMALL) {
+        eval_operands(exp, env, small);
+        return scm_apply(opt, n, small);
+    }
+    /* the malloc'ed array must not leak when an operand or the call throws */
+    args = malloc(n * sizeof(scm_object *));
+    SCM_TRY {
+        eval_operands(exp, env, args);
+        val = scm_apply(opt, n, args);
+    } SCM_CATCH {
+        free(args);
+        SCM_THROW;
+    } SCM_END_TRY;
+    free(args);
+    return val;
 }
 
 static scm_object *eval_syntax_or_application(scm_object *exp, scm_object *env) {
@@ -434,18 +491,95 @@ scm_object *scm_eval(scm_object *exp, scm_object *env) {
     return NULL;
 }
 
-scm_object *scm_apply(scm_object *opt, int n, scm_object *opds) {
+scm_object *scm_apply(scm_object *opt, int n, scm_object **args) {
     scm_procedure_check_arity(opt, n);
     if (opt->type == scm_type_primitive) {
-        scm_procedure_check_contract(opt, opds);
-        return scm_primitive_apply(opt, n, opds);
+        scm_procedure_check_contract(opt, n, args);
+        return scm_primitive_apply(opt, n, args);
     }
     else {
-        return scm_compound_apply(opt, opds);
+        return scm_compound_apply(opt, n, args);
+    }
+}
+
+/* the operands of most maps fit on the stack */
+#define MAP_SMALL   4
+
+/* the elements at index @k of the @n vectors in @seqs, or the cars of the
+ * lists left in @cur, which move on, into @opds; 0 if one has run out */
+static int map_next(const char *name, int vectors, int n, scm_object **seqs, scm_object **cur,
+                    scm_object **opds, long k, long len) {
+    if (vectors) {
+        if (k == len)
+            return 0;
+        for (int i = 0; i < n; ++i)
+            opds[i] = scm_vector_elements(seqs[i])[k];
+        return 1;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (cur[i]->type != scm_type_pair) {
+            if (cur[i] != scm_null)
+                scm_contract_violation(name, i + 2, "list?", seqs[i]);
+            return 0;
+        }
+        opds[i] = scm_car(cur[i]);
+        cur[i] = scm_cdr(cur[i]);
+    }
+    return 1;
+}
+
+scm_object *scm_map(const char *name, int n, scm_object **args, int vectors, int collect) {
+    scm_object *proc = args[0], **seqs = args + 1;
+    scm_object *small[2 * MAP_SMALL], **cur, **opds;
+    scm_object *val, *r = vectors || !collect ? scm_void : scm_null, *tail = NULL, *q;
+    int ns = n - 1, i;
+    long len = -1;
+
+    if (proc->type != scm_type_primitive && proc->type != scm_type_compound)
+        scm_contract_violation(name, 1, "procedure?", proc);
+    if (vectors) {
+        for (i = 0; i < ns; ++i) {
+            if (seqs[i]->type != scm_type_vector)
+                scm_contract_violation(name, i + 2, "vector?", seqs[i]);
+            if (len < 0 || scm_vector_length(seqs[i]) < len)
+                len = scm_vector_length(seqs[i]);
+        }
+        if (collect)
+            r = len ? scm_vector_alloc(len) : scm_empty_vector;
     }
+
+    cur = ns <= MAP_SMALL ? small : malloc(2 * ns * sizeof(scm_object *));
+    opds = cur + ns;
+    for (i = 0; i < ns; ++i)
+        cur[i] = seqs[i];
+    /* the malloc'ed array must not leak when @proc or a list check throws */
+    SCM_TRY {
+        for (long k = 0; map_next(name, vectors, ns, seqs, cur, opds, k, len); ++k) {
+            val = scm_apply(proc, ns, opds);
+            if (!collect)
+                continue;
+            if (vectors) {
+                scm_vector_elements(r)[k] = val;
+                continue;
+            }
+            q = scm_cons(val, scm_null);
+            if (tail)
+                scm_set_cdr(tail, q);
+            else
+                r = q;
+            tail = q;
+        }
+    } SCM_CATCH {
+        if (cur != small)
+            free(cur);
+        SCM_THROW;
+    } SCM_END_TRY;
+    if (cur != small)
+        free(cur);
+    return r;
 }
 
-static scm_object_methods core_syntax_methods = { core_syntax_free, same_object, same_object };
+static scm_object_methods core_syntax_methods = { core_syntax_free, same_object, same_object, NULL, NULL };
 
 static int initialized = 0;
 
@@ -469,6 +603,8 @@ int scm_eval_init_env(scm_object *env) {
     scm_env_define_var(env, sym_let_syntax, core_syntax_new(sym_let_syntax, eval_let_syntax));
     scm_env_define_var(env, sym_letrec_syntax, core_syntax_new(sym_letrec_syntax, eval_letrec_syntax));
     scm_env_define_var(env, sym_define_syntax, core_syntax_new(sym_define_syntax, eval_define_syntax));
+    scm_env_define_var(env, sym_define_record_type, core_syntax_new(sym_define_record_type,
+                                                                    eval_define_record_type));
     scm_env_define_var(env, sym_unquote, core_syntax_new(sym_unquote, eval_unquote));
     scm_env_define_var(env, sym_unquote_splicing, core_syntax_new(sym_unquote_splicing, eval_unquote_splicing));
 
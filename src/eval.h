@@ -4,7 +4,12 @@
 
 scm_object *scm_eval(scm_object *exp, scm_object *env);
 scm_object *scm_eval_sequence(scm_object *exp, scm_object *env);
-scm_object *scm_apply(scm_object *opt, int n, scm_object *opds);
+/* the @n arguments in @args */
+scm_object *scm_apply(scm_object *opt, int n, scm_object **args);
+/* calls the procedure args[0] on the elements at each position of the lists,
+ * or the @vectors, in the rest of the @n @args, up to the end of the shortest
+ * one; the results in a list or vector if @collect */
+scm_object *scm_map(const char *name, int n, scm_object **args, int vectors, int collect);
 
 int scm_eval_init(void);
 int scm_eval_init_env(scm_object *env);
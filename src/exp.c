@@ -35,6 +35,7 @@ scm_object *sym_cond_apply = NULL;
 scm_object *sym_let_syntax = NULL;
 scm_object *sym_letrec_syntax = NULL;
 scm_object *sym_define_syntax = NULL;
+scm_object *sym_define_record_type = NULL;
 scm_object *sym_syntax_rules = NULL;
 scm_object *sym_ellipsis = NULL;
 scm_object *sym_underscore = NULL;
@@ -63,6 +64,10 @@ static void app_error(scm_object *exp, const char *err) {
     scm_error_object(exp, "#%%app: %s in: ", err);
 }
 
+static void record_error(scm_object *exp, const char *err) {
+    scm_error_object(exp, "define-record-type: %s in: ", err);
+}
+
 static void syntax_rules_error(scm_object *exp, const char *err) {
     scm_error_object(exp, "syntax-rules: %s in: ", err);
 }
@@ -365,6 +370,72 @@ void scm_exp_check_define_syntax(scm_object *exp) {
     check_macro_binding(scm_cdr(exp));
 }
 
+/* (define-record-type <name> (<constructor> <field> ...) <pred> <field spec> ...)
+ * <field spec>: (<field> <accessor>) or (<field> <accessor> <modifier>) */
+void scm_exp_check_define_record_type(scm_object *exp) {
+    scm_object *o, *l;
+
+    if (scm_list_length(exp) < 4)
+        record_error(exp, "bad syntax");
+    if (!IS_IDENTIFIER(scm_cadr(exp)))
+        record_error(scm_cadr(exp), "not an identifier");
+
+    o = scm_caddr(exp);
+    if (scm_list_length(o) < 1)
+        record_error(o, "bad constructor spec");
+    FOREACH_LIST(id, o) {
+        if (!IS_IDENTIFIER(id))
+            record_error(id, "not an identifier");
+    }
+
+    if (!IS_IDENTIFIER(scm_cadddr(exp)))
+        record_error(scm_cadddr(exp), "not an identifier");
+
+    l = scm_cddddr(exp);
+    FOREACH_LIST(spec, l) {
+        int len = scm_list_length(spec);
+        if (len != 2 && len != 3)
+            record_error(spec, "bad field spec");
+        o = spec;
+        FOREACH_LIST(id, o) {
+            if (!IS_IDENTIFIER(id))
+                record_error(id, "not an identifier");
+        }
+    }
+}
+
+scm_object *scm_exp_get_record_type_name(scm_object *exp) {
+    return scm_cadr(exp);
+}
+
+scm_object *scm_exp_get_record_constructor(scm_object *exp) {
+    return scm_car(scm_caddr(exp));
+}
+
+scm_object *scm_exp_get_record_constructor_fields(scm_object *exp) {
+    return scm_cdr(scm_caddr(exp));
+}
+
+scm_object *scm_exp_get_record_predicate(scm_object *exp) {
+    return scm_cadddr(exp);
+}
+
+scm_object *scm_exp_get_record_field_specs(scm_object *exp) {
+    return scm_cddddr(exp);
+}
+
+scm_object *scm_exp_get_field_spec_field(scm_object *spec) {
+    return scm_car(spec);
+}
+
+scm_object *scm_exp_get_field_spec_accessor(scm_object *spec) {
+    return scm_cadr(spec);
+}
+
+/* NULL if without */
+scm_object *scm_exp_get_field_spec_modifier(scm_object *spec) {
+    return scm_cddr(spec) == scm_null ? NULL : scm_caddr(spec);
+}
 
 scm_object *scm_exp_get_spec_first_rule(scm_object *exp) {
     return scm_car(exp);
@@ -454,6 +525,7 @@ int scm_exp_init(void) {
     sym_let_syntax = scm_symbol_new("let-syntax", 10);
     sym_letrec_syntax = scm_symbol_new("letrec-syntax", 13);
     sym_define_syntax = scm_symbol_new("define-syntax", 13);
+    sym_define_record_type = scm_symbol_new("define-record-type", 18);
     sym_syntax_rules = scm_symbol_new("syntax-rules", 12);
     sym_ellipsis = scm_symbol_new("...", 3);
     sym_underscore = scm_symbol_new("_", 1);
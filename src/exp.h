@@ -28,6 +28,7 @@ extern scm_object *sym_cond_apply;
 extern scm_object *sym_let_syntax;
 extern scm_object *sym_letrec_syntax;
 extern scm_object *sym_define_syntax;
+extern scm_object *sym_define_record_type;
 extern scm_object *sym_syntax_rules;
 extern scm_object *sym_ellipsis;
 extern scm_object *sym_underscore;
@@ -70,6 +71,15 @@ scm_object *scm_exp_get_application_operands(scm_object *exp);
 void scm_exp_check_let_syntax(scm_object *exp);
 void scm_exp_check_letrec_syntax(scm_object *exp);
 void scm_exp_check_define_syntax(scm_object *exp);
+void scm_exp_check_define_record_type(scm_object *exp);
+scm_object *scm_exp_get_record_type_name(scm_object *exp);
+scm_object *scm_exp_get_record_constructor(scm_object *exp);
+scm_object *scm_exp_get_record_constructor_fields(scm_object *exp);
+scm_object *scm_exp_get_record_predicate(scm_object *exp);
+scm_object *scm_exp_get_record_field_specs(scm_object *exp);
+scm_object *scm_exp_get_field_spec_field(scm_object *spec);
+scm_object *scm_exp_get_field_spec_accessor(scm_object *spec);
+scm_object *scm_exp_get_field_spec_modifier(scm_object *spec);
 scm_object *scm_exp_get_spec_first_rule(scm_object *exp);
 int scm_exp_is_spec_empty_rules(scm_object *exp);
 scm_object *scm_exp_get_spec_keyword(scm_object *exp);
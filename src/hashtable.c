@@ -0,0 +1,567 @@
+#include "hashtable.h"
+#include "number.h"
+#include "pair.h"
+#include "symbol.h"
+#include "proc.h"
+#include "env.h"
+#include "err.h"
+#include "eval.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* open addressing with robin-hood probing: an entry being inserted takes
+ * the slot of any entry nearer to its home slot, so probe lengths stay
+ * short and even, and a lookup stops at the first entry nearer to its home
+ * than the key would be
+ *
+ * a table that fills up moves to a new array of twice the size a few slots
+ * at a time, so that no single insertion pays for rehashing all the
+ * entries; until the old array is drained both are searched */
+
+typedef enum {
+    kind_eqv,
+    kind_equal,
+    kind_custom,    /* by the procedures */
+} hash_kind;
+
+typedef struct entry_st {
+    scm_object *key;    /* NULL if empty */
+    scm_object *val;
+    size_t hash;
+} entry;
+
+typedef struct scm_hashtable_st {
+    scm_object base;
+    hash_kind kind;
+    scm_object *equiv;
+    scm_object *hash;   /* NULL for the builtin hashes */
+    entry *slots;
+    size_t mask;
+    long count;
+    /* the array being moved, which only loses entries */
+    entry *old;
+    size_t old_mask;
+    size_t migrated;    /* old slots before this are done */
+    long old_count;
+} scm_hashtable;
+
+#define MIN_CAPACITY    8
+/* old slots moved by each insertion or deletion, more than the 1 per 7/8
+ * insertions which drains the old array before the new one fills up */
+#define MIGRATE_STEP    8
+#define too_full(count, mask)   ((size_t)(count) * 8 > ((mask) + 1) * 7)
+
+/* marks the entries deleted or moved from the old array, whose hashes
+ * still count for the probe distances */
+static scm_object tombstone_obj;
+#define TOMBSTONE (&tombstone_obj)
+
+#define dist(hash, i, mask)     (((i) - ((hash) & (mask))) & (mask))
+
+scm_object *pred_hashtable = NULL;
+
+static entry *slots_new(size_t capacity) {
+    return calloc(capacity, sizeof(entry));
+}
+
+static scm_object *hashtable_alloc(hash_kind kind, scm_object *equiv, scm_object *hash) {
+    scm_hashtable *t = malloc(sizeof(scm_hashtable));
+
+    t->base.type = scm_type_hashtable;
+    t->kind = kind;
+    t->equiv = equiv;
+    t->hash = hash;
+    t->slots = slots_new(MIN_CAPACITY);
+    t->mask = MIN_CAPACITY - 1;
+    t->count = 0;
+    t->old = NULL;
+    t->old_mask = 0;
+    t->migrated = 0;
+    t->old_count = 0;
+
+    return (scm_object *)t;
+}
+
+scm_object *scm_eqv_hashtable_new(void) {
+    return hashtable_alloc(kind_eqv, NULL, NULL);
+}
+
+scm_object *scm_equal_hashtable_new(void) {
+    return hashtable_alloc(kind_equal, NULL, NULL);
+}
+
+static int is_primitive(scm_object *proc, const char *name) {
+    return proc->type == scm_type_primitive && !strcmp(scm_procedure_name(proc), name);
+}
+
+scm_object *scm_hashtable_new(scm_object *equiv, scm_object *hash) {
+    hash_kind kind = kind_custom;
+
+    if (is_primitive(equiv, "eq?") || is_primitive(equiv, "eqv?"))
+        kind = kind_eqv;
+    else if (is_primitive(equiv, "equal?"))
+        kind = kind_equal;
+    return hashtable_alloc(hash ? kind_custom : kind, equiv, hash);
+}
+
+static size_t hash_of(scm_hashtable *t, scm_object *key) {
+    scm_object *opds[] = { key };
+
+    switch (t->kind) {
+    case kind_eqv:
+        return scm_eqv_hash(key);
+    case kind_equal:
+        return scm_equal_hash(key);
+    default:
+        if (t->hash)
+            return scm_eqv_hash(scm_apply(t->hash, 1, opds));
+        return scm_equal_hash(key);
+    }
+}
+
+static int same_key(scm_hashtable *t, scm_object *k1, scm_object *k2) {
+    scm_object *opds[] = { k1, k2 };
+
+    switch (t->kind) {
+    case kind_eqv:
+        return k1 == k2 || scm_eqv(k1, k2);
+    case kind_equal:
+        return k1 == k2 || scm_equal(k1, k2);
+    default:
+        return scm_apply(t->equiv, 2, opds) != scm_false;
+    }
+}
+
+static entry *slots_lookup(scm_hashtable *t, entry *slots, size_t mask,
+                           scm_object *key, size_t h) {
+    size_t i = h & mask, d = 0;
+    entry *e;
+
+    for (;; i = (i + 1) & mask, ++d) {
+        e = slots + i;
+        if (!e->key || dist(e->hash, i, mask) < d)
+            return NULL;
+        if (e->hash == h && e->key != TOMBSTONE && same_key(t, e->key, key))
+            return e;
+    }
+}
+
+/* @key must not be there, and there must be a free slot */
+static void slots_insert(entry *slots, size_t mask, scm_object *key, scm_object *val, size_t h) {
+    entry in = { key, val, h }, tmp;
+    size_t i = h & mask, d = 0, ed;
+    entry *e;
+
+    for (;; i = (i + 1) & mask, ++d) {
+        e = slots + i;
+        if (!e->key) {
+            *e = in;
+            return;
+        }
+        ed = dist(e->hash, i, mask);
+        if (ed < d) {
+            tmp = *e;
+            *e = in;
+            in = tmp;
+            d = ed;
+        }
+    }
+}
+
+/* shift the following entries back instead of leaving a tombstone */
+static void slots_remove(entry *slots, size_t mask, entry *e) {
+    size_t i = e - slots, j;
+
+    for (;; i = j) {
+        j = (i + 1) & mask;
+        if (!slots[j].key || dist(slots[j].hash, j, mask) == 0)
+            break;
+        slots[i] = slots[j];
+    }
+    slots[i].key = NULL;
+    slots[i].val = NULL;
+}
+
+static void migrate(scm_hashtable *t, size_t n) {
+    entry *e;
+
+    while (t->old && n--) {
+        e = t->old + t->migrated;
+        if (e->key && e->key != TOMBSTONE) {
+            slots_insert(t->slots, t->mask, e->key, e->val, e->hash);
+            ++t->count;
+            --t->old_count;
+            e->key = TOMBSTONE;
+        }
+        if (++t->migrated > t->old_mask || t->old_count == 0) {
+            free(t->old);
+            t->old = NULL;
+            t->old_count = 0;
+        }
+    }
+}
+
+static void grow(scm_hashtable *t) {
+    size_t capacity = (t->mask + 1) * 2;
+
+    migrate(t, (size_t)-1);
+    t->old = t->slots;
+    t->old_mask = t->mask;
+    t->old_count = t->count;
+    t->migrated = 0;
+    t->slots = slots_new(capacity);
+    t->mask = capacity - 1;
+    t->count = 0;
+}
+
+static entry *lookup(scm_hashtable *t, scm_object *key, size_t h) {
+    entry *e = slots_lookup(t, t->slots, t->mask, key, h);
+    if (!e && t->old)
+        e = slots_lookup(t, t->old, t->old_mask, key, h);
+    return e;
+}
+
+scm_object *scm_hashtable_ref(scm_object *table, scm_object *key, scm_object *dflt) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    entry *e = lookup(t, key, hash_of(t, key));
+    return e ? e->val : dflt;
+}
+
+void scm_hashtable_set(scm_object *table, scm_object *key, scm_object *val) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    size_t h = hash_of(t, key);
+    entry *e = lookup(t, key, h);
+
+    if (e) {
+        e->val = val;
+        return;
+    }
+    if (too_full(t->count + t->old_count + 1, t->mask))
+        grow(t);
+    slots_insert(t->slots, t->mask, key, val, h);
+    ++t->count;
+    migrate(t, MIGRATE_STEP);
+}
+
+int scm_hashtable_delete(scm_object *table, scm_object *key) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    size_t h = hash_of(t, key);
+    entry *e = slots_lookup(t, t->slots, t->mask, key, h);
+
+    if (e) {
+        slots_remove(t->slots, t->mask, e);
+        --t->count;
+    }
+    else if (t->old && (e = slots_lookup(t, t->old, t->old_mask, key, h))) {
+        e->key = TOMBSTONE;
+        e->val = NULL;
+        --t->old_count;
+    }
+    migrate(t, MIGRATE_STEP);
+    return e != NULL;
+}
+
+void scm_hashtable_clear(scm_object *table) {
+    scm_hashtable *t = (scm_hashtable *)table;
+
+    free(t->slots);
+    free(t->old);
+    t->slots = slots_new(MIN_CAPACITY);
+    t->mask = MIN_CAPACITY - 1;
+    t->count = 0;
+    t->old = NULL;
+    t->migrated = 0;
+    t->old_count = 0;
+}
+
+long scm_hashtable_count(scm_object *table) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    return t->count + t->old_count;
+}
+
+scm_object *scm_hashtable_copy(scm_object *table) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    scm_hashtable *c = malloc(sizeof(scm_hashtable));
+
+    *c = *t;
+    c->slots = malloc((t->mask + 1) * sizeof(entry));
+    memcpy(c->slots, t->slots, (t->mask + 1) * sizeof(entry));
+    if (t->old) {
+        c->old = malloc((t->old_mask + 1) * sizeof(entry));
+        memcpy(c->old, t->old, (t->old_mask + 1) * sizeof(entry));
+    }
+    return (scm_object *)c;
+}
+
+static scm_object *slots_to_alist(entry *slots, size_t mask, scm_object *l) {
+    for (size_t i = 0; i <= mask; ++i) {
+        if (slots[i].key && slots[i].key != TOMBSTONE)
+            l = scm_cons(scm_cons(slots[i].key, slots[i].val), l);
+    }
+    return l;
+}
+
+scm_object *scm_hashtable_to_alist(scm_object *table) {
+    scm_hashtable *t = (scm_hashtable *)table;
+    scm_object *l = slots_to_alist(t->slots, t->mask, scm_null);
+    if (t->old)
+        l = slots_to_alist(t->old, t->old_mask, l);
+    return l;
+}
+
+static void hashtable_free(scm_object *obj) {
+    scm_hashtable *t = (scm_hashtable *)obj;
+    free(t->slots);
+    free(t->old);
+    free(t);
+}
+
+/* primitives */
+static scm_object *prim_is_hashtable(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(args[0]->type == scm_type_hashtable);
+}
+
+static void check_procedure(const char *name, int argno, scm_object *obj) {
+    if (obj->type != scm_type_primitive && obj->type != scm_type_compound)
+        scm_contract_violation(name, argno, "procedure?", obj);
+}
+
+static scm_object *prim_make_hash_table(int n, scm_object **args) {
+    if (n == 0)
+        return scm_equal_hashtable_new();
+    check_procedure("make-hash-table", 1, args[0]);
+    if (n == 2)
+        check_procedure("make-hash-table", 2, args[1]);
+    return scm_hashtable_new(args[0], n == 2 ? args[1] : NULL);
+}
+
+static scm_object *prim_make_eqv_hash_table(int n, scm_object **args) {
+    (void)n; (void)args;
+    return scm_eqv_hashtable_new();
+}
+
+static scm_object *prim_make_equal_hash_table(int n, scm_object **args) {
+    (void)n; (void)args;
+    return scm_equal_hashtable_new();
+}
+
+static scm_object *prim_alist_to_hash_table(int n, scm_object **args) {
+    scm_object *l = args[0], *table, *p;
+
+    if (scm_list_length(l) < 0)
+        scm_contract_violation("alist->hash-table", 1, "list?", l);
+    table = prim_make_hash_table(n - 1, args + 1);
+    /* the first association of a key wins */
+    while (l != scm_null) {
+        p = scm_car(l);
+        if (p->type != scm_type_pair)
+            scm_contract_violation("alist->hash-table", 1, "(listof pair?)", args[0]);
+        if (!scm_hashtable_ref(table, scm_car(p), NULL))
+            scm_hashtable_set(table, scm_car(p), scm_cdr(p));
+        l = scm_cdr(l);
+    }
+    return table;
+}
+
+static scm_object *prim_hash_table_ref(int n, scm_object **args) {
+    scm_object *key = args[1];
+    scm_object *val = scm_hashtable_ref(args[0], key, NULL);
+
+    if (val)
+        return val;
+    if (n == 3) {
+        check_procedure("hash-table-ref", 3, args[2]);
+        return scm_apply(args[2], 0, NULL);
+    }
+    scm_error_object(key, "hash-table-ref: no value found for key\nkey: ");
+    return NULL;
+}
+
+static scm_object *prim_hash_table_ref_default(int n, scm_object **args) {
+    (void)n;
+    return scm_hashtable_ref(args[0], args[1], args[2]);
+}
+
+static scm_object *prim_hash_table_set(int n, scm_object **args) {
+    (void)n;
+    scm_hashtable_set(args[0], args[1], args[2]);
+    return scm_void;
+}
+
+static scm_object *prim_hash_table_delete(int n, scm_object **args) {
+    (void)n;
+    scm_hashtable_delete(args[0], args[1]);
+    return scm_void;
+}
+
+static scm_object *prim_hash_table_exists(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(scm_hashtable_ref(args[0], args[1], NULL) != NULL);
+}
+
+static scm_object *prim_hash_table_update(int n, scm_object **args) {
+    scm_object *table = args[0], *key = args[1], *proc = args[2];
+    scm_object *val;
+
+    check_procedure("hash-table-update!", 3, proc);
+    val = scm_hashtable_ref(table, key, NULL);
+    if (!val) {
+        if (n < 4)
+            scm_error_object(key, "hash-table-update!: no value found for key\nkey: ");
+        check_procedure("hash-table-update!", 4, args[3]);
+        val = scm_apply(args[3], 0, NULL);
+    }
+    scm_hashtable_set(table, key, scm_apply(proc, 1, &val));
+    return scm_void;
+}
+
+static scm_object *prim_hash_table_update_default(int n, scm_object **args) {
+    scm_object *table = args[0], *key = args[1], *proc = args[2];
+    (void)n;
+
+    check_procedure("hash-table-update!/default", 3, proc);
+    scm_object *val = scm_hashtable_ref(table, key, args[3]);
+    scm_hashtable_set(table, key, scm_apply(proc, 1, &val));
+    return scm_void;
+}
+
+static scm_object *prim_hash_table_size(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(scm_hashtable_count(args[0]));
+}
+
+static scm_object *prim_hash_table_keys(int n, scm_object **args) {
+    scm_object *l = scm_hashtable_to_alist(args[0]);
+    (void)n;
+    for (scm_object *p = l; p != scm_null; p = scm_cdr(p))
+        scm_set_car(p, scm_caar(p));
+    return l;
+}
+
+static scm_object *prim_hash_table_values(int n, scm_object **args) {
+    scm_object *l = scm_hashtable_to_alist(args[0]);
+    (void)n;
+    for (scm_object *p = l; p != scm_null; p = scm_cdr(p))
+        scm_set_car(p, scm_cdar(p));
+    return l;
+}
+
+static scm_object *prim_hash_table_to_alist(int n, scm_object **args) {
+    (void)n;
+    return scm_hashtable_to_alist(args[0]);
+}
+
+/* over a snapshot, so that the procedure may change the table */
+static scm_object *prim_hash_table_walk(int n, scm_object **args) {
+    scm_object *proc = args[1], *p, *opds[2];
+    (void)n;
+
+    check_procedure("hash-table-walk", 2, proc);
+    for (scm_object *l = scm_hashtable_to_alist(args[0]); l != scm_null; l = scm_cdr(l)) {
+        p = scm_car(l);
+        opds[0] = scm_car(p);
+        opds[1] = scm_cdr(p);
+        scm_apply(proc, 2, opds);
+    }
+    return scm_void;
+}
+
+static scm_object *prim_hash_table_fold(int n, scm_object **args) {
+    scm_object *proc = args[1], *acc = args[2], *p, *opds[3];
+    (void)n;
+
+    check_procedure("hash-table-fold", 2, proc);
+    for (scm_object *l = scm_hashtable_to_alist(args[0]); l != scm_null; l = scm_cdr(l)) {
+        p = scm_car(l);
+        opds[0] = scm_car(p);
+        opds[1] = scm_cdr(p);
+        opds[2] = acc;
+        acc = scm_apply(proc, 3, opds);
+    }
+    return acc;
+}
+
+static scm_object *prim_hash_table_copy(int n, scm_object **args) {
+    (void)n;
+    return scm_hashtable_copy(args[0]);
+}
+
+static scm_object *prim_hash_table_clear(int n, scm_object **args) {
+    (void)n;
+    scm_hashtable_clear(args[0]);
+    return scm_void;
+}
+
+/* hashes as non-negative fixnums, optionally below a bound */
+static scm_object *hash_result(const char *name, int n, scm_object **args, size_t h) {
+    scm_object *bound;
+
+    h >>= 2;
+    if (n == 2) {
+        bound = args[1];
+        if (bound->type != scm_type_integer || scm_integer_get_val(bound) <= 0)
+            scm_contract_violation(name, 2, "exact-positive-integer?", bound);
+        h %= (size_t)scm_integer_get_val(bound);
+    }
+    return INTEGER((long)h);
+}
+
+static scm_object *prim_hash(int n, scm_object **args) {
+    return hash_result("hash", n, args, scm_equal_hash(args[0]));
+}
+
+static scm_object *prim_hash_by_identity(int n, scm_object **args) {
+    return hash_result("hash-by-identity", n, args, scm_eqv_hash(args[0]));
+}
+
+static scm_object *prim_string_hash(int n, scm_object **args) {
+    return hash_result("string-hash", n, args, scm_equal_hash(args[0]));
+}
+
+static scm_object_methods hashtable_methods = { hashtable_free, same_object, same_object, NULL, NULL };
+
+static int initialized = 0;
+
+int scm_hashtable_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_hashtable, &hashtable_methods);
+    pred_hashtable = scm_type_predicate_new("hash-table?", prim_is_hashtable,
+                                            SCM_TYPE_BIT(scm_type_hashtable));
+
+    initialized = 1;
+    return 0;
+}
+
+int scm_hashtable_init_env(scm_object *env) {
+    scm_object *pred_table = scm_list(1, pred_hashtable);
+
+    scm_env_define_var(env, scm_symbol_new("hash-table?", -1), pred_hashtable);
+    scm_env_add_prim(env, "make-hash-table", prim_make_hash_table, 0, 2, NULL);
+    scm_env_add_prim(env, "make-eq-hash-table", prim_make_eqv_hash_table, 0, 0, NULL);
+    scm_env_add_prim(env, "make-eqv-hash-table", prim_make_eqv_hash_table, 0, 0, NULL);
+    scm_env_add_prim(env, "make-equal-hash-table", prim_make_equal_hash_table, 0, 0, NULL);
+    scm_env_add_prim(env, "alist->hash-table", prim_alist_to_hash_table, 1, 3, NULL);
+    scm_env_add_prim(env, "hash-table-ref", prim_hash_table_ref, 2, 3, pred_table);
+    scm_env_add_prim(env, "hash-table-ref/default", prim_hash_table_ref_default, 3, 3, pred_table);
+    scm_env_add_prim(env, "hash-table-set!", prim_hash_table_set, 3, 3, pred_table);
+    scm_env_add_prim(env, "hash-table-delete!", prim_hash_table_delete, 2, 2, pred_table);
+    scm_env_add_prim(env, "hash-table-exists?", prim_hash_table_exists, 2, 2, pred_table);
+    scm_env_add_prim(env, "hash-table-update!", prim_hash_table_update, 3, 4, pred_table);
+    scm_env_add_prim(env, "hash-table-update!/default", prim_hash_table_update_default, 4, 4, pred_table);
+    scm_env_add_prim(env, "hash-table-size", prim_hash_table_size, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash-table-keys", prim_hash_table_keys, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash-table-values", prim_hash_table_values, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash-table->alist", prim_hash_table_to_alist, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash-table-walk", prim_hash_table_walk, 2, 2, pred_table);
+    scm_env_add_prim(env, "hash-table-fold", prim_hash_table_fold, 3, 3, pred_table);
+    scm_env_add_prim(env, "hash-table-copy", prim_hash_table_copy, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash-table-clear!", prim_hash_table_clear, 1, 1, pred_table);
+    scm_env_add_prim(env, "hash", prim_hash, 1, 2, NULL);
+    scm_env_add_prim(env, "hash-by-identity", prim_hash_by_identity, 1, 2, NULL);
+    scm_env_add_prim(env, "string-hash", prim_string_hash, 1, 2, scm_list(1, pred_string));
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef SCHEME_HASHTABLE_H
+#define SCHEME_HASHTABLE_H
+#include "object.h"
+
+/* hash tables keyed by eqv?, equal? or any equivalence procedure and a
+ * hash procedure consistent with it (SRFI-69)
+ * eq? is the same as eqv? here, so eq? tables are eqv? ones */
+
+extern scm_object *pred_hashtable;
+
+scm_object *scm_eqv_hashtable_new(void);
+scm_object *scm_equal_hashtable_new(void);
+/* @equiv and @hash are procedures, and @hash may be NULL if @equiv is one of
+ * eq?, eqv? and equal? */
+scm_object *scm_hashtable_new(scm_object *equiv, scm_object *hash);
+scm_object *scm_hashtable_copy(scm_object *table);
+
+/* @dflt if not found, which may be NULL */
+scm_object *scm_hashtable_ref(scm_object *table, scm_object *key, scm_object *dflt);
+void scm_hashtable_set(scm_object *table, scm_object *key, scm_object *val);
+/* 1 if @key was there */
+int scm_hashtable_delete(scm_object *table, scm_object *key);
+void scm_hashtable_clear(scm_object *table);
+long scm_hashtable_count(scm_object *table);
+/* ((key . val) ...) in no particular order */
+scm_object *scm_hashtable_to_alist(scm_object *table);
+
+int scm_hashtable_init(void);
+int scm_hashtable_init_env(scm_object *env);
+
+#endif /* SCHEME_HASHTABLE_H */
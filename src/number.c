@@ -1,12 +1,20 @@
 #include "number.h"
+#include "bignum.h"
+#include "rational.h"
 #include "proc.h"
 #include "env.h"
+#include "err.h"
+#include "port.h"
+#include "read.h"
+#include "string.h"
 
 #include <errno.h>
 #include <math.h>
 #include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
 /* complex = 2 real objects combination
@@ -16,7 +24,9 @@
  * rational = 2 integer objects combination
  * exact order  : integer -> rational -> complex, can auto-degrade
  * inexact order: float -> complex, can't auto-degrade
- * exact -> inexact */
+ * exact -> inexact
+ * integers beyond the range of a long are bignums, see bignum.c, and the
+ * rationals are in rational.c */
 
 typedef struct scm_integer_st {
     scm_object base;
@@ -44,14 +54,12 @@ scm_object *scm_number_new_integer(const char *num, int radix) {
 
     errno = 0;
     i->val = strtol(num, NULL, radix);
-    if (errno == ERANGE) {  /* TODO: support bn */
-        goto err;
+    if (errno == ERANGE) {
+        free(i);
+        return scm_bignum_from_string(num, strlen(num), radix);
     }
 
     return (scm_object *)i;
-err:
-    free(i);
-    return NULL;
 }
 
 scm_object *scm_number_new_float_from_integer(const char *num, int radix) {
@@ -62,15 +70,15 @@ scm_object *scm_number_new_float_from_integer(const char *num, int radix) {
 
     errno = 0;
     val = strtol(num, NULL, radix);
-    if (errno == ERANGE) {  /* TODO: support bn */
-        goto err;
+    if (errno == ERANGE) {
+        scm_object *big = scm_bignum_from_string(num, strlen(num), radix);
+        f->val = scm_bignum_to_double(big);
+        scm_object_free(big);
     }
-    f->val = (double)val;   /* XXX: lost precision */
+    else
+        f->val = (double)val;   /* XXX: lost precision */
 
     return (scm_object *)f;
-err:
-    free(f);
-    return NULL;
 }
 
 scm_object *scm_number_new_float(const char *num) {
@@ -109,8 +117,127 @@ err:
     return NULL;
 }
 
+/* see pow5.c */
+extern const uint64_t scm_pow5_128[][2];
+
+/* 64x64 -> 128 bits multiplication */
+static void mul128(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo) {
+    uint64_t a0 = (uint32_t)a, a1 = a >> 32;
+    uint64_t b0 = (uint32_t)b, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+
+    *lo = (mid << 32) | (uint32_t)p00;
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+
+static int leading_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & (1ULL << 63))) {
+        x <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/* returned by eisel_lemire, a NaN pattern it never makes otherwise */
+#define EISEL_LEMIRE_FAIL   UINT64_MAX
+
+/* Eisel-Lemire algorithm: the binary64 nearest to w * 10^q, or
+ * EISEL_LEMIRE_FAIL when the 128-bit product cannot decide the rounding.
+ * w must be the exact non-zero decimal significand, with at most 19 digits */
+static uint64_t eisel_lemire(uint64_t w, long q) {
+    uint64_t hi, lo, hi2, lo2, mant;
+    long power2;
+    int lz, upper, shift;
+
+    if (q < -342)
+        return 0;
+    if (q > 308)
+        return 0x7FFULL << 52;  /* infinity */
+
+    lz = leading_zeros(w);
+    w <<= lz;
+    mul128(w, scm_pow5_128[q + 342][0], &hi, &lo);
+    /* the lower half of the power matters only when the 55 bits we need
+     * might be affected by a carry */
+    if ((hi & 0x1FF) == 0x1FF) {
+        mul128(w, scm_pow5_128[q + 342][1], &hi2, &lo2);
+        lo += hi2;
+        if (hi2 > lo)
+            ++hi;
+        /* the truncated rest of the power might still carry */
+        if ((hi & 0x1FF) == 0x1FF && lo + 1 == 0 && lo2 + w < w)
+            return EISEL_LEMIRE_FAIL;
+    }
+
+    upper = hi >> 63;
+    shift = upper + 9;
+    mant = hi >> shift;
+    /* floor(log2(10^q)) + 63 plus the bias */
+    power2 = (((152170 + 65536) * q) >> 16) + 63 + upper - lz + 1023;
+
+    if (power2 <= 0) {  /* subnormal */
+        if (-power2 + 1 >= 64)
+            return 0;
+        mant >>= -power2 + 1;
+        mant += mant & 1;
+        mant >>= 1;
+        /* rounding may have carried it into the normal range */
+        power2 = mant < (1ULL << 52) ? 0 : 1;
+        return mant | ((uint64_t)power2 << 52);
+    }
+
+    /* exactly halfway between two doubles: round to even, which the
+     * product only tells for small powers */
+    if (lo <= 1 && (mant & 3) == 1 && (mant << shift) == hi) {
+        if (q < -4 || q > 23)
+            return EISEL_LEMIRE_FAIL;
+        mant &= ~1ULL;
+    }
+
+    mant += mant & 1;
+    mant >>= 1;
+    if (mant >= (2ULL << 52)) {
+        mant = 1ULL << 52;
+        ++power2;
+    }
+    mant &= ~(1ULL << 52);
+    if (power2 >= 0x7FF)
+        return 0x7FFULL << 52;
+
+    return mant | ((uint64_t)power2 << 52);
+}
+
+/* convert the exact decimal significand @mant and exponent @exp10 collected
+ * by the lexer into a double, without going through the text.
+ * return 1 when the result overflows or underflows, and -1 when the caller
+ * must convert the text itself */
+int scm_number_decimal_to_double(unsigned long mant, long exp10, int neg, double *val) {
+    uint64_t bits = 0;
+    double d;
+
+    if (mant) {
+        bits = eisel_lemire(mant, exp10);
+        if (bits == EISEL_LEMIRE_FAIL)
+            return -1;
+        if (bits == 0 || bits == 0x7FFULL << 52)
+            return 1;
+    }
+    if (neg)
+        bits |= 1ULL << 63;
+
+    memcpy(&d, &bits, sizeof(d));
+    *val = d;
+    return 0;
+}
+
 static scm_object *scm_is_exact(scm_object *obj) {
-    return scm_boolean(obj->type == scm_type_integer);
+    return scm_boolean(obj->type != scm_type_float);
 }
 define_primitive_1(is_exact);
 
@@ -119,6 +246,375 @@ static scm_object *scm_is_inexact(scm_object *obj) {
 }
 define_primitive_1(is_inexact);
 
+/* cached powers of ten for Grisu: normalized 64-bit significand and binary
+ * exponent of 10^k for k = -348, -340, ..., 340 */
+static const struct {
+    uint64_t f;
+    int e;
+} cached_pow10[] = {
+    {0xfa8fd5a0081c0288ULL, -1220}, /* 10^-348 */
+    {0xbaaee17fa23ebf76ULL, -1193}, /* 10^-340 */
+    {0x8b16fb203055ac76ULL, -1166}, /* 10^-332 */
+    {0xcf42894a5dce35eaULL, -1140}, /* 10^-324 */
+    {0x9a6bb0aa55653b2dULL, -1113}, /* 10^-316 */
+    {0xe61acf033d1a45dfULL, -1087}, /* 10^-308 */
+    {0xab70fe17c79ac6caULL, -1060}, /* 10^-300 */
+    {0xff77b1fcbebcdc4fULL, -1034}, /* 10^-292 */
+    {0xbe5691ef416bd60cULL, -1007}, /* 10^-284 */
+    {0x8dd01fad907ffc3cULL, -980}, /* 10^-276 */
+    {0xd3515c2831559a83ULL, -954}, /* 10^-268 */
+    {0x9d71ac8fada6c9b5ULL, -927}, /* 10^-260 */
+    {0xea9c227723ee8bcbULL, -901}, /* 10^-252 */
+    {0xaecc49914078536dULL, -874}, /* 10^-244 */
+    {0x823c12795db6ce57ULL, -847}, /* 10^-236 */
+    {0xc21094364dfb5637ULL, -821}, /* 10^-228 */
+    {0x9096ea6f3848984fULL, -794}, /* 10^-220 */
+    {0xd77485cb25823ac7ULL, -768}, /* 10^-212 */
+    {0xa086cfcd97bf97f4ULL, -741}, /* 10^-204 */
+    {0xef340a98172aace5ULL, -715}, /* 10^-196 */
+    {0xb23867fb2a35b28eULL, -688}, /* 10^-188 */
+    {0x84c8d4dfd2c63f3bULL, -661}, /* 10^-180 */
+    {0xc5dd44271ad3cdbaULL, -635}, /* 10^-172 */
+    {0x936b9fcebb25c996ULL, -608}, /* 10^-164 */
+    {0xdbac6c247d62a584ULL, -582}, /* 10^-156 */
+    {0xa3ab66580d5fdaf6ULL, -555}, /* 10^-148 */
+    {0xf3e2f893dec3f126ULL, -529}, /* 10^-140 */
+    {0xb5b5ada8aaff80b8ULL, -502}, /* 10^-132 */
+    {0x87625f056c7c4a8bULL, -475}, /* 10^-124 */
+    {0xc9bcff6034c13053ULL, -449}, /* 10^-116 */
+    {0x964e858c91ba2655ULL, -422}, /* 10^-108 */
+    {0xdff9772470297ebdULL, -396}, /* 10^-100 */
+    {0xa6dfbd9fb8e5b88fULL, -369}, /* 10^-92 */
+    {0xf8a95fcf88747d94ULL, -343}, /* 10^-84 */
+    {0xb94470938fa89bcfULL, -316}, /* 10^-76 */
+    {0x8a08f0f8bf0f156bULL, -289}, /* 10^-68 */
+    {0xcdb02555653131b6ULL, -263}, /* 10^-60 */
+    {0x993fe2c6d07b7facULL, -236}, /* 10^-52 */
+    {0xe45c10c42a2b3b06ULL, -210}, /* 10^-44 */
+    {0xaa242499697392d3ULL, -183}, /* 10^-36 */
+    {0xfd87b5f28300ca0eULL, -157}, /* 10^-28 */
+    {0xbce5086492111aebULL, -130}, /* 10^-20 */
+    {0x8cbccc096f5088ccULL, -103}, /* 10^-12 */
+    {0xd1b71758e219652cULL, -77}, /* 10^-4 */
+    {0x9c40000000000000ULL, -50}, /* 10^4 */
+    {0xe8d4a51000000000ULL, -24}, /* 10^12 */
+    {0xad78ebc5ac620000ULL, 3}, /* 10^20 */
+    {0x813f3978f8940984ULL, 30}, /* 10^28 */
+    {0xc097ce7bc90715b3ULL, 56}, /* 10^36 */
+    {0x8f7e32ce7bea5c70ULL, 83}, /* 10^44 */
+    {0xd5d238a4abe98068ULL, 109}, /* 10^52 */
+    {0x9f4f2726179a2245ULL, 136}, /* 10^60 */
+    {0xed63a231d4c4fb27ULL, 162}, /* 10^68 */
+    {0xb0de65388cc8ada8ULL, 189}, /* 10^76 */
+    {0x83c7088e1aab65dbULL, 216}, /* 10^84 */
+    {0xc45d1df942711d9aULL, 242}, /* 10^92 */
+    {0x924d692ca61be758ULL, 269}, /* 10^100 */
+    {0xda01ee641a708deaULL, 295}, /* 10^108 */
+    {0xa26da3999aef774aULL, 322}, /* 10^116 */
+    {0xf209787bb47d6b85ULL, 348}, /* 10^124 */
+    {0xb454e4a179dd1877ULL, 375}, /* 10^132 */
+    {0x865b86925b9bc5c2ULL, 402}, /* 10^140 */
+    {0xc83553c5c8965d3dULL, 428}, /* 10^148 */
+    {0x952ab45cfa97a0b3ULL, 455}, /* 10^156 */
+    {0xde469fbd99a05fe3ULL, 481}, /* 10^164 */
+    {0xa59bc234db398c25ULL, 508}, /* 10^172 */
+    {0xf6c69a72a3989f5cULL, 534}, /* 10^180 */
+    {0xb7dcbf5354e9beceULL, 561}, /* 10^188 */
+    {0x88fcf317f22241e2ULL, 588}, /* 10^196 */
+    {0xcc20ce9bd35c78a5ULL, 614}, /* 10^204 */
+    {0x98165af37b2153dfULL, 641}, /* 10^212 */
+    {0xe2a0b5dc971f303aULL, 667}, /* 10^220 */
+    {0xa8d9d1535ce3b396ULL, 694}, /* 10^228 */
+    {0xfb9b7cd9a4a7443cULL, 720}, /* 10^236 */
+    {0xbb764c4ca7a44410ULL, 747}, /* 10^244 */
+    {0x8bab8eefb6409c1aULL, 774}, /* 10^252 */
+    {0xd01fef10a657842cULL, 800}, /* 10^260 */
+    {0x9b10a4e5e9913129ULL, 827}, /* 10^268 */
+    {0xe7109bfba19c0c9dULL, 853}, /* 10^276 */
+    {0xac2820d9623bf429ULL, 880}, /* 10^284 */
+    {0x80444b5e7aa7cf85ULL, 907}, /* 10^292 */
+    {0xbf21e44003acdd2dULL, 933}, /* 10^300 */
+    {0x8e679c2f5e44ff8fULL, 960}, /* 10^308 */
+    {0xd433179d9c8cb841ULL, 986}, /* 10^316 */
+    {0x9e19db92b4e31ba9ULL, 1013}, /* 10^324 */
+    {0xeb96bf6ebadf77d9ULL, 1039}, /* 10^332 */
+    {0xaf87023b9bf0ee6bULL, 1066}, /* 10^340 */
+};
+
+static const uint64_t pow10_64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+/* a floating point number f * 2^e with a 64-bit significand */
+typedef struct diy_fp_st {
+    uint64_t f;
+    int e;
+} diy_fp;
+
+static diy_fp diy_fp_mul(diy_fp x, diy_fp y) {
+    diy_fp r;
+    uint64_t hi, lo;
+
+    mul128(x.f, y.f, &hi, &lo);
+    r.f = hi + (lo >> 63);  /* round */
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+static diy_fp diy_fp_normalize(diy_fp x) {
+    int lz = leading_zeros(x.f);
+    x.f <<= lz;
+    x.e -= lz;
+    return x;
+}
+
+/* move the last digit down while that keeps the digits within the interval
+ * and brings them closer to w, which lies @wp_w below the upper end.
+ * distances are known to within @unit, return 0 when that is not enough to
+ * tell the digits round-trip and are the closest */
+static int grisu_round(char *buf, int len, uint64_t wp_w, uint64_t delta, uint64_t rest,
+                       uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small = wp_w - unit, big = wp_w + unit;
+
+    while (rest < small && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < small || small - rest >= rest + ten_kappa - small)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+    /* would the digit move down once more for w as far as it could be? */
+    if (rest < big && delta - rest >= ten_kappa &&
+        (rest + ten_kappa < big || big - rest > rest + ten_kappa - big))
+        return 0;
+    return 2 * unit <= rest && rest <= delta - 4 * unit;
+}
+
+/* generate the digits of @w, between @mm and @mp, widening the interval by
+ * the one unit the products may be off; return 0 when they cannot be
+ * trusted */
+static int grisu_digits(diy_fp mm, diy_fp w, diy_fp mp, char *buf, int *len, int *k) {
+    int shift = -w.e, kappa = 0;
+    uint64_t one = 1ULL << shift, unit = 1, tmp;
+    uint64_t too_high = mp.f + unit, delta = too_high - (mm.f - unit);
+    uint32_t p1 = too_high >> shift, d;
+    uint64_t p2 = too_high & (one - 1);
+
+    while (kappa < 10 && p1 >= pow10_64[kappa])
+        ++kappa;
+
+    *len = 0;
+    while (kappa > 0) {
+        d = p1 / pow10_64[kappa - 1];
+        p1 %= pow10_64[kappa - 1];
+        if (d || *len)
+            buf[(*len)++] = '0' + d;
+        --kappa;
+        tmp = ((uint64_t)p1 << shift) + p2;
+        if (tmp < delta) {
+            *k += kappa;
+            return grisu_round(buf, *len, too_high - w.f, delta, tmp,
+                               pow10_64[kappa] << shift, unit);
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        unit *= 10;
+        delta *= 10;
+        d = p2 >> shift;
+        if (d || *len)
+            buf[(*len)++] = '0' + d;
+        p2 &= one - 1;
+        --kappa;
+        if (p2 < delta) {
+            *k += kappa;
+            return grisu_round(buf, *len, (too_high - w.f) * unit, delta, p2, one, unit);
+        }
+    }
+}
+
+/* Grisu3: the shortest digit string that reads back as the positive finite
+ * @val and is the closest to it, such that val = digits * 10^k.
+ * return the number of digits, or -1 for the about 0.5% of doubles where
+ * the 64-bit arithmetic cannot guarantee the result */
+static int grisu3(double val, char *buf, int *k) {
+    uint64_t bits;
+    diy_fp v, plus, minus, c;
+    int index, len;
+    double dk;
+
+    memcpy(&bits, &val, sizeof(bits));
+    v.f = bits & ((1ULL << 52) - 1);
+    if (bits >> 52) {
+        v.f += 1ULL << 52;
+        v.e = (int)(bits >> 52) - 1075;
+    }
+    else {
+        v.e = -1074;
+    }
+
+    /* boundaries: halfway to the neighbouring doubles */
+    plus.f = (v.f << 1) + 1;
+    plus.e = v.e - 1;
+    plus = diy_fp_normalize(plus);
+    if (v.f == 1ULL << 52) {
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    else {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    /* a power of ten bringing the product's exponent into [-60, -32] */
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    index = (int)dk;
+    if (dk - index > 0.0)
+        ++index;
+    index = (index >> 3) + 1;
+    *k = -(-348 + index * 8);
+    c.f = cached_pow10[index].f;
+    c.e = cached_pow10[index].e;
+
+    v = diy_fp_mul(diy_fp_normalize(v), c);
+    plus = diy_fp_mul(plus, c);
+    minus = diy_fp_mul(minus, c);
+    return grisu_digits(minus, v, plus, buf, &len, k) ? len : -1;
+}
+
+static int reads_back(double val, const char *digits, int len, int k) {
+    char tmp[32];
+
+    snprintf(tmp, sizeof(tmp), "%.*se%d", len, digits, k);
+    return strtod(tmp, NULL) == val;
+}
+
+/* the shortest digits of @val for the doubles Grisu3 gives up on, from
+ * printf and strtod, which are exact but slow */
+static int exact_digits(double val, char *buf, int *k) {
+    char tmp[32];
+    int len, i;
+
+    for (len = 1; ; ++len) {
+        snprintf(tmp, sizeof(tmp), "%.*e", len - 1, val);
+        buf[0] = tmp[0];
+        memcpy(buf + 1, tmp + 2, len - 1);
+        *k = atoi(strchr(tmp, 'e') + 1) - (len - 1);
+        if (len == 17 || reads_back(val, buf, len, *k))
+            break;
+        /* below a power of two the lower neighbour is twice as near, and
+         * the digits above may still read back when the nearest do not */
+        if (strtod(tmp, NULL) > val)
+            continue;
+        for (i = len - 1; i >= 0 && buf[i] == '9'; --i)
+            buf[i] = '0';
+        if (i < 0) {
+            buf[0] = '1';
+            ++*k;
+        }
+        else {
+            buf[i]++;
+        }
+        if (reads_back(val, buf, len, *k))
+            break;
+    }
+    while (len > 1 && buf[len - 1] == '0') {
+        --len;
+        ++*k;
+    }
+    return len;
+}
+
+static int format_exponent(char *buf, int e) {
+    char *s = buf;
+    *s++ = 'e';
+    if (e < 0) {
+        *s++ = '-';
+        e = -e;
+    }
+    else {
+        *s++ = '+';
+    }
+    if (e >= 100) {
+        *s++ = '0' + e / 100;
+        e %= 100;
+    }
+    *s++ = '0' + e / 10;
+    *s++ = '0' + e % 10;
+    return s - buf;
+}
+
+/* format like "%.16g" does, but with the shortest digits that round-trip,
+ * and ".0" on integral values so they still read back as inexact */
+static int format_float(double val, char *buf) {
+    char digits[24], *s = buf;
+    int len, k, kk;
+
+    if (isnan(val)) {
+        memcpy(buf, "+nan.0", 7);
+        return 6;
+    }
+    if (isinf(val)) {
+        memcpy(buf, val > 0 ? "+inf.0" : "-inf.0", 7);
+        return 6;
+    }
+
+    if (signbit(val)) {
+        *s++ = '-';
+        val = -val;
+    }
+    if (val == 0) {
+        memcpy(s, "0.0", 4);
+        return s - buf + 3;
+    }
+
+    len = grisu3(val, digits, &k);
+    if (len < 0)
+        len = exact_digits(val, digits, &k);
+    kk = len + k;   /* val = 0.digits * 10^kk */
+
+    if (kk < -3 || kk > 16) {
+        *s++ = digits[0];
+        if (len > 1) {
+            *s++ = '.';
+            memcpy(s, digits + 1, len - 1);
+            s += len - 1;
+        }
+        s += format_exponent(s, kk - 1);
+    }
+    else if (kk >= len) {
+        memcpy(s, digits, len);
+        s += len;
+        memset(s, '0', kk - len);
+        s += kk - len;
+        *s++ = '.';
+        *s++ = '0';
+    }
+    else if (kk > 0) {
+        memcpy(s, digits, kk);
+        s += kk;
+        *s++ = '.';
+        memcpy(s, digits + kk, len - kk);
+        s += len - kk;
+    }
+    else {
+        *s++ = '0';
+        *s++ = '.';
+        memset(s, '0', -kk);
+        s += -kk;
+        memcpy(s, digits, len);
+        s += len;
+    }
+
+    *s = '\0';
+    return s - buf;
+}
+
 static int log2n(int x) {
     int result = -1;
     while (x > 0) {
@@ -128,7 +624,8 @@ static int log2n(int x) {
     return result;
 }
 
-static void ulong_to_string(unsigned long val, char *buf, int radix) {
+static int ulong_to_string(unsigned long val, char *buf, int radix) {
+    char *s = buf;
     int bits_per_digit = log2n(radix);
     int bits = sizeof(unsigned long) * 8;
     int r = bits % bits_per_digit;
@@ -139,61 +636,75 @@ static void ulong_to_string(unsigned long val, char *buf, int radix) {
     for (bits -= r; bits >= 0; bits = bits - bits_per_digit) {
         int c = (val >> bits) & mask;
         if (c || has_digit) {
-            *buf++ = chars[c];
+            *s++ = chars[c];
             has_digit = 1;
         }
     }
     assert(bits == 0 - bits_per_digit);
 
     if (!has_digit) {
-        *buf++ = '0';
+        *s++ = '0';
     }
-    *buf = '\0';
+    *s = '\0';
+    return s - buf;
 }
 
-char *scm_number_to_string(scm_object *obj, int radix) {
-    char *buf, *s;
-    buf = malloc(256+2);
-    s = buf;
+static int ulong_to_decimal(unsigned long val, char *buf) {
+    char tmp[24];
+    int n = 0;
+
+    do {
+        tmp[n++] = '0' + val % 10;
+        val /= 10;
+    } while (val);
 
+    for (int i = 0; i < n; i++)
+        buf[i] = tmp[n - 1 - i];
+    buf[n] = '\0';
+    return n;
+}
+
+int scm_number_format(scm_object *obj, int radix, char *buf) {
+    if (obj->type == scm_type_bignum || obj->type == scm_type_rational)
+        return -1;
     if (obj->type == scm_type_integer) {
-        scm_integer *i = (scm_integer *)obj;
-        unsigned long val;
+        long ival = ((scm_integer *)obj)->val;
+        unsigned long val = ival;
+        int sign = 0;
+
+        if (ival < 0) {
+            buf[0] = '-';
+            sign = 1;
+            val = -val;
+        }
         switch (radix) {
         case 16:
         case 8:
         case 2:
-            if (i->val < 0) {
-                buf[0] = '-';
-                ++s;
-                val = -i->val;
-            }
-            else {
-                val = i->val;
-            }
-            ulong_to_string(val, s, radix);
-            break;
+            return sign + ulong_to_string(val, buf + sign, radix);
         default: /* 10 */
-            (void) snprintf(buf, 256, "%ld", i->val);
-            break;
-        }
-    }
-    else {
-        if (radix != 10) {
-            free(buf);
-            return NULL;    /* inexact number only support radix 10 */
-        }
-        scm_float *f = (scm_float *)obj;
-        (void) snprintf(buf, 256, "%.16g", f->val);
-        /* add .0 if it looks like an integer */
-        while (*s != 'E' && *s != 'e' && *s != '.') {
-            if (*s++ == 0) {
-                sprintf(s-1, ".0");
-                break;
-            }
+            return sign + ulong_to_decimal(val, buf + sign);
         }
     }
 
+    if (radix != 10)
+        return -1;  /* inexact number only support radix 10 */
+    return format_float(((scm_float *)obj)->val, buf);
+}
+
+char *scm_number_to_string(scm_object *obj, int radix) {
+    char *buf;
+
+    if (obj->type == scm_type_bignum)
+        return scm_bignum_to_string(obj, radix);
+    if (obj->type == scm_type_rational)
+        return scm_rational_to_string(obj, radix);
+    buf = malloc(SCM_NUMBER_BUF_SIZE);
+
+    if (scm_number_format(obj, radix, buf) < 0) {
+        free(buf);
+        return NULL;
+    }
     return buf;
 }
 
@@ -215,8 +726,11 @@ scm_object *FLOAT(double n) {
     return (scm_object *)i;
 }
 
+/* bignums saturate, which is enough for sizes and indices */
 long scm_integer_get_val(scm_object *obj) {
     scm_integer *i = (scm_integer *)obj;
+    if (obj->type == scm_type_bignum)
+        return scm_bignum_sign(obj) < 0 ? LONG_MIN : LONG_MAX;
     return i->val;
 }
 
@@ -235,6 +749,891 @@ double scm_float_get_val(scm_object *obj) {
     return f->val;
 }
 
+/* arithmetic
+ * the primitives check their arguments themselves instead of going through
+ * predicate contracts, and handle integer x integer and float x float
+ * directly before falling back to the mixed cases */
+#if !defined(__GNUC__) && !defined(__clang__)
+int scm_add_overflow(long a, long b, long *r) {
+    if ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b))
+        return 1;
+    *r = a + b;
+    return 0;
+}
+
+int scm_sub_overflow(long a, long b, long *r) {
+    if ((b < 0 && a > LONG_MAX + b) || (b > 0 && a < LONG_MIN + b))
+        return 1;
+    *r = a - b;
+    return 0;
+}
+
+int scm_mul_overflow(long a, long b, long *r) {
+    if (a && b && ((a == -1 && b == LONG_MIN) || (b == -1 && a == LONG_MIN) ||
+                   (a != -1 && b != -1 && (a * b) / b != a)))
+        return 1;
+    *r = a * b;
+    return 0;
+}
+#endif
+
+#define is_integer(obj) ((obj)->type == scm_type_integer || (obj)->type == scm_type_bignum)
+#define is_exact(obj) (is_integer(obj) || (obj)->type == scm_type_rational)
+#define is_number(obj) (is_exact(obj) || (obj)->type == scm_type_float)
+#define ival(obj) (((scm_integer *)(obj))->val)
+#define fval(obj) (((scm_float *)(obj))->val)
+
+static double to_double(scm_object *obj) {
+    switch (obj->type) {
+    case scm_type_integer:
+        return (double)ival(obj);
+    case scm_type_bignum:
+        return scm_bignum_to_double(obj);
+    case scm_type_rational:
+        return scm_rational_to_double(obj);
+    default:
+        return fval(obj);
+    }
+}
+
+double scm_number_to_double(scm_object *obj) {
+    return to_double(obj);
+}
+
+static void check_number(const char *name, int i, scm_object *obj) {
+    if (!is_number(obj))
+        scm_contract_violation(name, i, "number?", obj);
+}
+
+/* integers of either exactness */
+static int is_integral(scm_object *obj) {
+    if (is_integer(obj))
+        return 1;
+    return obj->type == scm_type_float && isfinite(fval(obj)) && fval(obj) == floor(fval(obj));
+}
+
+static void check_integer(const char *name, int i, scm_object *obj) {
+    if (!is_integral(obj))
+        scm_contract_violation(name, i, "integer?", obj);
+}
+
+static void division_by_zero(const char *name) {
+    scm_error("%s: undefined for 0", name);
+}
+
+enum {
+    op_add,
+    op_sub,
+    op_mul,
+    op_div,
+};
+
+static const char *op_names[] = { "+", "-", "*", "/" };
+
+/* running result of an n-ary operation, exact until an inexact operand
+ * exact values other than fixnums are kept in @exact */
+typedef struct num_acc_st {
+    int inexact;
+    long i;
+    scm_object *exact;
+    double f;
+} num_acc;
+
+static void acc_init(num_acc *acc, scm_object *obj) {
+    acc->inexact = obj->type == scm_type_float;
+    acc->exact = NULL;
+    if (acc->inexact)
+        acc->f = fval(obj);
+    else if (obj->type != scm_type_integer)
+        acc->exact = obj;
+    else
+        acc->i = ival(obj);
+}
+
+/* the accumulator and @obj are exact */
+static void acc_apply_exact(num_acc *acc, int op, scm_object *obj) {
+    scm_object *a = acc->exact ? acc->exact : INTEGER(acc->i), *r;
+
+    switch (op) {
+    case op_add:
+        r = scm_rational_add(a, obj);
+        break;
+    case op_sub:
+        r = scm_rational_sub(a, obj);
+        break;
+    case op_mul:
+        r = scm_rational_mul(a, obj);
+        break;
+    default:
+        if (scm_rational_sign(obj) == 0)
+            division_by_zero(op_names[op]);
+        r = scm_rational_div(a, obj);
+        break;
+    }
+
+    acc->exact = NULL;
+    if (r->type == scm_type_integer)
+        acc->i = ival(r);
+    else
+        acc->exact = r;
+}
+
+static void acc_apply(num_acc *acc, int op, scm_object *obj) {
+    long v, r = 0;
+    int overflow = 0;
+    double d;
+
+    if (!acc->inexact && !acc->exact && obj->type == scm_type_integer) {
+        v = ival(obj);
+        switch (op) {
+        case op_add:
+            overflow = scm_add_overflow(acc->i, v, &r);
+            break;
+        case op_sub:
+            overflow = scm_sub_overflow(acc->i, v, &r);
+            break;
+        case op_mul:
+            overflow = scm_mul_overflow(acc->i, v, &r);
+            break;
+        default:
+            if (v == 0)
+                division_by_zero(op_names[op]);
+            /* LONG_MIN / -1 and fractions go the exact way */
+            if ((v == -1 && acc->i == LONG_MIN) || acc->i % v != 0)
+                overflow = 1;
+            else
+                r = acc->i / v;
+            break;
+        }
+        if (!overflow) {
+            acc->i = r;
+            return;
+        }
+    }
+
+    if (!acc->inexact && is_exact(obj)) {
+        acc_apply_exact(acc, op, obj);
+        return;
+    }
+
+    if (!acc->inexact) {
+        acc->inexact = 1;
+        acc->f = acc->exact ? to_double(acc->exact) : (double)acc->i;
+    }
+    d = to_double(obj);
+    switch (op) {
+    case op_add:
+        acc->f += d;
+        break;
+    case op_sub:
+        acc->f -= d;
+        break;
+    case op_mul:
+        acc->f *= d;
+        break;
+    default:
+        acc->f /= d;
+        break;
+    }
+}
+
+static scm_object *acc_result(num_acc *acc) {
+    if (acc->inexact)
+        return FLOAT(acc->f);
+    return acc->exact ? acc->exact : INTEGER(acc->i);
+}
+
+/* fold the arguments from @init, or from the first one when there're
+ * more than one and @init is NULL */
+static scm_object *arith(int op, int n, scm_object **args, scm_object *init) {
+    const char *name = op_names[op];
+    scm_object *a, *b;
+    num_acc acc;
+    long r;
+    int i = 0;
+
+    if (n == 2) {
+        a = args[0];
+        b = args[1];
+        if (a->type == scm_type_integer && b->type == scm_type_integer) {
+            switch (op) {
+            case op_add:
+                if (!scm_add_overflow(ival(a), ival(b), &r))
+                    return INTEGER(r);
+                break;
+            case op_sub:
+                if (!scm_sub_overflow(ival(a), ival(b), &r))
+                    return INTEGER(r);
+                break;
+            case op_mul:
+                if (!scm_mul_overflow(ival(a), ival(b), &r))
+                    return INTEGER(r);
+                break;
+            }
+        }
+        else if (a->type == scm_type_float && b->type == scm_type_float) {
+            switch (op) {
+            case op_add:
+                return FLOAT(fval(a) + fval(b));
+            case op_sub:
+                return FLOAT(fval(a) - fval(b));
+            case op_mul:
+                return FLOAT(fval(a) * fval(b));
+            default:
+                return FLOAT(fval(a) / fval(b));
+            }
+        }
+    }
+
+    if (init == NULL) {
+        a = args[i++];
+        check_number(name, i, a);
+        acc_init(&acc, a);
+    }
+    else {
+        acc_init(&acc, init);
+    }
+
+    for (; i < n; ++i) {
+        a = args[i];
+        check_number(name, i + 1, a);
+        acc_apply(&acc, op, a);
+    }
+    return acc_result(&acc);
+}
+
+static scm_object *integer_zero = NULL;
+static scm_object *integer_one = NULL;
+
+static scm_object *prim_add(int n, scm_object **args) {
+    return arith(op_add, n, args, integer_zero);
+}
+
+static scm_object *prim_mul(int n, scm_object **args) {
+    return arith(op_mul, n, args, integer_one);
+}
+
+/* negation is not 0 - x, which would give 0.0 for -0.0 */
+static scm_object *prim_sub(int n, scm_object **args) {
+    if (n == 1) {
+        check_number("-", 1, args[0]);
+        if (args[0]->type == scm_type_float)
+            return FLOAT(-fval(args[0]));
+        return scm_rational_neg(args[0]);
+    }
+    return arith(op_sub, n, args, NULL);
+}
+
+static scm_object *prim_div(int n, scm_object **args) {
+    return arith(op_div, n, args, n == 1 ? integer_one : NULL);
+}
+
+/* an exact number against a float, exactly */
+static int exact_float_cmp(scm_object *a, double y) {
+    if (isnan(y))
+        return 2;
+    if (isinf(y))
+        return y > 0 ? -1 : 1;
+    return scm_rational_cmp(a, scm_rational_from_double(y));
+}
+
+/* -1, 0, 1 like strcmp, 2 when unordered (nan) */
+static int num_cmp(scm_object *a, scm_object *b) {
+    int c;
+
+    if (a->type == scm_type_integer && b->type == scm_type_integer)
+        return (ival(a) > ival(b)) - (ival(a) < ival(b));
+    if (is_exact(a) && is_exact(b))
+        return scm_rational_cmp(a, b);
+    if (a->type == scm_type_bignum || a->type == scm_type_rational)
+        return exact_float_cmp(a, fval(b));
+    if (b->type == scm_type_bignum || b->type == scm_type_rational) {
+        c = exact_float_cmp(b, fval(a));
+        return c == 2 ? c : -c;
+    }
+
+    double x = to_double(a), y = to_double(b);
+    if (x < y)
+        return -1;
+    if (x > y)
+        return 1;
+    if (x == y)
+        return 0;
+    return 2;
+}
+
+enum {
+    cmp_eq,
+    cmp_lt,
+    cmp_gt,
+    cmp_le,
+    cmp_ge,
+};
+
+static scm_object *compare(const char *name, int cmp, int n, scm_object **args) {
+    scm_object *a = args[0], *b;
+    int result = 1, c, i;
+
+    check_number(name, 1, a);
+    for (i = 1; i < n; ++i) {
+        b = args[i];
+        check_number(name, i + 1, b);
+        if (result) {
+            c = num_cmp(a, b);
+            switch (cmp) {
+            case cmp_eq:
+                result = c == 0;
+                break;
+            case cmp_lt:
+                result = c == -1;
+                break;
+            case cmp_gt:
+                result = c == 1;
+                break;
+            case cmp_le:
+                result = c == -1 || c == 0;
+                break;
+            default:
+                result = c == 1 || c == 0;
+                break;
+            }
+        }
+        a = b;
+    }
+    return scm_boolean(result);
+}
+
+#define define_compare(fn, name, cmp) \
+    static scm_object *prim_##fn(int n, scm_object **args) { \
+        return compare(name, cmp, n, args); \
+    }
+
+define_compare(num_eq, "=", cmp_eq);
+define_compare(num_lt, "<", cmp_lt);
+define_compare(num_gt, ">", cmp_gt);
+define_compare(num_le, "<=", cmp_le);
+define_compare(num_ge, ">=", cmp_ge);
+
+static scm_object *extremum(const char *name, int max, int n, scm_object **args) {
+    scm_object *a = args[0], *b;
+    int inexact, i;
+
+    check_number(name, 1, a);
+    inexact = a->type == scm_type_float;
+    for (i = 1; i < n; ++i) {
+        b = args[i];
+        check_number(name, i + 1, b);
+        inexact |= b->type == scm_type_float;
+        if (num_cmp(b, a) == (max ? 1 : -1) || (b->type == scm_type_float && isnan(fval(b))))
+            a = b;
+    }
+    /* inexact contagion */
+    if (inexact && is_exact(a))
+        return FLOAT(to_double(a));
+    return a;
+}
+
+static scm_object *prim_max(int n, scm_object **args) {
+    return extremum("max", 1, n, args);
+}
+
+static scm_object *prim_min(int n, scm_object **args) {
+    return extremum("min", 0, n, args);
+}
+
+#define define_sign_predicate(fn, name, exp) \
+    static scm_object *prim_##fn(int n, scm_object **args) { \
+        (void)n; \
+        scm_object *obj = args[0]; \
+        check_number(name, 1, obj); \
+        if (is_exact(obj)) { \
+            long x = scm_rational_sign(obj); \
+            return scm_boolean(exp); \
+        } \
+        else { \
+            double x = fval(obj); \
+            return scm_boolean(exp); \
+        } \
+    }
+
+define_sign_predicate(is_zero, "zero?", x == 0);
+define_sign_predicate(is_positive, "positive?", x > 0);
+define_sign_predicate(is_negative, "negative?", x < 0);
+
+static scm_object *prim_is_odd(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    check_integer("odd?", 1, obj);
+    if (obj->type == scm_type_float)
+        return scm_boolean(fmod(fval(obj), 2) != 0);
+    return scm_boolean(scm_bignum_is_odd(obj));
+}
+
+static scm_object *prim_is_even(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    check_integer("even?", 1, obj);
+    if (obj->type == scm_type_float)
+        return scm_boolean(fmod(fval(obj), 2) == 0);
+    return scm_boolean(!scm_bignum_is_odd(obj));
+}
+
+static scm_object *prim_abs(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    check_number("abs", 1, obj);
+    if (obj->type == scm_type_float)
+        return FLOAT(fabs(fval(obj)));
+    return scm_rational_sign(obj) < 0 ? scm_rational_neg(obj) : obj;
+}
+
+enum {
+    div_quotient,
+    div_remainder,
+    div_modulo,
+};
+
+/* of integral doubles, the quotient is exact as @x - @r is a multiple of @y */
+static scm_object *float_division(const char *name, int kind, double x, double y) {
+    double r;
+
+    if (y == 0)
+        division_by_zero(name);
+    r = fmod(x, y);
+    switch (kind) {
+    case div_quotient:
+        return FLOAT((x - r) / y);
+    case div_remainder:
+        return FLOAT(r);
+    default:
+        if (r != 0 && (r < 0) != (y < 0))
+            r += y;
+        return FLOAT(r);
+    }
+}
+
+static scm_object *integer_division(const char *name, int kind, scm_object **args) {
+    scm_object *a = args[0], *b = args[1];
+    long x, y, r;
+
+    scm_object *q, *rem;
+
+    check_integer(name, 1, a);
+    check_integer(name, 2, b);
+    if (a->type == scm_type_float || b->type == scm_type_float)
+        return float_division(name, kind, to_double(a), to_double(b));
+    if (scm_bignum_sign(b) == 0)
+        division_by_zero(name);
+
+    if (a->type == scm_type_bignum || b->type == scm_type_bignum ||
+        (ival(a) == LONG_MIN && ival(b) == -1)) {   /* overflows a long */
+        scm_bignum_divmod(a, b, &q, &rem);
+        if (kind == div_quotient)
+            return q;
+        if (kind == div_modulo && scm_bignum_sign(rem) != 0 &&
+            scm_bignum_sign(rem) != scm_bignum_sign(b))
+            rem = scm_bignum_add(rem, b);
+        return rem;
+    }
+
+    x = ival(a);
+    y = ival(b);
+    switch (kind) {
+    case div_quotient:
+        return INTEGER(x / y);
+    case div_remainder:
+        return INTEGER(x % y);
+    default:
+        r = x % y;
+        if (r != 0 && (r < 0) != (y < 0))
+            r += y;
+        return INTEGER(r);
+    }
+}
+
+static scm_object *prim_quotient(int n, scm_object **args) {
+    (void)n;
+    return integer_division("quotient", div_quotient, args);
+}
+
+static scm_object *prim_remainder(int n, scm_object **args) {
+    (void)n;
+    return integer_division("remainder", div_remainder, args);
+}
+
+static scm_object *prim_modulo(int n, scm_object **args) {
+    (void)n;
+    return integer_division("modulo", div_modulo, args);
+}
+
+static unsigned long ulong_abs(long x) {
+    return x < 0 ? -(unsigned long)x : (unsigned long)x;
+}
+
+static scm_object *exact_abs(scm_object *obj) {
+    return scm_bignum_sign(obj) < 0 ? scm_bignum_neg(obj) : obj;
+}
+
+/* the exact integer of an integral @obj, noting in @inexact if it's not */
+static scm_object *exact_integer_arg(const char *name, int i, scm_object *obj, int *inexact) {
+    check_integer(name, i, obj);
+    if (obj->type != scm_type_float)
+        return obj;
+    *inexact = 1;
+    return scm_bignum_from_double(fval(obj));
+}
+
+static scm_object *prim_gcd(int n, scm_object **args) {
+    scm_object *g = integer_zero, *a;
+    unsigned long x;
+    int inexact = 0;
+
+    for (int i = 0; i < n; ++i) {
+        a = exact_integer_arg("gcd", i + 1, args[i], &inexact);
+        if (g->type == scm_type_integer && a->type == scm_type_integer) {
+            x = scm_ulong_gcd(ulong_abs(ival(g)), ulong_abs(ival(a)));
+            if (x <= LONG_MAX) {
+                g = INTEGER(x);
+                continue;
+            }
+        }
+        g = scm_bignum_gcd(g, a);
+    }
+    return inexact ? FLOAT(to_double(g)) : g;
+}
+
+static scm_object *prim_lcm(int n, scm_object **args) {
+    scm_object *l = integer_one, *x, *q;
+    long r;
+    unsigned long y;
+    int inexact = 0;
+
+    for (int i = 0; i < n; ++i) {
+        x = exact_abs(exact_integer_arg("lcm", i + 1, args[i], &inexact));
+        if (scm_bignum_sign(x) == 0) {
+            l = integer_zero;
+            continue;
+        }
+        if (scm_bignum_sign(l) == 0)
+            continue;
+        if (l->type == scm_type_integer && x->type == scm_type_integer) {
+            y = ival(x);
+            if (!scm_mul_overflow(ival(l) / (long)scm_ulong_gcd(ival(l), y), (long)y, &r)) {
+                l = INTEGER(r);
+                continue;
+            }
+        }
+        scm_bignum_divmod(l, scm_bignum_gcd(l, x), &q, NULL);
+        l = scm_bignum_mul(q, x);
+    }
+    return inexact ? FLOAT(to_double(l)) : l;
+}
+
+#define define_rounding(fn, name, cfn, mode) \
+    static scm_object *prim_##fn(int n, scm_object **args) { \
+        (void)n; \
+        scm_object *obj = args[0]; \
+        check_number(name, 1, obj); \
+        if (is_exact(obj)) \
+            return scm_rational_round(obj, mode); \
+        return FLOAT(cfn(fval(obj))); \
+    }
+
+/* rint rounds half to even in the default rounding mode */
+define_rounding(floor, "floor", floor, scm_rounding_floor);
+define_rounding(ceiling, "ceiling", ceil, scm_rounding_ceiling);
+define_rounding(truncate, "truncate", trunc, scm_rounding_truncate);
+define_rounding(round, "round", rint, scm_rounding_round);
+
+#define define_transcendental(fn, name, cfn) \
+    static scm_object *prim_##fn(int n, scm_object **args) { \
+        (void)n; \
+        scm_object *obj = args[0]; \
+        check_number(name, 1, obj); \
+        return FLOAT(cfn(to_double(obj))); \
+    }
+
+define_transcendental(exp, "exp", exp);
+define_transcendental(log, "log", log);
+define_transcendental(sin, "sin", sin);
+define_transcendental(cos, "cos", cos);
+define_transcendental(tan, "tan", tan);
+define_transcendental(asin, "asin", asin);
+define_transcendental(acos, "acos", acos);
+
+static scm_object *prim_atan(int n, scm_object **args) {
+    scm_object *y = args[0], *x;
+
+    check_number("atan", 1, y);
+    if (n == 1)
+        return FLOAT(atan(to_double(y)));
+    x = args[1];
+    check_number("atan", 2, x);
+    return FLOAT(atan2(to_double(y), to_double(x)));
+}
+
+/* the root of a non-negative exact integer, NULL unless a perfect square */
+static scm_object *exact_integer_sqrt(scm_object *obj) {
+    scm_object *s, *t, *q;
+    double r;
+
+    if (obj->type == scm_type_integer) {
+        long x = ival(obj), s = (long)sqrt((double)x);
+        /* correct the rounding of the double square root */
+        while (s > 0 && s > x / s)
+            --s;
+        while ((s + 1) <= x / (s + 1))
+            ++s;
+        return s * s == x ? INTEGER(s) : NULL;
+    }
+
+    r = sqrt(to_double(obj));
+    if (!isfinite(r))
+        return NULL;
+    /* newton's iteration from above converges to the integer root */
+    s = scm_bignum_add(scm_bignum_from_double(ceil(r * (1 + 0x1p-40))), integer_one);
+    while (1) {
+        scm_bignum_divmod(obj, s, &q, NULL);
+        scm_bignum_divmod(scm_bignum_add(s, q), INTEGER(2), &t, NULL);
+        if (scm_bignum_cmp(t, s) >= 0)
+            break;
+        s = t;
+    }
+    return scm_bignum_cmp(scm_bignum_mul(s, s), obj) == 0 ? s : NULL;
+}
+
+/* exact results for exact perfect squares */
+static scm_object *prim_sqrt(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0], *num, *den;
+
+    check_number("sqrt", 1, obj);
+    if (is_exact(obj) && scm_rational_sign(obj) >= 0) {
+        num = exact_integer_sqrt(scm_rational_numerator(obj));
+        den = num ? exact_integer_sqrt(scm_rational_denominator(obj)) : NULL;
+        if (den)
+            return scm_rational_new(num, den);
+    }
+    return FLOAT(sqrt(to_double(obj)));
+}
+
+/* @base is exact, and non-zero if @k is negative */
+static scm_object *exact_expt(scm_object *base, long k) {
+    scm_object *r = integer_one;
+    int neg = k < 0;
+
+    for (; k; k /= 2) {
+        if (k & 1)
+            r = scm_rational_mul(r, base);
+        if (k > 1 || k < -1)
+            base = scm_rational_mul(base, base);
+    }
+    return neg ? scm_rational_div(integer_one, r) : r;
+}
+
+scm_object *scm_number_exact_decimal(const char *digits, long len, long exp10) {
+    scm_object *obj = scm_bignum_from_string(digits, len, 10);
+    if (exp10 == 0 || scm_bignum_sign(obj) == 0)
+        return obj;
+    return scm_rational_mul(obj, exact_expt(INTEGER(10), exp10));
+}
+
+static scm_object *prim_expt(int n, scm_object **args) {
+    (void)n;
+    scm_object *base = args[0], *e = args[1];
+    long b, k, r = 1;
+
+    check_number("expt", 1, base);
+    check_number("expt", 2, e);
+    if (is_exact(base) && e->type == scm_type_integer) {
+        /* square and multiply, in fixnums until they overflow */
+        if (base->type == scm_type_integer && ival(e) >= 0) {
+            b = ival(base);
+            for (k = ival(e); k; k >>= 1) {
+                if ((k & 1) && scm_mul_overflow(r, b, &r))
+                    break;
+                if (k > 1 && scm_mul_overflow(b, b, &b))
+                    break;
+            }
+            if (!k)
+                return INTEGER(r);
+        }
+        if (ival(e) < 0 && scm_rational_sign(base) == 0)
+            division_by_zero("expt");
+        return exact_expt(base, ival(e));
+    }
+    return FLOAT(pow(to_double(base), to_double(e)));
+}
+
+static scm_object *prim_exact_to_inexact(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    check_number("exact->inexact", 1, obj);
+    if (obj->type == scm_type_float)
+        return obj;
+    return FLOAT(to_double(obj));
+}
+
+static scm_object *prim_inexact_to_exact(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    double d;
+
+    check_number("inexact->exact", 1, obj);
+    if (is_exact(obj))
+        return obj;
+    d = fval(obj);
+    if (!isfinite(d))
+        scm_error_object(obj, "inexact->exact: no exact representation\nnumber: ");
+    return scm_rational_from_double(d);
+}
+
+/* the simplest rational in [@lo, @hi] for 0 < @lo <= @hi, by the
+ * continued fractions of the bounds */
+static scm_object *simplest_rational(scm_object *lo, scm_object *hi) {
+    scm_object *fl = scm_rational_round(lo, scm_rounding_floor);
+
+    if (scm_rational_cmp(fl, lo) == 0)
+        return fl;
+    if (scm_rational_cmp(fl, scm_rational_round(hi, scm_rounding_floor)) < 0)
+        return scm_rational_add(fl, integer_one);
+    return scm_rational_add(fl, scm_rational_div(integer_one, simplest_rational(
+        scm_rational_div(integer_one, scm_rational_sub(hi, fl)),
+        scm_rational_div(integer_one, scm_rational_sub(lo, fl)))));
+}
+
+static scm_object *prim_rationalize(int n, scm_object **args) {
+    (void)n;
+    scm_object *x = args[0], *y = args[1], *lo, *hi, *r;
+    int inexact = x->type == scm_type_float || y->type == scm_type_float;
+    double dx, dy;
+
+    check_number("rationalize", 1, x);
+    check_number("rationalize", 2, y);
+    if (inexact) {
+        dx = to_double(x);
+        dy = to_double(y);
+        if (isnan(dx) || isnan(dy))
+            return FLOAT(NAN);
+        if (isinf(dy))
+            return FLOAT(isinf(dx) ? NAN : 0.0);
+        if (isinf(dx))
+            return x;
+        x = scm_rational_from_double(dx);
+        y = scm_rational_from_double(dy);
+    }
+    if (scm_rational_sign(y) < 0)
+        y = scm_rational_neg(y);
+
+    lo = scm_rational_sub(x, y);
+    hi = scm_rational_add(x, y);
+    if (scm_rational_sign(lo) <= 0 && scm_rational_sign(hi) >= 0)
+        r = integer_zero;
+    else if (scm_rational_sign(hi) < 0)
+        r = scm_rational_neg(simplest_rational(scm_rational_neg(hi), scm_rational_neg(lo)));
+    else
+        r = simplest_rational(lo, hi);
+    return inexact ? FLOAT(to_double(r)) : r;
+}
+
+static scm_object *prim_numerator(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+
+    check_number("numerator", 1, obj);
+    if (is_exact(obj))
+        return scm_rational_numerator(obj);
+    if (!isfinite(fval(obj)))
+        scm_contract_violation("numerator", 1, "rational?", obj);
+    return FLOAT(to_double(scm_rational_numerator(scm_rational_from_double(fval(obj)))));
+}
+
+static scm_object *prim_denominator(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+
+    check_number("denominator", 1, obj);
+    if (is_exact(obj))
+        return scm_rational_denominator(obj);
+    if (!isfinite(fval(obj)))
+        scm_contract_violation("denominator", 1, "rational?", obj);
+    return FLOAT(to_double(scm_rational_denominator(scm_rational_from_double(fval(obj)))));
+}
+
+static int check_radix(const char *name, int n, scm_object **args) {
+    scm_object *obj;
+    long radix;
+
+    if (n < 2)
+        return 10;
+    obj = args[1];
+    radix = obj->type == scm_type_integer ? ival(obj) : 0;
+    if (radix != 2 && radix != 8 && radix != 10 && radix != 16)
+        scm_contract_violation(name, 2, "(or/c 2 8 10 16)", obj);
+    return radix;
+}
+
+static scm_object *prim_number_to_string(int n, scm_object **args) {
+    scm_object *obj = args[0];
+    int radix;
+    char *buf;
+
+    check_number("number->string", 1, obj);
+    radix = check_radix("number->string", n, args);
+    buf = scm_number_to_string(obj, radix);
+    if (!buf) {
+        scm_error_object(obj, "number->string: inexact numbers can only be "
+                         "written in radix 10\nnumber: ");
+    }
+    return scm_string_new(buf, strlen(buf));
+}
+
+/* run the lexer over the text, anything but a single number gives #f */
+static scm_object *prim_string_to_number(int n, scm_object **args) {
+    scm_object *str = args[0], *port, *obj = scm_false;
+    const char *prefix = "";
+    char *buf;
+    long len;
+    int radix;
+
+    if (str->type != scm_type_string)
+        scm_contract_violation("string->number", 1, "string?", str);
+    radix = check_radix("string->number", n, args);
+    if (radix != 10)
+        prefix = radix == 16 ? "#x" : radix == 8 ? "#o" : "#b";
+
+    len = scm_string_size(str);
+    buf = malloc(len + 3);
+    strcpy(buf, prefix);
+    memcpy(buf + strlen(prefix), scm_string_get_str(str), len);
+    len += strlen(prefix);
+
+    port = string_input_port_new(buf, len);
+    SCM_TRY {
+        obj = scm_read(port);
+        if (!is_number(obj) || scm_read(port) != scm_eof)
+            obj = scm_false;
+    } SCM_CATCH {
+        obj = scm_false;
+    } SCM_END_TRY;
+
+    scm_object_free(port);
+    free(buf);
+    return obj;
+}
+
+static scm_object *prim_is_rational(int n, scm_object **args) {
+    (void)n;
+    scm_object *obj = args[0];
+    return scm_boolean(is_exact(obj) ||
+                       (obj->type == scm_type_float && isfinite(fval(obj))));
+}
+
+static scm_object *prim_is_complex(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(is_number(args[0]));
+}
+
 static int integer_eqv(scm_object *o1, scm_object *o2) {
     return ((scm_integer *)o1)->val == ((scm_integer *)o2)->val;
 }
@@ -243,8 +1642,22 @@ static int float_eqv(scm_object *o1, scm_object *o2) {
     return ((scm_float *)o1)->val == ((scm_float *)o2)->val;
 }
 
-static scm_object_methods integer_methods = { number_free, integer_eqv, integer_eqv };
-static scm_object_methods float_methods = { number_free, float_eqv, float_eqv };
+static size_t integer_hash(scm_object *obj) {
+    return scm_hash_mix((size_t)((scm_integer *)obj)->val);
+}
+
+static size_t float_hash(scm_object *obj) {
+    double d = ((scm_float *)obj)->val;
+    uint64_t bits;
+
+    if (d == 0)     /* -0.0 is eqv to 0.0 */
+        d = 0;
+    memcpy(&bits, &d, sizeof(bits));
+    return scm_hash_mix((size_t)bits);
+}
+
+static scm_object_methods integer_methods = { number_free, integer_eqv, integer_eqv, integer_hash, NULL };
+static scm_object_methods float_methods = { number_free, float_eqv, float_eqv, float_hash, NULL };
 
 static int initialized = 0;
 
@@ -253,6 +1666,11 @@ int scm_number_init(void) {
 
     scm_object_register(scm_type_integer, &integer_methods);
     scm_object_register(scm_type_float, &float_methods);
+    scm_bignum_init();
+    scm_rational_init();
+
+    integer_zero = INTEGER(0);
+    integer_one = INTEGER(1);
 
     initialized = 1;
     return 0;
@@ -261,6 +1679,55 @@ int scm_number_init(void) {
 int scm_number_init_env(scm_object *env) {
     scm_env_add_prim(env, "exact?", prim_is_exact, 1, 1, pred_number);
     scm_env_add_prim(env, "inexact?", prim_is_inexact, 1, 1, pred_number);
+    scm_env_add_prim(env, "complex?", prim_is_complex, 1, 1, NULL);
+    scm_env_add_prim(env, "rational?", prim_is_rational, 1, 1, NULL);
+
+    scm_env_add_prim(env, "+", prim_add, 0, -1, NULL);
+    scm_env_add_prim(env, "-", prim_sub, 1, -1, NULL);
+    scm_env_add_prim(env, "*", prim_mul, 0, -1, NULL);
+    scm_env_add_prim(env, "/", prim_div, 1, -1, NULL);
+    scm_env_add_prim(env, "=", prim_num_eq, 1, -1, NULL);
+    scm_env_add_prim(env, "<", prim_num_lt, 1, -1, NULL);
+    scm_env_add_prim(env, ">", prim_num_gt, 1, -1, NULL);
+    scm_env_add_prim(env, "<=", prim_num_le, 1, -1, NULL);
+    scm_env_add_prim(env, ">=", prim_num_ge, 1, -1, NULL);
+    scm_env_add_prim(env, "max", prim_max, 1, -1, NULL);
+    scm_env_add_prim(env, "min", prim_min, 1, -1, NULL);
+
+    scm_env_add_prim(env, "zero?", prim_is_zero, 1, 1, NULL);
+    scm_env_add_prim(env, "positive?", prim_is_positive, 1, 1, NULL);
+    scm_env_add_prim(env, "negative?", prim_is_negative, 1, 1, NULL);
+    scm_env_add_prim(env, "odd?", prim_is_odd, 1, 1, NULL);
+    scm_env_add_prim(env, "even?", prim_is_even, 1, 1, NULL);
+    scm_env_add_prim(env, "abs", prim_abs, 1, 1, NULL);
+    scm_env_add_prim(env, "quotient", prim_quotient, 2, 2, NULL);
+    scm_env_add_prim(env, "remainder", prim_remainder, 2, 2, NULL);
+    scm_env_add_prim(env, "modulo", prim_modulo, 2, 2, NULL);
+    scm_env_add_prim(env, "gcd", prim_gcd, 0, -1, NULL);
+    scm_env_add_prim(env, "lcm", prim_lcm, 0, -1, NULL);
+    scm_env_add_prim(env, "numerator", prim_numerator, 1, 1, NULL);
+    scm_env_add_prim(env, "denominator", prim_denominator, 1, 1, NULL);
+    scm_env_add_prim(env, "rationalize", prim_rationalize, 2, 2, NULL);
+
+    scm_env_add_prim(env, "floor", prim_floor, 1, 1, NULL);
+    scm_env_add_prim(env, "ceiling", prim_ceiling, 1, 1, NULL);
+    scm_env_add_prim(env, "truncate", prim_truncate, 1, 1, NULL);
+    scm_env_add_prim(env, "round", prim_round, 1, 1, NULL);
+    scm_env_add_prim(env, "exp", prim_exp, 1, 1, NULL);
+    scm_env_add_prim(env, "log", prim_log, 1, 1, NULL);
+    scm_env_add_prim(env, "sin", prim_sin, 1, 1, NULL);
+    scm_env_add_prim(env, "cos", prim_cos, 1, 1, NULL);
+    scm_env_add_prim(env, "tan", prim_tan, 1, 1, NULL);
+    scm_env_add_prim(env, "asin", prim_asin, 1, 1, NULL);
+    scm_env_add_prim(env, "acos", prim_acos, 1, 1, NULL);
+    scm_env_add_prim(env, "atan", prim_atan, 1, 2, NULL);
+    scm_env_add_prim(env, "sqrt", prim_sqrt, 1, 1, NULL);
+    scm_env_add_prim(env, "expt", prim_expt, 2, 2, NULL);
+
+    scm_env_add_prim(env, "exact->inexact", prim_exact_to_inexact, 1, 1, NULL);
+    scm_env_add_prim(env, "inexact->exact", prim_inexact_to_exact, 1, 1, NULL);
+    scm_env_add_prim(env, "number->string", prim_number_to_string, 1, 2, NULL);
+    scm_env_add_prim(env, "string->number", prim_string_to_number, 1, 2, NULL);
 
     return 0;
 }
@@ -6,14 +6,35 @@ scm_object *scm_number_new_integer(const char *num, int radix);
 scm_object *scm_number_new_integer_from_float(const char *num);
 scm_object *scm_number_new_float(const char *num);
 scm_object *scm_number_new_float_from_integer(const char *num, int radix);
+int scm_number_decimal_to_double(unsigned long mant, long exp10, int neg, double *val);
+/* the exact value of the optionally signed decimal digits times 10^@exp10 */
+scm_object *scm_number_exact_decimal(const char *digits, long len, long exp10);
 scm_object *INTEGER(long n);
 scm_object *FLOAT(double n);
 
+/* enough for a 64-bit integer in binary, and any float */
+#define SCM_NUMBER_BUF_SIZE 72
+
+/* fixnums and floats only, -1 for the others */
+int scm_number_format(scm_object *obj, int radix, char *buf);
 char *scm_number_to_string(scm_object *obj, int radix);
 long scm_integer_get_val(scm_object *obj);
 void scm_integer_inc(scm_object *obj);
 void scm_integer_dec(scm_object *obj);
 double scm_float_get_val(scm_object *obj);
+/* the nearest double of any real number */
+double scm_number_to_double(scm_object *obj);
+
+/* long arithmetic, nonzero when the result overflows */
+#if defined(__GNUC__) || defined(__clang__)
+#define scm_add_overflow(a, b, r) __builtin_add_overflow(a, b, r)
+#define scm_sub_overflow(a, b, r) __builtin_sub_overflow(a, b, r)
+#define scm_mul_overflow(a, b, r) __builtin_mul_overflow(a, b, r)
+#else
+int scm_add_overflow(long a, long b, long *r);
+int scm_sub_overflow(long a, long b, long *r);
+int scm_mul_overflow(long a, long b, long *r);
+#endif
 
 int scm_number_init(void);
 int scm_number_init_env(scm_object *env);
@@ -0,0 +1,673 @@
+#include "numvector.h"
+#include "bytevector.h"
+#include "bignum.h"
+#include "err.h"
+#include "number.h"
+#include "symbol.h"
+#include "pair.h"
+#include "proc.h"
+#include "eval.h"
+#include "env.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* the u8vectors are bytevectors and don't use this */
+typedef struct scm_numvector_st {
+    scm_object base;
+    int kind;
+    long len;
+    void *buf;
+} scm_numvector;
+
+static const struct {
+    const char *pred;
+    int width;
+} kinds[] = {
+    { "u8vector?", sizeof(uint8_t) },
+    { "s64vector?", sizeof(int64_t) },
+    { "f64vector?", sizeof(double) },
+};
+
+scm_object *pred_u8vector = NULL;
+scm_object *pred_s64vector = NULL;
+scm_object *pred_f64vector = NULL;
+
+#define IS_REAL(obj) ((obj)->type >= scm_type_integer && (obj)->type <= scm_type_float)
+
+scm_object *scm_numvector_new(int kind, long len) {
+    scm_numvector *v;
+
+    if (kind == SCM_U8VECTOR)
+        return scm_bytevector_new(len);
+    v = malloc(sizeof(scm_numvector));
+    v->base.type = scm_type_numvector;
+    v->kind = kind;
+    v->len = len;
+    v->buf = calloc(len ? len : 1, kinds[kind].width);
+    return (scm_object *)v;
+}
+
+int scm_numvector_kind(scm_object *obj) {
+    if (obj->type == scm_type_bytevector)
+        return SCM_U8VECTOR;
+    if (obj->type == scm_type_numvector)
+        return ((scm_numvector *)obj)->kind;
+    return -1;
+}
+
+long scm_numvector_length(scm_object *v) {
+    if (v->type == scm_type_bytevector)
+        return scm_bytevector_size(v);
+    return ((scm_numvector *)v)->len;
+}
+
+void *scm_numvector_data(scm_object *v) {
+    if (v->type == scm_type_bytevector)
+        return scm_bytevector_data(v);
+    return ((scm_numvector *)v)->buf;
+}
+
+scm_object *scm_numvector_ref(scm_object *v, long k) {
+    void *buf = scm_numvector_data(v);
+
+    switch (scm_numvector_kind(v)) {
+    case SCM_U8VECTOR:
+        return INTEGER(((uint8_t *)buf)[k]);
+    case SCM_S64VECTOR:
+        return INTEGER(((int64_t *)buf)[k]);
+    default:
+        return FLOAT(((double *)buf)[k]);
+    }
+}
+
+static int element_fits(int kind, scm_object *obj) {
+    switch (kind) {
+    case SCM_U8VECTOR:
+        return obj->type == scm_type_integer && scm_integer_get_val(obj) >= 0
+            && scm_integer_get_val(obj) <= UINT8_MAX;
+    case SCM_S64VECTOR:
+        /* fixnums are exactly the 64-bit integers */
+        return obj->type == scm_type_integer;
+    default:
+        return IS_REAL(obj);
+    }
+}
+
+static const char *element_pred[] = { "byte?", "fixnum?", "real?" };
+
+/* @obj should fit */
+static void element_set(int kind, void *buf, long k, scm_object *obj) {
+    switch (kind) {
+    case SCM_U8VECTOR:
+        ((uint8_t *)buf)[k] = scm_integer_get_val(obj);
+        break;
+    case SCM_S64VECTOR:
+        ((int64_t *)buf)[k] = scm_integer_get_val(obj);
+        break;
+    default:
+        ((double *)buf)[k] = scm_number_to_double(obj);
+        break;
+    }
+}
+
+static void numvector_free(scm_object *obj) {
+    free(((scm_numvector *)obj)->buf);
+    free(obj);
+}
+
+/* bitwise, so by eqv? on the elements */
+static int numvector_equal(scm_object *o1, scm_object *o2) {
+    scm_numvector *v1 = (scm_numvector *)o1, *v2 = (scm_numvector *)o2;
+    return v1->kind == v2->kind && v1->len == v2->len
+        && !memcmp(v1->buf, v2->buf, v1->len * kinds[v1->kind].width);
+}
+
+static size_t numvector_equal_hash(scm_object *obj, int *budget) {
+    scm_numvector *v = (scm_numvector *)obj;
+    (void)budget;
+    return scm_hash_bytes(v->buf, v->len * kinds[v->kind].width);
+}
+
+/* kernels
+ * each runs a vector loop while whole vectors remain and finishes the tail,
+ * or the whole array without SSE2, with the scalar loop */
+#if defined(__AVX__)
+typedef __m256d f64_vec;
+#define F64_LANES           4
+#define f64_load(p)         _mm256_loadu_pd(p)
+#define f64_store(p, x)     _mm256_storeu_pd(p, x)
+#define f64_zero()          _mm256_setzero_pd()
+#define f64_add             _mm256_add_pd
+#define f64_sub             _mm256_sub_pd
+#define f64_mul             _mm256_mul_pd
+#define f64_div             _mm256_div_pd
+#define f64_min             _mm256_min_pd
+#define f64_max             _mm256_max_pd
+#elif defined(__SSE2__)
+typedef __m128d f64_vec;
+#define F64_LANES           2
+#define f64_load(p)         _mm_loadu_pd(p)
+#define f64_store(p, x)     _mm_storeu_pd(p, x)
+#define f64_zero()          _mm_setzero_pd()
+#define f64_add             _mm_add_pd
+#define f64_sub             _mm_sub_pd
+#define f64_mul             _mm_mul_pd
+#define f64_div             _mm_div_pd
+#define f64_min             _mm_min_pd
+#define f64_max             _mm_max_pd
+#endif
+
+#if defined(__SSE2__)
+typedef __m128i int_vec;
+#define U8_LANES            16
+#define S64_LANES           2
+#define int_load(p)         _mm_loadu_si128((const __m128i *)(p))
+#define int_store(p, x)     _mm_storeu_si128((__m128i *)(p), x)
+#define u8_add              _mm_add_epi8
+#define u8_sub              _mm_sub_epi8
+#define u8_min              _mm_min_epu8
+#define u8_max              _mm_max_epu8
+#define s64_add             _mm_add_epi64
+#define s64_sub             _mm_sub_epi64
+#endif
+
+/* the same as the instructions, the first operand unless the second is
+ * strictly less (greater), so a NaN is kept only from the second */
+#define MIN(x, y)   ((x) < (y) ? (x) : (y))
+#define MAX(x, y)   ((x) > (y) ? (x) : (y))
+#define ADD(x, y)   ((x) + (y))
+#define SUB(x, y)   ((x) - (y))
+#define MUL(x, y)   ((x) * (y))
+#define DIV(x, y)   ((x) / (y))
+/* integer arithmetic wraps around like the machine's */
+#define WRAP_ADD(x, y)  (int64_t)((uint64_t)(x) + (uint64_t)(y))
+#define WRAP_SUB(x, y)  (int64_t)((uint64_t)(x) - (uint64_t)(y))
+#define WRAP_MUL(x, y)  (int64_t)((uint64_t)(x) * (uint64_t)(y))
+
+typedef void (*elementwise_fn)(void *r, const void *a, const void *b, long n);
+
+/* r[i] = op(a[i], b[i]) */
+#define define_scalar_kernel(name, type, op) \
+    static void name(void *rp, const void *ap, const void *bp, long n) { \
+        type *r = rp; \
+        const type *a = ap, *b = bp; \
+        for (long i = 0; i < n; ++i) \
+            r[i] = op(a[i], b[i]); \
+    }
+
+/* the same with whole vectors first */
+#if defined(__SSE2__)
+#define define_vector_kernel(name, type, lanes, load, store, vop, op) \
+    static void name(void *rp, const void *ap, const void *bp, long n) { \
+        type *r = rp; \
+        const type *a = ap, *b = bp; \
+        long i = 0; \
+        for (; i + (lanes) <= n; i += (lanes)) \
+            store(r + i, vop(load(a + i), load(b + i))); \
+        for (; i < n; ++i) \
+            r[i] = op(a[i], b[i]); \
+    }
+#else
+#define define_vector_kernel(name, type, lanes, load, store, vop, op) \
+    define_scalar_kernel(name, type, op)
+#endif
+
+define_vector_kernel(u8_add_kernel, uint8_t, U8_LANES, int_load, int_store, u8_add, ADD)
+define_vector_kernel(u8_sub_kernel, uint8_t, U8_LANES, int_load, int_store, u8_sub, SUB)
+define_scalar_kernel(u8_mul_kernel, uint8_t, MUL)
+define_vector_kernel(s64_add_kernel, int64_t, S64_LANES, int_load, int_store, s64_add, WRAP_ADD)
+define_vector_kernel(s64_sub_kernel, int64_t, S64_LANES, int_load, int_store, s64_sub, WRAP_SUB)
+define_scalar_kernel(s64_mul_kernel, int64_t, WRAP_MUL)
+define_vector_kernel(f64_add_kernel, double, F64_LANES, f64_load, f64_store, f64_add, ADD)
+define_vector_kernel(f64_sub_kernel, double, F64_LANES, f64_load, f64_store, f64_sub, SUB)
+define_vector_kernel(f64_mul_kernel, double, F64_LANES, f64_load, f64_store, f64_mul, MUL)
+define_vector_kernel(f64_div_kernel, double, F64_LANES, f64_load, f64_store, f64_div, DIV)
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV };
+
+/* by kind and operation, no integer division */
+static const elementwise_fn elementwise_kernels[][4] = {
+    { u8_add_kernel, u8_sub_kernel, u8_mul_kernel, NULL },
+    { s64_add_kernel, s64_sub_kernel, s64_mul_kernel, NULL },
+    { f64_add_kernel, f64_sub_kernel, f64_mul_kernel, f64_div_kernel },
+};
+
+/* op over the @n > 0 elements of @a, op is idempotent */
+#if defined(__SSE2__)
+#define define_extremum_kernel(name, type, vtype, lanes, load, store, vop, op) \
+    static type name(const type *a, long n) { \
+        type m = a[0], lane[lanes]; \
+        long i = 0; \
+        if (n >= (lanes)) { \
+            vtype acc = load(a); \
+            for (i = (lanes); i + (lanes) <= n; i += (lanes)) \
+                acc = vop(acc, load(a + i)); \
+            store(lane, acc); \
+            for (int j = 0; j < (lanes); ++j) \
+                m = op(m, lane[j]); \
+        } \
+        for (; i < n; ++i) \
+            m = op(m, a[i]); \
+        return m; \
+    }
+#else
+#define define_extremum_kernel(name, type, vtype, lanes, load, store, vop, op) \
+    static type name(const type *a, long n) { \
+        type m = a[0]; \
+        for (long i = 1; i < n; ++i) \
+            m = op(m, a[i]); \
+        return m; \
+    }
+#endif
+
+define_extremum_kernel(u8_min_kernel, uint8_t, int_vec, U8_LANES, int_load, int_store, u8_min, MIN)
+define_extremum_kernel(u8_max_kernel, uint8_t, int_vec, U8_LANES, int_load, int_store, u8_max, MAX)
+define_extremum_kernel(f64_min_kernel, double, f64_vec, F64_LANES, f64_load, f64_store, f64_min, MIN)
+define_extremum_kernel(f64_max_kernel, double, f64_vec, F64_LANES, f64_load, f64_store, f64_max, MAX)
+
+/* no SIMD minimum of 64-bit integers before AVX-512 */
+static int64_t s64_min_kernel(const int64_t *a, long n) {
+    int64_t m = a[0];
+    for (long i = 1; i < n; ++i)
+        m = MIN(m, a[i]);
+    return m;
+}
+
+static int64_t s64_max_kernel(const int64_t *a, long n) {
+    int64_t m = a[0];
+    for (long i = 1; i < n; ++i)
+        m = MAX(m, a[i]);
+    return m;
+}
+
+/* the lanes add up in a different order than a scalar loop would, so the
+ * sums of floats may differ from it in the last bits */
+#if defined(__SSE2__)
+static double f64_lanes_sum(f64_vec x) {
+    double lane[F64_LANES], s = 0;
+    f64_store(lane, x);
+    for (int j = 0; j < F64_LANES; ++j)
+        s += lane[j];
+    return s;
+}
+#endif
+
+static double f64_sum_kernel(const double *a, long n) {
+    double s = 0;
+    long i = 0;
+#if defined(__SSE2__)
+    f64_vec acc = f64_zero();
+    for (; i + F64_LANES <= n; i += F64_LANES)
+        acc = f64_add(acc, f64_load(a + i));
+    s = f64_lanes_sum(acc);
+#endif
+    for (; i < n; ++i)
+        s += a[i];
+    return s;
+}
+
+static double f64_dot_kernel(const double *a, const double *b, long n) {
+    double s = 0;
+    long i = 0;
+#if defined(__SSE2__)
+    f64_vec acc = f64_zero();
+    for (; i + F64_LANES <= n; i += F64_LANES)
+        acc = f64_add(acc, f64_mul(f64_load(a + i), f64_load(b + i)));
+    s = f64_lanes_sum(acc);
+#endif
+    for (; i < n; ++i)
+        s += a[i] * b[i];
+    return s;
+}
+
+/* sums of absolute differences from zero, two 64-bit partial sums of 8 bytes
+ * each per vector, which can't overflow */
+static long u8_sum_kernel(const uint8_t *a, long n) {
+    long s = 0, i = 0;
+#if defined(__SSE2__)
+    int_vec acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+    int64_t lane[2];
+    for (; i + U8_LANES <= n; i += U8_LANES)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(int_load(a + i), zero));
+    int_store(lane, acc);
+    s = lane[0] + lane[1];
+#endif
+    for (; i < n; ++i)
+        s += a[i];
+    return s;
+}
+
+static long u8_dot_kernel(const uint8_t *a, const uint8_t *b, long n) {
+    long s = 0;
+    for (long i = 0; i < n; ++i)
+        s += a[i] * b[i];
+    return s;
+}
+
+static scm_object *add_exact(scm_object *big, scm_object *x) {
+    return big ? scm_bignum_add(big, x) : x;
+}
+
+/* exact, the part which overflowed a fixnum goes to a bignum */
+static scm_object *s64_sum(const int64_t *a, const int64_t *b, long n) {
+    scm_object *big = NULL;
+    long s = 0, x, t;
+
+    for (long i = 0; i < n; ++i) {
+        if (!b)
+            x = a[i];
+        else if (scm_mul_overflow((long)a[i], (long)b[i], &x)) {
+            big = add_exact(big, scm_bignum_mul(INTEGER(a[i]), INTEGER(b[i])));
+            continue;
+        }
+        if (scm_add_overflow(s, x, &t)) {
+            big = add_exact(big, INTEGER(s));
+            t = x;
+        }
+        s = t;
+    }
+    return big ? scm_bignum_add(big, INTEGER(s)) : INTEGER(s);
+}
+
+/* arguments */
+static void check_index(const char *name, scm_object *v, long k) {
+    long len = scm_numvector_length(v);
+    if (len == 0)
+        scm_error_object(v, "%s: index is out of range for empty vector\nindex: %ld\nvector: ", name, k);
+    if (k >= len)
+        scm_error_object(v, "%s: index is out of range\nindex: %ld\n"
+                         "valid range: [0, %ld]\nvector: ", name, k, len - 1);
+}
+
+static void check_lengths(const char *name, scm_object *a, scm_object *b) {
+    if (scm_numvector_length(a) != scm_numvector_length(b))
+        scm_error_object(b, "%s: vectors of different lengths\nlength: %ld\nvector: ",
+                         name, scm_numvector_length(a));
+}
+
+static void check_element(const char *name, int kind, int i, scm_object *obj) {
+    if (!element_fits(kind, obj))
+        scm_contract_violation(name, i, element_pred[kind], obj);
+}
+
+/* the primitives of all the kinds */
+static scm_object *is_ex(int kind, scm_object *obj) {
+    return scm_boolean(scm_numvector_kind(obj) == kind);
+}
+
+static scm_object *make_ex(int kind, const char *name, int n, scm_object **args) {
+    long k = scm_index_arg(name, 1, args[0]);
+    scm_object *v = scm_numvector_new(kind, k);
+    void *buf = scm_numvector_data(v);
+
+    if (n > 1) {
+        check_element(name, kind, 2, args[1]);
+        for (long i = 0; i < k; ++i)
+            element_set(kind, buf, i, args[1]);
+    }
+    return v;
+}
+
+static scm_object *list_ex(int kind, const char *name, int n, scm_object **args) {
+    scm_object *v = scm_numvector_new(kind, n);
+    void *buf = scm_numvector_data(v);
+
+    for (int i = 0; i < n; ++i) {
+        check_element(name, kind, i + 1, args[i]);
+        element_set(kind, buf, i, args[i]);
+    }
+    return v;
+}
+
+static scm_object *ref_ex(const char *name, scm_object **args) {
+    scm_object *v = args[0];
+    long k = scm_index_arg(name, 2, args[1]);
+
+    check_index(name, v, k);
+    return scm_numvector_ref(v, k);
+}
+
+static scm_object *set_ex(int kind, const char *name, scm_object **args) {
+    scm_object *v = args[0];
+    long k = scm_index_arg(name, 2, args[1]);
+
+    check_element(name, kind, 3, args[2]);
+    check_index(name, v, k);
+    element_set(kind, scm_numvector_data(v), k, args[2]);
+    return scm_void;
+}
+
+static scm_object *to_list_ex(scm_object *v) {
+    scm_object *list = scm_null;
+    for (long i = scm_numvector_length(v) - 1; i >= 0; --i)
+        list = scm_cons(scm_numvector_ref(v, i), list);
+    return list;
+}
+
+static scm_object *from_list_ex(int kind, const char *name, scm_object *list) {
+    long len = scm_list_length(list);
+    scm_object *v, *p;
+    void *buf;
+
+    if (len < 0)
+        scm_contract_violation(name, 1, "list?", list);
+    v = scm_numvector_new(kind, len);
+    buf = scm_numvector_data(v);
+    for (long i = 0; i < len; ++i, list = scm_cdr(list)) {
+        p = scm_car(list);
+        if (!element_fits(kind, p))
+            scm_error_object(p, "%s: element of the wrong type\nexpected: %s\nelement: ",
+                             name, element_pred[kind]);
+        element_set(kind, buf, i, p);
+    }
+    return v;
+}
+
+static scm_object *elementwise_ex(int kind, int op, const char *name, scm_object **args) {
+    scm_object *a = args[0], *b = args[1], *r;
+    long len = scm_numvector_length(a);
+
+    check_lengths(name, a, b);
+    r = scm_numvector_new(kind, len);
+    elementwise_kernels[kind][op](scm_numvector_data(r), scm_numvector_data(a), scm_numvector_data(b), len);
+    return r;
+}
+
+static scm_object *sum_ex(int kind, scm_object *v) {
+    void *buf = scm_numvector_data(v);
+    long len = scm_numvector_length(v);
+
+    switch (kind) {
+    case SCM_U8VECTOR:
+        return INTEGER(u8_sum_kernel(buf, len));
+    case SCM_S64VECTOR:
+        return s64_sum(buf, NULL, len);
+    default:
+        return FLOAT(f64_sum_kernel(buf, len));
+    }
+}
+
+static scm_object *dot_ex(int kind, const char *name, scm_object **args) {
+    scm_object *a = args[0], *b = args[1];
+    void *x = scm_numvector_data(a), *y = scm_numvector_data(b);
+    long len = scm_numvector_length(a);
+
+    check_lengths(name, a, b);
+    switch (kind) {
+    case SCM_U8VECTOR:
+        return INTEGER(u8_dot_kernel(x, y, len));
+    case SCM_S64VECTOR:
+        return s64_sum(x, y, len);
+    default:
+        return FLOAT(f64_dot_kernel(x, y, len));
+    }
+}
+
+static scm_object *extremum_ex(int kind, int max, const char *name, scm_object *v) {
+    void *buf = scm_numvector_data(v);
+    long len = scm_numvector_length(v);
+
+    if (len == 0)
+        scm_error_object(v, "%s: empty vector\nvector: ", name);
+    switch (kind) {
+    case SCM_U8VECTOR:
+        return INTEGER(max ? u8_max_kernel(buf, len) : u8_min_kernel(buf, len));
+    case SCM_S64VECTOR:
+        return INTEGER(max ? s64_max_kernel(buf, len) : s64_min_kernel(buf, len));
+    default:
+        return FLOAT(max ? f64_max_kernel(buf, len) : f64_min_kernel(buf, len));
+    }
+}
+
+/* (map proc v1 [v2]) into a new vector of the kind, to the shorter length */
+static scm_object *map_ex(int kind, const char *name, int n, scm_object **args) {
+    scm_object *proc = args[0], *a = args[1], *b = n > 2 ? args[2] : NULL;
+    scm_object *r, *opds[2], *val;
+    long len = scm_numvector_length(a);
+    void *buf;
+
+    if (b) {
+        if (scm_numvector_kind(b) != kind)
+            scm_contract_violation(name, 3, kinds[kind].pred, b);
+        if (scm_numvector_length(b) < len)
+            len = scm_numvector_length(b);
+    }
+    r = scm_numvector_new(kind, len);
+    buf = scm_numvector_data(r);
+    for (long i = 0; i < len; ++i) {
+        opds[0] = scm_numvector_ref(a, i);
+        if (b)
+            opds[1] = scm_numvector_ref(b, i);
+        val = scm_apply(proc, b ? 2 : 1, opds);
+        if (!element_fits(kind, val))
+            scm_error_object(val, "%s: result of the wrong type\nexpected: %s\nresult: ",
+                             name, element_pred[kind]);
+        element_set(kind, buf, i, val);
+    }
+    return r;
+}
+
+#define define_numvector_primitives(tag, kind) \
+    static scm_object *prim_is_##tag##vector(int n, scm_object **args) { \
+        (void)n; \
+        return is_ex(kind, args[0]); \
+    } \
+    static scm_object *prim_make_##tag##vector(int n, scm_object **args) { \
+        return make_ex(kind, "make-" #tag "vector", n, args); \
+    } \
+    static scm_object *prim_##tag##vector(int n, scm_object **args) { \
+        return list_ex(kind, #tag "vector", n, args); \
+    } \
+    static scm_object *prim_##tag##vector_length(int n, scm_object **args) { \
+        (void)n; \
+        return INTEGER(scm_numvector_length(args[0])); \
+    } \
+    static scm_object *prim_##tag##vector_ref(int n, scm_object **args) { \
+        (void)n; \
+        return ref_ex(#tag "vector-ref", args); \
+    } \
+    static scm_object *prim_##tag##vector_set(int n, scm_object **args) { \
+        (void)n; \
+        return set_ex(kind, #tag "vector-set!", args); \
+    } \
+    static scm_object *prim_##tag##vector_to_list(int n, scm_object **args) { \
+        (void)n; \
+        return to_list_ex(args[0]); \
+    } \
+    static scm_object *prim_list_to_##tag##vector(int n, scm_object **args) { \
+        (void)n; \
+        return from_list_ex(kind, "list->" #tag "vector", args[0]); \
+    } \
+    static scm_object *prim_##tag##vector_add(int n, scm_object **args) { \
+        (void)n; \
+        return elementwise_ex(kind, OP_ADD, #tag "vector-add", args); \
+    } \
+    static scm_object *prim_##tag##vector_sub(int n, scm_object **args) { \
+        (void)n; \
+        return elementwise_ex(kind, OP_SUB, #tag "vector-sub", args); \
+    } \
+    static scm_object *prim_##tag##vector_mul(int n, scm_object **args) { \
+        (void)n; \
+        return elementwise_ex(kind, OP_MUL, #tag "vector-mul", args); \
+    } \
+    static scm_object *prim_##tag##vector_dot(int n, scm_object **args) { \
+        (void)n; \
+        return dot_ex(kind, #tag "vector-dot", args); \
+    } \
+    static scm_object *prim_##tag##vector_sum(int n, scm_object **args) { \
+        (void)n; \
+        return sum_ex(kind, args[0]); \
+    } \
+    static scm_object *prim_##tag##vector_min(int n, scm_object **args) { \
+        (void)n; \
+        return extremum_ex(kind, 0, #tag "vector-min", args[0]); \
+    } \
+    static scm_object *prim_##tag##vector_max(int n, scm_object **args) { \
+        (void)n; \
+        return extremum_ex(kind, 1, #tag "vector-max", args[0]); \
+    } \
+    static scm_object *prim_##tag##vector_map(int n, scm_object **args) { \
+        return map_ex(kind, #tag "vector-map", n, args); \
+    }
+
+define_numvector_primitives(u8, SCM_U8VECTOR)
+define_numvector_primitives(s64, SCM_S64VECTOR)
+define_numvector_primitives(f64, SCM_F64VECTOR)
+
+static scm_object *prim_f64vector_div(int n, scm_object **args) {
+    (void)n;
+    return elementwise_ex(SCM_F64VECTOR, OP_DIV, "f64vector-div", args);
+}
+
+#define add_numvector_primitives(env, tag, pred) \
+    do { \
+        scm_object *pred_v = scm_list(1, pred); \
+        scm_env_define_var(env, scm_symbol_new(#tag "vector?", -1), pred); \
+        scm_env_add_prim(env, "make-" #tag "vector", prim_make_##tag##vector, 1, 2, NULL); \
+        scm_env_add_prim(env, #tag "vector", prim_##tag##vector, 0, -1, NULL); \
+        scm_env_add_prim(env, #tag "vector-length", prim_##tag##vector_length, 1, 1, pred_v); \
+        scm_env_add_prim(env, #tag "vector-ref", prim_##tag##vector_ref, 2, 2, pred_v); \
+        scm_env_add_prim(env, #tag "vector-set!", prim_##tag##vector_set, 3, 3, pred_v); \
+        scm_env_add_prim(env, #tag "vector->list", prim_##tag##vector_to_list, 1, 1, pred_v); \
+        scm_env_add_prim(env, "list->" #tag "vector", prim_list_to_##tag##vector, 1, 1, NULL); \
+        scm_env_add_prim(env, #tag "vector-add", prim_##tag##vector_add, 2, 2, pred); \
+        scm_env_add_prim(env, #tag "vector-sub", prim_##tag##vector_sub, 2, 2, pred); \
+        scm_env_add_prim(env, #tag "vector-mul", prim_##tag##vector_mul, 2, 2, pred); \
+        scm_env_add_prim(env, #tag "vector-dot", prim_##tag##vector_dot, 2, 2, pred); \
+        scm_env_add_prim(env, #tag "vector-sum", prim_##tag##vector_sum, 1, 1, pred); \
+        scm_env_add_prim(env, #tag "vector-min", prim_##tag##vector_min, 1, 1, pred); \
+        scm_env_add_prim(env, #tag "vector-max", prim_##tag##vector_max, 1, 1, pred); \
+        scm_env_add_prim(env, #tag "vector-map", prim_##tag##vector_map, 2, 3, \
+                         scm_list(2, pred_procedure, pred)); \
+    } while (0)
+
+static scm_object_methods numvector_methods = { numvector_free, same_object, numvector_equal, NULL,
+                                                numvector_equal_hash };
+
+static int initialized = 0;
+
+int scm_numvector_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_numvector, &numvector_methods);
+    pred_u8vector = scm_primitive_new("u8vector?", prim_is_u8vector, 1, 1, NULL);
+    pred_s64vector = scm_primitive_new("s64vector?", prim_is_s64vector, 1, 1, NULL);
+    pred_f64vector = scm_primitive_new("f64vector?", prim_is_f64vector, 1, 1, NULL);
+
+    initialized = 1;
+    return 0;
+}
+
+int scm_numvector_init_env(scm_object *env) {
+    add_numvector_primitives(env, u8, pred_u8vector);
+    add_numvector_primitives(env, s64, pred_s64vector);
+    add_numvector_primitives(env, f64, pred_f64vector);
+    scm_env_add_prim(env, "f64vector-div", prim_f64vector_div, 2, 2, pred_f64vector);
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SCHEME_NUMVECTOR_H
+#define SCHEME_NUMVECTOR_H
+#include "object.h"
+
+/* homogeneous numeric vectors (SRFI-4) keep their elements unboxed and
+ * contiguous, the u8vectors are the bytevectors
+ * the element-wise arithmetic and the reductions run vector loops over SSE2,
+ * or AVX when the compiler targets it, and scalar loops for the tails and on
+ * other machines */
+
+enum {
+    SCM_U8VECTOR,
+    SCM_S64VECTOR,
+    SCM_F64VECTOR,
+};
+
+extern scm_object *pred_u8vector;
+extern scm_object *pred_s64vector;
+extern scm_object *pred_f64vector;
+
+/* zeroed */
+scm_object *scm_numvector_new(int kind, long len);
+/* -1 for the other objects */
+int scm_numvector_kind(scm_object *obj);
+long scm_numvector_length(scm_object *v);
+/* uint8_t, int64_t or double by the kind */
+void *scm_numvector_data(scm_object *v);
+scm_object *scm_numvector_ref(scm_object *v, long k);
+
+int scm_numvector_init(void);
+int scm_numvector_init_env(scm_object *env);
+
+#endif /* SCHEME_NUMVECTOR_H */
@@ -4,8 +4,14 @@
 #include "port.h"
 #include "proc.h"
 #include "env.h"
+#include "pair.h"
+#include "vector.h"
+#include "hashtable.h"
+#include "number.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 static scm_object_methods *all_methods[scm_type_max] = {0};
 
@@ -41,16 +47,249 @@ int scm_eq(scm_object *o1, scm_object *o2) {
     return scm_eqv(o1, o2);
 }
 
-int scm_equal(scm_object *o1, scm_object *o2) {
-    if (o1->type != o2->type)
+/* equal? walks pairs and vectors itself with an explicit stack: along the
+ * cdrs in a loop, with the cdr pushed while descending into a compound car,
+ * and through the elements of vectors from their frames, so neither long
+ * nor deep data exhausts the C stack
+ *
+ * cyclic data ends too. a pair met again is taken as equal, which is sound
+ * since it is either being compared or already found equal. along a run of
+ * cdrs the pair is checked against a checkpoint moved at powers of two
+ * (Brent), and after a number of runs the pairs starting them are merged in
+ * a union-find (Adams and Dybvig, Efficient Nondestructive Equality
+ * Checking for Trees and Graphs); once no run start is new every step pops
+ * the stack, so the walk ends */
+
+typedef struct equal_frame_st {
+    scm_object *a;
+    scm_object *b;
+    long i;     /* the next element of vectors, -1 for other objects */
+} equal_frame;
+
+#define EQUAL_STACK_INIT    32
+#define EQUAL_UF_AFTER      1024
+
+typedef struct equal_state_st {
+    equal_frame *frames;
+    long n;
+    long cap;
+    long runs;
+    scm_object *uf;     /* object -> a more representative one */
+    /* the checkpoint of the current run */
+    scm_object *pa;
+    scm_object *pb;
+    long power;
+    long lam;
+    equal_frame init[EQUAL_STACK_INIT];
+} equal_state;
+
+static void equal_push(equal_state *s, scm_object *a, scm_object *b, long i) {
+    if (s->n == s->cap) {
+        s->cap *= 2;
+        if (s->frames == s->init) {
+            s->frames = malloc(s->cap * sizeof(equal_frame));
+            memcpy(s->frames, s->init, sizeof(s->init));
+        }
+        else {
+            s->frames = realloc(s->frames, s->cap * sizeof(equal_frame));
+        }
+    }
+    s->frames[s->n].a = a;
+    s->frames[s->n].b = b;
+    s->frames[s->n].i = i;
+    ++s->n;
+}
+
+static scm_object *uf_find(scm_object *uf, scm_object *x) {
+    scm_object *p, *root = x;
+
+    while ((p = scm_hashtable_ref(uf, root, NULL)))
+        root = p;
+    /* path compression */
+    while (x != root) {
+        p = scm_hashtable_ref(uf, x, NULL);
+        scm_hashtable_set(uf, x, root);
+        x = p;
+    }
+    return root;
+}
+
+/* whether @a and @b starting a run are already taken as equal, and take
+ * them so */
+static int run_start_seen(equal_state *s, scm_object *a, scm_object *b) {
+    scm_object *ra, *rb;
+
+    s->pa = a;
+    s->pb = b;
+    s->power = 1;
+    s->lam = 0;
+    if (++s->runs < EQUAL_UF_AFTER)
         return 0;
-    return all_methods[o1->type]->equal(o1, o2);
+    if (!s->uf)
+        s->uf = scm_eqv_hashtable_new();
+    ra = uf_find(s->uf, a);
+    rb = uf_find(s->uf, b);
+    if (ra == rb)
+        return 1;
+    scm_hashtable_set(s->uf, ra, rb);
+    return 0;
+}
+
+static int run_seen(equal_state *s, scm_object *a, scm_object *b) {
+    if (a == s->pa && b == s->pb)
+        return 1;
+    if (++s->lam == s->power) {
+        s->pa = a;
+        s->pb = b;
+        s->power *= 2;
+        s->lam = 0;
+    }
+    return 0;
+}
+
+static int is_structured(scm_object *obj) {
+    return obj->type == scm_type_pair || obj->type == scm_type_vector;
+}
+
+static int atom_equal(scm_object *a, scm_object *b) {
+    return a == b || (a->type == b->type && all_methods[a->type]->equal(a, b));
+}
+
+static int structure_equal(equal_state *s, scm_object *a, scm_object *b) {
+    equal_frame *f;
+    scm_object *ca, *cb;
+    long len;
+    int start = 1;  /* whether @a and @b start a run */
+
+    for (;;) {
+        if (a == b)
+            goto next;
+        if (a->type != b->type)
+            return 0;
+        if (a->type == scm_type_pair) {
+            if (start ? run_start_seen(s, a, b) : run_seen(s, a, b))
+                goto next;
+            start = 0;
+            ca = scm_car(a);
+            cb = scm_car(b);
+            a = scm_cdr(a);
+            b = scm_cdr(b);
+            if (ca != cb && is_structured(ca)) {
+                equal_push(s, a, b, -1);
+                a = ca;
+                b = cb;
+                start = 1;
+            }
+            else if (!atom_equal(ca, cb)) {
+                return 0;
+            }
+            continue;
+        }
+        if (a->type == scm_type_vector) {
+            len = scm_vector_length(a);
+            if (len != scm_vector_length(b))
+                return 0;
+            if (len == 0 || run_start_seen(s, a, b))
+                goto next;
+            if (len > 1)
+                equal_push(s, a, b, 1);
+            a = scm_vector_elements(a)[0];
+            b = scm_vector_elements(b)[0];
+            start = 1;
+            continue;
+        }
+        if (!all_methods[a->type]->equal(a, b))
+            return 0;
+
+next:
+        if (s->n == 0)
+            return 1;
+        f = s->frames + s->n - 1;
+        if (f->i < 0) {
+            a = f->a;
+            b = f->b;
+            --s->n;
+        }
+        else {
+            a = scm_vector_elements(f->a)[f->i];
+            b = scm_vector_elements(f->b)[f->i];
+            if (++f->i == scm_vector_length(f->a))
+                --s->n;
+        }
+        start = 1;
+    }
+}
+
+int scm_equal(scm_object *o1, scm_object *o2) {
+    equal_state s;
+    int res;
+
+    if (!is_structured(o1))
+        return atom_equal(o1, o2);
+
+    s.frames = s.init;
+    s.n = 0;
+    s.cap = EQUAL_STACK_INIT;
+    s.runs = 0;
+    s.uf = NULL;
+    res = structure_equal(&s, o1, o2);
+    if (s.frames != s.init)
+        free(s.frames);
+    if (s.uf)
+        scm_object_free(s.uf);
+    return res;
+}
+
+/* the finalizer of MurmurHash3, so that nearby keys spread */
+size_t scm_hash_mix(size_t h) {
+    uint64_t x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+/* FNV-1a */
+size_t scm_hash_bytes(const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (len--) {
+        h ^= *p++;
+        h *= 0x100000001b3ULL;
+    }
+    return scm_hash_mix((size_t)h);
+}
+
+size_t scm_eqv_hash(scm_object *obj) {
+    scm_object_methods *methods = all_methods[obj->type];
+    if (methods && methods->hash)
+        return methods->hash(obj);
+    return scm_hash_mix((size_t)(uintptr_t)obj);
+}
+
+size_t scm_equal_hash_bounded(scm_object *obj, int *budget) {
+    scm_object_methods *methods = all_methods[obj->type];
+    if (*budget <= 0)
+        return obj->type;
+    if (methods && methods->equal_hash)
+        return methods->equal_hash(obj, budget);
+    return scm_eqv_hash(obj);
+}
+
+/* only the first components of large or cyclic data are taken */
+#define EQUAL_HASH_BUDGET   64
+
+size_t scm_equal_hash(scm_object *obj) {
+    int budget = EQUAL_HASH_BUDGET;
+    return scm_equal_hash_bounded(obj, &budget);
 }
 
 #define define_prim_eq(name) \
-static scm_object *prim_##name(int n, scm_object *args) { \
+static scm_object *prim_##name(int n, scm_object **args) { \
     (void)n; \
-    if (scm_##name(scm_car(args), scm_cadr(args))) \
+    if (scm_##name(args[0], args[1])) \
         return scm_true; \
     else \
         return scm_false; \
@@ -73,8 +312,17 @@ define_predicate(boolean, obj == scm_true || obj == scm_false);
 define_predicate(null, obj == scm_null);
 define_predicate(eof, obj == scm_eof);
 define_predicate(char, obj->type == scm_type_char);
-define_predicate(integer, obj->type == scm_type_integer);
-define_predicate(number, obj->type == scm_type_integer || obj->type == scm_type_float);
+/* integral floats are integers too, only exact ones are indexes */
+static int is_integral_float(scm_object *obj) {
+    double d = scm_float_get_val(obj);
+    return isfinite(d) && d == floor(d);
+}
+
+define_predicate(integer, obj->type == scm_type_integer || obj->type == scm_type_bignum ||
+                          (obj->type == scm_type_float && is_integral_float(obj)));
+define_predicate(exact_integer, obj->type == scm_type_integer || obj->type == scm_type_bignum);
+define_predicate(number, obj->type == scm_type_integer || obj->type == scm_type_bignum ||
+                         obj->type == scm_type_rational || obj->type == scm_type_float);
 define_predicate(string, obj->type == scm_type_string);
 define_predicate(symbol, obj->type == scm_type_identifier);
 define_predicate(pair, obj->type == scm_type_pair);
@@ -85,6 +333,13 @@ define_predicate(port, obj->type == scm_type_input_port || obj->type == scm_type
 define_predicate(procedure, obj->type == scm_type_primitive || obj->type == scm_type_compound);
 scm_object *pred_real = NULL;
 
+/* the types of the predicates above */
+#define BOOLEAN_TYPES   (SCM_TYPE_BIT(scm_type_true) | SCM_TYPE_BIT(scm_type_false))
+#define INTEGER_TYPES   (SCM_TYPE_BIT(scm_type_integer) | SCM_TYPE_BIT(scm_type_bignum))
+#define NUMBER_TYPES    (INTEGER_TYPES | SCM_TYPE_BIT(scm_type_rational) | SCM_TYPE_BIT(scm_type_float))
+#define PORT_TYPES      (SCM_TYPE_BIT(scm_type_input_port) | SCM_TYPE_BIT(scm_type_output_port))
+#define PROCEDURE_TYPES (SCM_TYPE_BIT(scm_type_primitive) | SCM_TYPE_BIT(scm_type_compound))
+
 
 /* singleton objects */
 
@@ -113,7 +368,7 @@ int same_object(scm_object *o1, scm_object *o2) {
     return o1 == o2;
 }
 
-scm_object_methods simple_methods = { NULL, always_eqv, always_eqv};
+scm_object_methods simple_methods = { NULL, always_eqv, always_eqv, NULL, NULL };
 
 static int initialized = 0;
 
@@ -127,21 +382,24 @@ int scm_object_init(void) {
     scm_object_register(scm_type_void, &simple_methods);
     scm_object_register(scm_type_null, &simple_methods);
 
-    pred_null = scm_primitive_new("null?", prim_is_null, 1, 1, NULL);
-    pred_eof = scm_primitive_new("eof-object?", prim_is_eof, 1, 1, NULL);
-    pred_boolean = scm_primitive_new("boolean?", prim_is_boolean, 1, 1, NULL);
-    pred_char = scm_primitive_new("char?", prim_is_char, 1, 1, NULL);
-    pred_integer = scm_primitive_new("integer?", prim_is_integer, 1, 1, NULL);
-    pred_real = scm_primitive_new("real?", prim_is_number, 1, 1, NULL);
-    pred_number = scm_primitive_new("number?", prim_is_number, 1, 1, NULL);
-    pred_string = scm_primitive_new("string?", prim_is_string, 1, 1, NULL);
-    pred_symbol = scm_primitive_new("symbol?", prim_is_symbol, 1, 1, NULL);
-    pred_pair = scm_primitive_new("pair?", prim_is_pair, 1, 1, NULL);
-    pred_vector = scm_primitive_new("vector?", prim_is_vector, 1, 1, NULL);
-    pred_input_port = scm_primitive_new("input-port?", prim_is_input_port, 1, 1, NULL);
-    pred_output_port = scm_primitive_new("output-port?", prim_is_output_port, 1, 1, NULL);
-    pred_port = scm_primitive_new("port?", prim_is_port, 1, 1, NULL);
-    pred_procedure = scm_primitive_new("procedure?", prim_is_procedure, 1, 1, NULL);
+    pred_null = scm_type_predicate_new("null?", prim_is_null, SCM_TYPE_BIT(scm_type_null));
+    pred_eof = scm_type_predicate_new("eof-object?", prim_is_eof, SCM_TYPE_BIT(scm_type_eof));
+    pred_boolean = scm_type_predicate_new("boolean?", prim_is_boolean, BOOLEAN_TYPES);
+    pred_char = scm_type_predicate_new("char?", prim_is_char, SCM_TYPE_BIT(scm_type_char));
+    pred_integer = scm_type_predicate_new("integer?", prim_is_integer, INTEGER_TYPES);
+    pred_exact_integer = scm_type_predicate_new("exact-integer?", prim_is_exact_integer, INTEGER_TYPES);
+    pred_real = scm_type_predicate_new("real?", prim_is_number, NUMBER_TYPES);
+    pred_number = scm_type_predicate_new("number?", prim_is_number, NUMBER_TYPES);
+    pred_string = scm_type_predicate_new("string?", prim_is_string, SCM_TYPE_BIT(scm_type_string));
+    pred_symbol = scm_type_predicate_new("symbol?", prim_is_symbol, SCM_TYPE_BIT(scm_type_identifier));
+    pred_pair = scm_type_predicate_new("pair?", prim_is_pair, SCM_TYPE_BIT(scm_type_pair));
+    pred_vector = scm_type_predicate_new("vector?", prim_is_vector, SCM_TYPE_BIT(scm_type_vector));
+    pred_input_port = scm_type_predicate_new("input-port?", prim_is_input_port,
+                                             SCM_TYPE_BIT(scm_type_input_port));
+    pred_output_port = scm_type_predicate_new("output-port?", prim_is_output_port,
+                                              SCM_TYPE_BIT(scm_type_output_port));
+    pred_port = scm_type_predicate_new("port?", prim_is_port, PORT_TYPES);
+    pred_procedure = scm_type_predicate_new("procedure?", prim_is_procedure, PROCEDURE_TYPES);
 
     initialized = 1;
     return 0;
@@ -152,6 +410,7 @@ int scm_object_init_env(scm_object *env) {
     scm_env_define_var(env, scm_symbol_new("boolean?", -1), pred_boolean);
     scm_env_define_var(env, scm_symbol_new("char?", -1), pred_char);
     scm_env_define_var(env, scm_symbol_new("integer?", -1), pred_integer);
+    scm_env_define_var(env, scm_symbol_new("exact-integer?", -1), pred_exact_integer);
     scm_env_define_var(env, scm_symbol_new("real?", -1), pred_real);
     scm_env_define_var(env, scm_symbol_new("number?", -1), pred_number);
     scm_env_define_var(env, scm_symbol_new("string?", -1), pred_string);
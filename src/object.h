@@ -1,5 +1,6 @@
 #ifndef SCHEME_OBJECT_H
 #define SCHEME_OBJECT_H
+#include <stddef.h>     /* size_t */
 #include <stdint.h>     /* intptr_t */
 
 /* no data: eof, true, false, null
@@ -14,12 +15,21 @@ typedef enum {
     scm_type_false,
     scm_type_char,
     scm_type_integer,
+    scm_type_bignum,
+    scm_type_rational,
     scm_type_float,
     scm_type_string,
     scm_type_identifier,
     scm_type_eidentifier,
     scm_type_pair,
     scm_type_vector,
+    scm_type_bytevector,
+    scm_type_numvector,
+    scm_type_record_type,
+    scm_type_record,
+    scm_type_pmap,
+    scm_type_pvector,
+    scm_type_hashtable,
     scm_type_input_port,
     scm_type_output_port,
     scm_type_primitive,
@@ -29,6 +39,12 @@ typedef enum {
     scm_type_max,
 } scm_type;
 
+/* sets of types, one bit each */
+typedef unsigned int scm_type_mask;
+#define SCM_TYPE_BIT(t)     (1u << (t))
+#define SCM_TYPES_ALL       (~0u)
+_Static_assert(scm_type_max <= 32, "a type mask has a bit for every type");
+
 typedef struct scm_object_st {
     scm_type type;
 } scm_object;
@@ -50,10 +66,17 @@ extern scm_object *scm_void;
 /* free function of the specific type */
 typedef void (*scm_object_free_fn)(scm_object *obj);
 typedef int (*scm_eq_fn)(scm_object *o1, scm_object *o2);
+/* consistent with eqv, by identity if not given */
+typedef size_t (*scm_hash_fn)(scm_object *obj);
+/* consistent with equal, visiting at most @budget components,
+ * the same as the eqv one if not given */
+typedef size_t (*scm_equal_hash_fn)(scm_object *obj, int *budget);
 typedef struct scm_object_methods_st {
     scm_object_free_fn free;
     scm_eq_fn eqv;
     scm_eq_fn equal;
+    scm_hash_fn hash;
+    scm_equal_hash_fn equal_hash;
 } scm_object_methods;
 
 scm_object *scm_boolean(int);
@@ -68,11 +91,20 @@ int scm_eq(scm_object *o1, scm_object *o2);
 int scm_eqv(scm_object *o1, scm_object *o2);
 int scm_equal(scm_object *o1, scm_object *o2);
 
+size_t scm_eqv_hash(scm_object *obj);
+size_t scm_equal_hash(scm_object *obj);
+size_t scm_equal_hash_bounded(scm_object *obj, int *budget);
+size_t scm_hash_mix(size_t h);
+size_t scm_hash_bytes(const void *buf, size_t len);
+#define scm_hash_combine(h, x) \
+    ((h) ^ ((x) + (size_t)0x9e3779b97f4a7c15ULL + ((h) << 6) + ((h) >> 2)))
+
 /* predicate primitives */
 extern scm_object *pred_null;
 extern scm_object *pred_boolean;
 extern scm_object *pred_char;
 extern scm_object *pred_integer;
+extern scm_object *pred_exact_integer;
 extern scm_object *pred_real;
 extern scm_object *pred_number;
 extern scm_object *pred_string;
@@ -2,6 +2,8 @@
 #include "number.h"
 #include "proc.h"
 #include "env.h"
+#include "err.h"
+#include "eval.h"
 
 #include <stdarg.h>
 #include <stdlib.h>
@@ -28,12 +30,16 @@ scm_object *scm_cons(scm_object *car, scm_object *cdr) {
 }
 define_primitive_2(cons);
 
+/* iterate along the cdrs, so that long lists don't exhaust the stack */
 static void pair_free(scm_object *pair) {
-    scm_pair *p = (scm_pair *)pair;
-    scm_object_free(p->car);
-    scm_object_free(p->cdr);
-
-    free(pair);
+    scm_pair *p;
+    while (pair->type == scm_type_pair) {
+        p = (scm_pair *)pair;
+        scm_object_free(p->car);
+        pair = p->cdr;
+        free(p);
+    }
+    scm_object_free(pair);
 }
 
 scm_object *scm_car(scm_object *pair) {
@@ -69,16 +75,6 @@ scm_object *scm_set_cdr(scm_object *pair, scm_object *o) {
 }
 define_primitive_2(set_cdr);
 
-static int pair_equal(scm_object *o1, scm_object *o2) {
-    if (same_object(o1, o2))
-        return 1;
-    scm_object *a1 = scm_car(o1);
-    scm_object *a2 = scm_car(o2);
-    scm_object *d1 = scm_cdr(o1);
-    scm_object *d2 = scm_cdr(o2);
-    return scm_equal(a1, a2) && scm_equal(d1, d2);
-}
-
 /* create a list */
 scm_object *scm_list(long count, ...) {
     va_list objs;
@@ -107,9 +103,12 @@ scm_object *scm_list(long count, ...) {
     return head;
 }
 
-static scm_object *prim_list(int n, scm_object *li) {
-    (void)n;
-    return li;
+/* the arguments are only lent, so the list is built of them here */
+static scm_object *prim_list(int n, scm_object **args) {
+    scm_object *list = scm_null;
+    while (n > 0)
+        list = scm_cons(args[--n], list);
+    return list;
 }
 
 scm_object *scm_list_ref(scm_object *list, long k) {
@@ -226,6 +225,130 @@ static scm_object *scm_is_list(scm_object *list) {
 }
 define_primitive_1(is_list);
 
+/* list primitives
+ * results are built front to back with a tail pointer in a single pass, and
+ * improper lists are reported by the argument that should be a list */
+static void not_list(const char *name, int n, scm_object *opd) {
+    scm_contract_violation(name, n, "list?", opd);
+}
+
+static scm_object *prim_length(int n, scm_object **args) {
+    long len = scm_list_length(args[0]);
+    (void)n;
+    if (len < 0)
+        not_list("length", 1, args[0]);
+    return INTEGER(len);
+}
+
+static scm_object *prim_append(int n, scm_object **args) {
+    scm_object *head = scm_null, *tail = NULL, *l, *p, *q;
+
+    for (int i = 1; i < n; ++i) {
+        l = args[i - 1];
+        for (p = l; p->type == scm_type_pair; p = scm_cdr(p)) {
+            q = scm_cons(scm_car(p), scm_null);
+            if (tail)
+                scm_set_cdr(tail, q);
+            else
+                head = q;
+            tail = q;
+        }
+        if (p != scm_null)
+            not_list("append", i, l);
+    }
+    if (n == 0)
+        return scm_null;
+    /* the last one is shared */
+    if (!tail)
+        return args[n - 1];
+    scm_set_cdr(tail, args[n - 1]);
+    return head;
+}
+
+static scm_object *prim_reverse(int n, scm_object **args) {
+    scm_object *l = args[0], *r = scm_null;
+    (void)n;
+
+    for (; l->type == scm_type_pair; l = scm_cdr(l))
+        r = scm_cons(scm_car(l), r);
+    if (l != scm_null)
+        not_list("reverse", 1, args[0]);
+    return r;
+}
+
+static scm_object *list_tail(const char *name, scm_object *l, scm_object *index) {
+    long k = scm_index_arg(name, 2, index);
+
+    for (long i = 0; i < k; ++i) {
+        if (l->type != scm_type_pair)
+            scm_error_object(l, "%s: index is too large for the list\nindex: %ld\nin: ", name, k);
+        l = scm_cdr(l);
+    }
+    return l;
+}
+
+static scm_object *prim_list_tail(int n, scm_object **args) {
+    (void)n;
+    return list_tail("list-tail", args[0], args[1]);
+}
+
+static scm_object *prim_list_ref(int n, scm_object **args) {
+    scm_object *p = list_tail("list-ref", args[0], args[1]);
+    (void)n;
+    if (p->type != scm_type_pair)
+        scm_error_object(args[0], "list-ref: index is too large for the list\nindex: %ld\nin: ",
+                         scm_integer_get_val(args[1]));
+    return scm_car(p);
+}
+
+static scm_object *mem_ex(const char *name, scm_object **args, scm_eq_fn eq) {
+    scm_object *o = args[0], *l = args[1];
+
+    for (; l->type == scm_type_pair; l = scm_cdr(l)) {
+        if (eq(o, scm_car(l)))
+            return l;
+    }
+    if (l != scm_null)
+        not_list(name, 2, args[1]);
+    return scm_false;
+}
+
+static scm_object *ass_ex(const char *name, scm_object **args, scm_eq_fn eq) {
+    scm_object *o = args[0], *l = args[1], *p;
+
+    for (; l->type == scm_type_pair; l = scm_cdr(l)) {
+        p = scm_car(l);
+        if (p->type != scm_type_pair)
+            scm_contract_violation(name, 2, "(listof pair?)", args[1]);
+        if (eq(o, scm_car(p)))
+            return p;
+    }
+    if (l != scm_null)
+        not_list(name, 2, args[1]);
+    return scm_false;
+}
+
+#define define_search_primitive(name, fn, eq) \
+    static scm_object *prim_##name(int n, scm_object **args) { \
+        (void)n; \
+        return fn(#name, args, eq); \
+    }
+
+define_search_primitive(memq, mem_ex, scm_eq)
+define_search_primitive(memv, mem_ex, scm_eqv)
+define_search_primitive(member, mem_ex, scm_equal)
+define_search_primitive(assq, ass_ex, scm_eq)
+define_search_primitive(assv, ass_ex, scm_eqv)
+define_search_primitive(assoc, ass_ex, scm_equal)
+
+static scm_object *prim_map(int n, scm_object **args) {
+    return scm_map("map", n, args, 0, 1);
+}
+
+static scm_object *prim_for_each(int n, scm_object **args) {
+    return scm_map("for-each", n, args, 0, 0);
+}
+
 scm_object *scm_caar(scm_object *pair) {
     return scm_car(scm_car(pair));
 }
@@ -338,7 +461,22 @@ scm_object *scm_cddddr(scm_object *pair) {
     return scm_cdr(scm_cdr(scm_cdr(scm_cdr(pair))));
 }
 
-static scm_object_methods pair_methods = { pair_free, same_object, pair_equal };
+/* down the cdrs in a loop so that long lists don't deepen the stack */
+static size_t pair_equal_hash(scm_object *obj, int *budget) {
+    size_t h = scm_type_pair;
+
+    while (obj->type == scm_type_pair && *budget > 0) {
+        --*budget;
+        h = scm_hash_combine(h, scm_equal_hash_bounded(scm_car(obj), budget));
+        obj = scm_cdr(obj);
+    }
+    if (obj->type != scm_type_pair)
+        h = scm_hash_combine(h, scm_equal_hash_bounded(obj, budget));
+    return h;
+}
+
+/* equal? of pairs and vectors is walked by scm_equal */
+static scm_object_methods pair_methods = { pair_free, same_object, NULL, NULL, pair_equal_hash };
 
 static int initialized = 0;
 
@@ -359,6 +497,19 @@ int scm_pair_init_env(scm_object *env) {
     scm_env_add_prim(env, "set-cdr!", prim_set_cdr, 2, 2, scm_list(1, pred_pair));
     scm_env_add_prim(env, "list", prim_list, 0, -1, NULL);
     scm_env_add_prim(env, "list?", prim_is_list, 1, 1, NULL);
+    scm_env_add_prim(env, "length", prim_length, 1, 1, NULL);
+    scm_env_add_prim(env, "append", prim_append, 0, -1, NULL);
+    scm_env_add_prim(env, "reverse", prim_reverse, 1, 1, NULL);
+    scm_env_add_prim(env, "list-tail", prim_list_tail, 2, 2, NULL);
+    scm_env_add_prim(env, "list-ref", prim_list_ref, 2, 2, NULL);
+    scm_env_add_prim(env, "memq", prim_memq, 2, 2, NULL);
+    scm_env_add_prim(env, "memv", prim_memv, 2, 2, NULL);
+    scm_env_add_prim(env, "member", prim_member, 2, 2, NULL);
+    scm_env_add_prim(env, "assq", prim_assq, 2, 2, NULL);
+    scm_env_add_prim(env, "assv", prim_assv, 2, 2, NULL);
+    scm_env_add_prim(env, "assoc", prim_assoc, 2, 2, NULL);
+    scm_env_add_prim(env, "map", prim_map, 2, -1, NULL);
+    scm_env_add_prim(env, "for-each", prim_for_each, 2, -1, NULL);
 
     return 0;
 }
@@ -0,0 +1,454 @@
+#include "pmap.h"
+#include "number.h"
+#include "pair.h"
+#include "symbol.h"
+#include "proc.h"
+#include "env.h"
+#include "err.h"
+#include "eval.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* each node takes the next 5 bits of the hash of a key, and keeps the
+ * entries and subnodes of the set bits of its bitmap in a dense array in
+ * the order of the bits
+ * when the bits run out, the keys of the same hash are kept in a
+ * collision node, a plain array without a bitmap */
+
+#define BITS        5
+#define WIDTH       (1 << BITS)
+#define HASH_BITS   ((int)sizeof(size_t) * 8)
+
+typedef struct hnode_st hnode;
+
+typedef struct slot_st {
+    scm_object *key;    /* NULL for a subnode */
+    union {
+        scm_object *val;
+        hnode *node;
+    } u;
+    size_t hash;
+} slot;
+
+struct hnode_st {
+    int refs;
+    int count;
+    uint32_t bitmap;
+    slot slots[];
+};
+
+typedef struct scm_pmap_st {
+    scm_object base;
+    int equal;
+    long count;
+    hnode *root;    /* NULL if empty */
+} scm_pmap;
+
+scm_object *pred_pmap = NULL;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define popcount(x) __builtin_popcount(x)
+#else
+static int popcount(uint32_t x) {
+    int n = 0;
+    for (; x; x &= x - 1)
+        ++n;
+    return n;
+}
+#endif
+
+#define bit_of(hash, shift) ((uint32_t)1 << (((hash) >> (shift)) & (WIDTH - 1)))
+#define index_of(bitmap, bit) popcount((bitmap) & ((bit) - 1))
+
+static size_t hash_of(int equal, scm_object *key) {
+    return equal ? scm_equal_hash(key) : scm_eqv_hash(key);
+}
+
+static int same_key(int equal, scm_object *k1, scm_object *k2) {
+    return k1 == k2 || (equal ? scm_equal(k1, k2) : scm_eqv(k1, k2));
+}
+
+static hnode *node_new(int count, uint32_t bitmap) {
+    hnode *n = malloc(sizeof(hnode) + count * sizeof(slot));
+    n->refs = 1;
+    n->count = count;
+    n->bitmap = bitmap;
+    return n;
+}
+
+static void node_release(hnode *n) {
+    if (--n->refs)
+        return;
+    for (int i = 0; i < n->count; ++i) {
+        if (!n->slots[i].key)
+            node_release(n->slots[i].u.node);
+    }
+    free(n);
+}
+
+/* a copy of @n with @remove slots at @i replaced by the @insert ones of @in,
+ * whose subnodes are handed over, sharing the subnodes kept */
+static hnode *node_splice(hnode *n, uint32_t bitmap, int i, int remove, const slot *in, int insert) {
+    int count = n->count - remove + insert;
+    hnode *c = node_new(count, bitmap);
+
+    memcpy(c->slots, n->slots, i * sizeof(slot));
+    if (insert)
+        memcpy(c->slots + i, in, insert * sizeof(slot));
+    memcpy(c->slots + i + insert, n->slots + i + remove, (n->count - i - remove) * sizeof(slot));
+    for (int j = 0; j < count; ++j) {
+        if (!c->slots[j].key && (j < i || j >= i + insert))
+            ++c->slots[j].u.node->refs;
+    }
+    return c;
+}
+
+static slot subnode(hnode *n) {
+    slot s;
+    s.key = NULL;
+    s.u.node = n;
+    s.hash = 0;
+    return s;
+}
+
+/* the node of two entries of different keys from @shift on */
+static hnode *node_pair(const slot *a, const slot *b, int shift) {
+    uint32_t ba, bb;
+    hnode *n;
+    slot s;
+
+    if (shift >= HASH_BITS) {
+        n = node_new(2, 0);
+        n->slots[0] = *a;
+        n->slots[1] = *b;
+        return n;
+    }
+    ba = bit_of(a->hash, shift);
+    bb = bit_of(b->hash, shift);
+    if (ba == bb) {
+        n = node_new(1, ba);
+        s = subnode(node_pair(a, b, shift + BITS));
+        n->slots[0] = s;
+        return n;
+    }
+    n = node_new(2, ba | bb);
+    n->slots[ba < bb ? 0 : 1] = *a;
+    n->slots[ba < bb ? 1 : 0] = *b;
+    return n;
+}
+
+static slot *node_lookup(int equal, hnode *n, scm_object *key, size_t h) {
+    uint32_t bit;
+    slot *s;
+
+    for (int shift = 0; ; shift += BITS) {
+        if (shift >= HASH_BITS) {
+            for (int i = 0; i < n->count; ++i) {
+                if (same_key(equal, n->slots[i].key, key))
+                    return n->slots + i;
+            }
+            return NULL;
+        }
+        bit = bit_of(h, shift);
+        if (!(n->bitmap & bit))
+            return NULL;
+        s = n->slots + index_of(n->bitmap, bit);
+        if (s->key)
+            return s->hash == h && same_key(equal, s->key, key) ? s : NULL;
+        n = s->u.node;
+    }
+}
+
+/* the new node with the entry @e, @added set if its key wasn't there */
+static hnode *node_set(int equal, hnode *n, int shift, const slot *e, int *added) {
+    uint32_t bit;
+    slot *s, in;
+    int i;
+
+    if (shift >= HASH_BITS) {
+        for (i = 0; i < n->count; ++i) {
+            if (same_key(equal, n->slots[i].key, e->key))
+                return node_splice(n, 0, i, 1, e, 1);
+        }
+        *added = 1;
+        return node_splice(n, 0, n->count, 0, e, 1);
+    }
+
+    bit = bit_of(e->hash, shift);
+    i = index_of(n->bitmap, bit);
+    if (!(n->bitmap & bit)) {
+        *added = 1;
+        return node_splice(n, n->bitmap | bit, i, 0, e, 1);
+    }
+    s = n->slots + i;
+    if (!s->key)
+        in = subnode(node_set(equal, s->u.node, shift + BITS, e, added));
+    else if (s->hash == e->hash && same_key(equal, s->key, e->key))
+        in = *e;
+    else {
+        *added = 1;
+        in = subnode(node_pair(s, e, shift + BITS));
+    }
+    return node_splice(n, n->bitmap, i, 1, &in, 1);
+}
+
+/* the new node without @key, NULL if none is left, or @n itself with one
+ * more reference if @key wasn't there */
+static hnode *node_delete(int equal, hnode *n, int shift, scm_object *key, size_t h, int *removed) {
+    uint32_t bit;
+    hnode *child;
+    slot *s, in;
+    int i;
+
+    if (shift >= HASH_BITS) {
+        for (i = 0; i < n->count; ++i) {
+            if (same_key(equal, n->slots[i].key, key)) {
+                *removed = 1;
+                return n->count == 1 ? NULL : node_splice(n, 0, i, 1, NULL, 0);
+            }
+        }
+        ++n->refs;
+        return n;
+    }
+
+    bit = bit_of(h, shift);
+    i = index_of(n->bitmap, bit);
+    s = n->slots + i;
+    if (!(n->bitmap & bit) || (s->key && (s->hash != h || !same_key(equal, s->key, key)))) {
+        ++n->refs;
+        return n;
+    }
+    if (s->key) {
+        *removed = 1;
+        return n->count == 1 ? NULL : node_splice(n, n->bitmap & ~bit, i, 1, NULL, 0);
+    }
+
+    child = node_delete(equal, s->u.node, shift + BITS, key, h, removed);
+    if (!*removed) {
+        node_release(child);
+        ++n->refs;
+        return n;
+    }
+    if (!child)
+        return n->count == 1 ? NULL : node_splice(n, n->bitmap & ~bit, i, 1, NULL, 0);
+    /* a single entry left below moves up here */
+    if (child->count == 1 && child->slots[0].key) {
+        in = child->slots[0];
+        node_release(child);
+    }
+    else
+        in = subnode(child);
+    return node_splice(n, n->bitmap, i, 1, &in, 1);
+}
+
+static scm_object *node_to_alist(hnode *n, scm_object *l) {
+    for (int i = 0; i < n->count; ++i) {
+        if (n->slots[i].key)
+            l = scm_cons(scm_cons(n->slots[i].key, n->slots[i].u.val), l);
+        else
+            l = node_to_alist(n->slots[i].u.node, l);
+    }
+    return l;
+}
+
+static scm_object *pmap_alloc(int equal, long count, hnode *root) {
+    scm_pmap *m = malloc(sizeof(scm_pmap));
+
+    m->base.type = scm_type_pmap;
+    m->equal = equal;
+    m->count = count;
+    m->root = root;
+
+    return (scm_object *)m;
+}
+
+scm_object *scm_eqv_pmap_new(void) {
+    return pmap_alloc(0, 0, NULL);
+}
+
+scm_object *scm_equal_pmap_new(void) {
+    return pmap_alloc(1, 0, NULL);
+}
+
+scm_object *scm_pmap_ref(scm_object *map, scm_object *key, scm_object *dflt) {
+    scm_pmap *m = (scm_pmap *)map;
+    slot *s;
+
+    if (!m->root)
+        return dflt;
+    s = node_lookup(m->equal, m->root, key, hash_of(m->equal, key));
+    return s ? s->u.val : dflt;
+}
+
+scm_object *scm_pmap_set(scm_object *map, scm_object *key, scm_object *val) {
+    scm_pmap *m = (scm_pmap *)map;
+    hnode *root;
+    int added = 0;
+    slot e;
+
+    e.key = key;
+    e.u.val = val;
+    e.hash = hash_of(m->equal, key);
+    if (!m->root) {
+        root = node_new(1, bit_of(e.hash, 0));
+        root->slots[0] = e;
+        added = 1;
+    }
+    else
+        root = node_set(m->equal, m->root, 0, &e, &added);
+    return pmap_alloc(m->equal, m->count + added, root);
+}
+
+scm_object *scm_pmap_delete(scm_object *map, scm_object *key) {
+    scm_pmap *m = (scm_pmap *)map;
+    hnode *root;
+    int removed = 0;
+
+    if (!m->root)
+        return pmap_alloc(m->equal, 0, NULL);
+    root = node_delete(m->equal, m->root, 0, key, hash_of(m->equal, key), &removed);
+    return pmap_alloc(m->equal, m->count - removed, root);
+}
+
+long scm_pmap_count(scm_object *map) {
+    return ((scm_pmap *)map)->count;
+}
+
+scm_object *scm_pmap_to_alist(scm_object *map) {
+    scm_pmap *m = (scm_pmap *)map;
+    return m->root ? node_to_alist(m->root, scm_null) : scm_null;
+}
+
+static void pmap_free(scm_object *obj) {
+    scm_pmap *m = (scm_pmap *)obj;
+    if (m->root)
+        node_release(m->root);
+    free(m);
+}
+
+/* primitives */
+static scm_object *prim_is_pmap(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(args[0]->type == scm_type_pmap);
+}
+
+static scm_object *prim_make_eqv_pmap(int n, scm_object **args) {
+    (void)n; (void)args;
+    return scm_eqv_pmap_new();
+}
+
+static scm_object *prim_make_equal_pmap(int n, scm_object **args) {
+    (void)n; (void)args;
+    return scm_equal_pmap_new();
+}
+
+/* (alist->pmap alist [equal-keys?]), the first association of a key wins */
+static scm_object *prim_alist_to_pmap(int n, scm_object **args) {
+    scm_object *l = args[0], *map, *p;
+
+    if (scm_list_length(l) < 0)
+        scm_contract_violation("alist->pmap", 1, "list?", l);
+    map = n > 1 && args[1] == scm_false ? scm_eqv_pmap_new() : scm_equal_pmap_new();
+    for (; l != scm_null; l = scm_cdr(l)) {
+        p = scm_car(l);
+        if (p->type != scm_type_pair)
+            scm_contract_violation("alist->pmap", 1, "(listof pair?)", args[0]);
+        if (!scm_pmap_ref(map, scm_car(p), NULL))
+            map = scm_pmap_set(map, scm_car(p), scm_cdr(p));
+    }
+    return map;
+}
+
+static scm_object *prim_pmap_ref(int n, scm_object **args) {
+    scm_object *key = args[1];
+    scm_object *val = scm_pmap_ref(args[0], key, NULL);
+
+    if (val)
+        return val;
+    if (n == 3) {
+        if (args[2]->type != scm_type_primitive && args[2]->type != scm_type_compound)
+            scm_contract_violation("pmap-ref", 3, "procedure?", args[2]);
+        return scm_apply(args[2], 0, NULL);
+    }
+    scm_error_object(key, "pmap-ref: no value found for key\nkey: ");
+    return NULL;
+}
+
+static scm_object *prim_pmap_ref_default(int n, scm_object **args) {
+    (void)n;
+    return scm_pmap_ref(args[0], args[1], args[2]);
+}
+
+static scm_object *prim_pmap_set(int n, scm_object **args) {
+    (void)n;
+    return scm_pmap_set(args[0], args[1], args[2]);
+}
+
+static scm_object *prim_pmap_delete(int n, scm_object **args) {
+    (void)n;
+    return scm_pmap_delete(args[0], args[1]);
+}
+
+static scm_object *prim_pmap_contains(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(scm_pmap_ref(args[0], args[1], NULL) != NULL);
+}
+
+static scm_object *prim_pmap_size(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(scm_pmap_count(args[0]));
+}
+
+static scm_object *prim_pmap_to_alist(int n, scm_object **args) {
+    (void)n;
+    return scm_pmap_to_alist(args[0]);
+}
+
+static scm_object *prim_pmap_fold(int n, scm_object **args) {
+    scm_object *proc = args[1], *acc = args[2], *p, *opds[3];
+    (void)n;
+
+    for (scm_object *l = scm_pmap_to_alist(args[0]); l != scm_null; l = scm_cdr(l)) {
+        p = scm_car(l);
+        opds[0] = scm_car(p);
+        opds[1] = scm_cdr(p);
+        opds[2] = acc;
+        acc = scm_apply(proc, 3, opds);
+    }
+    return acc;
+}
+
+static scm_object_methods pmap_methods = { pmap_free, same_object, same_object, NULL, NULL };
+
+static int initialized = 0;
+
+int scm_pmap_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_pmap, &pmap_methods);
+    pred_pmap = scm_type_predicate_new("pmap?", prim_is_pmap, SCM_TYPE_BIT(scm_type_pmap));
+
+    initialized = 1;
+    return 0;
+}
+
+int scm_pmap_init_env(scm_object *env) {
+    scm_object *pred_map = scm_list(1, pred_pmap);
+
+    scm_env_define_var(env, scm_symbol_new("pmap?", -1), pred_pmap);
+    scm_env_add_prim(env, "make-pmap", prim_make_equal_pmap, 0, 0, NULL);
+    scm_env_add_prim(env, "make-eqv-pmap", prim_make_eqv_pmap, 0, 0, NULL);
+    scm_env_add_prim(env, "make-equal-pmap", prim_make_equal_pmap, 0, 0, NULL);
+    scm_env_add_prim(env, "alist->pmap", prim_alist_to_pmap, 1, 2, NULL);
+    scm_env_add_prim(env, "pmap-ref", prim_pmap_ref, 2, 3, pred_map);
+    scm_env_add_prim(env, "pmap-ref/default", prim_pmap_ref_default, 3, 3, pred_map);
+    scm_env_add_prim(env, "pmap-set", prim_pmap_set, 3, 3, pred_map);
+    scm_env_add_prim(env, "pmap-delete", prim_pmap_delete, 2, 2, pred_map);
+    scm_env_add_prim(env, "pmap-contains?", prim_pmap_contains, 2, 2, pred_map);
+    scm_env_add_prim(env, "pmap-size", prim_pmap_size, 1, 1, pred_map);
+    scm_env_add_prim(env, "pmap->alist", prim_pmap_to_alist, 1, 1, pred_map);
+    scm_env_add_prim(env, "pmap-fold", prim_pmap_fold, 3, 3, scm_list(2, pred_pmap, pred_procedure));
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef SCHEME_PMAP_H
+#define SCHEME_PMAP_H
+#include "object.h"
+
+/* persistent maps keyed by eqv? or equal?, hash array mapped tries of 32-way
+ * nodes, so an update copies the O(log32 n) nodes on the path to its key
+ * and shares all the others with the map it came from
+ * the nodes are reference counted, freeing a map only releases its own */
+
+extern scm_object *pred_pmap;
+
+/* empty */
+scm_object *scm_eqv_pmap_new(void);
+scm_object *scm_equal_pmap_new(void);
+
+/* @dflt if not found, which may be NULL */
+scm_object *scm_pmap_ref(scm_object *map, scm_object *key, scm_object *dflt);
+/* the new map, @map is unchanged */
+scm_object *scm_pmap_set(scm_object *map, scm_object *key, scm_object *val);
+scm_object *scm_pmap_delete(scm_object *map, scm_object *key);
+long scm_pmap_count(scm_object *map);
+/* ((key . val) ...) in no particular order */
+scm_object *scm_pmap_to_alist(scm_object *map);
+
+int scm_pmap_init(void);
+int scm_pmap_init_env(scm_object *env);
+
+#endif /* SCHEME_PMAP_H */
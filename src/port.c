@@ -1,5 +1,10 @@
 #include "port.h"
 #include "sys.h"
+#include "proc.h"
+#include "env.h"
+#include "string.h"
+#include "char.h"
+#include "number.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -39,15 +44,20 @@ struct scm_output_port_st {
 };
 
 typedef int (*writec_fn)(scm_output_port *, char);
+typedef int (*write_fn)(scm_output_port *, const char *, int);
+typedef int (*flush_fn)(scm_output_port *);
 
 enum {
     oport_type_string = 0,
+    oport_type_string_buffer,
     oport_type_file,
     oport_type_max,
 };
 
 static struct oport_callbacks_st {
     writec_fn writec;
+    write_fn write;
+    flush_fn flush;
     scm_object_free_fn free;
     scm_eq_fn eqv;
 } oport_callbacks[oport_type_max];
@@ -64,7 +74,7 @@ typedef struct string_input_port_st string_input_port;
 
 static int string_input_port_readc(scm_input_port *port) {
     if (port->cache_pos) {
-        return port->cache[--(port->cache_pos)];
+        return (unsigned char)port->cache[--(port->cache_pos)];
     }
 
     string_input_port *p = (string_input_port *)port;
@@ -72,7 +82,7 @@ static int string_input_port_readc(scm_input_port *port) {
         return -1;  /* eof */
     }
     else {
-        return p->buf[p->pos++];
+        return (unsigned char)p->buf[p->pos++];
     }
 }
 
@@ -97,7 +107,7 @@ typedef struct file_input_port_st file_input_port;
 
 static int file_input_port_readc(scm_input_port *port) {
     if (port->cache_pos) {
-        return port->cache[--(port->cache_pos)];
+        return (unsigned char)port->cache[--(port->cache_pos)];
     }
 
     file_input_port *p = (file_input_port *)port;
@@ -142,6 +152,22 @@ static int string_output_port_writec(scm_output_port *port, char c) {
     return 1;
 }
 
+static int string_output_port_write(scm_output_port *port, const char *s, int len) {
+    string_output_port *p = (string_output_port *)port;
+    if (len > (int)(p->size - p->pos)) {
+        len = p->size - p->pos;
+    }
+
+    memcpy(p->buf + p->pos, s, len);
+    p->pos += len;
+    return len;
+}
+
+static int string_output_port_flush(scm_output_port *port) {
+    (void)port;
+    return 0;
+}
+
 static void string_output_port_free(scm_object *port) {
     free(port);
     return;
@@ -149,29 +175,116 @@ static void string_output_port_free(scm_object *port) {
 
 static void string_output_port_register() {
     oport_callbacks[oport_type_string].writec = string_output_port_writec;
+    oport_callbacks[oport_type_string].write = string_output_port_write;
+    oport_callbacks[oport_type_string].flush = string_output_port_flush;
     oport_callbacks[oport_type_string].free = string_output_port_free;
     oport_callbacks[oport_type_string].eqv = same_object;
     return;
 }
 
+/* string_buffer_output_port, grows as needed */
+#define STRING_BUFFER_INIT_SIZE 64
+
+struct string_buffer_output_port_st {
+    scm_output_port base;
+    char *buf;
+    size_t size;
+    size_t pos;
+};
+typedef struct string_buffer_output_port_st string_buffer_output_port;
+
+/* keep room for @len more bytes and the terminating NUL */
+static void string_buffer_reserve(string_buffer_output_port *p, size_t len) {
+    size_t size = p->size;
+    if (p->pos + len < size)
+        return;
+
+    while (p->pos + len >= size)
+        size *= 2;
+    p->buf = realloc(p->buf, size);
+    p->size = size;
+}
+
+static int string_buffer_output_port_writec(scm_output_port *port, char c) {
+    string_buffer_output_port *p = (string_buffer_output_port *)port;
+    string_buffer_reserve(p, 1);
+    p->buf[p->pos++] = c;
+    return 1;
+}
+
+static int string_buffer_output_port_write(scm_output_port *port, const char *s, int len) {
+    string_buffer_output_port *p = (string_buffer_output_port *)port;
+    string_buffer_reserve(p, len);
+    memcpy(p->buf + p->pos, s, len);
+    p->pos += len;
+    return len;
+}
+
+static void string_buffer_output_port_free(scm_object *port) {
+    string_buffer_output_port *p = (string_buffer_output_port *)port;
+    free(p->buf);
+    free(p);
+    return;
+}
+
+static void string_buffer_output_port_register() {
+    oport_callbacks[oport_type_string_buffer].writec = string_buffer_output_port_writec;
+    oport_callbacks[oport_type_string_buffer].write = string_buffer_output_port_write;
+    oport_callbacks[oport_type_string_buffer].flush = string_output_port_flush;
+    oport_callbacks[oport_type_string_buffer].free = string_buffer_output_port_free;
+    oport_callbacks[oport_type_string_buffer].eqv = same_object;
+    return;
+}
+
 /* file_output_port */
+#define FILE_OPORT_BUF_SIZE 4096
+
 struct file_output_port_st {
     scm_output_port base;
     FILE *fp;
+    size_t pos;
+    char buf[FILE_OPORT_BUF_SIZE];
 };
 typedef struct file_output_port_st file_output_port;
 
+static int file_output_port_flush(scm_output_port *port) {
+    file_output_port *p = (file_output_port *)port;
+    size_t n = fwrite(p->buf, 1, p->pos, p->fp);
+    int failed = n != p->pos;
+
+    p->pos = 0;
+    if (fflush(p->fp) == EOF)
+        failed = 1;
+    return failed;
+}
+
 static int file_output_port_writec(scm_output_port *port, char c) {
     file_output_port *p = (file_output_port *)port;
-    int ret = fputc(c, p->fp);
-    if (ret == EOF)
+    if (p->pos == FILE_OPORT_BUF_SIZE && file_output_port_flush(port))
         return 0;
-    else
-        return 1;
+
+    p->buf[p->pos++] = c;
+    return 1;
+}
+
+static int file_output_port_write(scm_output_port *port, const char *s, int len) {
+    file_output_port *p = (file_output_port *)port;
+    if (p->pos + len > FILE_OPORT_BUF_SIZE) {
+        if (file_output_port_flush(port))
+            return 0;
+        /* too large to be worth copying */
+        if (len >= FILE_OPORT_BUF_SIZE)
+            return fwrite(s, 1, len, p->fp);
+    }
+
+    memcpy(p->buf + p->pos, s, len);
+    p->pos += len;
+    return len;
 }
 
 static void file_output_port_free(scm_object *port) {
     file_output_port *p = (file_output_port *)port;
+    file_output_port_flush((scm_output_port *)port);
     fclose(p->fp);
     free(p);
     return;
@@ -179,6 +292,8 @@ static void file_output_port_free(scm_object *port) {
 
 static void file_output_port_register() {
     oport_callbacks[oport_type_file].writec = file_output_port_writec;
+    oport_callbacks[oport_type_file].write = file_output_port_write;
+    oport_callbacks[oport_type_file].flush = file_output_port_flush;
     oport_callbacks[oport_type_file].free = file_output_port_free;
     oport_callbacks[oport_type_file].eqv = same_object;
     return;
@@ -188,7 +303,7 @@ static void file_output_port_register() {
 /* public */
 
 /* use the external buffer */
-scm_object *string_input_port_new(const char *buf, int size) {
+scm_object *string_input_port_new(const char *buf, long size) {
     if (buf == NULL) {
         return NULL;
     }
@@ -277,6 +392,56 @@ int scm_input_port_peekc(scm_object *obj) {
     return c;
 }
 
+/* a character of UTF-8 and the @k bytes of it in @buf, U+FFFD for an
+ * ill-formed sequence */
+static int read_sequence(scm_object *obj, char *buf, int *k) {
+    int c = scm_input_port_readc(obj), len, i;
+
+    *k = 0;
+    if (c < 0x80)
+        return c;
+    buf[0] = c;
+    len = c < 0xc2 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf5 ? 4 : 1;
+    for (i = 1; i < len; ++i) {
+        c = scm_input_port_peekc(obj);
+        if (c == -1 || (c & 0xc0) != 0x80)
+            break;
+        buf[i] = scm_input_port_readc(obj);
+    }
+    *k = i;
+    if (scm_utf8_validate(buf, i) != 1)
+        return 0xfffd;
+    scm_utf8_decode(buf, &c);
+    return c;
+}
+
+int scm_input_port_read_char(scm_object *obj) {
+    char buf[SCM_UTF8_MAX];
+    int k;
+
+    return read_sequence(obj, buf, &k);
+}
+
+/* the bytes read are put back, the cache holds the longest sequence */
+int scm_input_port_peek_char(scm_object *obj) {
+    char buf[SCM_UTF8_MAX];
+    int c, k;
+
+    c = read_sequence(obj, buf, &k);
+    if (k == 0 && c != -1)
+        scm_input_port_unreadc(obj, c);
+    while (k > 0)
+        scm_input_port_unreadc(obj, (unsigned char)buf[--k]);
+    return c;
+}
+
+/* the bytes of the encoding of @c */
+int scm_output_port_write_char(scm_object *obj, int c) {
+    char buf[SCM_UTF8_MAX];
+
+    return scm_output_port_write(obj, buf, scm_utf8_encode(c, buf));
+}
+
 static void iport_free(scm_object *obj) {
     scm_input_port *port = (scm_input_port *)obj;
     iport_callbacks[port->type].free(obj);
@@ -314,6 +479,47 @@ scm_object *string_output_port_new(char *buf, int size) {
     return (scm_object *)port;
 }
 
+/* use an internal buffer which grows as needed */
+scm_object *string_output_port_open(void) {
+    string_buffer_output_port *port = malloc(sizeof(string_buffer_output_port));
+    if (port == NULL) {
+        return NULL;
+    }
+
+    port->base.base.type = scm_type_output_port;
+    port->base.type = oport_type_string_buffer;
+    port->buf = malloc(STRING_BUFFER_INIT_SIZE);
+    port->size = STRING_BUFFER_INIT_SIZE;
+    port->pos = 0;
+
+    return (scm_object *)port;
+}
+
+/* the NUL terminated content of a port from string_output_port_open,
+ * valid until the next write. return NULL for other ports */
+const char *scm_output_port_string(scm_object *obj, long *len) {
+    scm_output_port *port = (scm_output_port *)obj;
+    if (obj->type != scm_type_output_port ||
+        port->type != oport_type_string_buffer) {
+        return NULL;
+    }
+
+    string_buffer_output_port *p = (string_buffer_output_port *)port;
+    p->buf[p->pos] = '\0';
+    if (len)
+        *len = p->pos;
+    return p->buf;
+}
+
+/* empty a port from string_output_port_open, keeping its buffer */
+void scm_output_port_string_reset(scm_object *obj) {
+    scm_output_port *port = (scm_output_port *)obj;
+    if (obj->type == scm_type_output_port &&
+        port->type == oport_type_string_buffer) {
+        ((string_buffer_output_port *)port)->pos = 0;
+    }
+}
+
 scm_object *file_output_port_new(FILE *fp) {
     file_output_port *port = calloc(1, sizeof(file_output_port));
     if (port == NULL) {
@@ -350,22 +556,110 @@ int scm_output_port_writec(scm_object *obj, char c) {
     return oport_callbacks[port->type].writec(port, c);
 }
 
+int scm_output_port_write(scm_object *obj, const char *p, int len) {
+    scm_output_port *port = (scm_output_port *)obj;
+
+    return oport_callbacks[port->type].write(port, p, len);
+}
+
 int scm_output_port_puts(scm_object *obj, const char *p) {
+    return scm_output_port_write(obj, p, strlen(p));
+}
+
+/* return 0 on success */
+int scm_output_port_flush(scm_object *obj) {
     scm_output_port *port = (scm_output_port *)obj;
-    int i = 0;
-    char c;
-    while ((c = *(p++))) {
-        i += oport_callbacks[port->type].writec(port, c);
-    }
 
-    return i;
+    return oport_callbacks[port->type].flush(port);
 }
 
+static scm_object *scm_flush_output(int n, scm_object **args) {
+    scm_object *port = n ? args[0] : default_oport;
+    if (scm_output_port_flush(port))
+        scm_error_object(port, "flush-output: error writing to the port\nport: ");
+    return scm_void;
+}
+define_primitive_0n(flush_output);
+
+static scm_object *scm_open_output_string() {
+    return string_output_port_open();
+}
+define_primitive_0(open_output_string);
+
+static scm_object *scm_get_output_string(scm_object *port) {
+    long len;
+    const char *s = scm_output_port_string(port, &len);
+    if (s == NULL)
+        scm_contract_violation("get-output-string", 1, "string output port", port);
+    return scm_string_copy_new(s, len);
+}
+define_primitive_1(get_output_string);
+
 int scm_newline(scm_object *obj) {
     scm_output_port *port = (scm_output_port *)obj;
     return oport_callbacks[port->type].writec(port, '\n');
 }
 
+/* the characters are shared, the string copies them before it's changed */
+static scm_object *scm_open_input_string(scm_object *str) {
+    return string_input_port_new(scm_string_share_str(str), scm_string_size(str));
+}
+define_primitive_1(open_input_string);
+
+static scm_object *input_port_arg(const char *name, int n, scm_object **args) {
+    if (n < 1)
+        return default_iport;
+
+    scm_object *port = args[0];
+    if (port->type != scm_type_input_port)
+        scm_contract_violation(name, 1, "input-port?", port);
+    return port;
+}
+
+static scm_object *prim_read_char(int n, scm_object **args) {
+    int c = scm_input_port_read_char(input_port_arg("read-char", n, args));
+    return c == EOF ? scm_eof : scm_char_new(c);
+}
+
+static scm_object *prim_peek_char(int n, scm_object **args) {
+    int c = scm_input_port_peek_char(input_port_arg("peek-char", n, args));
+    return c == EOF ? scm_eof : scm_char_new(c);
+}
+
+static scm_object *output_port_arg(const char *name, int n, int i, scm_object **args) {
+    if (n < i)
+        return default_oport;
+
+    scm_object *port = args[i - 1];
+    if (port->type != scm_type_output_port)
+        scm_contract_violation(name, i, "output-port?", port);
+    return port;
+}
+
+static scm_object *prim_write_char(int n, scm_object **args) {
+    scm_output_port_write_char(output_port_arg("write-char", n, 2, args), scm_char_get_codepoint(args[0]));
+    return scm_void;
+}
+
+/* (write-string string [port [start [end]]]) */
+static scm_object *prim_write_string(int n, scm_object **args) {
+    scm_object *str = args[0];
+    scm_object *port = output_port_arg("write-string", n, 2, args);
+    long start, end;
+
+    scm_range_args("write-string", n, 3, args, str, "string", scm_string_length(str), &start, &end);
+    if (end > start) {
+        str = scm_substring(str, start, end);
+        scm_output_port_write(port, scm_string_get_str(str), scm_string_size(str));
+    }
+    return scm_void;
+}
+
+static scm_object *prim_newline(int n, scm_object **args) {
+    scm_newline(output_port_arg("newline", n, 1, args));
+    return scm_void;
+}
+
 static void oport_free(scm_object *obj) {
     scm_output_port *port = (scm_output_port *)obj;
     oport_callbacks[port->type].free(obj);
@@ -380,8 +674,17 @@ static int oport_eqv(scm_object *o1, scm_object *o2) {
     return oport_callbacks[p1->type].eqv(o1, o2);
 }
 
-static scm_object_methods input_methods = { iport_free, iport_eqv, iport_eqv };
-static scm_object_methods output_methods = { oport_free, oport_eqv, oport_eqv };
+/* the eqv of each kind of ports is up to itself */
+static size_t iport_hash(scm_object *obj) {
+    return scm_hash_mix(((scm_input_port *)obj)->type);
+}
+
+static size_t oport_hash(scm_object *obj) {
+    return scm_hash_mix(((scm_output_port *)obj)->type);
+}
+
+static scm_object_methods input_methods = { iport_free, iport_eqv, iport_eqv, iport_hash, NULL };
+static scm_object_methods output_methods = { oport_free, oport_eqv, oport_eqv, oport_hash, NULL };
 
 static int initialized = 0;
 
@@ -390,12 +693,12 @@ int scm_port_init(void) {
 
     string_input_port_register();
     string_output_port_register();
+    string_buffer_output_port_register();
     file_input_port_register();
     file_output_port_register();
 
     default_iport = file_input_port_new(stdin);
-    /* we use stderr here, because stdout is line buffering
-     * but we need to output the prompt at the start of a command line */
+    /* file ports do their own buffering, the REPL flushes after the prompt */
     default_oport = file_output_port_new(stderr);
 
     scm_object_register(scm_type_input_port, &input_methods);
@@ -406,6 +709,14 @@ int scm_port_init(void) {
 }
 
 int scm_port_init_env(scm_object *env) {
-    (void)env;
+    scm_env_add_prim(env, "flush-output", prim_flush_output, 0, 1, pred_output_port);
+    scm_env_add_prim(env, "open-output-string", prim_open_output_string, 0, 0, NULL);
+    scm_env_add_prim(env, "get-output-string", prim_get_output_string, 1, 1, pred_output_port);
+    scm_env_add_prim(env, "open-input-string", prim_open_input_string, 1, 1, pred_string);
+    scm_env_add_prim(env, "read-char", prim_read_char, 0, 1, NULL);
+    scm_env_add_prim(env, "peek-char", prim_peek_char, 0, 1, NULL);
+    scm_env_add_prim(env, "write-char", prim_write_char, 1, 2, scm_list(1, pred_char));
+    scm_env_add_prim(env, "write-string", prim_write_string, 1, 4, scm_list(1, pred_string));
+    scm_env_add_prim(env, "newline", prim_newline, 0, 1, NULL);
     return 0;
 }
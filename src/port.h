@@ -8,20 +8,30 @@ typedef struct scm_output_port_st scm_output_port;
 extern scm_object *default_iport;
 extern scm_object *default_oport;
 
-scm_object *string_input_port_new(const char *buf, int size);
+scm_object *string_input_port_new(const char *buf, long size);
 scm_object *file_input_port_new(FILE *fp);
 scm_object *file_input_port_open(const char *name);
 /* return -1 when eof */
 int scm_input_port_readc(scm_object *port);
 int scm_input_port_peekc(scm_object *port);
 int scm_input_port_unreadc(scm_object *port, int c);
+/* characters of UTF-8, -1 on eof */
+int scm_input_port_read_char(scm_object *port);
+int scm_input_port_peek_char(scm_object *port);
 
 scm_object *string_output_port_new(char *buf, int size);
+scm_object *string_output_port_open(void);
+const char *scm_output_port_string(scm_object *port, long *len);
+void scm_output_port_string_reset(scm_object *port);
 scm_object *file_output_port_new(FILE *fp);
 scm_object *file_output_port_open(const char *name);
 /* return number of bytes written */
 int scm_output_port_writec(scm_object *port, char c);
+int scm_output_port_write(scm_object *port, const char *p, int len);
 int scm_output_port_puts(scm_object *port, const char *p);
+int scm_output_port_write_char(scm_object *port, int c);
+/* file ports are buffered, return 0 when all the bytes reached the file */
+int scm_output_port_flush(scm_object *port);
 int scm_newline(scm_object *obj);
 
 int scm_port_init(void);
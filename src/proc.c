@@ -2,6 +2,7 @@
 #include "err.h"
 #include "env.h"
 #include "eval.h"
+#include "number.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -12,9 +13,19 @@ typedef struct scm_primitive_st {
     int max_arity;
     const char *name;
     prim_fn fn;
+    /* instead of @fn if set */
+    prim_data_fn data_fn;
+    void *data;
     /* contract for the parameters.
      * if is not a pair, it's used for all the rest arguments */
     scm_object *preds;
+    /* the types @preds accept without a call, the first @nmasks are for the
+     * leading arguments and @rest_mask for all the others */
+    int nmasks;
+    scm_type_mask *masks;
+    scm_type_mask rest_mask;
+    /* of a type predicate, the types it's true of */
+    scm_type_mask types;
 } scm_primitive;
 
 typedef struct scm_compound_st {
@@ -54,12 +65,36 @@ static void arity_mismatch(scm_primitive *proc, int n) {
     }
 }
 
-static void contract_violation(scm_object *opt, int n, scm_object *pred, scm_object *opd) {
+/* for primitives checking their arguments themselves */
+void scm_contract_violation(const char *name, int n, const char *expected, scm_object *opd) {
     scm_error_object(opd, "%s: contract violation by argument #%d\nexpected: %s\ngiven: ",
-                     ((scm_primitive *)opt)->name, n, ((scm_primitive *)pred)->name);
+                     name, n, expected);
+}
+
+long scm_index_arg(const char *name, int i, scm_object *obj) {
+    if (obj->type != scm_type_integer || scm_integer_get_val(obj) < 0)
+        scm_contract_violation(name, i, "exact-nonnegative-integer?", obj);
+    return scm_integer_get_val(obj);
+}
+
+void scm_range_args(const char *name, int n, int i, scm_object **args, scm_object *obj,
+                    const char *kind, long len, long *start, long *end) {
+    *start = n >= i ? scm_index_arg(name, i, args[i - 1]) : 0;
+    *end = n > i ? scm_index_arg(name, i + 1, args[i]) : len;
+    if (*start > len)
+        scm_error_object(obj, "%s: starting index is out of range\nstarting index: %ld\n"
+                         "valid range: [0, %ld]\n%s: ", name, *start, len, kind);
+    if (*end < *start || *end > len)
+        scm_error_object(obj, "%s: ending index is out of range\nending index: %ld\n"
+                         "valid range: [%ld, %ld]\n%s: ", name, *end, *start, len, kind);
+}
+
+static void contract_violation(scm_object *opt, int n, scm_object *pred, scm_object *opd) {
+    scm_contract_violation(((scm_primitive *)opt)->name, n, ((scm_primitive *)pred)->name, opd);
 }
 
 static void primitive_free(scm_object *obj) {
+    free(((scm_primitive *)obj)->masks);
     free(obj);
 }
 
@@ -75,10 +110,46 @@ scm_object *scm_primitive_new(const char *name, prim_fn fn, int min_arity,
     scm_primitive *prim = malloc(sizeof(scm_primitive));
     prim->base.type = scm_type_primitive;
     prim->fn = fn;
+    prim->data_fn = NULL;
+    prim->data = NULL;
     prim->name = name;
     prim->min_arity = min_arity;
     prim->max_arity = max_arity;
     prim->preds = preds;
+    prim->nmasks = 0;
+    prim->masks = NULL;
+    prim->rest_mask = SCM_TYPES_ALL;
+    prim->types = 0;
+
+    if (!preds)
+        return (scm_object *)prim;
+    /* other predicates accept no type without a call */
+    scm_object *p;
+    for (p = preds; p->type == scm_type_pair; p = scm_cdr(p))
+        prim->nmasks++;
+    if (prim->nmasks)
+        prim->masks = malloc(prim->nmasks * sizeof(scm_type_mask));
+    int i = 0;
+    for (p = preds; p->type == scm_type_pair; p = scm_cdr(p))
+        prim->masks[i++] = ((scm_primitive *)scm_car(p))->types;
+    if (p != scm_null)
+        prim->rest_mask = ((scm_primitive *)p)->types;
+
+    return (scm_object *)prim;
+}
+
+scm_object *scm_type_predicate_new(const char *name, prim_fn fn, scm_type_mask types) {
+    scm_primitive *prim = (scm_primitive *)scm_primitive_new(name, fn, 1, 1, NULL);
+    prim->types = types;
+
+    return (scm_object *)prim;
+}
+
+scm_object *scm_primitive_new_with_data(const char *name, prim_data_fn fn, void *data,
+                                        int min_arity, int max_arity) {
+    scm_primitive *prim = (scm_primitive *)scm_primitive_new(name, NULL, min_arity, max_arity, NULL);
+    prim->data_fn = fn;
+    prim->data = data;
 
     return (scm_object *)prim;
 }
@@ -86,6 +157,7 @@ scm_object *scm_primitive_new(const char *name, prim_fn fn, int min_arity,
 scm_object *scm_compound_new(scm_object *params, scm_object *body, scm_object *env) {
     scm_compound *comp = malloc(sizeof(scm_compound));
     comp->base.type = scm_type_compound;
+    comp->name = NULL;
     comp->max_arity = scm_list_length(params);
     if (comp->max_arity == -1)
         comp->min_arity = scm_list_quasilength(params);
@@ -119,46 +191,52 @@ void scm_procedure_check_arity(scm_object *opt, int n) {
         arity_mismatch(proc, n);
 }
 
-scm_object *scm_primitive_apply(scm_object *opt, int n, scm_object *opds) {
+scm_object *scm_primitive_apply(scm_object *opt, int n, scm_object **args) {
     scm_primitive *proc = (scm_primitive *)opt;
-    return proc->fn(n, opds);
+    if (proc->data_fn)
+        return proc->data_fn(proc->data, n, args);
+    return proc->fn(n, args);
 }
 
-scm_object *scm_compound_apply(scm_object *opt, scm_object *opds) {
+scm_object *scm_compound_apply(scm_object *opt, int n, scm_object **args) {
     scm_compound *proc = (scm_compound *)opt;
-    scm_object *env = scm_env_extend(proc->env, proc->params, opds);
+    scm_object *env = scm_env_extend_args(proc->env, proc->params, n, args);
     return scm_eval_sequence(proc->body, env);
 }
 
-void scm_procedure_check_contract(scm_object *opt, scm_object *opds) {
+/* the predicate for the argument #@i+1 is called only when its mask doesn't
+ * accept the argument's type */
+static void check_predicate(scm_primitive *proc, int i, scm_object **args) {
+    scm_object *pred = proc->preds;
+    for (int k = 0; k < i && pred->type == scm_type_pair; ++k)
+        pred = scm_cdr(pred);
+    if (pred->type == scm_type_pair)
+        pred = scm_car(pred);
+    if (scm_primitive_apply(pred, 1, args + i) == scm_false)
+        contract_violation((scm_object *)proc, i + 1, pred, args[i]);
+}
+
+void scm_procedure_check_contract(scm_object *opt, int n, scm_object **args) {
     if (opt->type == scm_type_compound)
         return;
     scm_primitive *proc = (scm_primitive *)opt;
-    scm_object *preds = proc->preds;
-    scm_object *pred = NULL;
-    int i = 1;
-    if (preds) {
-        while (preds->type == scm_type_pair) {
-            pred = scm_car(preds);
-            if (scm_primitive_apply(pred, 1, opds) == scm_false)
-                contract_violation(opt, i, pred, scm_car(opds));
-            preds = scm_cdr(preds);
-            opds = scm_cdr(opds);
-            ++i;
-        }
-        if (preds != scm_null) {
-            while (opds != scm_null) {
-                if (scm_primitive_apply(preds, 1, opds) == scm_false)
-                    contract_violation(opt, i, preds, scm_car(opds));
-                opds = scm_cdr(opds);
-                ++i;
-            }
-        }
+    if (!proc->preds)
+        return;
+    int i = 0;
+    for (; i < n && i < proc->nmasks; ++i) {
+        if (!(SCM_TYPE_BIT(args[i]->type) & proc->masks[i]))
+            check_predicate(proc, i, args);
+    }
+    if (proc->rest_mask == SCM_TYPES_ALL)
+        return;
+    for (; i < n; ++i) {
+        if (!(SCM_TYPE_BIT(args[i]->type) & proc->rest_mask))
+            check_predicate(proc, i, args);
     }
 }
 
-static scm_object_methods prim_methods = { primitive_free, same_object, same_object };
-static scm_object_methods comp_methods = { compound_free, same_object, same_object };
+static scm_object_methods prim_methods = { primitive_free, same_object, same_object, NULL, NULL };
+static scm_object_methods comp_methods = { compound_free, same_object, same_object, NULL, NULL };
 
 static int initialized = 0;
 
@@ -3,66 +3,83 @@
 #include "object.h"
 #include "pair.h"
 
-/* signature of primitives */
-typedef scm_object *(*prim_fn)(int n, scm_object *args);
+/* signature of primitives, the @n arguments are in @args, which is only lent
+ * for the call: a primitive keeping them makes its own copy */
+typedef scm_object *(*prim_fn)(int n, scm_object **args);
+/* of primitives made at run time, closed over their @data */
+typedef scm_object *(*prim_data_fn)(void *data, int n, scm_object **args);
 
 scm_object *scm_primitive_new(const char *name, prim_fn fn, int min_arity,
                               int max_arity, scm_object *preds);
+/* a predicate true of all the objects of the @types, contracts made of it
+ * check the type of their argument and only call it for other types */
+scm_object *scm_type_predicate_new(const char *name, prim_fn fn, scm_type_mask types);
+/* checking their arguments themselves */
+scm_object *scm_primitive_new_with_data(const char *name, prim_data_fn fn, void *data,
+                                        int min_arity, int max_arity);
 scm_object *scm_compound_new(scm_object *params, scm_object *body, scm_object *env);
 const char *scm_procedure_name(scm_object *proc);
 void scm_compound_set_name(scm_object *proc, const char *name);
 void scm_procedure_check_arity(scm_object *opt, int n);
-void scm_procedure_check_contract(scm_object *opt, scm_object *opds);
-scm_object *scm_primitive_apply(scm_object *opt, int n, scm_object *opds);
-scm_object *scm_compound_apply(scm_object *opt, scm_object *opds);
+void scm_procedure_check_contract(scm_object *opt, int n, scm_object **args);
+void scm_contract_violation(const char *name, int n, const char *expected, scm_object *opd);
+/* the argument #@i @obj of a primitive as an index, an exact nonnegative
+ * integer */
+long scm_index_arg(const char *name, int i, scm_object *obj);
+/* the optional [start [end]] arguments from #@i on of the @n in @args, as a
+ * range in the @len elements of @obj, which is a @kind in the messages */
+void scm_range_args(const char *name, int n, int i, scm_object **args, scm_object *obj,
+                    const char *kind, long len, long *start, long *end);
+scm_object *scm_primitive_apply(scm_object *opt, int n, scm_object **args);
+scm_object *scm_compound_apply(scm_object *opt, int n, scm_object **args);
 int scm_proc_init(void);
 
 #define define_primitive_0(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; (void)args;\
         return scm_##name(); \
     }
 
 #define define_primitive_1(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(scm_car(args)); \
+        return scm_##name(args[0]); \
     }
 
 #define define_primitive_2(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(scm_car(args), scm_cadr(args)); \
+        return scm_##name(args[0], args[1]); \
     }
 
 #define define_primitive_3(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(scm_car(args), scm_cadr(args), scm_caddr(args)); \
+        return scm_##name(args[0], args[1], args[2]); \
     }
 
 #define define_primitive_0n(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n;\
         return scm_##name(n, args); \
     }
 
 #define define_primitive_1n(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(n, scm_car(args), scm_cdr(args)); \
+        return scm_##name(n, args[0], args + 1); \
     }
 
 #define define_primitive_2n(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(n, scm_car(args), scm_cadr(args), scm_cddr(args)); \
+        return scm_##name(n, args[0], args[1], args + 2); \
     }
 
 #define define_primitive_3n(name) \
-    static scm_object *prim_##name(int n, scm_object *args) { \
+    static scm_object *prim_##name(int n, scm_object **args) { \
         (void)n; \
-        return scm_##name(n, scm_car(args), scm_cadr(args), scm_caddr(args), scm_cdddr(args)); \
+        return scm_##name(n, args[0], args[1], args[2], args + 3); \
     }
 
 
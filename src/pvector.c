@@ -0,0 +1,410 @@
+#include "pvector.h"
+#include "vector.h"
+#include "number.h"
+#include "pair.h"
+#include "symbol.h"
+#include "proc.h"
+#include "env.h"
+#include "err.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* the leaves hold the elements, and a node of level l holds the subtries of
+ * the next 5 bits of the index below bit l, the root being of level @shift
+ * the tail takes the pushes until it fills up and goes into the trie as a
+ * leaf, and the trie is empty while everything fits in the tail */
+
+#define BITS    5
+#define WIDTH   (1 << BITS)
+#define MASK    (WIDTH - 1)
+
+typedef struct pnode_st pnode;
+
+struct pnode_st {
+    int refs;
+    union {
+        pnode *node;
+        scm_object *obj;
+    } slots[WIDTH];
+};
+
+typedef struct scm_pvector_st {
+    scm_object base;
+    long count;
+    int shift;
+    pnode *root;    /* NULL while the tail has everything */
+    pnode *tail;    /* NULL if empty */
+} scm_pvector;
+
+scm_object *pred_pvector = NULL;
+scm_object *scm_empty_pvector = NULL;
+
+/* a copy sharing the subnodes, or a new node if @n is NULL */
+static pnode *node_copy(pnode *n, int level) {
+    pnode *c = malloc(sizeof(pnode));
+
+    c->refs = 1;
+    if (!n) {
+        memset(c->slots, 0, sizeof(c->slots));
+        return c;
+    }
+    memcpy(c->slots, n->slots, sizeof(c->slots));
+    if (level > 0) {
+        for (int i = 0; i < WIDTH; ++i) {
+            if (c->slots[i].node)
+                ++c->slots[i].node->refs;
+        }
+    }
+    return c;
+}
+
+static void node_release(pnode *n, int level) {
+    if (--n->refs)
+        return;
+    if (level > 0) {
+        for (int i = 0; i < WIDTH; ++i) {
+            if (n->slots[i].node)
+                node_release(n->slots[i].node, level - BITS);
+        }
+    }
+    free(n);
+}
+
+#define retain(n) do { if (n) ++(n)->refs; } while (0)
+
+static scm_object *pvector_alloc(long count, int shift, pnode *root, pnode *tail) {
+    scm_pvector *v = malloc(sizeof(scm_pvector));
+
+    v->base.type = scm_type_pvector;
+    v->count = count;
+    v->shift = shift;
+    v->root = root;
+    v->tail = tail;
+
+    return (scm_object *)v;
+}
+
+/* the index of the first element in the tail */
+static long tail_offset(scm_pvector *v) {
+    return v->count < WIDTH ? 0 : ((v->count - 1) >> BITS) << BITS;
+}
+
+static pnode *leaf_for(scm_pvector *v, long k) {
+    pnode *n = v->root;
+
+    if (k >= tail_offset(v))
+        return v->tail;
+    for (int level = v->shift; level > 0; level -= BITS)
+        n = n->slots[(k >> level) & MASK].node;
+    return n;
+}
+
+scm_object *scm_pvector_ref(scm_object *v, long k) {
+    return leaf_for((scm_pvector *)v, k)->slots[k & MASK].obj;
+}
+
+long scm_pvector_length(scm_object *v) {
+    return ((scm_pvector *)v)->count;
+}
+
+static pnode *assoc(pnode *n, int level, long k, scm_object *obj) {
+    pnode *c = node_copy(n, level), *child;
+    int i = (k >> level) & MASK;
+
+    if (level == 0) {
+        c->slots[i].obj = obj;
+        return c;
+    }
+    child = c->slots[i].node;
+    --child->refs;
+    c->slots[i].node = assoc(child, level - BITS, k, obj);
+    return c;
+}
+
+scm_object *scm_pvector_set(scm_object *vector, long k, scm_object *obj) {
+    scm_pvector *v = (scm_pvector *)vector;
+    pnode *tail;
+
+    if (k >= tail_offset(v)) {
+        tail = node_copy(v->tail, 0);
+        tail->slots[k & MASK].obj = obj;
+        retain(v->root);
+        return pvector_alloc(v->count, v->shift, v->root, tail);
+    }
+    retain(v->tail);
+    return pvector_alloc(v->count, v->shift, assoc(v->root, v->shift, k, obj), v->tail);
+}
+
+/* the chain of single nodes from @level down to @leaf */
+static pnode *new_path(int level, pnode *leaf) {
+    pnode *n;
+
+    if (level == 0)
+        return leaf;
+    n = node_copy(NULL, level);
+    n->slots[0].node = new_path(level - BITS, leaf);
+    return n;
+}
+
+/* @leaf holds the elements from @count - 32 on */
+static pnode *push_tail(pnode *parent, int level, long count, pnode *leaf) {
+    pnode *n = node_copy(parent, level), *child;
+    int i = ((count - 1) >> level) & MASK;
+
+    if (level == BITS) {
+        n->slots[i].node = leaf;
+        return n;
+    }
+    child = n->slots[i].node;
+    if (child) {
+        --child->refs;
+        n->slots[i].node = push_tail(child, level - BITS, count, leaf);
+    }
+    else
+        n->slots[i].node = new_path(level - BITS, leaf);
+    return n;
+}
+
+scm_object *scm_pvector_push(scm_object *vector, scm_object *obj) {
+    scm_pvector *v = (scm_pvector *)vector;
+    long count = v->count;
+    int shift = v->shift;
+    pnode *root, *tail;
+
+    if (count - tail_offset(v) < WIDTH) {
+        tail = node_copy(v->tail, 0);
+        tail->slots[count - tail_offset(v)].obj = obj;
+        retain(v->root);
+        return pvector_alloc(count + 1, shift, v->root, tail);
+    }
+
+    ++v->tail->refs;
+    if ((count >> BITS) > (1L << shift)) {
+        /* the root is full, a level more */
+        root = node_copy(NULL, shift + BITS);
+        root->slots[0].node = v->root;
+        ++v->root->refs;
+        root->slots[1].node = new_path(shift, v->tail);
+        shift += BITS;
+    }
+    else
+        root = push_tail(v->root, shift, count, v->tail);
+    tail = node_copy(NULL, 0);
+    tail->slots[0].obj = obj;
+    return pvector_alloc(count + 1, shift, root, tail);
+}
+
+/* without the leaf of the elements from @count - 32 - 1 on, NULL if that
+ * leaves nothing */
+static pnode *pop_tail(pnode *n, int level, long count) {
+    int i = ((count - 2) >> level) & MASK;
+    pnode *c, *child;
+
+    if (level > BITS) {
+        child = pop_tail(n->slots[i].node, level - BITS, count);
+        if (!child && i == 0)
+            return NULL;
+        c = node_copy(n, level);
+        --c->slots[i].node->refs;
+        c->slots[i].node = child;
+        return c;
+    }
+    if (i == 0)
+        return NULL;
+    c = node_copy(n, level);
+    --c->slots[i].node->refs;
+    c->slots[i].node = NULL;
+    return c;
+}
+
+scm_object *scm_pvector_pop(scm_object *vector) {
+    scm_pvector *v = (scm_pvector *)vector;
+    long count = v->count;
+    int shift = v->shift;
+    pnode *root, *tail, *top;
+
+    if (count == 1)
+        return scm_empty_pvector;
+    if (count - tail_offset(v) > 1) {
+        tail = node_copy(v->tail, 0);
+        tail->slots[count - tail_offset(v) - 1].obj = NULL;
+        retain(v->root);
+        return pvector_alloc(count - 1, shift, v->root, tail);
+    }
+
+    /* the last leaf of the trie becomes the tail */
+    tail = leaf_for(v, count - 2);
+    ++tail->refs;
+    root = pop_tail(v->root, shift, count);
+    if (!root)
+        shift = BITS;
+    else if (shift > BITS && !root->slots[1].node) {
+        top = root;
+        root = top->slots[0].node;
+        ++root->refs;
+        node_release(top, shift);
+        shift -= BITS;
+    }
+    return pvector_alloc(count - 1, shift, root, tail);
+}
+
+static void pvector_free(scm_object *obj) {
+    scm_pvector *v = (scm_pvector *)obj;
+
+    if (obj == scm_empty_pvector)
+        return;
+    if (v->root)
+        node_release(v->root, v->shift);
+    if (v->tail)
+        node_release(v->tail, 0);
+    free(v);
+}
+
+/* pushes in turn, freeing the versions in between */
+static scm_object *push_all(scm_object *v, scm_object *obj) {
+    scm_object *nv = scm_pvector_push(v, obj);
+    scm_object_free(v);
+    return nv;
+}
+
+static void out_of_range(scm_object *v, const char *name, long k) {
+    if (scm_pvector_length(v) == 0)
+        scm_error_object(v, "%s: index is out of range for empty pvector\nindex: %ld\npvector: ", name, k);
+    scm_error_object(v, "%s: index is out of range\nindex: %ld\n"
+                     "valid range: [0, %ld]\npvector: ", name, k, scm_pvector_length(v) - 1);
+}
+
+static long index_arg(const char *name, scm_object *v, scm_object *obj) {
+    long k = scm_index_arg(name, 2, obj);
+
+    if (k >= scm_pvector_length(v))
+        out_of_range(v, name, k);
+    return k;
+}
+
+/* primitives */
+static scm_object *prim_is_pvector(int n, scm_object **args) {
+    (void)n;
+    return scm_boolean(args[0]->type == scm_type_pvector);
+}
+
+static scm_object *prim_pvector(int n, scm_object **args) {
+    scm_object *v = scm_empty_pvector;
+    for (int i = 0; i < n; ++i)
+        v = push_all(v, args[i]);
+    return v;
+}
+
+static scm_object *prim_make_pvector(int n, scm_object **args) {
+    scm_object *v = scm_empty_pvector, *fill = n > 1 ? args[1] : scm_false;
+    long k = scm_index_arg("make-pvector", 1, args[0]);
+
+    for (long i = 0; i < k; ++i)
+        v = push_all(v, fill);
+    return v;
+}
+
+static scm_object *prim_pvector_length(int n, scm_object **args) {
+    (void)n;
+    return INTEGER(scm_pvector_length(args[0]));
+}
+
+static scm_object *prim_pvector_ref(int n, scm_object **args) {
+    scm_object *v = args[0];
+    (void)n;
+    return scm_pvector_ref(v, index_arg("pvector-ref", v, args[1]));
+}
+
+static scm_object *prim_pvector_set(int n, scm_object **args) {
+    scm_object *v = args[0];
+    (void)n;
+    return scm_pvector_set(v, index_arg("pvector-set", v, args[1]), args[2]);
+}
+
+static scm_object *prim_pvector_push(int n, scm_object **args) {
+    (void)n;
+    return scm_pvector_push(args[0], args[1]);
+}
+
+static scm_object *prim_pvector_pop(int n, scm_object **args) {
+    scm_object *v = args[0];
+    (void)n;
+    if (scm_pvector_length(v) == 0)
+        scm_error_object(v, "pvector-pop: empty pvector\npvector: ");
+    return scm_pvector_pop(v);
+}
+
+static scm_object *prim_pvector_to_list(int n, scm_object **args) {
+    scm_object *v = args[0], *l = scm_null;
+    (void)n;
+    for (long i = scm_pvector_length(v) - 1; i >= 0; --i)
+        l = scm_cons(scm_pvector_ref(v, i), l);
+    return l;
+}
+
+static scm_object *prim_list_to_pvector(int n, scm_object **args) {
+    scm_object *l = args[0], *v = scm_empty_pvector;
+    (void)n;
+
+    if (scm_list_length(l) < 0)
+        scm_contract_violation("list->pvector", 1, "list?", l);
+    for (; l != scm_null; l = scm_cdr(l))
+        v = push_all(v, scm_car(l));
+    return v;
+}
+
+static scm_object *prim_vector_to_pvector(int n, scm_object **args) {
+    scm_object *vec = args[0], *v = scm_empty_pvector;
+    (void)n;
+    FOREACH_VECTOR(i, len, vec)
+        v = push_all(v, scm_vector_ref(vec, i));
+    return v;
+}
+
+static scm_object *prim_pvector_to_vector(int n, scm_object **args) {
+    scm_object *v = args[0], *vec;
+    long len = scm_pvector_length(v);
+    (void)n;
+
+    if (len == 0)
+        return scm_empty_vector;
+    vec = scm_vector_alloc(len);
+    for (long i = 0; i < len; ++i)
+        scm_vector_set(vec, i, scm_pvector_ref(v, i));
+    return vec;
+}
+
+static scm_object_methods pvector_methods = { pvector_free, same_object, same_object, NULL, NULL };
+
+static int initialized = 0;
+
+int scm_pvector_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_pvector, &pvector_methods);
+    pred_pvector = scm_type_predicate_new("pvector?", prim_is_pvector, SCM_TYPE_BIT(scm_type_pvector));
+    scm_empty_pvector = pvector_alloc(0, BITS, NULL, NULL);
+
+    initialized = 1;
+    return 0;
+}
+
+int scm_pvector_init_env(scm_object *env) {
+    scm_object *pred_v = scm_list(1, pred_pvector);
+
+    scm_env_define_var(env, scm_symbol_new("pvector?", -1), pred_pvector);
+    scm_env_add_prim(env, "pvector", prim_pvector, 0, -1, NULL);
+    scm_env_add_prim(env, "make-pvector", prim_make_pvector, 1, 2, NULL);
+    scm_env_add_prim(env, "pvector-length", prim_pvector_length, 1, 1, pred_v);
+    scm_env_add_prim(env, "pvector-ref", prim_pvector_ref, 2, 2, pred_v);
+    scm_env_add_prim(env, "pvector-set", prim_pvector_set, 3, 3, pred_v);
+    scm_env_add_prim(env, "pvector-push", prim_pvector_push, 2, 2, pred_v);
+    scm_env_add_prim(env, "pvector-pop", prim_pvector_pop, 1, 1, pred_v);
+    scm_env_add_prim(env, "pvector->list", prim_pvector_to_list, 1, 1, pred_v);
+    scm_env_add_prim(env, "list->pvector", prim_list_to_pvector, 1, 1, NULL);
+    scm_env_add_prim(env, "vector->pvector", prim_vector_to_pvector, 1, 1, scm_list(1, pred_vector));
+    scm_env_add_prim(env, "pvector->vector", prim_pvector_to_vector, 1, 1, pred_v);
+
+    return 0;
+}
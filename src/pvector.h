@@ -0,0 +1,25 @@
+#ifndef SCHEME_PVECTOR_H
+#define SCHEME_PVECTOR_H
+#include "object.h"
+
+/* persistent vectors, 32-way tries indexed by the bits of the index with the
+ * last up to 32 elements in a separate tail, so set, push and pop copy the
+ * O(log32 n) nodes on one path and share all the others
+ * the nodes are reference counted, freeing a vector only releases its own */
+
+extern scm_object *pred_pvector;
+
+extern scm_object *scm_empty_pvector;
+
+scm_object *scm_pvector_ref(scm_object *v, long k);
+/* the new vector, @v is unchanged */
+scm_object *scm_pvector_set(scm_object *v, long k, scm_object *obj);
+scm_object *scm_pvector_push(scm_object *v, scm_object *obj);
+/* @v must not be empty */
+scm_object *scm_pvector_pop(scm_object *v);
+long scm_pvector_length(scm_object *v);
+
+int scm_pvector_init(void);
+int scm_pvector_init_env(scm_object *env);
+
+#endif /* SCHEME_PVECTOR_H */
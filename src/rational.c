@@ -0,0 +1,319 @@
+#include "rational.h"
+#include "bignum.h"
+#include "number.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct scm_rational_st {
+    scm_object base;
+    scm_object *num;
+    scm_object *den;
+} scm_rational;
+
+#define is_integer(obj) ((obj)->type == scm_type_integer || (obj)->type == scm_type_bignum)
+#define num(obj) (((scm_rational *)(obj))->num)
+#define den(obj) (((scm_rational *)(obj))->den)
+
+static scm_object *integer_one = NULL;
+
+static scm_object *rational_alloc(scm_object *num, scm_object *den) {
+    scm_rational *r = malloc(sizeof(scm_rational));
+
+    r->base.type = scm_type_rational;
+    r->num = num;
+    r->den = den;
+
+    return (scm_object *)r;
+}
+
+/* fixnum fast paths
+ * operands whose numerator and denominator are both fixnums are worked in
+ * longs, the reductions keep the intermediates small (Knuth 4.5.1), and
+ * any overflow gives NULL to fall back to the general path */
+static unsigned long ulong_abs(long x) {
+    return x < 0 ? 0UL - (unsigned long)x : (unsigned long)x;
+}
+
+static int small(scm_object *obj, long *n, long *d) {
+    if (obj->type == scm_type_integer) {
+        *n = scm_integer_get_val(obj);
+        *d = 1;
+        return 1;
+    }
+    if (obj->type == scm_type_rational && num(obj)->type == scm_type_integer &&
+        den(obj)->type == scm_type_integer) {
+        *n = scm_integer_get_val(num(obj));
+        *d = scm_integer_get_val(den(obj));
+        return 1;
+    }
+    return 0;
+}
+
+/* n / d already in lowest terms with d > 0 */
+static scm_object *small_make(long n, long d) {
+    if (d == 1)
+        return INTEGER(n);
+    return rational_alloc(INTEGER(n), INTEGER(d));
+}
+
+static scm_object *small_add(long a, long b, long c, long d) {
+    long g = (long)scm_ulong_gcd(b, d), t, u, g2, den;
+
+    if (g == 1) {
+        if (scm_mul_overflow(a, d, &t) || scm_mul_overflow(b, c, &u) ||
+            scm_add_overflow(t, u, &t) || scm_mul_overflow(b, d, &den))
+            return NULL;
+        return small_make(t, den);
+    }
+    /* t shares no factor with b/g * d but those of g */
+    if (scm_mul_overflow(a, d / g, &t) || scm_mul_overflow(c, b / g, &u) ||
+        scm_add_overflow(t, u, &t))
+        return NULL;
+    g2 = (long)scm_ulong_gcd(ulong_abs(t), g);
+    if (scm_mul_overflow(b / g, d / g2, &den))
+        return NULL;
+    return small_make(t / g2, den);
+}
+
+static scm_object *small_mul(long a, long b, long c, long d) {
+    long g1, g2, n, den;
+
+    if (a == 0 || c == 0)
+        return INTEGER(0);
+    g1 = (long)scm_ulong_gcd(ulong_abs(a), d);
+    g2 = (long)scm_ulong_gcd(ulong_abs(c), b);
+    if (scm_mul_overflow(a / g1, c / g2, &n) || scm_mul_overflow(b / g2, d / g1, &den))
+        return NULL;
+    return small_make(n, den);
+}
+
+/* general path */
+static scm_object *normalize(scm_object *num, scm_object *den) {
+    scm_object *g;
+
+    if (scm_bignum_sign(den) < 0) {
+        num = scm_bignum_neg(num);
+        den = scm_bignum_neg(den);
+    }
+    g = scm_bignum_gcd(num, den);
+    if (g->type != scm_type_integer || scm_integer_get_val(g) != 1) {
+        scm_bignum_divmod(num, g, &num, NULL);
+        scm_bignum_divmod(den, g, &den, NULL);
+    }
+    if (den->type == scm_type_integer && scm_integer_get_val(den) == 1)
+        return num;
+    return rational_alloc(num, den);
+}
+
+scm_object *scm_rational_new(scm_object *num, scm_object *den) {
+    long n, d;
+    unsigned long g;
+
+    if (num->type == scm_type_integer && den->type == scm_type_integer) {
+        n = scm_integer_get_val(num);
+        d = scm_integer_get_val(den);
+        if (d > 0 || (d != LONG_MIN && n != LONG_MIN)) {
+            if (d < 0) {
+                n = -n;
+                d = -d;
+            }
+            g = scm_ulong_gcd(ulong_abs(n), d);
+            return small_make(n / (long)g, d / (long)g);
+        }
+    }
+    return normalize(num, den);
+}
+
+scm_object *scm_rational_numerator(scm_object *obj) {
+    return obj->type == scm_type_rational ? num(obj) : obj;
+}
+
+scm_object *scm_rational_denominator(scm_object *obj) {
+    return obj->type == scm_type_rational ? den(obj) : integer_one;
+}
+
+scm_object *scm_rational_from_double(double d) {
+    double m;
+    int e;
+
+    if (d == floor(d))
+        return scm_bignum_from_double(d);
+    /* d = m * 2^(e - 53) with an integral m of 53 bits */
+    m = ldexp(frexp(d, &e), 53);
+    return scm_rational_new(scm_bignum_from_double(m), scm_bignum_shift(integer_one, 53 - e));
+}
+
+double scm_rational_to_double(scm_object *obj) {
+    scm_object *n, *d, *q, *r;
+    long k, nv, dv;
+
+    if (obj->type != scm_type_rational)
+        return scm_bignum_to_double(obj);
+
+    n = num(obj);
+    d = den(obj);
+    if (small(obj, &nv, &dv) && ulong_abs(nv) <= (1UL << 53) && dv <= (1L << 53))
+        return (double)nv / (double)dv;
+
+    /* a quotient of 65 bits or so and a sticky bit for the remainder, so
+     * that the conversion of that rounds correctly */
+    k = 65 - (scm_bignum_bit_length(n) - scm_bignum_bit_length(d));
+    if (scm_bignum_sign(n) < 0)
+        n = scm_bignum_neg(n);
+    if (k >= 0)
+        n = scm_bignum_shift(n, k);
+    else
+        d = scm_bignum_shift(d, -k);
+    scm_bignum_divmod(n, d, &q, &r);
+    q = scm_bignum_add(scm_bignum_shift(q, 1), INTEGER(scm_bignum_sign(r) != 0));
+    return ldexp(scm_rational_sign(obj) * scm_bignum_to_double(q), (int)(-k - 1));
+}
+
+char *scm_rational_to_string(scm_object *obj, int radix) {
+    char *n, *d, *s;
+    size_t nlen, dlen;
+
+    if (obj->type != scm_type_rational)
+        return scm_number_to_string(obj, radix);
+
+    n = scm_number_to_string(num(obj), radix);
+    d = scm_number_to_string(den(obj), radix);
+    nlen = strlen(n);
+    dlen = strlen(d);
+    s = malloc(nlen + dlen + 2);
+    memcpy(s, n, nlen);
+    s[nlen] = '/';
+    memcpy(s + nlen + 1, d, dlen + 1);
+    free(n);
+    free(d);
+    return s;
+}
+
+scm_object *scm_rational_add(scm_object *a, scm_object *b) {
+    scm_object *r;
+    long an, ad, bn, bd;
+
+    if (is_integer(a) && is_integer(b))
+        return scm_bignum_add(a, b);
+    if (small(a, &an, &ad) && small(b, &bn, &bd) && (r = small_add(an, ad, bn, bd)))
+        return r;
+    return scm_rational_new(scm_bignum_add(scm_bignum_mul(scm_rational_numerator(a), scm_rational_denominator(b)),
+                                           scm_bignum_mul(scm_rational_numerator(b), scm_rational_denominator(a))),
+                            scm_bignum_mul(scm_rational_denominator(a), scm_rational_denominator(b)));
+}
+
+scm_object *scm_rational_neg(scm_object *a) {
+    if (a->type != scm_type_rational)
+        return scm_bignum_neg(a);
+    return rational_alloc(scm_bignum_neg(num(a)), den(a));
+}
+
+scm_object *scm_rational_sub(scm_object *a, scm_object *b) {
+    if (is_integer(a) && is_integer(b))
+        return scm_bignum_sub(a, b);
+    return scm_rational_add(a, scm_rational_neg(b));
+}
+
+scm_object *scm_rational_mul(scm_object *a, scm_object *b) {
+    scm_object *r;
+    long an, ad, bn, bd;
+
+    if (is_integer(a) && is_integer(b))
+        return scm_bignum_mul(a, b);
+    if (small(a, &an, &ad) && small(b, &bn, &bd) && (r = small_mul(an, ad, bn, bd)))
+        return r;
+    return scm_rational_new(scm_bignum_mul(scm_rational_numerator(a), scm_rational_numerator(b)),
+                            scm_bignum_mul(scm_rational_denominator(a), scm_rational_denominator(b)));
+}
+
+scm_object *scm_rational_div(scm_object *a, scm_object *b) {
+    scm_object *r;
+    long an, ad, bn, bd;
+
+    if (small(a, &an, &ad) && small(b, &bn, &bd) && bn != LONG_MIN) {
+        /* a/b * d/c with the sign moved up */
+        if (bn < 0) {
+            bn = -bn;
+            bd = -bd;
+        }
+        if ((r = small_mul(an, ad, bd, bn)))
+            return r;
+    }
+    return scm_rational_new(scm_bignum_mul(scm_rational_numerator(a), scm_rational_denominator(b)),
+                            scm_bignum_mul(scm_rational_denominator(a), scm_rational_numerator(b)));
+}
+
+int scm_rational_cmp(scm_object *a, scm_object *b) {
+    long an, ad, bn, bd, x, y;
+
+    if (is_integer(a) && is_integer(b))
+        return scm_bignum_cmp(a, b);
+    if (small(a, &an, &ad) && small(b, &bn, &bd) &&
+        !scm_mul_overflow(an, bd, &x) && !scm_mul_overflow(bn, ad, &y))
+        return (x > y) - (x < y);
+    return scm_bignum_cmp(scm_bignum_mul(scm_rational_numerator(a), scm_rational_denominator(b)),
+                          scm_bignum_mul(scm_rational_numerator(b), scm_rational_denominator(a)));
+}
+
+int scm_rational_sign(scm_object *a) {
+    return scm_bignum_sign(scm_rational_numerator(a));
+}
+
+scm_object *scm_rational_round(scm_object *obj, scm_rounding mode) {
+    scm_object *q, *r, *step;
+    int sign, c;
+
+    if (obj->type != scm_type_rational)
+        return obj;
+
+    scm_bignum_divmod(num(obj), den(obj), &q, &r);
+    sign = scm_bignum_sign(r);
+    step = INTEGER(sign);
+    switch (mode) {
+    case scm_rounding_floor:
+        return sign < 0 ? scm_bignum_add(q, step) : q;
+    case scm_rounding_ceiling:
+        return sign > 0 ? scm_bignum_add(q, step) : q;
+    case scm_rounding_truncate:
+        return q;
+    default:
+        /* compare twice the remainder with the denominator */
+        if (sign < 0)
+            r = scm_bignum_neg(r);
+        c = scm_bignum_cmp(scm_bignum_shift(r, 1), den(obj));
+        if (c > 0 || (c == 0 && scm_bignum_is_odd(q)))
+            return scm_bignum_add(q, step);
+        return q;
+    }
+}
+
+/* the numerator and the denominator may be shared */
+static void rational_free(scm_object *obj) {
+    free(obj);
+}
+
+static int rational_eqv(scm_object *o1, scm_object *o2) {
+    return scm_eqv(num(o1), num(o2)) && scm_eqv(den(o1), den(o2));
+}
+
+static size_t rational_hash(scm_object *obj) {
+    size_t h = scm_eqv_hash(num(obj));
+    return scm_hash_combine(h, scm_eqv_hash(den(obj)));
+}
+
+static scm_object_methods rational_methods = { rational_free, rational_eqv, rational_eqv, rational_hash, NULL };
+
+static int initialized = 0;
+
+int scm_rational_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_rational, &rational_methods);
+    integer_one = INTEGER(1);
+
+    initialized = 1;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef SCHEME_RATIONAL_H
+#define SCHEME_RATIONAL_H
+#include "object.h"
+
+/* exact non-integral numbers
+ * a numerator and a denominator > 1 without common factors, each of them a
+ * fixnum or a bignum; the operations take any exact numbers and give
+ * integers whenever the denominator comes to 1 */
+
+/* @num / @den for exact integers and a non-zero @den */
+scm_object *scm_rational_new(scm_object *num, scm_object *den);
+scm_object *scm_rational_numerator(scm_object *obj);
+scm_object *scm_rational_denominator(scm_object *obj);
+/* the exact value of a finite @d */
+scm_object *scm_rational_from_double(double d);
+/* rounded to the nearest */
+double scm_rational_to_double(scm_object *obj);
+/* the result should be free'd by the caller */
+char *scm_rational_to_string(scm_object *obj, int radix);
+
+scm_object *scm_rational_add(scm_object *a, scm_object *b);
+scm_object *scm_rational_sub(scm_object *a, scm_object *b);
+scm_object *scm_rational_mul(scm_object *a, scm_object *b);
+/* @b is non-zero */
+scm_object *scm_rational_div(scm_object *a, scm_object *b);
+scm_object *scm_rational_neg(scm_object *a);
+int scm_rational_cmp(scm_object *a, scm_object *b);
+int scm_rational_sign(scm_object *a);
+
+typedef enum {
+    scm_rounding_floor,
+    scm_rounding_ceiling,
+    scm_rounding_truncate,
+    scm_rounding_round,     /* to even on ties */
+} scm_rounding;
+
+scm_object *scm_rational_round(scm_object *obj, scm_rounding mode);
+
+int scm_rational_init(void);
+
+#endif /* SCHEME_RATIONAL_H */
@@ -5,6 +5,18 @@
 #include "token.h"
 #include "pair.h"
 #include "vector.h"
+#include "sys.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* chunks smaller than this are not worth a thread of their own */
+#define MIN_CHUNK_SIZE (64 * 1024)
+#define MAX_READ_THREADS 64
 
 static scm_object *scm_read_ex(scm_object *port, int in_seq);
 static scm_object *read_list(scm_object *port);
@@ -166,3 +178,206 @@ static scm_object *scm_read_ex(scm_object *port, int in_seq) {
 scm_object *scm_read(scm_object *port) {
     return scm_read_ex(port, 0);
 }
+
+/* split buf into at most @n chunks of roughly equal size at top-level datum
+ * boundaries, i.e. whitespaces outside any list, string, comment, character
+ * constant and not following a quote prefix.
+ * store the end offset of each chunk in @ends and return the number of chunks */
+static int split_chunks(const char *buf, long size, int n, long *ends) {
+    long target = size / n;
+    long i = 0;
+    int k = 0, depth = 0, prefix = 0;
+    char c;
+
+    while (i < size && k < n - 1) {
+        c = buf[i];
+        switch (c) {
+        case '"':
+            for (++i; i < size && buf[i] != '"'; ++i) {
+                if (buf[i] == '\\')
+                    ++i;
+            }
+            prefix = 0;
+            break;
+        case ';':
+            while (i < size && buf[i] != '\n')
+                ++i;
+            continue;   /* the newline is a boundary candidate */
+        case '#':
+            if (i + 1 < size && buf[i+1] == '\\')
+                i += 2; /* skip the character following `#\` */
+            prefix = 0;
+            break;
+        case '(':
+            ++depth;
+            prefix = 0;
+            break;
+        case ')':
+            --depth;
+            break;
+        case ',':
+            if (i + 1 < size && buf[i+1] == '@')
+                ++i;
+            /* fall through */
+        case '\'':
+        case '`':
+            prefix = 1;
+            break;
+        default:
+            if (!isspace((unsigned char)c))
+                prefix = 0;
+            else if (depth <= 0 && !prefix && i >= target * (k + 1))
+                ends[k++] = i;
+            break;
+        }
+        ++i;
+    }
+    ends[k++] = size;
+
+    return k;
+}
+
+typedef struct read_job_st {
+    const char *buf;
+    long size;
+    scm_object *head;
+    scm_object *tail;
+    char *err;
+    int threaded;
+} read_job;
+
+static void *read_chunk(void *arg) {
+    read_job *job = arg;
+    scm_object *port = string_input_port_new(job->buf, job->size);
+    scm_object *obj, *pair;
+    char *err;
+    long len;
+
+    job->head = job->tail = scm_null;
+    SCM_TRY {
+        while ((obj = scm_read(port)) != scm_eof) {
+            pair = scm_cons(obj, scm_null);
+            if (job->head == scm_null)
+                job->head = pair;
+            else
+                scm_set_cdr(job->tail, pair);
+            job->tail = pair;
+        }
+    } SCM_CATCH {
+        /* the message buffer belongs to this thread, so make a copy */
+        err = scm_error_msg();
+        len = strlen(err);
+        job->err = malloc(len + 1);
+        memcpy(job->err, err, len + 1);
+    } SCM_END_TRY;
+
+    scm_object_free(port);
+    return NULL;
+}
+
+int scm_read_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+        return 1;
+    return n < MAX_READ_THREADS ? n : MAX_READ_THREADS;
+}
+
+/* read all the data in buf and return them as a list in order.
+ * the buffer is split at top-level boundaries and the chunks are parsed on
+ * at most @nthreads threads, every thread allocating its own objects */
+scm_object *scm_read_buffer(const char *buf, long size, int nthreads) {
+    long ends[MAX_READ_THREADS];
+    pthread_t threads[MAX_READ_THREADS];
+    read_job jobs[MAX_READ_THREADS] = {{0}};
+    scm_object *head = scm_null, *tail = NULL;
+    char *err = NULL;
+    int i, n;
+
+    if (size < 0)
+        size = strlen(buf);
+    if (nthreads > size / MIN_CHUNK_SIZE)
+        nthreads = size / MIN_CHUNK_SIZE;
+    if (nthreads > MAX_READ_THREADS)
+        nthreads = MAX_READ_THREADS;
+    if (nthreads < 1)
+        nthreads = 1;
+
+    n = split_chunks(buf, size, nthreads, ends);
+    for (i = 0; i < n; ++i) {
+        jobs[i].buf = buf + (i ? ends[i-1] : 0);
+        jobs[i].size = ends[i] - (i ? ends[i-1] : 0);
+    }
+
+    /* the current thread takes the first chunk */
+    for (i = 1; i < n; ++i) {
+        jobs[i].threaded = !pthread_create(&threads[i], NULL, read_chunk, &jobs[i]);
+        if (!jobs[i].threaded)
+            read_chunk(&jobs[i]);
+    }
+    read_chunk(&jobs[0]);
+    for (i = 1; i < n; ++i) {
+        if (jobs[i].threaded)
+            pthread_join(threads[i], NULL);
+    }
+
+    /* stitch the results in order */
+    for (i = 0; i < n; ++i) {
+        if (jobs[i].err && !err) {
+            err = jobs[i].err;
+            scm_object_free(jobs[i].head);
+            continue;
+        }
+        free(jobs[i].err);
+        if (err || jobs[i].head == scm_null) {
+            scm_object_free(jobs[i].head);
+            continue;
+        }
+        if (head == scm_null)
+            head = jobs[i].head;
+        else
+            scm_set_cdr(tail, jobs[i].head);
+        tail = jobs[i].tail;
+    }
+
+    if (err) {
+        scm_object_free(head);
+        scm_error_free(free, err, "%s", err);
+    }
+
+    return head;
+}
+
+scm_object *scm_read_file(const char *name, int nthreads) {
+    FILE *fp = fopen(name, "rb");
+    char *buf;
+    long size;
+    scm_object *res = scm_null;
+
+    if (!fp) {
+        scm_sys_err("read-file: can't open input file\n"
+                    "name: %s\n", name);
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = malloc(size + 1);
+    if (fread(buf, 1, size, fp) != (size_t)size) {
+        fclose(fp);
+        free(buf);
+        scm_sys_err("read-file: can't read input file\n"
+                    "name: %s\n", name);
+    }
+    fclose(fp);
+    buf[size] = '\0';
+
+    SCM_TRY {
+        res = scm_read_buffer(buf, size, nthreads);
+    } SCM_CATCH {
+        free(buf);
+        SCM_THROW;
+    } SCM_END_TRY;
+
+    free(buf);
+    return res;
+}
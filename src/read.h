@@ -3,6 +3,10 @@
 #include "object.h"
 
 scm_object *scm_read(scm_object *port);
+/* parse all the top-level data, in parallel when the input is large enough */
+scm_object *scm_read_buffer(const char *buf, long size, int nthreads);
+scm_object *scm_read_file(const char *name, int nthreads);
+int scm_read_threads(void);
 
 #endif /* SCHEME_READ_H */
 
@@ -0,0 +1,199 @@
+#include "record.h"
+#include "err.h"
+#include "symbol.h"
+#include "pair.h"
+#include "proc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct scm_rtd_st {
+    scm_object base;
+    char *name;
+    /* the expected of contract violations, the name without <> and a ? */
+    char *pred;
+    long nfields;
+    scm_object **fields;
+} scm_rtd;
+
+typedef struct scm_record_st {
+    scm_object base;
+    scm_rtd *rtd;
+    scm_object *slots[];
+} scm_record;
+
+/* the data of the procedures of a type, @k is the field of accessors and
+ * modifiers and the number of the arguments of constructors */
+typedef struct record_proc_st {
+    scm_rtd *rtd;
+    char *name;
+    long k;
+    long slots[];
+} record_proc;
+
+/* a copy */
+static char *identifier_name(scm_object *id) {
+    const char *str;
+    char *name;
+    size_t len;
+
+    if (IS_EXTENDED_IDENTIFIER(id))
+        id = scm_esymbol_get_symbol(id);
+    str = scm_symbol_get_string(id);
+    len = strlen(str);
+    name = malloc(len + 1);
+    memcpy(name, str, len + 1);
+    return name;
+}
+
+scm_object *scm_record_type_new(scm_object *name, scm_object *fields) {
+    scm_rtd *rtd = malloc(sizeof(scm_rtd));
+    long i = 0, len;
+
+    rtd->base.type = scm_type_record_type;
+    rtd->name = identifier_name(name);
+    len = strlen(rtd->name);
+    rtd->pred = malloc(len + 2);
+    if (len > 2 && rtd->name[0] == '<' && rtd->name[len - 1] == '>')
+        sprintf(rtd->pred, "%.*s?", (int)len - 2, rtd->name + 1);
+    else
+        sprintf(rtd->pred, "%s?", rtd->name);
+
+    rtd->nfields = scm_list_length(fields);
+    rtd->fields = malloc((rtd->nfields ? rtd->nfields : 1) * sizeof(scm_object *));
+    FOREACH_LIST(field, fields)
+        rtd->fields[i++] = field;
+    return (scm_object *)rtd;
+}
+
+const char *scm_record_type_name(scm_object *rtd) {
+    return ((scm_rtd *)rtd)->name;
+}
+
+long scm_record_type_field_count(scm_object *rtd) {
+    return ((scm_rtd *)rtd)->nfields;
+}
+
+long scm_record_type_field_index(scm_object *rtd, scm_object *field) {
+    scm_rtd *t = (scm_rtd *)rtd;
+    for (long i = 0; i < t->nfields; ++i) {
+        if (same_id(t->fields[i], field))
+            return i;
+    }
+    return -1;
+}
+
+scm_object *scm_record_type(scm_object *record) {
+    return (scm_object *)((scm_record *)record)->rtd;
+}
+
+scm_object *scm_record_ref(scm_object *record, long k) {
+    return ((scm_record *)record)->slots[k];
+}
+
+void scm_record_set(scm_object *record, long k, scm_object *obj) {
+    ((scm_record *)record)->slots[k] = obj;
+}
+
+static record_proc *record_proc_new(scm_rtd *rtd, scm_object *name, long k, long nslots) {
+    record_proc *p = malloc(sizeof(record_proc) + nslots * sizeof(long));
+    p->rtd = rtd;
+    p->name = identifier_name(name);
+    p->k = k;
+    return p;
+}
+
+/* the procedures of a type */
+static scm_object *construct(void *data, int n, scm_object **args) {
+    record_proc *p = data;
+    long nfields = p->rtd->nfields;
+    scm_record *r = malloc(sizeof(scm_record) + nfields * sizeof(scm_object *));
+    (void)n;
+
+    r->base.type = scm_type_record;
+    r->rtd = p->rtd;
+    for (long i = 0; i < nfields; ++i)
+        r->slots[i] = scm_false;
+    for (long i = 0; i < p->k; ++i)
+        r->slots[p->slots[i]] = args[i];
+    return (scm_object *)r;
+}
+
+static scm_object *is_instance(void *data, int n, scm_object **args) {
+    record_proc *p = data;
+    scm_object *obj = args[0];
+    (void)n;
+    return scm_boolean(obj->type == scm_type_record && ((scm_record *)obj)->rtd == p->rtd);
+}
+
+static scm_record *record_arg(record_proc *p, scm_object *obj) {
+    if (obj->type != scm_type_record || ((scm_record *)obj)->rtd != p->rtd)
+        scm_contract_violation(p->name, 1, p->rtd->pred, obj);
+    return (scm_record *)obj;
+}
+
+static scm_object *access_field(void *data, int n, scm_object **args) {
+    record_proc *p = data;
+    (void)n;
+    return record_arg(p, args[0])->slots[p->k];
+}
+
+static scm_object *modify_field(void *data, int n, scm_object **args) {
+    record_proc *p = data;
+    (void)n;
+    record_arg(p, args[0])->slots[p->k] = args[1];
+    return scm_void;
+}
+
+scm_object *scm_record_constructor(scm_object *rtd, scm_object *name, scm_object *fields) {
+    long n = scm_list_length(fields), i = 0;
+    record_proc *p = record_proc_new((scm_rtd *)rtd, name, n, n);
+
+    FOREACH_LIST(field, fields)
+        p->slots[i++] = scm_record_type_field_index(rtd, field);
+    return scm_primitive_new_with_data(p->name, construct, p, n, n);
+}
+
+scm_object *scm_record_predicate(scm_object *rtd, scm_object *name) {
+    record_proc *p = record_proc_new((scm_rtd *)rtd, name, 0, 0);
+    return scm_primitive_new_with_data(p->name, is_instance, p, 1, 1);
+}
+
+scm_object *scm_record_accessor(scm_object *rtd, scm_object *name, long k) {
+    record_proc *p = record_proc_new((scm_rtd *)rtd, name, k, 0);
+    return scm_primitive_new_with_data(p->name, access_field, p, 1, 1);
+}
+
+scm_object *scm_record_modifier(scm_object *rtd, scm_object *name, long k) {
+    record_proc *p = record_proc_new((scm_rtd *)rtd, name, k, 0);
+    return scm_primitive_new_with_data(p->name, modify_field, p, 2, 2);
+}
+
+static void record_type_free(scm_object *obj) {
+    scm_rtd *rtd = (scm_rtd *)obj;
+    free(rtd->name);
+    free(rtd->pred);
+    free(rtd->fields);
+    free(rtd);
+}
+
+static void record_free(scm_object *obj) {
+    free(obj);
+}
+
+/* records are equal? only to themselves, as in R7RS */
+static scm_object_methods record_type_methods = { record_type_free, same_object, same_object, NULL, NULL };
+static scm_object_methods record_methods = { record_free, same_object, same_object, NULL, NULL };
+
+static int initialized = 0;
+
+int scm_record_init(void) {
+    if (initialized) return 0;
+
+    scm_object_register(scm_type_record_type, &record_type_methods);
+    scm_object_register(scm_type_record, &record_methods);
+
+    initialized = 1;
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef SCHEME_RECORD_H
+#define SCHEME_RECORD_H
+#include "object.h"
+
+/* records (R7RS define-record-type) keep their fields inline after the type
+ * descriptor, and the procedures made for a type are primitives closed over
+ * it, which check their record by the descriptor pointer and load the field
+ * at its index */
+
+/* @name and @fields are identifiers */
+scm_object *scm_record_type_new(scm_object *name, scm_object *fields);
+const char *scm_record_type_name(scm_object *rtd);
+long scm_record_type_field_count(scm_object *rtd);
+/* -1 if not a field of the type */
+long scm_record_type_field_index(scm_object *rtd, scm_object *field);
+
+scm_object *scm_record_type(scm_object *record);
+scm_object *scm_record_ref(scm_object *record, long k);
+void scm_record_set(scm_object *record, long k, scm_object *obj);
+
+/* @name is the identifier the procedure is defined to,
+ * @fields are those of the constructor arguments, the others start as #f */
+scm_object *scm_record_constructor(scm_object *rtd, scm_object *name, scm_object *fields);
+scm_object *scm_record_predicate(scm_object *rtd, scm_object *name);
+scm_object *scm_record_accessor(scm_object *rtd, scm_object *name, long k);
+scm_object *scm_record_modifier(scm_object *rtd, scm_object *name, long k);
+
+int scm_record_init(void);
+
+#endif /* SCHEME_RECORD_H */
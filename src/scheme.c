@@ -8,6 +8,13 @@
 #include "token.h"
 #include "pair.h"
 #include "vector.h"
+#include "hashtable.h"
+#include "bytevector.h"
+#include "numvector.h"
+#include "record.h"
+#include "pmap.h"
+#include "pvector.h"
+#include "sort.h"
 #include "env.h"
 #include "exp.h"
 #include "read.h"
@@ -17,7 +24,27 @@
 
 #include <stdio.h>
 
-int main()
+/* parse the whole file first, in parallel for large ones,
+ * then evaluate the top-level forms in order */
+static int load_file(const char *name, scm_object *env, scm_object *oport) {
+    int ret = 0;
+    SCM_TRY {
+        scm_object *exps = scm_read_file(name, scm_read_threads());
+        while (exps != scm_null) {
+            scm_eval(scm_car(exps), env);
+            exps = scm_cdr(exps);
+        }
+    } SCM_CATCH {
+        scm_output_port_puts(oport, scm_error_msg());
+        scm_newline(oport);
+        ret = 1;
+    } SCM_END_TRY;
+
+    scm_output_port_flush(oport);
+    return ret;
+}
+
+int main(int argc, char **argv)
 {
     scm_object_init();
     scm_char_init();
@@ -28,6 +55,13 @@ int main()
     scm_token_init();
     scm_pair_init();
     scm_vector_init();
+    scm_hashtable_init();
+    scm_bytevector_init();
+    scm_numvector_init();
+    scm_record_init();
+    scm_pmap_init();
+    scm_pvector_init();
+    scm_sort_init();
     scm_exp_init();
     scm_proc_init();
     scm_eval_init();
@@ -40,9 +74,20 @@ int main()
 
     scm_object *iport = default_iport;
     scm_object *oport = default_oport;
+
+    /* run the given files instead of the REPL */
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            if (load_file(argv[i], env, oport))
+                return 1;
+        }
+        return 0;
+    }
+
     scm_output_port_puts(oport, welcome);
     while (1) {
         scm_output_port_puts(oport, prompt);
+        scm_output_port_flush(oport);
         SCM_TRY {
             scm_object *exp = scm_read(iport);
             if (exp == scm_eof) {
@@ -0,0 +1,511 @@
+#include "sort.h"
+#include "number.h"
+#include "string.h"
+#include "char.h"
+#include "pair.h"
+#include "vector.h"
+#include "symbol.h"
+#include "proc.h"
+#include "env.h"
+#include "err.h"
+#include "eval.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* the primitives compared directly, as they are bound at start up */
+static scm_object *num_lt, *num_gt, *string_lt, *string_gt, *char_lt, *char_gt;
+
+enum { by_proc, by_fixnum, by_float, by_string, by_char };
+
+typedef struct sorter_st {
+    int kind;
+    /* whether the direct comparisons are reversed, for > and the like */
+    int desc;
+    scm_object *proc;
+} sorter;
+
+static int all_of_type(scm_object **elts, long n, scm_type type) {
+    for (long i = 0; i < n; ++i) {
+        if (elts[i]->type != type)
+            return 0;
+    }
+    return 1;
+}
+
+/* @less is compared directly if all the @n1 and @n2 elements suit it,
+ * or else called, where it raises errors as it would by itself */
+static void sorter_init(sorter *s, scm_object *less, scm_object **e1, long n1,
+                        scm_object **e2, long n2) {
+    s->kind = by_proc;
+    s->desc = less == num_gt || less == string_gt || less == char_gt;
+    s->proc = less;
+
+#define ALL(type) (all_of_type(e1, n1, type) && all_of_type(e2, n2, type))
+    if (less == num_lt || less == num_gt) {
+        if (ALL(scm_type_integer))
+            s->kind = by_fixnum;
+        else if (ALL(scm_type_float))
+            s->kind = by_float;
+    }
+    else if ((less == string_lt || less == string_gt) && ALL(scm_type_string))
+        s->kind = by_string;
+    else if ((less == char_lt || less == char_gt) && ALL(scm_type_char))
+        s->kind = by_char;
+#undef ALL
+}
+
+static int call_less(sorter *s, scm_object *a, scm_object *b) {
+    scm_object *args[] = { a, b };
+    return scm_apply(s->proc, 2, args) != scm_false;
+}
+
+/* whether @a goes strictly before @b */
+static inline int less(sorter *s, scm_object *a, scm_object *b) {
+    int c;
+
+    switch (s->kind) {
+    case by_fixnum: {
+        long x = scm_integer_get_val(a), y = scm_integer_get_val(b);
+        c = (x > y) - (x < y);
+        break;
+    }
+    case by_float: {
+        double x = scm_float_get_val(a), y = scm_float_get_val(b);
+        /* NaNs are before and after nothing, as with < */
+        c = (x > y) - (x < y);
+        break;
+    }
+    case by_string:
+        c = scm_string_compare(a, b);
+        break;
+    case by_char:
+        c = scm_char_get_codepoint(a) - scm_char_get_codepoint(b);
+        break;
+    default:
+        return call_less(s, a, b);
+    }
+    return s->desc ? c > 0 : c < 0;
+}
+
+/* natural merge sort: the runs already in order are found and short ones
+ * are made up to MIN_RUN elements by insertion, then adjacent runs are
+ * merged pairwise back and forth with a buffer
+ * a sorted input takes n - 1 comparisons, a reversed one 2n */
+
+#define MIN_RUN 32
+
+static void reverse(scm_object **elts, long n) {
+    for (long i = 0, j = n - 1; i < j; ++i, --j) {
+        scm_object *t = elts[i];
+        elts[i] = elts[j];
+        elts[j] = t;
+    }
+}
+
+/* inserts each of @elts[start, n) into the sorted @elts[0, start), after
+ * any equal ones */
+static void insertion_sort(sorter *s, scm_object **elts, long start, long n) {
+    for (long i = start; i < n; ++i) {
+        scm_object *x = elts[i];
+        long lo = 0, hi = i;
+        while (lo < hi) {
+            long mid = lo + (hi - lo) / 2;
+            if (less(s, x, elts[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(elts + lo + 1, elts + lo, (i - lo) * sizeof(scm_object *));
+        elts[lo] = x;
+    }
+}
+
+/* the length of the run at the start, in order after a strictly
+ * descending one is reversed, which keeps it stable */
+static long count_run(sorter *s, scm_object **elts, long n) {
+    long i = 2;
+
+    if (n < 2)
+        return n;
+    if (less(s, elts[1], elts[0])) {
+        while (i < n && less(s, elts[i], elts[i - 1]))
+            ++i;
+        reverse(elts, i);
+    }
+    else {
+        while (i < n && !less(s, elts[i], elts[i - 1]))
+            ++i;
+    }
+    return i;
+}
+
+/* @a first among equal elements */
+static void merge(sorter *s, scm_object **a, long na, scm_object **b, long nb,
+                  scm_object **out) {
+    long i = 0, j = 0;
+
+    if (na > 0 && nb > 0 && !less(s, b[0], a[na - 1])) {
+        memcpy(out, a, na * sizeof(scm_object *));
+        memcpy(out + na, b, nb * sizeof(scm_object *));
+        return;
+    }
+    while (i < na && j < nb) {
+        if (less(s, b[j], a[i]))
+            *out++ = b[j++];
+        else
+            *out++ = a[i++];
+    }
+    if (i < na)
+        memcpy(out, a + i, (na - i) * sizeof(scm_object *));
+    else if (j < nb)
+        memcpy(out, b + j, (nb - j) * sizeof(scm_object *));
+}
+
+static void merge_sort(sorter *s, scm_object **elts, long n) {
+    scm_object **src = elts, **dst, **t;
+    long *bounds, nruns = 0, i, k;
+
+    if (n < 2)
+        return;
+    bounds = malloc((n / MIN_RUN + 2) * sizeof(long));
+    for (i = 0; i < n; i += k) {
+        k = count_run(s, elts + i, n - i);
+        if (k < MIN_RUN) {
+            long m = n - i < MIN_RUN ? n - i : MIN_RUN;
+            insertion_sort(s, elts + i, k, m);
+            k = m;
+        }
+        bounds[nruns++] = i;
+    }
+    bounds[nruns] = n;
+    if (nruns == 1) {
+        free(bounds);
+        return;
+    }
+
+    dst = malloc(n * sizeof(scm_object *));
+    while (nruns > 1) {
+        for (i = 0, k = 0; i < nruns; i += 2, ++k) {
+            long lo = bounds[i], mid = bounds[i + 1];
+            long hi = i + 1 < nruns ? bounds[i + 2] : mid;
+            merge(s, src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+            bounds[k] = lo;
+        }
+        bounds[k] = n;
+        nruns = k;
+        t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != elts) {
+        memcpy(elts, src, n * sizeof(scm_object *));
+        dst = src;
+    }
+    free(dst);
+    free(bounds);
+}
+
+/* the direct comparisons only read the elements, so they can be sorted on
+ * several threads: each sorts a chunk, then the chunks are merged pairwise
+ * in rounds, every merge split at a few of the elements of its first run
+ * and the elements of its second one around them, so that all the threads
+ * stay busy until the last round
+ * chunks smaller than this are not worth a thread of their own */
+#define MIN_CHUNK_SIZE (16 * 1024)
+#define MAX_SORT_THREADS 64
+
+typedef struct sort_job_st {
+    sorter *s;
+    /* a chunk to sort if @a is NULL, or else the runs to merge into @out */
+    scm_object **elts;
+    long n;
+    scm_object **a, **b, **out;
+    long na, nb;
+    int threaded;
+} sort_job;
+
+static void *run_job(void *arg) {
+    sort_job *job = arg;
+    if (job->a)
+        merge(job->s, job->a, job->na, job->b, job->nb, job->out);
+    else
+        merge_sort(job->s, job->elts, job->n);
+    return NULL;
+}
+
+static void run_jobs(sort_job *jobs, int n) {
+    pthread_t threads[MAX_SORT_THREADS];
+    int i;
+
+    /* the current thread takes the first job */
+    for (i = 1; i < n; ++i) {
+        jobs[i].threaded = !pthread_create(&threads[i], NULL, run_job, &jobs[i]);
+        if (!jobs[i].threaded)
+            run_job(&jobs[i]);
+    }
+    run_job(&jobs[0]);
+    for (i = 1; i < n; ++i) {
+        if (jobs[i].threaded)
+            pthread_join(threads[i], NULL);
+    }
+}
+
+/* how many of the sorted @b go before @x, the equal ones go after it */
+static long count_less(sorter *s, scm_object **b, long nb, scm_object *x) {
+    long lo = 0, hi = nb;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (less(s, b[mid], x))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void parallel_sort(sorter *s, scm_object **elts, long n, int nthreads) {
+    sort_job jobs[MAX_SORT_THREADS] = {{0}};
+    long bounds[MAX_SORT_THREADS + 1];
+    scm_object **src = elts, **dst = malloc(n * sizeof(scm_object *)), **t;
+    int nruns = nthreads, i, j, k;
+
+    for (i = 0; i <= nruns; ++i)
+        bounds[i] = n / nruns * i + (i == nruns ? n % nruns : 0);
+    for (i = 0; i < nruns; ++i) {
+        jobs[i].s = s;
+        jobs[i].elts = elts + bounds[i];
+        jobs[i].n = bounds[i + 1] - bounds[i];
+    }
+    run_jobs(jobs, nruns);
+
+    /* @nthreads is a power of 2, so are the numbers of the runs */
+    for (; nruns > 1; nruns /= 2) {
+        int pieces = nthreads / (nruns / 2);
+        for (i = 0, k = 0; i < nruns; i += 2) {
+            scm_object **a = src + bounds[i], **b = src + bounds[i + 1];
+            long na = bounds[i + 1] - bounds[i], nb = bounds[i + 2] - bounds[i + 1];
+            long ia = 0, ib = 0;
+            for (j = 1; j <= pieces; ++j, ++k) {
+                long ja = na / pieces * j + (j == pieces ? na % pieces : 0);
+                long jb = ja < na ? count_less(s, b, nb, a[ja]) : nb;
+                /* NaNs may spoil the order the search relies on */
+                if (jb < ib)
+                    jb = ib;
+                jobs[k].s = s;
+                jobs[k].a = a + ia;
+                jobs[k].na = ja - ia;
+                jobs[k].b = b + ib;
+                jobs[k].nb = jb - ib;
+                jobs[k].out = dst + bounds[i] + ia + ib;
+                ia = ja;
+                ib = jb;
+            }
+        }
+        run_jobs(jobs, k);
+        for (i = 0; i <= nruns / 2; ++i)
+            bounds[i] = bounds[i * 2];
+        t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != elts) {
+        memcpy(elts, src, n * sizeof(scm_object *));
+        dst = src;
+    }
+    free(dst);
+}
+
+int scm_sort_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+        return 1;
+    return n < MAX_SORT_THREADS ? n : MAX_SORT_THREADS;
+}
+
+void scm_sort_parallel(scm_object **elts, long n, scm_object *less, int nthreads) {
+    sorter s;
+    int k = 1;
+
+    sorter_init(&s, less, elts, n, NULL, 0);
+    if (s.kind == by_proc)
+        nthreads = 1;
+    if (nthreads > n / MIN_CHUNK_SIZE)
+        nthreads = n / MIN_CHUNK_SIZE;
+    while (k * 2 <= nthreads && k * 2 <= MAX_SORT_THREADS)
+        k *= 2;
+    if (k == 1) {
+        merge_sort(&s, elts, n);
+        return;
+    }
+    /* flattened up front, they are only read from then on */
+    if (s.kind == by_string) {
+        for (long i = 0; i < n; ++i)
+            scm_string_get_str(elts[i]);
+    }
+    parallel_sort(&s, elts, n, k);
+}
+
+void scm_sort(scm_object **elts, long n, scm_object *less) {
+    scm_sort_parallel(elts, n, less, scm_sort_threads());
+}
+
+/* a malloc'ed array of the elements of the proper list @list */
+static scm_object **list_elements(const char *name, int argno, scm_object *list, long *n) {
+    scm_object **elts, *p;
+    long i = 0;
+
+    for (p = list; p->type == scm_type_pair; p = scm_cdr(p))
+        ++i;
+    if (p != scm_null)
+        scm_contract_violation(name, argno, "list?", list);
+    *n = i;
+    elts = malloc((i ? i : 1) * sizeof(scm_object *));
+    for (i = 0, p = list; p != scm_null; p = scm_cdr(p))
+        elts[i++] = scm_car(p);
+    return elts;
+}
+
+static scm_object *elements_list(scm_object **elts, long n) {
+    scm_object *list = scm_null;
+    while (n > 0)
+        list = scm_cons(elts[--n], list);
+    return list;
+}
+
+static scm_object *vector_of(scm_object **elts, long n) {
+    scm_object *v;
+    if (n == 0)
+        return scm_empty_vector;
+    v = scm_vector_alloc(n);
+    memcpy(scm_vector_elements(v), elts, n * sizeof(scm_object *));
+    return v;
+}
+
+static scm_object *list_sort(const char *name, int argno, scm_object *less, scm_object *list) {
+    long n;
+    scm_object **elts = list_elements(name, argno, list, &n), *r;
+    scm_sort(elts, n, less);
+    r = elements_list(elts, n);
+    free(elts);
+    return r;
+}
+
+scm_object *scm_list_sort(scm_object *less, scm_object *list) {
+    return list_sort("list-sort", 2, less, list);
+}
+
+static scm_object **merged(scm_object *less, scm_object **e1, long n1, scm_object **e2, long n2) {
+    scm_object **out = malloc((n1 + n2 ? n1 + n2 : 1) * sizeof(scm_object *));
+    sorter s;
+    sorter_init(&s, less, e1, n1, e2, n2);
+    merge(&s, e1, n1, e2, n2, out);
+    return out;
+}
+
+scm_object *scm_list_merge(scm_object *less, scm_object *l1, scm_object *l2) {
+    long n1, n2;
+    scm_object **e1 = list_elements("list-merge", 2, l1, &n1);
+    scm_object **e2 = list_elements("list-merge", 3, l2, &n2);
+    scm_object **out = merged(less, e1, n1, e2, n2), *r;
+
+    r = elements_list(out, n1 + n2);
+    free(out);
+    free(e1);
+    free(e2);
+    return r;
+}
+
+/* (sort list less?) */
+static scm_object *prim_sort(int n, scm_object **args) {
+    (void)n;
+    if (scm_primitive_apply(pred_procedure, 1, args + 1) == scm_false)
+        scm_contract_violation("sort", 2, "procedure?", args[1]);
+    return list_sort("sort", 1, args[1], args[0]);
+}
+
+/* (list-sort less? list) */
+static scm_object *prim_list_sort(int n, scm_object **args) {
+    (void)n;
+    return scm_list_sort(args[0], args[1]);
+}
+
+/* (list-merge less? list1 list2) */
+static scm_object *prim_list_merge(int n, scm_object **args) {
+    (void)n;
+    return scm_list_merge(args[0], args[1], args[2]);
+}
+
+/* (vector-sort less? vector [start [end]]), a new vector of the range */
+static scm_object *prim_vector_sort(int n, scm_object **args) {
+    scm_object *v = args[1], *r;
+    long start, end;
+
+    scm_range_args("vector-sort", n, 3, args, v, "vector", scm_vector_length(v), &start, &end);
+    r = vector_of(scm_vector_elements(v) + start, end - start);
+    if (r != scm_empty_vector)
+        scm_sort(scm_vector_elements(r), end - start, args[0]);
+    return r;
+}
+
+/* (vector-sort! vector less? [start [end]]) */
+static scm_object *prim_vector_sort_x(int n, scm_object **args) {
+    scm_object *v = args[0], **elts;
+    long start, end;
+
+    scm_range_args("vector-sort!", n, 3, args, v, "vector", scm_vector_length(v), &start, &end);
+    if (start == end)
+        return scm_void;
+    /* sorted aside, as @less may change the vector */
+    elts = malloc((end - start) * sizeof(scm_object *));
+    memcpy(elts, scm_vector_elements(v) + start, (end - start) * sizeof(scm_object *));
+    scm_sort(elts, end - start, args[1]);
+    memcpy(scm_vector_elements(v) + start, elts, (end - start) * sizeof(scm_object *));
+    free(elts);
+    return scm_void;
+}
+
+/* (vector-merge less? vector1 vector2) */
+static scm_object *prim_vector_merge(int n, scm_object **args) {
+    scm_object *v1 = args[1], *v2 = args[2], **out, *r;
+    long n1 = scm_vector_length(v1), n2 = scm_vector_length(v2);
+    (void)n;
+
+    out = merged(args[0], scm_vector_elements(v1), n1, scm_vector_elements(v2), n2);
+    r = vector_of(out, n1 + n2);
+    free(out);
+    return r;
+}
+
+static int initialized = 0;
+
+int scm_sort_init(void) {
+    if (initialized) return 0;
+
+    initialized = 1;
+    return 0;
+}
+
+/* after the comparisons are bound in @env */
+int scm_sort_init_env(scm_object *env) {
+    num_lt = scm_env_lookup_var(env, SYM(<));
+    num_gt = scm_env_lookup_var(env, SYM(>));
+    string_lt = scm_env_lookup_var(env, SYM(string<?));
+    string_gt = scm_env_lookup_var(env, SYM(string>?));
+    char_lt = scm_env_lookup_var(env, SYM(char<?));
+    char_gt = scm_env_lookup_var(env, SYM(char>?));
+
+    scm_env_add_prim(env, "sort", prim_sort, 2, 2, NULL);
+    scm_env_add_prim(env, "list-sort", prim_list_sort, 2, 2, scm_list(1, pred_procedure));
+    scm_env_add_prim(env, "list-merge", prim_list_merge, 3, 3, scm_list(1, pred_procedure));
+    scm_env_add_prim(env, "vector-sort", prim_vector_sort, 2, 4,
+                     scm_list(2, pred_procedure, pred_vector));
+    scm_env_add_prim(env, "vector-sort!", prim_vector_sort_x, 2, 4,
+                     scm_list(2, pred_vector, pred_procedure));
+    scm_env_add_prim(env, "vector-merge", prim_vector_merge, 3, 3,
+                     scm_list(3, pred_procedure, pred_vector, pred_vector));
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef SCHEME_SORT_H
+#define SCHEME_SORT_H
+#include "object.h"
+
+/* stable merge sorts by a procedure @less taking two elements
+ * <, >, string<?, string>?, char<? and char>? are compared directly
+ * without calls when all the elements are of the type they expect */
+
+/* sorts @elts in place, on up to scm_sort_threads threads when @less is
+ * compared directly and there are enough of them */
+void scm_sort(scm_object **elts, long n, scm_object *less);
+/* on at most @nthreads threads */
+void scm_sort_parallel(scm_object **elts, long n, scm_object *less, int nthreads);
+int scm_sort_threads(void);
+/* a new list, @list is unchanged */
+scm_object *scm_list_sort(scm_object *less, scm_object *list);
+/* a new list of the elements of the sorted lists, those of @l1 first
+ * among equal ones */
+scm_object *scm_list_merge(scm_object *less, scm_object *l1, scm_object *l2);
+
+int scm_sort_init(void);
+int scm_sort_init_env(scm_object *env);
+
+#endif /* SCHEME_SORT_H */
@@ -2,18 +2,55 @@
 #include "err.h"
 #include "char.h"
 #include "number.h"
+#include "pair.h"
 #include "proc.h"
 #include "env.h"
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* ropes are immutable balanced trees of slices of buffers, so that long
+ * strings can be concatenated and cut in O(log n) steps without copying
+ * the characters; the balance is the one of AVL trees, kept by rotations
+ * while joining (persistent AVL join) */
+typedef struct rope_st rope;
+struct rope_st {
+    long len;           /* in bytes */
+    int depth;          /* 0 for leaves */
+    rope *left;         /* for concatenations */
+    rope *right;
+    const char *buf;    /* for leaves */
+};
+
+/* a string is a mutable buffer, a slice of the buffer of another string,
+ * or a rope flattened into a buffer when its characters are needed
+ * a buffer that other strings or ropes refer to is shared, and copied
+ * before changing, so that substrings cost no copies of the characters
+ *
+ * the characters are in well-formed UTF-8: a string of ASCII only, whose
+ * length is its size, is indexed directly, others through a sparse index
+ * of the byte offset of every INDEX_STEP-th character, made on the first
+ * indexing, so that each index takes a walk of less than INDEX_STEP */
 typedef struct scm_string_st {
     scm_object base;
-    char *buf;
-    long len;   /* NOTE: need proper type */
+    char *buf;      /* NULL while only in @rope, not NUL terminated */
+    long size;      /* in bytes */
+    long len;       /* in characters */
+    rope *rope;     /* the same characters as @buf if both are there */
+    int shared;
+    long *index;    /* NULL until needed, dropped when @buf changes */
 } scm_string;
 
+#define is_ascii(s) ((s)->size == (s)->len)
+#define INDEX_STEP  32
+
+/* concatenations shorter than this are plain copies */
+#define ROPE_MIN_LEN    128
+/* adjacent leaves up to this length together are merged in a copy, so that
+ * appending small fragments doesn't make a leaf of each */
+#define ROPE_LEAF_MAX   512
+
 static scm_object *empty_string = NULL;
 
 static void out_of_range(scm_object *obj, long k) {
@@ -26,51 +63,282 @@ static void out_of_range(scm_object *obj, long k) {
                          "valid range: [0, %ld]\nstring: ", k, str->len-1);
 }
 
-static scm_object *string_alloc(char *buf, long len) {
+static scm_object *string_alloc(char *buf, long size, long len) {
     scm_string *str = malloc(sizeof(scm_string));
 
     str->base.type = scm_type_string;
 
     str->buf = buf;
+    str->size = size;
     str->len = len;
+    str->rope = NULL;
+    str->shared = 0;
+    str->index = NULL;
 
     return (scm_object *)str;
 }
 
-/* scm_string_new doesn't copy buf */
-scm_object *scm_string_new(char *buf, long len) {
-    if (len < 0) {
-        len = strlen(buf);
+/* ropes */
+static rope *leaf_new(const char *buf, long len) {
+    rope *r = malloc(sizeof(rope));
+    r->len = len;
+    r->depth = 0;
+    r->left = r->right = NULL;
+    r->buf = buf;
+    return r;
+}
+
+static rope *node_new(rope *left, rope *right) {
+    rope *r = malloc(sizeof(rope));
+    r->len = left->len + right->len;
+    r->depth = 1 + (left->depth > right->depth ? left->depth : right->depth);
+    r->left = left;
+    r->right = right;
+    r->buf = NULL;
+    return r;
+}
+
+/* (a (b c)) -> ((a b) c) */
+static rope *rotate_left(rope *r) {
+    return node_new(node_new(r->left, r->right->left), r->right->right);
+}
+
+/* ((a b) c) -> (a (b c)) */
+static rope *rotate_right(rope *r) {
+    return node_new(r->left->left, node_new(r->left->right, r->right));
+}
+
+static rope *rope_join(rope *l, rope *r);
+
+/* @l is deeper than @r by more than 1 */
+static rope *join_right(rope *l, rope *r) {
+    rope *t = rope_join(l->right, r);
+
+    if (t->depth <= l->left->depth + 1)
+        return node_new(l->left, t);
+    if (t->left->depth > t->right->depth)
+        t = rotate_right(t);
+    return rotate_left(node_new(l->left, t));
+}
+
+/* @r is deeper than @l by more than 1 */
+static rope *join_left(rope *l, rope *r) {
+    rope *t = rope_join(l, r->left);
+
+    if (t->depth <= r->right->depth + 1)
+        return node_new(t, r->right);
+    if (t->right->depth > t->left->depth)
+        t = rotate_left(t);
+    return rotate_right(node_new(t, r->right));
+}
+
+static rope *rope_join(rope *l, rope *r) {
+    char *buf;
+
+    if (!l->depth && !r->depth && l->len + r->len <= ROPE_LEAF_MAX) {
+        buf = malloc(l->len + r->len);
+        memcpy(buf, l->buf, l->len);
+        memcpy(buf + l->len, r->buf, r->len);
+        return leaf_new(buf, l->len + r->len);
     }
+    if (l->depth > r->depth + 1)
+        return join_right(l, r);
+    if (r->depth > l->depth + 1)
+        return join_left(l, r);
+    /* down the right spine to merge a small piece into the last leaf */
+    if (l->depth && !r->depth && r->len < ROPE_LEAF_MAX)
+        return rope_join(l->left, rope_join(l->right, r));
+    return node_new(l, r);
+}
 
-    if (len == 0)
+static rope *rope_sub(rope *r, long start, long end) {
+    long llen;
+
+    if (start == 0 && end == r->len)
+        return r;
+    if (!r->depth)
+        return leaf_new(r->buf + start, end - start);
+    llen = r->left->len;
+    if (end <= llen)
+        return rope_sub(r->left, start, end);
+    if (start >= llen)
+        return rope_sub(r->right, start - llen, end - llen);
+    return rope_join(rope_sub(r->left, start, llen), rope_sub(r->right, 0, end - llen));
+}
+
+/* the depth is logarithmic, so is the recursion */
+static void rope_copy(rope *r, char *dst) {
+    while (r->depth) {
+        rope_copy(r->left, dst);
+        dst += r->left->len;
+        r = r->right;
+    }
+    memcpy(dst, r->buf, r->len);
+}
+
+static rope *string_rope(scm_string *s) {
+    if (!s->rope) {
+        s->rope = leaf_new(s->buf, s->size);
+        s->shared = 1;
+    }
+    return s->rope;
+}
+
+/* flatten lazily, a single leaf is a slice as it is */
+static char *string_buf(scm_string *s) {
+    if (!s->buf && s->rope && !s->rope->depth) {
+        s->buf = (char *)s->rope->buf;
+        s->shared = 1;
+    } else if (!s->buf && s->rope) {
+        s->buf = malloc(s->size + 1);
+        rope_copy(s->rope, s->buf);
+        s->buf[s->size] = '\0';
+    }
+    return s->buf;
+}
+
+/* before the characters change */
+static char *string_own_buf(scm_string *s) {
+    char *buf = string_buf(s);
+
+    if (s->shared) {
+        s->buf = malloc(s->size + 1);
+        memcpy(s->buf, buf, s->size);
+        s->buf[s->size] = '\0';
+        s->shared = 0;
+    }
+    s->rope = NULL;
+    return s->buf;
+}
+
+/* put @buf of @size bytes in place of the characters */
+static void string_replace_buf(scm_string *s, char *buf, long size) {
+    if (!s->shared)
+        free(s->buf);
+    s->buf = buf;
+    s->size = size;
+    s->rope = NULL;
+    s->shared = 0;
+    free(s->index);
+    s->index = NULL;
+}
+
+/* the length of the UTF-8 sequence led by @b */
+#define sequence_length(b) \
+    ((unsigned char)(b) < 0x80 ? 1 : (unsigned char)(b) < 0xe0 ? 2 : (unsigned char)(b) < 0xf0 ? 3 : 4)
+
+/* the byte offset of the character @k, for 0 <= k <= len */
+static long byte_offset(scm_string *s, long k) {
+    const char *buf;
+    long off;
+
+    if (is_ascii(s))
+        return k;
+    if (k == s->len)
+        return s->size;
+    buf = string_buf(s);
+    if (!s->index) {
+        s->index = malloc((s->len / INDEX_STEP + 1) * sizeof(long));
+        off = 0;
+        for (long i = 0; i < s->len; ++i) {
+            if (i % INDEX_STEP == 0)
+                s->index[i / INDEX_STEP] = off;
+            off += sequence_length(buf[off]);
+        }
+    }
+    off = s->index[k / INDEX_STEP];
+    for (k %= INDEX_STEP; k > 0; --k)
+        off += sequence_length(buf[off]);
+    return off;
+}
+
+static scm_object *view_new(char *buf, long size, long len) {
+    scm_object *obj = string_alloc(buf, size, len);
+    ((scm_string *)obj)->shared = 1;
+    return obj;
+}
+
+/* the bytes from @start to @end of @s, which is flat */
+static scm_object *byte_slice(scm_string *s, long start, long end) {
+    if (start == end)
         return empty_string;
-    else
-        return string_alloc(buf, len);
+    s->shared = 1;
+    return view_new(s->buf + start, end - start,
+                    is_ascii(s) ? end - start : scm_utf8_count(s->buf + start, end - start));
+}
+
+static scm_object *rope_string(rope *r, long len) {
+    scm_object *obj;
+    char *buf;
+
+    if (!r->depth) {
+        obj = view_new((char *)r->buf, r->len, len);
+        ((scm_string *)obj)->rope = r;
+        return obj;
+    }
+    if (r->len < ROPE_MIN_LEN) {
+        buf = malloc(r->len + 1);
+        rope_copy(r, buf);
+        buf[r->len] = '\0';
+        return string_alloc(buf, r->len, len);
+    }
+    obj = string_alloc(NULL, r->len, len);
+    ((scm_string *)obj)->rope = r;
+    return obj;
+}
+
+/* scm_string_new doesn't copy buf
+ * ill-formed UTF-8 is replaced with U+FFFD, in a new buffer */
+scm_object *scm_string_new(char *buf, long size) {
+    long len;
+    char *repaired;
+
+    if (size < 0) {
+        size = strlen(buf);
+    }
+
+    if (size == 0)
+        return empty_string;
+    if ((len = scm_utf8_validate(buf, size)) < 0) {
+        repaired = scm_utf8_repair(buf, size, &size);
+        free(buf);
+        buf = repaired;
+        len = scm_utf8_count(buf, size);
+    }
+    return string_alloc(buf, size, len);
 }
 
 /* scm_string_copy_new copies buf, for tests */
-scm_object *scm_string_copy_new(const char *buf, long len) {
-    if (len < 0) {
-        len = strlen(buf);
+scm_object *scm_string_copy_new(const char *buf, long size) {
+    long len;
+    char *new_buf;
+
+    if (size < 0) {
+        size = strlen(buf);
     }
 
-    if (len == 0)
+    if (size == 0)
         return empty_string;
-    else {
-        char *new_buf = malloc(len + 1);
-        strncpy(new_buf, buf, len);
-        new_buf[len] = '\0';
-        return string_alloc(new_buf, len);
+    if ((len = scm_utf8_validate(buf, size)) < 0) {
+        new_buf = scm_utf8_repair(buf, size, &size);
+        len = scm_utf8_count(new_buf, size);
+    } else {
+        new_buf = malloc(size + 1);
+        memcpy(new_buf, buf, size);
+        new_buf[size] = '\0';
     }
+    return string_alloc(new_buf, size, len);
 }
 
+/* ropes and shared buffers may be parts of other strings */
 static void string_free(scm_object *obj) {
     if (obj == empty_string)
         return;
 
     scm_string *s = (scm_string *)obj;
-    free(s->buf);
+    if (!s->shared)
+        free(s->buf);
+    free(s->index);
     free(s);
 }
 
@@ -79,9 +347,14 @@ long scm_string_length(scm_object *obj) {
     return s->len;
 }
 
-static scm_object *prim_string_length(int n, scm_object *args) {
+long scm_string_size(scm_object *obj) {
+    scm_string *s = (scm_string *)obj;
+    return s->size;
+}
+
+static scm_object *prim_string_length(int n, scm_object **args) {
     (void)n;
-    return INTEGER(scm_string_length(scm_car(args)));
+    return INTEGER(scm_string_length(args[0]));
 }
 
 scm_object *scm_string_ref(scm_object *obj, long k) {
@@ -89,33 +362,387 @@ scm_object *scm_string_ref(scm_object *obj, long k) {
     if (k < 0 || k >= s->len) {
         out_of_range(obj, k);
     }
-    return (scm_object *)scm_chars[(int)scm_string_get_char(obj, k)];
+    return scm_char_new(scm_string_get_char(obj, k));
 }
 
-static scm_object *prim_string_ref(int n, scm_object *args) {
+static scm_object *prim_string_ref(int n, scm_object **args) {
     (void)n;
-    return scm_string_ref(scm_car(args), scm_integer_get_val(scm_cadr(args)));
+    return scm_string_ref(args[0], scm_integer_get_val(args[1]));
+}
+
+int scm_string_get_char(scm_object *obj, long k) {
+    scm_string *s = (scm_string *)obj;
+    const char *buf = string_buf(s);
+    int c;
+
+    if (is_ascii(s))
+        return buf[k];
+    scm_utf8_decode(buf + byte_offset(s, k), &c);
+    return c;
 }
 
-char scm_string_get_char(scm_object *obj, long k) {
+/* the raw bytes, not NUL terminated */
+const char *scm_string_get_str(scm_object *obj) {
     scm_string *s = (scm_string *)obj;
-    return s->buf[k];
+    return s->len ? string_buf(s) : "";
 }
 
+scm_object *scm_string_set(scm_object *obj, long k, int c) {
+    scm_string *s = (scm_string *)obj;
+    char enc[SCM_UTF8_MAX], *buf;
+    long off, old;
+    int len;
+
+    if (k < 0 || k >= s->len) {
+        scm_error_object(obj, "string-set!: index is out of range\nindex: %ld\n"
+                         "valid range: [0, %ld]\nstring: ", k, s->len-1);
+    }
+    if (is_ascii(s) && c < 0x80) {
+        string_own_buf(s)[k] = c;
+        return scm_void;
+    }
+
+    len = scm_utf8_encode(c, enc);
+    off = byte_offset(s, k);
+    old = sequence_length(string_buf(s)[off]);
+    if (len == old) {
+        memcpy(string_own_buf(s) + off, enc, len);
+        return scm_void;
+    }
+    /* the bytes after move */
+    buf = malloc(s->size - old + len + 1);
+    memcpy(buf, s->buf, off);
+    memcpy(buf + off, enc, len);
+    memcpy(buf + off + len, s->buf + off + old, s->size - off - old);
+    buf[s->size - old + len] = '\0';
+    string_replace_buf(s, buf, s->size - old + len);
+    return scm_void;
+}
+
+scm_object *scm_string_append(scm_object *s1, scm_object *s2) {
+    scm_string *a = (scm_string *)s1, *b = (scm_string *)s2;
+
+    if (a->len == 0)
+        return scm_string_copy(s2);
+    if (b->len == 0)
+        return scm_string_copy(s1);
+    return rope_string(rope_join(string_rope(a), string_rope(b)), a->len + b->len);
+}
+
+static void check_range(const char *name, scm_object *obj, long start, long end) {
+    long len = scm_string_length(obj);
+    if (start < 0 || start > len)
+        scm_error_object(obj, "%s: starting index is out of range\nstarting index: %ld\n"
+                         "valid range: [0, %ld]\nstring: ", name, start, len);
+    if (end < start || end > len)
+        scm_error_object(obj, "%s: ending index is out of range\nending index: %ld\n"
+                         "valid range: [%ld, %ld]\nstring: ", name, end, start, len);
+}
+
+/* ropes are cut by bytes, so only those of ASCII are cut as ropes, the
+ * others are flattened once to be cut by their index */
+scm_object *scm_substring(scm_object *obj, long start, long end) {
+    scm_string *s = (scm_string *)obj;
+    long bstart;
+
+    check_range("substring", obj, start, end);
+    if (start == end)
+        return empty_string;
+    if (s->buf || !is_ascii(s)) {
+        string_buf(s);
+        s->shared = 1;
+        bstart = byte_offset(s, start);
+        return view_new(s->buf + bstart, byte_offset(s, end) - bstart, end - start);
+    }
+    return rope_string(rope_sub(string_rope(s), start, end), end - start);
+}
+
+const char *scm_string_share_str(scm_object *obj) {
+    scm_string *s = (scm_string *)obj;
+
+    if (s->len == 0)
+        return "";
+    string_buf(s);
+    s->shared = 1;
+    return s->buf;
+}
+
+/* a new string of the same characters */
+scm_object *scm_string_copy(scm_object *obj) {
+    return scm_substring(obj, 0, scm_string_length(obj));
+}
+
+/* well-formed UTF-8 is the one encoding of its characters */
 static int string_equal(scm_object *o1, scm_object *o2) {
     scm_string *s1 = (scm_string *)o1;
     scm_string *s2 = (scm_string *)o2;
     return same_object(o1, o2) ||
-           (s1->len == s2->len && !strncmp(s1->buf, s2->buf, s1->len));
+           (s1->size == s2->size && (!s1->size || !memcmp(string_buf(s1), string_buf(s2), s1->size)));
+}
+
+static size_t string_equal_hash(scm_object *obj, int *budget) {
+    scm_string *s = (scm_string *)obj;
+    (void)budget;
+    return scm_hash_bytes(string_buf(s), s->size);
+}
+
+/* string primitives */
+/* @len times @c, NUL terminated */
+static char *repeat_char(int c, long len, long *size) {
+    char enc[SCM_UTF8_MAX], *buf;
+    int k = scm_utf8_encode(c, enc);
+
+    *size = len * k;
+    buf = malloc(*size + 1);
+    if (k == 1) {
+        memset(buf, c, len);
+    } else {
+        for (long i = 0; i < len; ++i)
+            memcpy(buf + i * k, enc, k);
+    }
+    buf[*size] = '\0';
+    return buf;
+}
+
+static scm_object *prim_make_string(int n, scm_object **args) {
+    long len = scm_index_arg("make-string", 1, args[0]), size;
+    int c = ' ';
+    char *buf;
+
+    if (n > 1) {
+        if (args[1]->type != scm_type_char)
+            scm_contract_violation("make-string", 2, "char?", args[1]);
+        c = scm_char_get_codepoint(args[1]);
+    }
+
+    if (len == 0)
+        return empty_string;
+    buf = repeat_char(c, len, &size);
+    return string_alloc(buf, size, len);
+}
+
+/* the string of the @n characters @chars */
+static scm_object *chars_to_string(long n, scm_object **chars) {
+    long size = 0, i = 0, k;
+    char *buf;
+
+    if (n == 0)
+        return empty_string;
+    for (k = 0; k < n; ++k)
+        size += scm_utf8_length(scm_char_get_codepoint(chars[k]));
+    buf = malloc(size + 1);
+    for (k = 0; k < n; ++k)
+        i += scm_utf8_encode(scm_char_get_codepoint(chars[k]), buf + i);
+    buf[size] = '\0';
+    return string_alloc(buf, size, n);
+}
+
+static scm_object *prim_string(int n, scm_object **args) {
+    return chars_to_string(n, args);
+}
+
+static scm_object *prim_string_set(int n, scm_object **args) {
+    (void)n;
+    return scm_string_set(args[0], scm_index_arg("string-set!", 2, args[1]),
+                          scm_char_get_codepoint(args[2]));
+}
+
+/* UTF-8 sorts by the code points bytewise, folded characters are compared
+ * one by one */
+static int string_compare(scm_object *o1, scm_object *o2, int ci) {
+    scm_string *a = (scm_string *)o1, *b = (scm_string *)o2;
+    long size = a->size < b->size ? a->size : b->size;
+    const char *s1, *s2;
+    long i = 0, j = 0;
+    int d, c1, c2;
+
+    if (size == 0)
+        return (a->size > b->size) - (a->size < b->size);
+    s1 = scm_string_get_str(o1);
+    s2 = scm_string_get_str(o2);
+    if (!ci) {
+        if ((d = memcmp(s1, s2, size)))
+            return d;
+        return (a->size > b->size) - (a->size < b->size);
+    }
+    while (i < a->size && j < b->size) {
+        i += scm_utf8_decode(s1 + i, &c1);
+        j += scm_utf8_decode(s2 + j, &c2);
+        if ((d = scm_char_downcase(c1) - scm_char_downcase(c2)))
+            return d;
+    }
+    return (i < a->size) - (j < b->size);
+}
+
+int scm_string_compare(scm_object *s1, scm_object *s2) {
+    return string_compare(s1, s2, 0);
+}
+
+/* whether the order holds pairwise along the arguments */
+#define define_compare_primitive(name, ci, op) \
+    static scm_object *prim_##name(int n, scm_object **args) { \
+        for (int i = 1; i < n; ++i) { \
+            if (!(string_compare(args[i - 1], args[i], ci) op 0)) \
+                return scm_false; \
+        } \
+        return scm_true; \
+    }
+
+define_compare_primitive(string_eq, 0, ==)
+define_compare_primitive(string_lt, 0, <)
+define_compare_primitive(string_gt, 0, >)
+define_compare_primitive(string_le, 0, <=)
+define_compare_primitive(string_ge, 0, >=)
+define_compare_primitive(string_ci_eq, 1, ==)
+define_compare_primitive(string_ci_lt, 1, <)
+define_compare_primitive(string_ci_gt, 1, >)
+define_compare_primitive(string_ci_le, 1, <=)
+define_compare_primitive(string_ci_ge, 1, >=)
+
+static scm_object *prim_substring(int n, scm_object **args) {
+    scm_object *s = args[0];
+    long start, end;
+
+    scm_range_args("substring", n, 2, args, s, "string", scm_string_length(s), &start, &end);
+    return scm_substring(s, start, end);
+}
+
+/* joined pairwise as a balanced rope, each join in O(log n) */
+static scm_object *prim_string_append(int n, scm_object **args) {
+    scm_object *r = empty_string;
+    int shared = 0;
+
+    for (int i = 0; i < n; ++i) {
+        if (scm_string_length(args[i]) == 0)
+            continue;
+        shared = r == empty_string;
+        r = shared ? args[i] : scm_string_append(r, args[i]);
+    }
+    /* a fresh string even if all but one argument are empty */
+    return shared ? scm_string_copy(r) : r;
+}
+
+static scm_object *prim_string_to_list(int n, scm_object **args) {
+    scm_object *str = args[0], *head = scm_null, *tail = NULL, *p;
+    scm_string *s = (scm_string *)str;
+    long start, end;
+    const char *buf;
+    long off;
+    int c;
+
+    scm_range_args("string->list", n, 2, args, str, "string", scm_string_length(str), &start, &end);
+    if (start == end)
+        return scm_null;
+    buf = scm_string_get_str(str);
+    off = byte_offset(s, start);
+    for (long i = start; i < end; ++i) {
+        off += scm_utf8_decode(buf + off, &c);
+        p = scm_cons(scm_char_new(c), scm_null);
+        if (tail)
+            scm_set_cdr(tail, p);
+        else
+            head = p;
+        tail = p;
+    }
+    return head;
+}
+
+static scm_object *prim_list_to_string(int n, scm_object **args) {
+    scm_object *l = args[0], *p, **chars, *r;
+    long len = scm_list_length(l), i = 0;
+    (void)n;
+
+    if (len < 0)
+        scm_contract_violation("list->string", 1, "(listof char?)", l);
+    for (p = l; p != scm_null; p = scm_cdr(p)) {
+        if (scm_car(p)->type != scm_type_char)
+            scm_contract_violation("list->string", 1, "(listof char?)", l);
+    }
+    chars = malloc((len ? len : 1) * sizeof(scm_object *));
+    for (p = l; p != scm_null; p = scm_cdr(p))
+        chars[i++] = scm_car(p);
+    r = chars_to_string(len, chars);
+    free(chars);
+    return r;
+}
+
+static scm_object *prim_string_copy(int n, scm_object **args) {
+    scm_object *s = args[0];
+    long start, end;
+
+    scm_range_args("string-copy", n, 2, args, s, "string", scm_string_length(s), &start, &end);
+    return scm_substring(s, start, end);
+}
+
+/* (string-split string [char])
+ * the fields between each of the delimiters, or the runs of characters
+ * other than ASCII whitespace if there is no delimiter
+ * the fields are slices of the string, found by bytes: in UTF-8 the
+ * encoding of a character only matches at a character */
+static scm_object *prim_string_split(int n, scm_object **args) {
+    scm_object *str = args[0], *head = scm_null, *tail = NULL, *p;
+    scm_string *s = (scm_string *)str;
+    long size = s->size, start = 0, end;
+    const char *buf, *q;
+    char delim[SCM_UTF8_MAX];
+    int k = 0;
+
+    if (n > 1) {
+        if (args[1]->type != scm_type_char)
+            scm_contract_violation("string-split", 2, "char?", args[1]);
+        k = scm_utf8_encode(scm_char_get_codepoint(args[1]), delim);
+    }
+    buf = scm_string_get_str(str);
+    while (start <= size) {
+        if (n > 1) {
+            for (q = buf + start; (q = memchr(q, delim[0], buf + size - q)); ++q) {
+                if (buf + size - q >= k && !memcmp(q, delim, k))
+                    break;
+            }
+            end = q ? q - buf : size;
+        } else {
+            while (start < size && isspace((unsigned char)buf[start]))
+                ++start;
+            if (start == size)
+                break;
+            for (end = start; end < size && !isspace((unsigned char)buf[end]); ++end)
+                ;
+        }
+        p = scm_cons(byte_slice(s, start, end), scm_null);
+        if (tail)
+            scm_set_cdr(tail, p);
+        else
+            head = p;
+        tail = p;
+        start = end + (k ? k : 1);
+    }
+    return head;
+}
+
+static scm_object *prim_string_fill(int n, scm_object **args) {
+    scm_string *s = (scm_string *)args[0];
+    int c = scm_char_get_codepoint(args[1]);
+    long size;
+    (void)n;
+
+    if (s->len == 0)
+        return scm_void;
+    if (is_ascii(s) && c < 0x80) {
+        memset(string_own_buf(s), c, s->len);
+    } else {
+        char *buf = repeat_char(c, s->len, &size);
+        string_replace_buf(s, buf, size);
+    }
+    return scm_void;
 }
 
-static scm_object_methods string_methods = { string_free, same_object, string_equal };
+static scm_object_methods string_methods = { string_free, same_object, string_equal, NULL, string_equal_hash };
 
 static int initialized = 0;
 int scm_string_init(void) {
     if (initialized) return 0;
 
-    empty_string = string_alloc(NULL, 0);
+    empty_string = string_alloc(NULL, 0, 0);
 
     scm_object_register(scm_type_string, &string_methods);
 
@@ -125,7 +752,28 @@ int scm_string_init(void) {
 
 int scm_string_init_env(scm_object *env) {
     scm_env_add_prim(env, "string-length", prim_string_length, 1, 1, pred_string);
-    scm_env_add_prim(env, "string-ref", prim_string_ref, 2, 2, scm_list(2, pred_string, pred_integer));
+    scm_env_add_prim(env, "string-ref", prim_string_ref, 2, 2, scm_list(2, pred_string, pred_exact_integer));
+    scm_env_add_prim(env, "make-string", prim_make_string, 1, 2, scm_list(1, pred_exact_integer));
+    scm_env_add_prim(env, "string", prim_string, 0, -1, pred_char);
+    scm_env_add_prim(env, "string-set!", prim_string_set, 3, 3,
+                     scm_list(3, pred_string, pred_exact_integer, pred_char));
+    scm_env_add_prim(env, "string=?", prim_string_eq, 1, -1, pred_string);
+    scm_env_add_prim(env, "string<?", prim_string_lt, 1, -1, pred_string);
+    scm_env_add_prim(env, "string>?", prim_string_gt, 1, -1, pred_string);
+    scm_env_add_prim(env, "string<=?", prim_string_le, 1, -1, pred_string);
+    scm_env_add_prim(env, "string>=?", prim_string_ge, 1, -1, pred_string);
+    scm_env_add_prim(env, "string-ci=?", prim_string_ci_eq, 1, -1, pred_string);
+    scm_env_add_prim(env, "string-ci<?", prim_string_ci_lt, 1, -1, pred_string);
+    scm_env_add_prim(env, "string-ci>?", prim_string_ci_gt, 1, -1, pred_string);
+    scm_env_add_prim(env, "string-ci<=?", prim_string_ci_le, 1, -1, pred_string);
+    scm_env_add_prim(env, "string-ci>=?", prim_string_ci_ge, 1, -1, pred_string);
+    scm_env_add_prim(env, "substring", prim_substring, 2, 3, scm_list(2, pred_string, pred_exact_integer));
+    scm_env_add_prim(env, "string-append", prim_string_append, 0, -1, pred_string);
+    scm_env_add_prim(env, "string->list", prim_string_to_list, 1, 3, scm_list(1, pred_string));
+    scm_env_add_prim(env, "list->string", prim_list_to_string, 1, 1, NULL);
+    scm_env_add_prim(env, "string-copy", prim_string_copy, 1, 3, scm_list(1, pred_string));
+    scm_env_add_prim(env, "string-split", prim_string_split, 1, 2, scm_list(1, pred_string));
+    scm_env_add_prim(env, "string-fill!", prim_string_fill, 2, 2, scm_list(2, pred_string, pred_char));
 
     return 0;
 }
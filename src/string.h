@@ -2,11 +2,31 @@
 #define SCHEME_STRING_H
 #include "object.h"
 
+/* strings of characters in UTF-8, made of @size bytes */
 scm_object *scm_string_new(char *str, long size);
-scm_object *scm_string_copy_new(const char *buf, long len);
+scm_object *scm_string_copy_new(const char *buf, long size);
+/* in characters */
 long  scm_string_length(scm_object *str);
+/* in bytes */
+long scm_string_size(scm_object *str);
 scm_object *scm_string_ref(scm_object *str, long k);
-char scm_string_get_char(scm_object *obj, long k);
+/* the code point of the character @k */
+int scm_string_get_char(scm_object *obj, long k);
+/* the raw bytes, scm_string_size of them */
+const char *scm_string_get_str(scm_object *obj);
+/* the raw bytes as scm_string_get_str, which stay as they are for good:
+ * the string copies them before it is changed */
+const char *scm_string_share_str(scm_object *obj);
+scm_object *scm_string_set(scm_object *obj, long k, int c);
+/* negative, zero or positive as @s1 sorts before, with or after @s2 */
+int scm_string_compare(scm_object *s1, scm_object *s2);
+
+/* strings are concatenated and cut as balanced ropes in O(log n) steps,
+ * sharing the characters, and flattened only when they are looked at
+ * substrings of flat strings are slices of their buffers */
+scm_object *scm_string_append(scm_object *s1, scm_object *s2);
+scm_object *scm_substring(scm_object *obj, long start, long end);
+scm_object *scm_string_copy(scm_object *obj);
 
 int scm_string_init(void);
 int scm_string_init_env(scm_object *env);
@@ -117,8 +117,17 @@ static int esymbol_eqv(scm_object *o1, scm_object *o2) {
     return o1 == o2 || (symbol_eqv(o1, o2) && s1->uid == s2->uid);
 }
 
-static scm_object_methods symbol_methods = { symbol_free, symbol_eqv, symbol_eqv };
-static scm_object_methods esymbol_methods = { esymbol_free, esymbol_eqv, esymbol_eqv };
+static size_t symbol_hash(scm_object *obj) {
+    scm_symbol *s = (scm_symbol *)obj;
+    return scm_hash_bytes(s->buf, s->len);
+}
+
+static size_t esymbol_hash(scm_object *obj) {
+    return scm_hash_mix(scm_esymbol_get_uid(obj));
+}
+
+static scm_object_methods symbol_methods = { symbol_free, symbol_eqv, symbol_eqv, symbol_hash, NULL };
+static scm_object_methods esymbol_methods = { esymbol_free, esymbol_eqv, esymbol_eqv, esymbol_hash, NULL };
 
 static int initialized = 0;
 int scm_symbol_init(void) {
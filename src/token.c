@@ -5,10 +5,15 @@
 #include "string.h"
 #include "symbol.h"
 #include "number.h"
+#include "bignum.h"
+#include "rational.h"
 
 #include <string.h>
 #include <ctype.h> /* isspace */
 #include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>  /* INFINITY, NAN */
 
 struct scm_token_st {
     short type;
@@ -174,7 +179,20 @@ static const char *identifier_error_fmt = "lexer: bad identifier `%s`";
 static const char *string_error_fmt = "lexer: bad string `%s`";
 static const char *number_error_prefix = "lexer: bad number";
 
-scm_token *read_char(scm_object *port) {
+/* the value of hex digits of a Unicode scalar value, or -1 */
+static int hex_scalar_value(const char *str) {
+    long c = 0;
+    int i;
+
+    for (i = 0; str[i]; ++i) {
+        if (!is_hex_digit(str[i]) || i == 6)
+            return -1;
+        c = c * 16 + (isdigit(str[i]) ? str[i] - '0' : tolower(str[i]) - 'a' + 10);
+    }
+    return i && scm_char_is_valid(c) ? (int)c : -1;
+}
+
+static scm_token *read_char(scm_object *port) {
     scm_token *tok = NULL;
     int c;
     int i = 0;
@@ -201,9 +219,16 @@ scm_token *read_char(scm_object *port) {
     }
 
     str[i] = '\0';
-    if (i == 1) {
+    if (i == 1 && (unsigned char)str[0] < 0x80) {
         tok = scm_token_chars[(int)str[0]];
     }
+    else if (scm_utf8_validate(str, i) == 1) {
+        scm_utf8_decode(str, &c);
+        tok = scm_token_new(scm_token_type_char, scm_char_new(c));
+    }
+    else if (str[0] == 'x' && (c = hex_scalar_value(str + 1)) >= 0) {
+        tok = c < 0x80 ? scm_token_chars[c] : scm_token_new(scm_token_type_char, scm_char_new(c));
+    }
     else if (i == 5 || i == 7) {
         if (!strcmp(str, "space")) {
             tok = scm_token_chars[' '];
@@ -316,34 +341,138 @@ err:
     return NULL;
 }
 
-static void number_error(char *buf, char *num, int len, char *msg) {
-    if (len) num[len] = '\0';
-    scm_error_free(free, num, "%s `%s%s`;\n%s",
-                   number_error_prefix, buf, num ? num : "", msg);
+/* the text of a number is only needed for error messages and for the rare
+ * slow paths, it's kept in an inline buffer which spills to the heap only
+ * for very long literals */
+#define NUM_INLINE_SIZE 64
+
+typedef struct num_text_st {
+    char *p;
+    int len;
+    int size;
+    char inl[NUM_INLINE_SIZE];
+} num_text;
+
+static void num_text_add(num_text *t, char c) {
+    if (t->len + 1 == t->size) {
+        t->size *= 2;
+        if (t->p == t->inl) {
+            t->p = malloc(t->size);
+            memcpy(t->p, t->inl, t->len);
+        }
+        else {
+            t->p = realloc(t->p, t->size);
+        }
+    }
+    t->p[t->len++] = c;
+    t->p[t->len] = '\0';
+}
+
+static void num_text_free(void *p) {
+    num_text *t = p;
+    if (t->p != t->inl)
+        free(t->p);
+}
+
+static void number_error(char *buf, num_text *num, char *msg) {
+    scm_error_free(num_text_free, num, "%s `%s%s`;\n%s",
+                   number_error_prefix, buf, num->p, msg);
+}
+
+static void number_error_char(char *buf, num_text *num, char *msg, char c) {
+    scm_error_free(num_text_free, num, "%s `%s%s`;\n%s `%c`",
+                   number_error_prefix, buf, num->p, msg, c);
+}
+
+static int digit_value(int c) {
+    if (c <= '9')
+        return c - '0';
+    return (c | 0x20) - 'a' + 10;
 }
 
-static void number_error_char(char *buf, char *num, int len, char *msg, char c) {
-    if (len) num[len] = '\0';
-    scm_error_free(free, num, "%s `%s%s`;\n%s `%c`",
-                   number_error_prefix, buf, num ? num : "", msg, c);
+/* the integer of the digits text[0..len), whose value is @val unless it
+ * overflowed */
+static scm_object *exact_integer(const char *text, int len, unsigned long val,
+                                 int overflow, int neg, int radix) {
+    /* LONG_MIN has no positive counterpart */
+    if (!overflow && val <= (unsigned long)LONG_MAX + neg)
+        return INTEGER(neg ? (long)(0UL - val) : (long)val);
+    return scm_bignum_from_string(text, len, radix);
 }
 
-/* TODO: support complex, rational */
+/* the exact value of the decimal text in @num, e.g. 5/4 of #e1.25 */
+static scm_object *exact_decimal(num_text *num) {
+    char *digits = malloc(num->len + 1);
+    const char *p;
+    long len = 0, exp10 = 0;
+    int point = 0;
+    scm_object *obj;
+
+    for (p = num->p; *p && *p != 'e'; ++p) {
+        if (*p == '.') {
+            point = 1;
+            continue;
+        }
+        digits[len++] = *p;
+        if (point)
+            --exp10;
+    }
+    if (*p == 'e')
+        exp10 += strtol(p + 1, NULL, 10);
+    obj = scm_number_exact_decimal(digits, len, exp10);
+    free(digits);
+    return obj;
+}
+
+/* +inf.0, -inf.0 and +nan.0, whose sign is already in @num */
+static scm_object *read_inf_nan(scm_object *port, char *buf, num_text *num, int neg) {
+    int c;
+    while (!is_delimiter_or_eof(c = scm_input_port_peekc(port))) {
+        scm_input_port_readc(port);
+        num_text_add(num, (char)tolower(c));
+    }
+    if (!strcmp(num->p + 1, "inf.0"))
+        return FLOAT(neg ? -INFINITY : INFINITY);
+    if (!strcmp(num->p + 1, "nan.0"))
+        return FLOAT(NAN);
+    number_error(buf, num, "bad digit");
+    return NULL;
+}
+
+/* TODO: support complex */
 /* complex = real + real i
  * real = integer/integer | float */
 
+/* the value is accumulated while lexing: the integer value in the given
+ * radix, and for decimals also the significand (at most 19 significant
+ * digits) and the exponent, which are converted into a float without
+ * going through the text */
 static scm_token *read_number(scm_object *port) {
     /* number containing point, exponent or sharp is inexact by default */
     int radix = -1, exactness = -1, is_float = 0;
-    int c, c2, i = 2, j = 0;
-    int num_size = 0;
-    char *num = NULL;
+    int c, c2, d, i = 2, j = 0;
     int has_point = 0, has_sharp = 0, has_exponent = 0, has_digit = 0;
+    int neg = 0, exp_neg = 0;
+    unsigned long ival = 0;     /* the integer value */
+    int ioverflow = 0;
+    int slash = 0;              /* where the denominator begins */
+    unsigned long num_ival = 0;
+    int num_ioverflow = 0, num_sharp = 0;
+    unsigned long mant = 0;     /* the decimal significand */
+    int ndigits = 0, truncated = 0;
+    long exp10 = 0, exp = 0;
+    double fval;
+    num_text num;
     scm_object *obj;
     scm_token *tok = NULL;
     c = scm_input_port_peekc(port);
     char buf[7] = {0};
 
+    num.p = num.inl;
+    num.len = 0;
+    num.size = NUM_INLINE_SIZE;
+    num.inl[0] = '\0';
+
     /* prefix */
     while (i > 0) {
         if (c != '#') {
@@ -358,42 +487,42 @@ static scm_token *read_number(scm_object *port) {
         switch (c2) {
         case 'i': case 'I':
             if (exactness != -1) {
-                number_error(buf, num, 0, "duplicate exactness specification");
+                number_error(buf, &num, "duplicate exactness specification");
             }
             exactness = 0;
             break;
         case 'e': case 'E':
             if (exactness != -1) {
-                number_error(buf, num, 0, "duplicate exactness specification");
+                number_error(buf, &num, "duplicate exactness specification");
             }
             exactness = 1;
             break;
         case 'b': case 'B':
             if (radix != -1) {
-                number_error(buf, num, 0, "duplicate radix specification");
+                number_error(buf, &num, "duplicate radix specification");
             }
             radix = 2;
             break;
         case 'o': case 'O':
             if (radix != -1) {
-                number_error(buf, num, 0, "duplicate radix specification");
+                number_error(buf, &num, "duplicate radix specification");
             }
             radix = 8;
             break;
         case 'd': case 'D':
             if (radix != -1) {
-                number_error(buf, num, 0, "duplicate radix specification");
+                number_error(buf, &num, "duplicate radix specification");
             }
             radix = 10;
             break;
         case 'x': case 'X':
             if (radix != -1) {
-                number_error(buf, num, 0, "duplicate radix specification");
+                number_error(buf, &num, "duplicate radix specification");
             }
             radix = 16;
             break;
         default:
-            number_error_char(buf, num, 0, "bad `#` indicator", c2);
+            number_error_char(buf, &num, "bad `#` indicator", c2);
         }
         scm_input_port_readc(port);
 
@@ -405,73 +534,113 @@ static scm_token *read_number(scm_object *port) {
         radix = 10;
     }
 
-    i = 0;
-    j = i;  /* save the beginning index */
     while (1) {
+        /* d, e and f are digits in hexadecimal */
         if (is_delimiter_or_eof(c) ||
-            is_exponent_marker(c)) {
+            (radix == 10 && is_exponent_marker(c))) {
             break;
         }
 
         scm_input_port_readc(port);
+        num_text_add(&num, (char)c);
 
-        if (i == num_size) {
-            if (num_size == 0) {
-                num_size = 16;
-                num = malloc(num_size + 1);
-            }
-            else {
-                num_size *= 2;
-                num = realloc(num, num_size + 1);
+        /* sign must be at the beginning */
+        if (num.len == 1 && (c == '+' || c == '-')) {
+            neg = c == '-';
+            c = scm_input_port_peekc(port);
+            if (c == 'i' || c == 'I' || c == 'n' || c == 'N') {
+                obj = read_inf_nan(port, buf, &num, neg);
+                if (exactness == 1)
+                    number_error(buf, &num, "no exact representation");
+                goto done;
             }
+            continue;
         }
-
-        num[i++] = (char)c;
-
-        /* sign must be at the beginning */
-        if (i == (j+1) && (c == '+' || c == '-')) {
+        else if (c == '/') {
+            if (!has_digit || has_point || slash) {
+                number_error(buf, &num, "`/` can only appear once between two"
+                             " integers");
+            }
+            /* the numerator is done, start over for the denominator */
+            slash = num.len;
+            num_ival = ival;
+            num_ioverflow = ioverflow;
+            num_sharp = has_sharp;
+            ival = 0;
+            ioverflow = has_digit = has_sharp = 0;
+            c = scm_input_port_peekc(port);
+            continue;
         }
         else if (c == '.') {
-            if (radix != 10 || has_point) {
-                number_error(buf, num, i, "`.` can only appear in decimal radix"
+            if (radix != 10 || has_point || slash) {
+                number_error(buf, &num, "`.` can only appear in decimal radix"
                              " and at most once");
             }
             has_point = 1;
+            c = scm_input_port_peekc(port);
+            continue;
         }
         else if (c == '#') {
             if (radix != 10 || !has_digit) {
-                number_error(buf, num, i, "`#`s can only appear at the end of a"
+                number_error(buf, &num, "`#`s can only appear at the end of a"
                              " decimal number with at least one leading digit");
             }
-            num[i-1] = '0'; /* change to 0 */
+            num.p[num.len-1] = '0'; /* change to 0 */
             has_sharp = 1;
+            d = 0;
         }
         else if (is_radix_digit(c, radix)) {
             if (has_sharp) {
-                number_error(buf, num, i, "`.` can only appear in decimal radix"
+                number_error(buf, &num, "`.` can only appear in decimal radix"
                              " and at most once");
             }
             has_digit = 1;
+            d = digit_value(c);
         }
         else {
-            number_error_char(buf, num, i, "bad digit", c);
+            number_error_char(buf, &num, "bad digit", c);
+        }
+
+        if (!has_point && !ioverflow) {
+            if (ival > (ULONG_MAX - d) / radix)
+                ioverflow = 1;
+            else
+                ival = ival * radix + d;
+        }
+
+        if (radix == 10) {
+            if (ndigits < 19) {
+                if (mant || d) {
+                    mant = mant * 10 + d;
+                    ++ndigits;
+                }
+                if (has_point)
+                    --exp10;
+            }
+            else {
+                /* the digits beyond are dropped */
+                if (d)
+                    truncated = 1;
+                if (!has_point)
+                    ++exp10;
+            }
         }
 
         c = scm_input_port_peekc(port);
     }
 
     if (!has_digit) {
-        number_error(buf, num, i, "no digit");
+        number_error(buf, &num, "no digit");
     }
 
     /* suffix */
-    if (is_exponent_marker(c)) {
-        if (radix != 10) {
-            number_error(buf, num, i, "numbers containing exponents must be in "
-                         "decimal radix");
+    if (radix == 10 && is_exponent_marker(c)) {
+        if (slash) {
+            number_error(buf, &num, "`/` can only appear once between two"
+                         " integers");
         }
         has_digit = 0;
-        j = i;  /* save the beginning index */
+        j = num.len;  /* save the beginning index */
 
         while (1) {
             if (is_delimiter_or_eof(c)) {
@@ -479,38 +648,33 @@ static scm_token *read_number(scm_object *port) {
             }
             scm_input_port_readc(port);
 
-            if (i == num_size) {
-                if (num_size == 0) {
-                    num = malloc(num_size + 1);
-                }
-                else {
-                    num = realloc(num, num_size + 1);
-                }
-            }
-
-            num[i++] = (char)c;
+            num_text_add(&num, (char)c);
 
-            if (i == (j+1)) {   /* the exponent marker */
+            if (num.len == (j+1)) {   /* the exponent marker */
+                num.p[j] = 'e';
             }
             /* sign must be at the beginning */
-            else if (i == (j+2) && (c == '+' || c == '-')) {
+            else if (num.len == (j+2) && (c == '+' || c == '-')) {
+                exp_neg = c == '-';
             }
             else if (isdigit(c)) {
-               has_digit = 1;
+                has_digit = 1;
+                if (exp < 100000)
+                    exp = exp * 10 + c - '0';
             }
             else {
-                number_error_char(buf, num, i, "bad digit", c);
+                number_error_char(buf, &num, "bad digit", c);
             }
 
             c = scm_input_port_peekc(port);
         }
 
         if (!has_digit) {
-            number_error(buf, num, i, "no digit");
+            number_error(buf, &num, "no digit");
         }
         has_exponent = 1;
+        exp10 += exp_neg ? -exp : exp;
     }
-    num[i] = '\0';
 
     if (has_point || has_exponent) {
         is_float = 1;
@@ -518,7 +682,7 @@ static scm_token *read_number(scm_object *port) {
 
     /* default exactness */
     if (exactness == -1) {
-        if (is_float || has_sharp) {
+        if (is_float || has_sharp || num_sharp) {
             exactness = 0;
         }
         else {
@@ -526,26 +690,65 @@ static scm_token *read_number(scm_object *port) {
         }
     }
 
-    if (exactness && is_float) {
-        obj = scm_number_new_integer_from_float(num);
-    }
-    else if (exactness && !is_float) {
-        obj = scm_number_new_integer(num, radix);
-    }
-    else if (is_float) {
-        obj = scm_number_new_float(num);
+    obj = NULL;
+    if (slash) {
+        obj = exact_integer(num.p + slash, num.len - slash, ival, ioverflow, 0, radix);
+        if (scm_bignum_sign(obj) == 0) {
+            number_error(buf, &num, "division by zero");
+        }
+        obj = scm_rational_new(exact_integer(num.p, slash - 1, num_ival, num_ioverflow, neg, radix), obj);
+        if (!exactness)
+            obj = FLOAT(scm_rational_to_double(obj));
+    }
+    else if (!is_float && !(ioverflow && radix == 10 && !exactness)) {
+        if (ioverflow) {
+            obj = scm_bignum_from_string(num.p, num.len, radix);
+            if (!exactness) {
+                scm_object *big = obj;
+                obj = FLOAT(scm_bignum_to_double(big));
+                scm_object_free(big);
+            }
+        }
+        else if (!exactness) {
+            obj = FLOAT(neg ? -(double)ival : (double)ival);
+        }
+        else {
+            obj = exact_integer(num.p, num.len, ival, 0, neg, radix);
+        }
     }
     else {
-        obj = scm_number_new_float_from_integer(num, radix);
+        /* more than 19 significant digits, or a rounding the fast path
+         * cannot decide, need the slow path */
+        int fast = truncated ? -1 : scm_number_decimal_to_double(mant, exp10, neg, &fval);
+        if (fast < 0) {
+            errno = 0;
+            fval = strtod(num.p, NULL);
+            if (errno == ERANGE)
+                is_float = -1;
+        }
+        else if (fast) {
+            is_float = -1;
+        }
+
+        if (is_float == -1) {
+            /* out of range */
+        }
+        else if (!exactness) {
+            obj = FLOAT(fval);
+        }
+        else {
+            obj = exact_decimal(&num);
+        }
     }
 
     if (!obj) {
-        number_error(buf, num, i, "out of range");
+        number_error(buf, &num, "out of range");
     }
 
+done:
     tok = scm_token_new(scm_token_type_number, obj);
 
-    free(num);
+    num_text_free(&num);
     return tok;
 }
 
@@ -615,8 +818,6 @@ scm_token *scm_token_read(scm_object *port) {
         case '-':
             c2 = scm_input_port_peekc(port);
             if (is_delimiter_or_eof(c2)) {
-                scm_input_port_readc(port);
-
                 if (c == '+') {
                     return make_peculiar_identifier("+", 1);
                 }
@@ -3,9 +3,12 @@
 #include "number.h"
 #include "proc.h"
 #include "env.h"
+#include "pair.h"
+#include "eval.h"
 
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct scm_vector_st {
     scm_object base;
@@ -71,22 +74,17 @@ scm_object *scm_vector_new(long count, ...) {
     return (scm_object *)vec;
 }
 
-static scm_object *prim_vector(int n, scm_object *args) {
+static scm_object *prim_vector(int n, scm_object **args) {
     if (n == 0)
         return scm_empty_vector;
     scm_vector *vec = (scm_vector *)scm_vector_alloc(n);
-    int i = 0;
-    while (i < n) {
-        vec->elts[i] = scm_car(args);
-        args = scm_cdr(args);
-        i++;
-    }
+    memcpy(vec->elts, args, n * sizeof(scm_object *));
     return (scm_object *)vec;
 }
 
 void scm_vector_fill(scm_object *vector, scm_object *fill) {
     scm_vector *vec = (scm_vector *)vector;
-    int i = vec->len;
+    long i = vec->len;
 
     while (i--) {
         vec->elts[i] = fill; /* not free the old, leave it to gc to consider */
@@ -101,10 +99,10 @@ scm_object *scm_vector_new_fill(long count, scm_object *fill) {
     return vec;
 }
 
-static scm_object *scm_make_vector(long n, scm_object *k, scm_object *args) {
-    scm_object *vec = scm_vector_alloc(scm_integer_get_val(k));
+static scm_object *scm_make_vector(long n, scm_object *k, scm_object **args) {
+    scm_object *vec = scm_vector_alloc(scm_index_arg("make-vector", 1, k));
     if (n > 1)
-        scm_vector_fill(vec, scm_car(args));
+        scm_vector_fill(vec, args[0]);
 
     return vec;
 }
@@ -133,9 +131,9 @@ scm_object *scm_vector_ref(scm_object *vector, long k) {
     return vec->elts[k];
 }
 
-static scm_object *prim_vector_ref(int n, scm_object *args) {
+static scm_object *prim_vector_ref(int n, scm_object **args) {
     (void)n;
-    return scm_vector_ref(scm_car(args), scm_integer_get_val(scm_cadr(args)));
+    return scm_vector_ref(args[0], scm_integer_get_val(args[1]));
 }
 
 scm_object *scm_vector_set(scm_object *vector, long k, scm_object *obj) {
@@ -149,9 +147,13 @@ scm_object *scm_vector_set(scm_object *vector, long k, scm_object *obj) {
     return scm_void;
 }
 
-static scm_object *prim_vector_set(int n, scm_object *args) {
+static scm_object *prim_vector_set(int n, scm_object **args) {
     (void)n;
-    return scm_vector_set(scm_car(args), scm_integer_get_val(scm_cadr(args)), scm_caddr(args));
+    return scm_vector_set(args[0], scm_integer_get_val(args[1]), args[2]);
+}
+
+scm_object **scm_vector_elements(scm_object *vector) {
+    return ((scm_vector *)vector)->elts;
 }
 
 long scm_vector_length(scm_object *vector) {
@@ -159,9 +161,9 @@ long scm_vector_length(scm_object *vector) {
     return vec->len;
 }
 
-static scm_object *prim_vector_length(int n, scm_object *args) {
+static scm_object *prim_vector_length(int n, scm_object **args) {
     (void)n;
-    long len = scm_vector_length(scm_car(args));
+    long len = scm_vector_length(args[0]);
     return INTEGER(len);
 }
 
@@ -178,21 +180,145 @@ scm_object *scm_vector_insert(scm_object *vector, scm_object *obj) {
     return vec;
 }
 
-static int vector_equal(scm_object *o1, scm_object *o2) {
-    if (same_object(o1, o2))
-        return 1;
-    scm_vector *v1 = (scm_vector *)o1;
-    scm_vector *v2 = (scm_vector *)o2;
-    if (v1->len != v2->len)
-        return 0;
-    for (int i = 0; i < v1->len; ++i) {
-        if (!scm_equal(scm_vector_ref(o1, i), scm_vector_ref(o2, i)))
-            return 0;
+/* copies, conversions and maps are made in vectors allocated to their
+ * final length up front, the elements moved in bulk */
+
+scm_object *scm_vector_copy(scm_object *vector, long start, long end) {
+    scm_object *vec;
+
+    if (start == end)
+        return scm_empty_vector;
+    vec = scm_vector_alloc(end - start);
+    memcpy(((scm_vector *)vec)->elts, ((scm_vector *)vector)->elts + start,
+           (end - start) * sizeof(scm_object *));
+    return vec;
+}
+
+scm_object *scm_vector_to_list(scm_object *vector, long start, long end) {
+    scm_object **elts = ((scm_vector *)vector)->elts, *list = scm_null;
+
+    while (end > start)
+        list = scm_cons(elts[--end], list);
+    return list;
+}
+
+scm_object *scm_list_to_vector(scm_object *list) {
+    long len = scm_list_length(list);
+    scm_object **elts, *vec;
+
+    if (len < 0)
+        return NULL;
+    if (len == 0)
+        return scm_empty_vector;
+    vec = scm_vector_alloc(len);
+    elts = ((scm_vector *)vec)->elts;
+    for (long i = 0; i < len; ++i, list = scm_cdr(list))
+        elts[i] = scm_car(list);
+    return vec;
+}
+
+/* (vector-fill! vector fill [start [end]]) */
+static scm_object *prim_vector_fill(int n, scm_object **args) {
+    scm_object *vec = args[0], *fill = args[1], **elts;
+    long start, end;
+
+    scm_range_args("vector-fill!", n, 3, args, vec, "vector", scm_vector_length(vec), &start, &end);
+    elts = ((scm_vector *)vec)->elts;
+    while (start < end)
+        elts[start++] = fill;
+    return scm_void;
+}
+
+/* (vector->list vector [start [end]]) */
+static scm_object *prim_vector_to_list(int n, scm_object **args) {
+    scm_object *vec = args[0];
+    long start, end;
+
+    scm_range_args("vector->list", n, 2, args, vec, "vector", scm_vector_length(vec), &start, &end);
+    return scm_vector_to_list(vec, start, end);
+}
+
+static scm_object *prim_list_to_vector(int n, scm_object **args) {
+    scm_object *vec = scm_list_to_vector(args[0]);
+    (void)n;
+    if (!vec)
+        scm_contract_violation("list->vector", 1, "list?", args[0]);
+    return vec;
+}
+
+/* (vector-copy vector [start [end]]) */
+static scm_object *prim_vector_copy(int n, scm_object **args) {
+    scm_object *vec = args[0];
+    long start, end;
+
+    scm_range_args("vector-copy", n, 2, args, vec, "vector", scm_vector_length(vec), &start, &end);
+    return scm_vector_copy(vec, start, end);
+}
+
+/* (subvector vector start end) */
+static scm_object *prim_subvector(int n, scm_object **args) {
+    scm_object *vec = args[0];
+    long start, end;
+
+    scm_range_args("subvector", n, 2, args, vec, "vector", scm_vector_length(vec), &start, &end);
+    return scm_vector_copy(vec, start, end);
+}
+
+/* (vector-copy! to at from [start [end]]), the ranges may overlap */
+static scm_object *prim_vector_copy_to(int n, scm_object **args) {
+    scm_vector *to = (scm_vector *)args[0], *from = (scm_vector *)args[2];
+    long at = scm_index_arg("vector-copy!", 2, args[1]), start, end;
+
+    scm_range_args("vector-copy!", n, 4, args, args[2], "vector", from->len, &start, &end);
+    if (at > to->len || end - start > to->len - at)
+        scm_error_object((scm_object *)to, "vector-copy!: not enough room in the destination\n"
+                         "index: %ld\nelements: %ld\nvector: ", at, end - start);
+    if (end > start)
+        memmove(to->elts + at, from->elts + start, (end - start) * sizeof(scm_object *));
+    return scm_void;
+}
+
+static scm_object *prim_vector_append(int n, scm_object **args) {
+    scm_object *vec;
+    scm_vector *v;
+    long total = 0, off = 0;
+    int i;
+
+    for (i = 0; i < n; ++i)
+        total += scm_vector_length(args[i]);
+    if (total == 0)
+        return scm_empty_vector;
+    vec = scm_vector_alloc(total);
+    for (i = 0; i < n; ++i) {
+        v = (scm_vector *)args[i];
+        if (v->len)
+            memcpy(((scm_vector *)vec)->elts + off, v->elts, v->len * sizeof(scm_object *));
+        off += v->len;
+    }
+    return vec;
+}
+
+static scm_object *prim_vector_map(int n, scm_object **args) {
+    return scm_map("vector-map", n, args, 1, 1);
+}
+
+static scm_object *prim_vector_for_each(int n, scm_object **args) {
+    return scm_map("vector-for-each", n, args, 1, 0);
+}
+
+static size_t vector_equal_hash(scm_object *obj, int *budget) {
+    scm_vector *vec = (scm_vector *)obj;
+    size_t h = scm_hash_mix(vec->len);
+
+    for (long i = 0; i < vec->len && *budget > 0; ++i) {
+        --*budget;
+        h = scm_hash_combine(h, scm_equal_hash_bounded(vec->elts[i], budget));
     }
-    return 1;
+    return h;
 }
 
-static scm_object_methods vector_methods = { vector_free, same_object, vector_equal };
+/* equal? of pairs and vectors is walked by scm_equal */
+static scm_object_methods vector_methods = { vector_free, same_object, NULL, NULL, vector_equal_hash };
 
 static int initialized = 0;
 
@@ -209,10 +335,20 @@ int scm_vector_init(void) {
 
 int scm_vector_init_env(scm_object *env) {
     scm_env_add_prim(env, "vector", prim_vector, 0, -1, NULL);
-    scm_env_add_prim(env, "make-vector", prim_make_vector, 1, 2, scm_list(1, pred_integer));
-    scm_env_add_prim(env, "vector-ref", prim_vector_ref, 2, 2, scm_list(2, pred_vector, pred_integer));
-    scm_env_add_prim(env, "vector-set!", prim_vector_set, 3, 3, scm_list(2, pred_vector, pred_integer));
+    scm_env_add_prim(env, "make-vector", prim_make_vector, 1, 2, scm_list(1, pred_exact_integer));
+    scm_env_add_prim(env, "vector-ref", prim_vector_ref, 2, 2, scm_list(2, pred_vector, pred_exact_integer));
+    scm_env_add_prim(env, "vector-set!", prim_vector_set, 3, 3, scm_list(2, pred_vector, pred_exact_integer));
     scm_env_add_prim(env, "vector-length", prim_vector_length, 1, 1, pred_vector);
+    scm_env_add_prim(env, "vector-fill!", prim_vector_fill, 2, 4, scm_list(1, pred_vector));
+    scm_env_add_prim(env, "vector->list", prim_vector_to_list, 1, 3, scm_list(1, pred_vector));
+    scm_env_add_prim(env, "list->vector", prim_list_to_vector, 1, 1, NULL);
+    scm_env_add_prim(env, "vector-copy", prim_vector_copy, 1, 3, scm_list(1, pred_vector));
+    scm_env_add_prim(env, "subvector", prim_subvector, 3, 3, scm_list(1, pred_vector));
+    scm_env_add_prim(env, "vector-copy!", prim_vector_copy_to, 3, 5,
+                     scm_list(3, pred_vector, pred_exact_integer, pred_vector));
+    scm_env_add_prim(env, "vector-append", prim_vector_append, 0, -1, pred_vector);
+    scm_env_add_prim(env, "vector-map", prim_vector_map, 2, -1, scm_list(1, pred_procedure));
+    scm_env_add_prim(env, "vector-for-each", prim_vector_for_each, 2, -1, scm_list(1, pred_procedure));
 
     return 0;
 }
@@ -12,7 +12,14 @@ scm_object *scm_vector_new_fill(long count, scm_object *fill);
 scm_object *scm_vector_ref(scm_object *vector, long k);
 scm_object *scm_vector_set(scm_object *vector, long k, scm_object *obj);
 long scm_vector_length(scm_object *vector);
+/* for loops which keep within the length themselves */
+scm_object **scm_vector_elements(scm_object *vector);
 scm_object *scm_vector_insert(scm_object *vector, scm_object *obj);
+/* a new vector of the elements [start, end) */
+scm_object *scm_vector_copy(scm_object *vector, long start, long end);
+scm_object *scm_vector_to_list(scm_object *vector, long start, long end);
+/* NULL if @list is not a proper list */
+scm_object *scm_list_to_vector(scm_object *list);
 
 #define FOREACH_VECTOR(i, n, v) \
     for (long i = 0, n = scm_vector_length(v); i < n; ++i)
@@ -7,17 +7,35 @@
 #include "symbol.h"
 #include "pair.h"
 #include "vector.h"
+#include "bytevector.h"
+#include "numvector.h"
+#include "record.h"
 #include "proc.h"
+#include "env.h"
+#include "err.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 static int write_raw_string(scm_object *port, const char *str) {
-    int i = 0;
-    char c;
-    while((c = str[i])) {
-        if (!scm_output_port_writec(port, c)) /* write failed */
-            break;
-        i++;
+    return scm_output_port_write(port, str, strlen(str));
+}
+
+static int write_number(scm_object *port, scm_object *obj) {
+    char buf[SCM_NUMBER_BUF_SIZE], *str;
+    int len;
+
+    if (obj->type == scm_type_bignum || obj->type == scm_type_rational) {
+        str = scm_number_to_string(obj, 10);
+        len = scm_output_port_write(port, str, strlen(str));
+        free(str);
+        return len;
     }
-    return i;
+    len = scm_number_format(obj, 10, buf);
+    return scm_output_port_write(port, buf, len);
 }
 
 static int write_char(scm_object *port, scm_object *obj) {
@@ -30,68 +48,61 @@ static int write_char(scm_object *port, scm_object *obj) {
         i += write_raw_string(port, "newline");
     }
     else {
-        i += scm_output_port_writec(port, scm_char_get_char(obj));
+        char buf[SCM_UTF8_MAX];
+        i += scm_output_port_write(port, buf, scm_utf8_encode(scm_char_get_codepoint(obj), buf));
     }
     return i;
 }
 
-static int write_string(scm_object *port, scm_object *obj) {
-    int i = 0, j = 0;
-    char c;
-    i += scm_output_port_writec(port, '"');
+static int write_bytevector(scm_object *port, scm_object *obj) {
+    char buf[SCM_NUMBER_BUF_SIZE];
+    const uint8_t *p = scm_bytevector_data(obj);
+    long size = scm_bytevector_size(obj);
+    int i = write_raw_string(port, "#u8(");
 
-    int len = scm_string_length(obj);
-    while (j < len) {
-        c = scm_string_get_char(obj, j);
-        if (c == '\\')
-            i += write_raw_string(port, "\\\\");
-        else if (c == '"')
-            i += write_raw_string(port, "\\\"");
-        else
-            i += scm_output_port_writec(port, c);
-
-        j++;
+    for (long k = 0; k < size; ++k) {
+        if (k)
+            i += scm_output_port_writec(port, ' ');
+        i += scm_output_port_write(port, buf, snprintf(buf, sizeof(buf), "%d", p[k]));
     }
-    i += scm_output_port_writec(port, '"');
-
+    i += scm_output_port_writec(port, ')');
     return i;
 }
 
-static int write_pair(scm_object *port, scm_object *obj) {
-    int i = 0;
-    i += scm_output_port_writec(port, '(');
+/* #s64(...) or #f64(...) */
+static int write_numvector(scm_object *port, scm_object *obj) {
+    long len = scm_numvector_length(obj);
+    int i = write_raw_string(port, scm_numvector_kind(obj) == SCM_S64VECTOR ? "#s64(" : "#f64(");
 
-    while (obj->type == scm_type_pair) {
-        i += scm_write(port, scm_car(obj));
-        obj = scm_cdr(obj);
-        if (obj != scm_null) {
+    for (long k = 0; k < len; ++k) {
+        if (k)
             i += scm_output_port_writec(port, ' ');
-        }
+        i += write_number(port, scm_numvector_ref(obj, k));
     }
-
-    if (obj != scm_null) {
-        i += write_raw_string(port, ". ");
-        i += scm_write(port, obj);
-    }
-
     i += scm_output_port_writec(port, ')');
     return i;
 }
 
-static int write_vector(scm_object *port, scm_object *obj) {
-    int i = 0, j = 0;
-    i += write_raw_string(port, "#(");
-    int n = scm_vector_length(obj);
+static int write_string(scm_object *port, scm_object *obj) {
+    int i = 0, j = 0, start = 0;
+    char c;
+    i += scm_output_port_writec(port, '"');
 
-    while (j < n) {
-        i += scm_write(port, scm_vector_ref(obj, j));
-        ++j;
-        if (j != n) {
-            i += scm_output_port_writec(port, ' ');
+    /* write the runs between escaped characters in bulk */
+    const char *str = scm_string_get_str(obj);
+    int len = scm_string_size(obj);
+    while (j < len) {
+        c = str[j];
+        if (c == '\\' || c == '"') {
+            i += scm_output_port_write(port, str + start, j - start);
+            i += write_raw_string(port, c == '"' ? "\\\"" : "\\\\");
+            start = j + 1;
         }
+        j++;
     }
+    i += scm_output_port_write(port, str + start, j - start);
+    i += scm_output_port_writec(port, '"');
 
-    i += scm_output_port_writec(port, ')');
     return i;
 }
 
@@ -107,8 +118,8 @@ static int write_procedure(scm_object *port, scm_object *obj) {
     return i;
 }
 
-/* return the number of bytes written */
-int scm_write(scm_object *port, scm_object *obj) {
+/* objects without components */
+static int write_atom(scm_object *port, scm_object *obj) {
     int i = 0;
     switch (obj->type) {
     case scm_type_eof:
@@ -130,8 +141,10 @@ int scm_write(scm_object *port, scm_object *obj) {
         i = write_char(port, obj);
         break;
     case scm_type_integer:
+    case scm_type_bignum:
+    case scm_type_rational:
     case scm_type_float:
-        i = write_raw_string(port, scm_number_to_string(obj, 10));
+        i = write_number(port, obj);
         break;
     case scm_type_string:
         i = write_string(port, obj);
@@ -142,11 +155,33 @@ int scm_write(scm_object *port, scm_object *obj) {
     case scm_type_eidentifier:
         i = write_raw_string(port, scm_esymbol_get_string(obj));
         break;
-    case scm_type_pair:
-        i = write_pair(port, obj);
+    case scm_type_vector:   /* the empty one */
+        i = write_raw_string(port, "#()");
+        break;
+    case scm_type_bytevector:
+        i = write_bytevector(port, obj);
         break;
-    case scm_type_vector:
-        i = write_vector(port, obj);
+    case scm_type_numvector:
+        i = write_numvector(port, obj);
+        break;
+    case scm_type_record_type:
+        i = write_raw_string(port, "#<record-type ");
+        i += write_raw_string(port, scm_record_type_name(obj));
+        i += scm_output_port_writec(port, '>');
+        break;
+    case scm_type_record:
+        i = write_raw_string(port, "#<record ");
+        i += write_raw_string(port, scm_record_type_name(scm_record_type(obj)));
+        i += scm_output_port_writec(port, '>');
+        break;
+    case scm_type_pmap:
+        i = write_raw_string(port, "#<pmap>");
+        break;
+    case scm_type_pvector:
+        i = write_raw_string(port, "#<pvector>");
+        break;
+    case scm_type_hashtable:
+        i = write_raw_string(port, "#<hash-table>");
         break;
     case scm_type_input_port:
         i = write_raw_string(port, "#<input-port>");
@@ -170,3 +205,691 @@ int scm_write(scm_object *port, scm_object *obj) {
     }
     return i;
 }
+
+/* objects which may be shared or be part of a cycle */
+static int is_compound(scm_object *obj) {
+    return obj->type == scm_type_pair ||
+           (obj->type == scm_type_vector && obj != scm_empty_vector);
+}
+
+/* pointer table for the datum label pre-pass */
+#define LABEL_ON_PATH   1   /* being scanned, seeing it again means a cycle */
+#define LABEL_NEEDED    2
+
+typedef struct label_entry_st {
+    scm_object *obj;
+    int flags;
+    long label;     /* -1 until the object is written */
+} label_entry;
+
+typedef struct label_table_st {
+    label_entry *entries;
+    size_t size;    /* power of 2 */
+    size_t count;
+    size_t needed;
+    long next_label;
+} label_table;
+
+static size_t label_hash(scm_object *obj) {
+    uint64_t x = (uintptr_t)obj;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static label_entry *label_slot(label_entry *entries, size_t size, scm_object *obj) {
+    size_t i = label_hash(obj) & (size - 1);
+    while (entries[i].obj && entries[i].obj != obj)
+        i = (i + 1) & (size - 1);
+    return entries + i;
+}
+
+static label_entry *label_lookup(label_table *t, scm_object *obj) {
+    label_entry *e = label_slot(t->entries, t->size, obj);
+    return e->obj ? e : NULL;
+}
+
+/* return NULL if @obj is already in the table */
+static label_entry *label_insert(label_table *t, scm_object *obj) {
+    if ((t->count + 1) * 2 > t->size) {
+        size_t size = t->size * 2;
+        label_entry *entries = calloc(size, sizeof(label_entry));
+        for (size_t i = 0; i < t->size; ++i) {
+            if (t->entries[i].obj)
+                *label_slot(entries, size, t->entries[i].obj) = t->entries[i];
+        }
+        free(t->entries);
+        t->entries = entries;
+        t->size = size;
+    }
+
+    label_entry *e = label_slot(t->entries, t->size, obj);
+    if (e->obj)
+        return NULL;
+    e->obj = obj;
+    e->flags = 0;
+    e->label = -1;
+    t->count++;
+    return e;
+}
+
+static int is_labeled(label_table *t, scm_object *obj) {
+    label_entry *e;
+    return t && (e = label_lookup(t, obj)) && (e->flags & LABEL_NEEDED);
+}
+
+/* explicit stack, so deep nesting doesn't recurse in C */
+enum {
+    frame_scan,         /* pre-pass an object */
+    frame_scan_vector,  /* pre-pass the elements from idx on */
+    frame_leave,        /* leave the components of a pair */
+    frame_write,        /* write an object */
+    frame_write_rest,   /* write the rest of a list after an element */
+    frame_write_vector, /* write the elements from idx on */
+    frame_close,
+};
+
+typedef struct write_frame_st {
+    int kind;
+    scm_object *obj;
+    long idx;
+} write_frame;
+
+typedef struct write_stack_st {
+    write_frame *frames;
+    size_t size;
+    size_t top;
+} write_stack;
+
+static void stack_push(write_stack *s, int kind, scm_object *obj, long idx) {
+    if (s->top == s->size) {
+        s->size = s->size ? s->size * 2 : 64;
+        s->frames = realloc(s->frames, s->size * sizeof(write_frame));
+    }
+    s->frames[s->top].kind = kind;
+    s->frames[s->top].obj = obj;
+    s->frames[s->top].idx = idx;
+    s->top++;
+}
+
+/* find the objects needing a label: all the objects met more than once when
+ * @shared, otherwise only those met again while their components are being
+ * scanned, that's to say the ones forming cycles */
+static void scan_labels(label_table *t, write_stack *s, scm_object *obj, int shared) {
+    label_entry *e;
+
+    stack_push(s, frame_scan, obj, 0);
+    while (s->top) {
+        write_frame f = s->frames[--s->top];
+        obj = f.obj;
+
+        switch (f.kind) {
+        case frame_leave:
+            label_lookup(t, obj)->flags &= ~LABEL_ON_PATH;
+            break;
+        case frame_scan_vector:
+            if (f.idx == scm_vector_length(obj)) {
+                label_lookup(t, obj)->flags &= ~LABEL_ON_PATH;
+            }
+            else {
+                stack_push(s, frame_scan_vector, obj, f.idx + 1);
+                stack_push(s, frame_scan, scm_vector_ref(obj, f.idx), 0);
+            }
+            break;
+        default:
+            if (!is_compound(obj))
+                break;
+            if ((e = label_insert(t, obj)) == NULL) {
+                e = label_lookup(t, obj);
+                if ((shared || (e->flags & LABEL_ON_PATH)) && !(e->flags & LABEL_NEEDED)) {
+                    e->flags |= LABEL_NEEDED;
+                    t->needed++;
+                }
+                break;
+            }
+            e->flags = shared ? 0 : LABEL_ON_PATH;
+
+            if (obj->type == scm_type_pair) {
+                if (!shared)
+                    stack_push(s, frame_leave, obj, 0);
+                stack_push(s, frame_scan, scm_cdr(obj), 0);
+                stack_push(s, frame_scan, scm_car(obj), 0);
+            }
+            else {
+                stack_push(s, frame_scan_vector, obj, 0);
+            }
+            break;
+        }
+    }
+}
+
+static int write_label(scm_object *port, long label, char suffix) {
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "#%ld%c", label, suffix);
+    return scm_output_port_write(port, buf, len);
+}
+
+/* @t is NULL when no label is needed */
+static int write_object(scm_object *port, scm_object *obj, label_table *t, write_stack *s) {
+    int i = 0;
+    label_entry *e;
+
+    stack_push(s, frame_write, obj, 0);
+    while (s->top) {
+        write_frame f = s->frames[--s->top];
+        obj = f.obj;
+
+        switch (f.kind) {
+        case frame_write_rest:
+            if (obj == scm_null) {
+                i += scm_output_port_writec(port, ')');
+            }
+            else if (obj->type == scm_type_pair && !is_labeled(t, obj)) {
+                i += scm_output_port_writec(port, ' ');
+                stack_push(s, frame_write_rest, scm_cdr(obj), 0);
+                stack_push(s, frame_write, scm_car(obj), 0);
+            }
+            else {
+                i += write_raw_string(port, " . ");
+                stack_push(s, frame_close, NULL, 0);
+                stack_push(s, frame_write, obj, 0);
+            }
+            break;
+        case frame_write_vector:
+            if (f.idx == scm_vector_length(obj)) {
+                i += scm_output_port_writec(port, ')');
+            }
+            else {
+                if (f.idx)
+                    i += scm_output_port_writec(port, ' ');
+                stack_push(s, frame_write_vector, obj, f.idx + 1);
+                stack_push(s, frame_write, scm_vector_ref(obj, f.idx), 0);
+            }
+            break;
+        case frame_close:
+            i += scm_output_port_writec(port, ')');
+            break;
+        default:
+            if (t && is_compound(obj) && (e = label_lookup(t, obj)) &&
+                (e->flags & LABEL_NEEDED)) {
+                if (e->label >= 0) {
+                    i += write_label(port, e->label, '#');
+                    break;
+                }
+                e->label = t->next_label++;
+                i += write_label(port, e->label, '=');
+            }
+
+            if (obj->type == scm_type_pair) {
+                i += scm_output_port_writec(port, '(');
+                stack_push(s, frame_write_rest, scm_cdr(obj), 0);
+                stack_push(s, frame_write, scm_car(obj), 0);
+            }
+            else if (obj->type == scm_type_vector) {
+                i += write_raw_string(port, "#(");
+                stack_push(s, frame_write_vector, obj, 0);
+            }
+            else {
+                i += write_atom(port, obj);
+            }
+            break;
+        }
+    }
+    return i;
+}
+
+static int write_with_labels(scm_object *port, scm_object *obj, int shared) {
+    write_stack s = { NULL, 0, 0 };
+    label_table t = { NULL, 64, 0, 0, 0 };
+    int i;
+
+    if (!is_compound(obj))
+        return write_atom(port, obj);
+
+    t.entries = calloc(t.size, sizeof(label_entry));
+    scan_labels(&t, &s, obj, shared);
+    i = write_object(port, obj, t.needed ? &t : NULL, &s);
+
+    free(t.entries);
+    free(s.frames);
+    return i;
+}
+
+/* return the number of bytes written.
+ * scm_write labels cycles only, scm_write_shared labels every object
+ * appearing more than once, scm_write_simple labels nothing and doesn't
+ * terminate on cyclic data */
+int scm_write(scm_object *port, scm_object *obj) {
+    return write_with_labels(port, obj, 0);
+}
+
+int scm_write_shared(scm_object *port, scm_object *obj) {
+    return write_with_labels(port, obj, 1);
+}
+
+int scm_write_simple(scm_object *port, scm_object *obj) {
+    write_stack s = { NULL, 0, 0 };
+    int i;
+
+    if (!is_compound(obj))
+        return write_atom(port, obj);
+
+    i = write_object(port, obj, NULL, &s);
+    free(s.frames);
+    return i;
+}
+
+/* Oppen's pretty printer, see "Prettyprinting" (1980).
+ * the datum is turned into a stream of tokens: strings, breaks which are
+ * either a blank or a newline, and the begin/end of groups. the tokens are
+ * held in a ring buffer until the width of their group is known or exceeds
+ * what is left of the line, so the lookahead never exceeds about one line */
+#define PP_INFINITY 0x7FFFFFFFL
+
+enum {
+    pp_tok_string,
+    pp_tok_break,
+    pp_tok_begin,
+    pp_tok_end,
+};
+
+typedef struct pp_token_st {
+    int kind;
+    int consistent; /* a begin breaking all its breaks, or only when needed */
+    long offset;    /* the indentation of a begin */
+    long size;      /* the width up to the next break, or of a group */
+    char *str;      /* kept across uses of the slot */
+    long len;
+    long cap;
+} pp_token;
+
+typedef struct pp_group_st {
+    long indent;
+    int broken;
+    int consistent;
+} pp_group;
+
+typedef struct pp_printer_st {
+    scm_object *port;
+    int bytes;
+    long margin;
+    long space;     /* left on the current line */
+    pp_token *ring;
+    long ring_size;
+    long left, right;
+    long left_total, right_total;
+    long *scan;     /* deque of ring indices whose size is unknown */
+    long scan_bottom, scan_count;
+    pp_group *groups;
+    long group_count, group_size;
+} pp_printer;
+
+static void pp_newline(pp_printer *pp, long indent) {
+    static const char blanks[] = "                                ";
+    long n;
+
+    pp->bytes += scm_output_port_writec(pp->port, '\n');
+    pp->space = pp->margin - indent;
+    while (indent > 0) {
+        n = indent < (long)sizeof(blanks) - 1 ? indent : (long)sizeof(blanks) - 1;
+        pp->bytes += scm_output_port_write(pp->port, blanks, n);
+        indent -= n;
+    }
+}
+
+static void pp_print(pp_printer *pp, pp_token *t) {
+    pp_group *g;
+
+    switch (t->kind) {
+    case pp_tok_begin:
+        if (pp->group_count == pp->group_size) {
+            pp->group_size = pp->group_size ? pp->group_size * 2 : 16;
+            pp->groups = realloc(pp->groups, pp->group_size * sizeof(pp_group));
+        }
+        g = pp->groups + pp->group_count++;
+        g->broken = t->size > pp->space;
+        g->consistent = t->consistent;
+        g->indent = pp->margin - pp->space + t->offset;
+        /* keep deep nesting from making the output quadratic */
+        if (g->indent > pp->margin / 2)
+            g->indent = pp->margin / 2;
+        break;
+    case pp_tok_end:
+        pp->group_count--;
+        break;
+    case pp_tok_break:
+        g = pp->group_count ? pp->groups + pp->group_count - 1 : NULL;
+        if (g && g->broken && (g->consistent || t->size > pp->space)) {
+            pp_newline(pp, g->indent);
+        }
+        else {
+            pp->bytes += scm_output_port_writec(pp->port, ' ');
+            pp->space--;
+        }
+        break;
+    default:
+        pp->bytes += scm_output_port_write(pp->port, t->str, t->len);
+        pp->space -= t->len;
+        break;
+    }
+}
+
+static void pp_scan_push(pp_printer *pp, long x) {
+    pp->scan[(pp->scan_bottom + pp->scan_count++) % pp->ring_size] = x;
+}
+
+static long pp_scan_top(pp_printer *pp) {
+    return pp->scan[(pp->scan_bottom + pp->scan_count - 1) % pp->ring_size];
+}
+
+static long pp_scan_pop(pp_printer *pp) {
+    long x = pp_scan_top(pp);
+    pp->scan_count--;
+    return x;
+}
+
+static long pp_scan_pop_bottom(pp_printer *pp) {
+    long x = pp->scan[pp->scan_bottom];
+    pp->scan_bottom = (pp->scan_bottom + 1) % pp->ring_size;
+    pp->scan_count--;
+    return x;
+}
+
+/* print the tokens from the left whose size is known */
+static void pp_advance_left(pp_printer *pp) {
+    pp_token *t = pp->ring + pp->left;
+
+    while (t->size >= 0) {
+        pp_print(pp, t);
+        if (t->kind == pp_tok_string)
+            pp->left_total += t->len;
+        else if (t->kind == pp_tok_break)
+            pp->left_total++;
+        if (pp->left == pp->right)
+            break;
+        pp->left = (pp->left + 1) % pp->ring_size;
+        t = pp->ring + pp->left;
+    }
+}
+
+/* the pending tokens can't fit on the line anyway */
+static void pp_check_stream(pp_printer *pp) {
+    while (pp->right_total - pp->left_total > pp->space) {
+        if (pp->scan_count && pp->scan[pp->scan_bottom] == pp->left)
+            pp->ring[pp_scan_pop_bottom(pp)].size = PP_INFINITY;
+        pp_advance_left(pp);
+        if (pp->left == pp->right)
+            break;
+    }
+}
+
+/* settle the sizes of the tokens closed by a break (@k = 0) or an end */
+static void pp_check_stack(pp_printer *pp, int k) {
+    while (pp->scan_count) {
+        pp_token *t = pp->ring + pp_scan_top(pp);
+        if (t->kind == pp_tok_begin) {
+            if (k == 0)
+                break;
+            pp_scan_pop(pp);
+            t->size += pp->right_total;
+            k--;
+        }
+        else if (t->kind == pp_tok_end) {
+            pp_scan_pop(pp);
+            t->size = 1;
+            k++;
+        }
+        else {
+            pp_scan_pop(pp);
+            t->size += pp->right_total;
+            if (k == 0)
+                break;
+        }
+    }
+}
+
+static pp_token *pp_advance_right(pp_printer *pp, int kind) {
+    if (pp->scan_count == 0) {
+        pp->left_total = pp->right_total = 1;
+        pp->left = pp->right = 0;
+    }
+    else {
+        pp->right = (pp->right + 1) % pp->ring_size;
+        assert(pp->right != pp->left);
+    }
+    pp->ring[pp->right].kind = kind;
+    return pp->ring + pp->right;
+}
+
+static void pp_begin(pp_printer *pp, long offset, int consistent) {
+    pp_token *t = pp_advance_right(pp, pp_tok_begin);
+    t->offset = offset;
+    t->consistent = consistent;
+    t->size = -pp->right_total;
+    pp_scan_push(pp, pp->right);
+}
+
+static void pp_end(pp_printer *pp) {
+    if (pp->scan_count == 0) {
+        pp->group_count--;
+        return;
+    }
+    pp_token *t = pp_advance_right(pp, pp_tok_end);
+    t->size = -1;
+    pp_scan_push(pp, pp->right);
+}
+
+static void pp_break(pp_printer *pp) {
+    pp_token *t = pp_advance_right(pp, pp_tok_break);
+    pp_check_stack(pp, 0);
+    pp_scan_push(pp, pp->right);
+    t->size = -pp->right_total;
+    pp->right_total++;
+}
+
+static void pp_string(pp_printer *pp, const char *s, long len) {
+    if (pp->scan_count == 0) {
+        pp->bytes += scm_output_port_write(pp->port, s, len);
+        pp->space -= len;
+        return;
+    }
+
+    pp_token *t = pp_advance_right(pp, pp_tok_string);
+    if (t->cap < len) {
+        t->cap = len;
+        t->str = realloc(t->str, len);
+    }
+    memcpy(t->str, s, len);
+    t->len = len;
+    t->size = len;
+    pp->right_total += len;
+    pp_check_stream(pp);
+}
+
+static void pp_flush(pp_printer *pp) {
+    if (pp->scan_count) {
+        pp_check_stack(pp, 0);
+        pp_advance_left(pp);
+    }
+}
+
+/* groups with only atoms fill the lines, others put every element on a line
+ * of its own when they don't fit */
+static int list_is_flat(label_table *t, scm_object *obj) {
+    do {
+        if (is_compound(scm_car(obj)))
+            return 0;
+        obj = scm_cdr(obj);
+    } while (obj->type == scm_type_pair && !is_labeled(t, obj));
+    return !is_compound(obj);
+}
+
+static int vector_is_flat(scm_object *obj) {
+    long n = scm_vector_length(obj);
+    for (long i = 0; i < n; ++i) {
+        if (is_compound(scm_vector_ref(obj, i)))
+            return 0;
+    }
+    return 1;
+}
+
+static void pprint_atom(pp_printer *pp, scm_object *scratch, scm_object *obj) {
+    long len;
+    const char *str;
+
+    scm_output_port_string_reset(scratch);
+    write_atom(scratch, obj);
+    str = scm_output_port_string(scratch, &len);
+    pp_string(pp, str, len);
+}
+
+static void pprint_object(pp_printer *pp, scm_object *obj, label_table *t, write_stack *s) {
+    scm_object *scratch = string_output_port_open();
+    label_entry *e;
+    char label[32];
+
+    stack_push(s, frame_write, obj, 0);
+    while (s->top) {
+        write_frame f = s->frames[--s->top];
+        obj = f.obj;
+
+        switch (f.kind) {
+        case frame_write_rest:
+            if (obj == scm_null) {
+                pp_string(pp, ")", 1);
+                pp_end(pp);
+            }
+            else if (obj->type == scm_type_pair && !is_labeled(t, obj)) {
+                pp_break(pp);
+                stack_push(s, frame_write_rest, scm_cdr(obj), 0);
+                stack_push(s, frame_write, scm_car(obj), 0);
+            }
+            else {
+                pp_break(pp);
+                pp_string(pp, ". ", 2);
+                stack_push(s, frame_close, NULL, 0);
+                stack_push(s, frame_write, obj, 0);
+            }
+            break;
+        case frame_write_vector:
+            if (f.idx == scm_vector_length(obj)) {
+                pp_string(pp, ")", 1);
+                pp_end(pp);
+            }
+            else {
+                if (f.idx)
+                    pp_break(pp);
+                stack_push(s, frame_write_vector, obj, f.idx + 1);
+                stack_push(s, frame_write, scm_vector_ref(obj, f.idx), 0);
+            }
+            break;
+        case frame_close:
+            pp_string(pp, ")", 1);
+            pp_end(pp);
+            break;
+        default:
+            if (t && is_compound(obj) && (e = label_lookup(t, obj)) &&
+                (e->flags & LABEL_NEEDED)) {
+                if (e->label >= 0) {
+                    pp_string(pp, label, snprintf(label, sizeof(label), "#%ld#", e->label));
+                    break;
+                }
+                e->label = t->next_label++;
+                pp_string(pp, label, snprintf(label, sizeof(label), "#%ld=", e->label));
+            }
+
+            if (obj->type == scm_type_pair) {
+                pp_begin(pp, 1, !list_is_flat(t, obj));
+                pp_string(pp, "(", 1);
+                stack_push(s, frame_write_rest, scm_cdr(obj), 0);
+                stack_push(s, frame_write, scm_car(obj), 0);
+            }
+            else if (obj->type == scm_type_vector) {
+                pp_begin(pp, 2, !vector_is_flat(obj));
+                pp_string(pp, "#(", 2);
+                stack_push(s, frame_write_vector, obj, 0);
+            }
+            else {
+                pprint_atom(pp, scratch, obj);
+            }
+            break;
+        }
+    }
+
+    pp_flush(pp);
+    scm_object_free(scratch);
+}
+
+/* write @obj broken into lines of at most @width columns where possible,
+ * labelling cycles like scm_write. return the number of bytes written */
+int scm_pretty_print(scm_object *port, scm_object *obj, int width) {
+    write_stack s = { NULL, 0, 0 };
+    label_table t = { NULL, 64, 0, 0, 0 };
+    pp_printer pp;
+
+    memset(&pp, 0, sizeof(pp));
+    pp.port = port;
+    pp.margin = width > 0 ? width : 1;
+    pp.space = pp.margin;
+    /* every column holds at most a string and a begin or an end */
+    pp.ring_size = 3 * pp.margin + 16;
+    pp.ring = calloc(pp.ring_size, sizeof(pp_token));
+    pp.scan = malloc(pp.ring_size * sizeof(long));
+
+    if (is_compound(obj)) {
+        t.entries = calloc(t.size, sizeof(label_entry));
+        scan_labels(&t, &s, obj, 0);
+    }
+    pprint_object(&pp, obj, t.needed ? &t : NULL, &s);
+
+    for (long i = 0; i < pp.ring_size; ++i)
+        free(pp.ring[i].str);
+    free(pp.ring);
+    free(pp.scan);
+    free(pp.groups);
+    free(t.entries);
+    free(s.frames);
+    return pp.bytes;
+}
+
+static scm_object *write_port_arg(const char *name, int n, scm_object **args) {
+    if (n < 2)
+        return default_oport;
+
+    scm_object *port = args[1];
+    if (port->type != scm_type_output_port)
+        scm_contract_violation(name, 2, "output-port?", port);
+    return port;
+}
+
+static scm_object *prim_write(int n, scm_object **args) {
+    scm_write(write_port_arg("write", n, args), args[0]);
+    return scm_void;
+}
+
+static scm_object *prim_write_shared(int n, scm_object **args) {
+    scm_write_shared(write_port_arg("write-shared", n, args), args[0]);
+    return scm_void;
+}
+
+static scm_object *prim_write_simple(int n, scm_object **args) {
+    scm_write_simple(write_port_arg("write-simple", n, args), args[0]);
+    return scm_void;
+}
+
+static scm_object *prim_pretty_print(int n, scm_object **args) {
+    scm_object *port = write_port_arg("pretty-print", n, args);
+    scm_pretty_print(port, args[0], PRETTY_PRINT_WIDTH);
+    scm_newline(port);
+    return scm_void;
+}
+
+int scm_write_init_env(scm_object *env) {
+    scm_env_add_prim(env, "write", prim_write, 1, 2, NULL);
+    scm_env_add_prim(env, "write-shared", prim_write_shared, 1, 2, NULL);
+    scm_env_add_prim(env, "write-simple", prim_write_simple, 1, 2, NULL);
+    scm_env_add_prim(env, "pretty-print", prim_pretty_print, 1, 2, NULL);
+
+    return 0;
+}
@@ -3,6 +3,13 @@
 #include "object.h"
 
 int scm_write(scm_object *port, scm_object *obj);
+int scm_write_shared(scm_object *port, scm_object *obj);
+int scm_write_simple(scm_object *port, scm_object *obj);
+
+#define PRETTY_PRINT_WIDTH 79
+int scm_pretty_print(scm_object *port, scm_object *obj, int width);
+
+int scm_write_init_env(scm_object *env);
 
 #endif /* SCHEME_WRITE_H */
 
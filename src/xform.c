@@ -986,7 +986,7 @@ scm_object *transform_macro(scm_object *xformer, scm_object *form, scm_object *e
     return NULL;
 }
 
-static scm_object_methods xformer_methods = { xformer_free, same_object, same_object };
+static scm_object_methods xformer_methods = { xformer_free, same_object, same_object, NULL, NULL };
 
 static int initialized = 0;
 
@@ -99,3 +99,30 @@ TEST(err, scm_error_free) {
     REQUIRE_EQ(x, 2);   /* free_fn is called */
     REQUIRE(!scm_jmp, "restore scm_jmp to the previous value");
 }
+
+TEST(err, long_message) {
+    static char err_msg[10000];
+    char *msg = NULL;
+
+    memset(err_msg, 'e', sizeof(err_msg) - 1);
+
+    SCM_TRY {
+        scm_error_add("%s", "prefix: ");
+        scm_error("%s", err_msg);
+        REQUIRE(0, "should not reach here");
+    } SCM_CATCH {
+        msg = scm_error_msg();
+    } SCM_END_TRY;
+
+    REQUIRE_EQ(strlen(msg), strlen(err_msg) + 8);
+    REQUIRE(!strncmp(msg, "prefix: ", 8));
+    REQUIRE_STREQ(msg + 8, err_msg);
+
+    SCM_TRY {
+        scm_error("%s", "short");
+    } SCM_CATCH {
+        msg = scm_error_msg();
+    } SCM_END_TRY;
+
+    REQUIRE_STREQ(msg, "short");
+}
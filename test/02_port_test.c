@@ -145,6 +145,99 @@ TEST(port, file_output_port) {
     remove(name);
 }
 
+TEST(port, string_output_port_write) {
+    TEST_INIT();
+
+    char buf[32] = {0};
+
+    scm_object *port = string_output_port_new(buf, 8);
+    REQUIRE(port, "string_output_port_new");
+
+    REQUIRE_EQ(scm_output_port_write(port, "abc", 3), 3);
+    REQUIRE_EQ(scm_output_port_puts(port, "de"), 2);
+    REQUIRE_EQ(scm_output_port_write(port, "fghij", 5), 3);
+    REQUIRE_EQ(scm_output_port_write(port, "k", 1), 0);
+    REQUIRE_EQ(scm_output_port_flush(port), 0);
+
+    REQUIRE_STREQ(buf, "abcdefgh");
+
+    scm_object_free(port);
+}
+
+TEST(port, string_buffer_output_port) {
+    TEST_INIT();
+    long len;
+    char fixed[4];
+
+    scm_object *port = string_output_port_open();
+    REQUIRE(port, "string_output_port_open");
+
+    const char *s = scm_output_port_string(port, &len);
+    REQUIRE_EQ(len, 0);
+    REQUIRE_STREQ(s, "");
+
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE_EQ(scm_output_port_writec(port, 'a' + i % 26), 1);
+        REQUIRE_EQ(scm_output_port_write(port, "01", 2), 2);
+    }
+
+    s = scm_output_port_string(port, &len);
+    REQUIRE_EQ(len, 30000);
+    REQUIRE_EQ(strlen(s), 30000);
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE_EQ(s[i * 3], 'a' + i % 26, "i=%d", i);
+        REQUIRE(!strncmp(s + i * 3 + 1, "01", 2), "i=%d", i);
+    }
+
+    scm_object *port2 = string_output_port_new(fixed, sizeof(fixed));
+    REQUIRE(!scm_output_port_string(port2, NULL), "fixed buffer port");
+    REQUIRE(!scm_output_port_string(scm_null, NULL), "not a port");
+
+    REQUIRE(!scm_eqv(port, port2), "scm_eqv");
+    scm_object_free(port);
+    scm_object_free(port2);
+}
+
+TEST(port, file_output_port_buffering) {
+    TEST_INIT();
+    char *name = "test_file.txt";
+    char buf[32];
+    static char big[10000];
+
+    scm_object *port = file_output_port_open(name);
+    REQUIRE(port, "file_output_port_open");
+
+    FILE *fp = fopen(name, "r");
+    REQUIRE(fp);
+
+    /* nothing reaches the file before a flush */
+    REQUIRE_EQ(scm_output_port_writec(port, 'a'), 1);
+    REQUIRE_EQ(scm_output_port_write(port, "bc", 2), 2);
+    REQUIRE(!fgets(buf, sizeof(buf), fp));
+    clearerr(fp);
+
+    REQUIRE_EQ(scm_output_port_flush(port), 0);
+    REQUIRE(fgets(buf, sizeof(buf), fp));
+    REQUIRE_STREQ(buf, "abc");
+
+    /* larger than the buffer, keeps the order */
+    memset(big, 'x', sizeof(big));
+    REQUIRE_EQ(scm_output_port_writec(port, '1'), 1);
+    REQUIRE_EQ(scm_output_port_write(port, big, sizeof(big)), sizeof(big));
+    REQUIRE_EQ(scm_output_port_writec(port, '2'), 1);
+    scm_object_free(port);
+
+    clearerr(fp);
+    REQUIRE_EQ(fgetc(fp), '1');
+    for (size_t i = 0; i < sizeof(big); ++i)
+        REQUIRE_EQ(fgetc(fp), 'x', "i=%zu", i);
+    REQUIRE_EQ(fgetc(fp), '2');
+    REQUIRE_EQ(fgetc(fp), EOF);
+
+    fclose(fp);
+    remove(name);
+}
+
 TEST(port, equivalence) {
     TEST_INIT();
 
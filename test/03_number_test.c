@@ -1,4 +1,5 @@
 #include "test.h"
+#include <math.h>
 
 TAU_MAIN()
 
@@ -86,18 +87,104 @@ TEST(number, integer_max_min) {
     }
 }
 
-TEST(number, integer_out_of_range) {
-    int i;
-    scm_object *obj;
+TEST(number, integer_bignum) {
+    int i, j;
+    scm_object *obj, *obj2;
+    char *str = NULL;
     TEST_INIT();
 
-    const int n = 2;
-    char *strs[n] = {"9223372036854775808", "-9223372036854775809"};
-    int radices[n] = {10, 10};
+    const int n = 4;
+    char *strs[n] = {"9223372036854775808", "-9223372036854775809",
+                     "123456789012345678901234567890123456789", "-340282366920938463463374607431768211456"};
+    int radices[4] = {10, 16, 8, 2};
     for (i = 0; i < n; ++i) {
-        obj = scm_number_new_integer(strs[i], radices[i]);
-        REQUIRE(!obj, "scm_number_new_integer, i=%d", i);
+        obj = scm_number_new_integer(strs[i], 10);
+        REQUIRE(obj, "scm_number_new_integer, i=%d", i);
+        REQUIRE_EQ(obj->type, scm_type_bignum, "i=%d", i);
+
+        for (j = 0; j < 4; ++j) {
+            str = scm_number_to_string(obj, radices[j]);
+            obj2 = scm_number_new_integer(str, radices[j]);
+            REQUIRE(scm_eqv(obj, obj2), "i=%d,j=%d", i, j);
+            free(str);
+            scm_object_free(obj2);
+        }
+        str = scm_number_to_string(obj, 10);
+        REQUIRE_STREQ(str, strs[i], "i=%d", i);
+        free(str);
+        scm_object_free(obj);
     }
+
+    /* demoted whenever they fit */
+    obj = scm_bignum_sub(scm_number_new_integer("9223372036854775808", 10), INTEGER(1));
+    REQUIRE_EQ(obj->type, scm_type_integer);
+    REQUIRE_EQ(scm_integer_get_val(obj), LONG_MAX);
+    obj = scm_bignum_neg(scm_number_new_integer("9223372036854775808", 10));
+    REQUIRE_EQ(obj->type, scm_type_integer);
+    REQUIRE_EQ(scm_integer_get_val(obj), LONG_MIN);
+}
+
+static char *repeat(char c, int n) {
+    char *s = malloc(n + 1);
+    memset(s, c, n);
+    s[n] = '\0';
+    return s;
+}
+
+TEST(number, bignum_arithmetic) {
+    int i, k = 3000;
+    scm_object *a, *b, *q, *r;
+    char *str, *nines, *zeros, *digits;
+    TEST_INIT();
+
+    /* (10^k - 1)^2 = 10^2k - 2*10^k + 1, big enough for Karatsuba */
+    nines = repeat('9', k);
+    a = scm_number_new_integer(nines, 10);
+    str = scm_number_to_string(scm_bignum_mul(a, a), 10);
+    REQUIRE_EQ((int)strlen(str), 2 * k);
+    REQUIRE(!strncmp(str, nines, k - 1) && str[k - 1] == '8', "high half");
+    zeros = repeat('0', k - 1);
+    REQUIRE(!strncmp(str + k, zeros, k - 1) && str[2 * k - 1] == '1', "low half");
+    free(str);
+
+    /* unbalanced operands against the product computed limb by limb */
+    b = INTEGER(1);
+    for (i = 0; i < 10; ++i)
+        b = scm_bignum_mul(b, INTEGER(1000000007));
+    q = scm_bignum_mul(a, b);
+    r = a;
+    for (i = 0; i < 10; ++i)
+        r = scm_bignum_mul(r, INTEGER(1000000007));
+    REQUIRE_EQ(scm_bignum_cmp(q, r), 0);
+
+    /* a = q * b + r with |r| < |b| and the sign of a */
+    digits = malloc(2 * k + 1);
+    for (i = 0; i < 2 * k; ++i)
+        digits[i] = '1' + (i * 7919) % 9;
+    digits[2 * k] = '\0';
+    a = scm_bignum_neg(scm_number_new_integer(digits, 10));
+    digits[k] = '\0';
+    b = scm_number_new_integer(digits + 3, 10);
+    scm_bignum_divmod(a, b, &q, &r);
+    REQUIRE(scm_bignum_sign(r) < 0, "remainder sign");
+    REQUIRE(scm_bignum_cmp(scm_bignum_neg(r), b) < 0, "remainder range");
+    REQUIRE_EQ(scm_bignum_cmp(scm_bignum_add(scm_bignum_mul(q, b), r), a), 0);
+
+    /* decimal conversion of a few thousand limbs */
+    digits[k] = '1';
+    str = scm_number_to_string(scm_number_new_integer(digits, 10), 10);
+    REQUIRE_STREQ(str, digits);
+    free(str);
+
+    REQUIRE_EQ(scm_bignum_to_double(scm_number_new_integer("18446744073709551617", 10)), 0x1p64);
+    REQUIRE_EQ(scm_bignum_to_double(scm_number_new_integer("-36893488147419103231", 10)), -0x1p65);
+    str = scm_number_to_string(scm_bignum_from_double(-0x1p100), 10);
+    REQUIRE_STREQ(str, "-1267650600228229401496703205376");
+    free(str);
+
+    free(nines);
+    free(zeros);
+    free(digits);
 }
 
 TEST(number, floats) {
@@ -123,6 +210,96 @@ TEST(number, floats) {
     }
 }
 
+/* the digits of the formatted number @s from its first to its last
+ * non-zero one */
+static int significant_digits(const char *s) {
+    const char *first = NULL, *last = NULL;
+    int n = 0;
+
+    for (; *s && *s != 'e'; ++s) {
+        if (*s >= '1' && *s <= '9') {
+            if (!first)
+                first = s;
+            last = s;
+        }
+    }
+    for (s = first; s && s <= last; ++s)
+        n += *s != '.';
+    return n;
+}
+
+TEST(number, floats_shortest) {
+    int i;
+    char buf[SCM_NUMBER_BUF_SIZE];
+    TEST_INIT();
+
+    const int n = 14;
+    double vals[n] = {0.1, 0.1 + 0.2, 5e-324, 1e16, 1e15, 123456.789, 1.0 / 3,
+                      -2.2250738585072014e-308, 1.7976931348623157e308, 1e-4, -0.0, 1e21,
+                      1e23, 9.5e-5};
+    char *ress[n] = {"0.1", "0.30000000000000004", "5e-324", "1e+16", "1000000000000000.0",
+                     "123456.789", "0.3333333333333333", "-2.2250738585072014e-308",
+                     "1.7976931348623157e+308", "0.0001", "-0.0", "1e+21", "1e+23", "9.5e-05"};
+    for (i = 0; i < n; ++i) {
+        scm_object *obj = FLOAT(vals[i]);
+        int len = scm_number_format(obj, 10, buf);
+        REQUIRE_STREQ(buf, ress[i], "i=%d", i);
+        REQUIRE_EQ(len, (int)strlen(ress[i]), "i=%d", i);
+        scm_object_free(obj);
+    }
+
+    REQUIRE_EQ(scm_number_format(FLOAT(1.5), 16, buf), -1);
+
+    /* random bit patterns read back as the same double, and one digit less
+     * rounded to nearest does not */
+    unsigned long long seed = 88172645463325252ULL;
+    for (i = 0; i < 100000; ++i) {
+        double d, r;
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        memcpy(&d, &seed, sizeof(d));
+        if (isnan(d) || isinf(d))
+            continue;
+        scm_object *obj = FLOAT(d);
+        scm_number_format(obj, 10, buf);
+        r = strtod(buf, NULL);
+        REQUIRE(memcmp(&r, &d, sizeof(d)) == 0, "%s", buf);
+        int len = significant_digits(buf);
+        if (len > 1) {
+            char shorter[32];
+            snprintf(shorter, sizeof(shorter), "%.*e", len - 2, d);
+            REQUIRE(strtod(shorter, NULL) != d, "%s %s", buf, shorter);
+        }
+        scm_object_free(obj);
+    }
+}
+
+TEST(number, decimal_to_double) {
+    int i;
+    char buf[64];
+    TEST_INIT();
+
+    /* random significands and exponents convert like strtod, unless the
+     * fast path leaves them to it */
+    unsigned long long seed = 88172645463325252ULL;
+    for (i = 0; i < 100000; ++i) {
+        double d, r;
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        unsigned long mant = seed % 10000000000000000000ULL;
+        long exp10 = (long)(seed >> 40) % 640 - 330;
+        if (!mant)
+            continue;
+        snprintf(buf, sizeof(buf), "%lue%ld", mant, exp10);
+        if (scm_number_decimal_to_double(mant, exp10, 0, &d))
+            continue;
+        r = strtod(buf, NULL);
+        REQUIRE(memcmp(&r, &d, sizeof(d)) == 0, "%s", buf);
+    }
+}
+
 TEST(number, floats_out_of_range) {
     int i;
     scm_object *obj;
@@ -207,3 +384,125 @@ TEST(number, equivalence) {
         scm_object_free(nums[i]);
     }
 }
+
+TEST(number, arithmetic) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(+)", "0"}, {"(*)", "1"}, {"(+ 1 2 3)", "6"}, {"(- 5)", "-5"},
+        {"(- 10 1 2)", "7"}, {"(* 2 3.5)", "7.0"}, {"(+ 0.5 0.25)", "0.75"},
+        {"(/ 6 3)", "2"}, {"(/ 7 2)", "7/2"}, {"(/ 2)", "1/2"}, {"(/ 1.0 0)", "+inf.0"},
+        {"(+ 9223372036854775806 1)", "9223372036854775807"},
+        {"(= 1 1.0)", "#t"}, {"(< 1 2 3)", "#t"}, {"(< 1 3 2)", "#f"},
+        {"(>= 3 3 1)", "#t"}, {"(> 2 1.5)", "#t"}, {"(<= 1 1 0)", "#f"},
+        {"(max 1 2.0)", "2.0"}, {"(min 1 2)", "1"}, {"(abs -7)", "7"},
+        {"(quotient -7 2)", "-3"}, {"(remainder -7 2)", "-1"}, {"(modulo -7 2)", "1"},
+        {"(modulo 7 -2)", "-1"}, {"(quotient -9223372036854775807 -1)", "9223372036854775807"},
+        {"(gcd 12 -18)", "6"}, {"(gcd)", "0"}, {"(lcm 4 6)", "12"}, {"(lcm 0 5)", "0"},
+        /* integral floats are inexact integers */
+        {"(integer? 2.0)", "#t"}, {"(integer? 2.5)", "#f"}, {"(integer? (/ 1. 0))", "#f"},
+        {"(exact-integer? 2.0)", "#f"}, {"(exact-integer? 2)", "#t"},
+        {"(even? 2.0)", "#t"}, {"(odd? -3.0)", "#t"}, {"(quotient 7.0 2)", "3.0"},
+        {"(remainder -7 2.0)", "-1.0"}, {"(modulo -7. 2)", "1.0"}, {"(modulo 7 -2.)", "-1.0"},
+        {"(gcd 2.0 4)", "2.0"}, {"(lcm 4 6.)", "12.0"}, {"(lcm 0. 5)", "0.0"},
+        {"(floor 2.5)", "2.0"}, {"(ceiling 2.5)", "3.0"}, {"(round 2.5)", "2.0"},
+        {"(round 3.5)", "4.0"}, {"(truncate -2.7)", "-2.0"}, {"(floor 3)", "3"},
+        {"(sqrt 16)", "4"}, {"(sqrt 2)", "1.4142135623730951"}, {"(sqrt 16.0)", "4.0"},
+        {"(expt 2 62)", "4611686018427387904"}, {"(expt -3 3)", "-27"}, {"(expt 2 0.5)", "1.4142135623730951"},
+        {"(exp 0)", "1.0"}, {"(atan 1 1)", "0.7853981633974483"},
+        {"(exact->inexact 3)", "3.0"}, {"(inexact->exact 4.0)", "4"},
+        {"(number->string 255 16)", "\"ff\""}, {"(number->string -1.5)", "\"-1.5\""},
+        {"(string->number \"1e3\")", "1000.0"}, {"(string->number \"-17\")", "-17"},
+        {"(string->number \"101\" 2)", "5"}, {"(string->number \"abc\")", "#f"},
+        {"(string->number \"ff\" 16)", "255"}, {"(string->number (number->string 57005 16) 16)", "57005"},
+        {"(string->number \"1 2\")", "#f"}, {"(string->number \"\")", "#f"},
+        /* #e decimals are exact to the last digit */
+        {"#e1.5", "3/2"}, {"#e1.25", "5/4"}, {"(string->number \"#e1.2\")", "6/5"},
+        {"#e-2.5e-3", "-1/400"}, {"#e1.5e1", "15"}, {"#e.1", "1/10"}, {"#e12#.#", "120"},
+        {"(= #e0.1000000000000000055511151231257827021181583404541015625 (inexact->exact 0.1))", "#t"},
+        {"(= #e0.1 (inexact->exact 0.1))", "#f"}, {"(= #e1.5 (inexact->exact 1.5))", "#t"},
+        /* what is written of infinities and nan reads back */
+        {"(string->number (number->string (/ 1. 0)))", "+inf.0"}, {"-inf.0", "-inf.0"},
+        {"(string->number \"+nan.0\")", "+nan.0"}, {"(- +INF.0)", "-inf.0"},
+        {"(= +inf.0 (/ 1. 0))", "#t"}, {"(string->number \"+inf.1\")", "#f"},
+        {"(zero? 0.0)", "#t"}, {"(positive? -1)", "#f"}, {"(negative? -1.5)", "#t"},
+        {"(odd? 3)", "#t"}, {"(even? 3)", "#f"}, {"(rational? 1.5)", "#t"},
+        {"(complex? 'a)", "#f"}, {"(exact-integer? 5)", "#t"}, {"(exact-integer? 5.0)", "#f"},
+        {"(exact-integer? (expt 2 70))", "#t"},
+        {"(+ 9223372036854775807 1)", "9223372036854775808"},
+        {"(* 4611686018427387904 2)", "9223372036854775808"},
+        {"(- -9223372036854775807 2)", "-9223372036854775809"},
+        {"(- (+ 9223372036854775807 1) 1)", "9223372036854775807"},
+        {"(expt 2 100)", "1267650600228229401496703205376"},
+        {"(quotient (expt 10 30) -7)", "-142857142857142857142857142857"},
+        {"(modulo (- (expt 10 30)) 7)", "6"}, {"(remainder (- (expt 10 30)) 7)", "-1"},
+        {"(/ (expt 10 30) (expt 10 28))", "100"}, {"(abs -9223372036854775808)", "9223372036854775808"},
+        {"(gcd (expt 2 80) (expt 6 40))", "1099511627776"}, {"(lcm (expt 2 70) 3)", "3541774862152233910272"},
+        {"(sqrt (expt 3 80))", "12157665459056928801"},
+        {"(< 9223372036854775807 9223372036854775808 1e19)", "#t"}, {"(= (expt 2 70) (expt 2.0 70))", "#t"},
+        {"(exact->inexact (expt 2 70))", "1.1805916207174113e+21"},
+        {"(inexact->exact 1e20)", "100000000000000000000"},
+        {"(even? (expt 2 70))", "#t"}, {"(negative? (- (expt 2 70)))", "#t"},
+        {"(number->string (expt 2 64) 16)", "\"10000000000000000\""},
+        {"(string->number \"-100000000000000000000\")", "-100000000000000000000"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("+: contract violation by argument #2\nexpected: number?\ngiven: a",
+                eval_string("(+ 1 'a)"));
+    REQUIRE_EXC("<: contract violation by argument #3", eval_string("(< 1 0 'a)"));
+    REQUIRE_EXC("/: undefined for 0", eval_string("(/ 1 0)"));
+    REQUIRE_EXC("quotient: undefined for 0", eval_string("(quotient 1 0)"));
+    REQUIRE_EXC("quotient: undefined for 0", eval_string("(quotient 1. 0)"));
+    REQUIRE_EXC("vector-ref: contract violation by argument #2\nexpected: exact-integer?",
+                eval_string("(vector-ref (vector 1 2) 1.0)"));
+    REQUIRE_EXC("quotient: contract violation by argument #1\nexpected: integer?",
+                eval_string("(quotient 1.5 2)"));
+    REQUIRE_EXC("inexact->exact: no exact representation", eval_string("(inexact->exact (/ 1.0 0))"));
+    REQUIRE_EXC("number->string: contract violation by argument #2", eval_string("(number->string 1 3)"));
+}
+
+TEST(number, rationals) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"1/3", "1/3"}, {"-6/4", "-3/2"}, {"6/3", "2"}, {"#x-a/c", "-5/6"}, {"#i1/4", "0.25"},
+        {"(/ 6 4)", "3/2"}, {"(/ -1 -3)", "1/3"}, {"(/ 1 -3)", "-1/3"}, {"(/ 1 2 3)", "1/6"},
+        {"(+ 1/3 1/6)", "1/2"}, {"(+ 1/3 2/3)", "1"}, {"(- 1/2 1/3)", "1/6"}, {"(* 2/3 3/4)", "1/2"},
+        {"(/ 2/3 4/9)", "3/2"}, {"(* 1/2 4)", "2"}, {"(+ 1/2 0.5)", "1.0"}, {"(- 1/3)", "-1/3"},
+        {"(- 0.0)", "-0.0"}, {"(- -0.0)", "0.0"}, {"(- -9223372036854775808)", "9223372036854775808"},
+        {"(rationalize 1/3 1/100)", "1/3"}, {"(rationalize 3/10 1/10)", "1/3"},
+        {"(rationalize .3 1/10)", "0.3333333333333333"}, {"(rationalize -3/10 1/10)", "-1/3"},
+        {"(rationalize 5 1/2)", "5"}, {"(rationalize 1/4 -1/4)", "0"}, {"(rationalize 22/7 0)", "22/7"},
+        {"(rationalize 3.14159 0.01)", "3.142857142857143"}, {"(rationalize 3.14159 0.001)", "3.140625"}, {"(rationalize 3 +inf.0)", "0.0"},
+        {"(rationalize +inf.0 3)", "+inf.0"}, {"(rationalize +inf.0 +inf.0)", "+nan.0"},
+        {"(+ 1/9223372036854775807 1/9223372036854775806)",
+         "18446744073709551613/85070591730234615838173535747377725442"},
+        {"(* 9223372036854775807/2 2/9223372036854775807)", "1"},
+        {"(/ (expt 10 20) (expt 10 22))", "1/100"}, {"(expt 2/3 3)", "8/27"}, {"(expt 2 -3)", "1/8"},
+        {"(expt -2/3 -3)", "-27/8"},
+        {"(< 1/3 0.34 1/2)", "#t"}, {"(= 1/2 0.5)", "#t"}, {"(> 1/3 0.3333333333333333)", "#t"},
+        {"(< -1/3 -1/4)", "#t"}, {"(max 1/2 1/3)", "1/2"}, {"(max 1/2 0.1)", "0.5"},
+        {"(floor 7/2)", "3"}, {"(floor -7/2)", "-4"}, {"(ceiling 7/2)", "4"}, {"(ceiling -7/2)", "-3"},
+        {"(truncate -7/2)", "-3"}, {"(round 7/2)", "4"}, {"(round 5/2)", "2"}, {"(round -5/2)", "-2"},
+        {"(round 8/3)", "3"}, {"(abs -1/2)", "1/2"}, {"(negative? -1/2)", "#t"}, {"(zero? 1/2)", "#f"},
+        {"(numerator 6/4)", "3"}, {"(denominator 6/4)", "2"}, {"(denominator 5)", "1"},
+        {"(numerator 0.75)", "3.0"}, {"(denominator 0.75)", "4.0"},
+        {"(sqrt 4/9)", "2/3"}, {"(sqrt 1/2)", "0.7071067811865476"},
+        {"(exact->inexact 1/3)", "0.3333333333333333"},
+        {"(exact->inexact (/ (expt 10 400) (+ (expt 10 399) 1)))", "10.0"},
+        {"(inexact->exact 0.1)", "3602879701896397/36028797018963968"}, {"(inexact->exact -1.5)", "-3/2"},
+        {"(exact? 1/2)", "#t"}, {"(rational? 1/2)", "#t"}, {"(integer? 1/2)", "#f"}, {"(eqv? 1/2 2/4)", "#t"},
+        {"(number->string 3/4 2)", "\"11/100\""}, {"(string->number \"-4/6\")", "-2/3"},
+        {"(string->number \"1/0\")", "#f"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("/: undefined for 0", eval_string("(/ 1/2 0)"));
+    REQUIRE_EXC("expt: undefined for 0", eval_string("(expt 0 -1)"));
+    REQUIRE_EXC("odd?: contract violation by argument #1\nexpected: integer?", eval_string("(odd? 1/2)"));
+    REQUIRE_EXC("lexer: bad number", eval_string("1/2/3"));
+    REQUIRE_EXC("lexer: bad number", eval_string("1.5/2"));
+}
@@ -99,3 +99,169 @@ TEST(string, equivalence) {
         scm_object_free(strs[i]);
     }
 }
+
+TEST(string, rope) {
+    char piece[8], expected[64 * 1024];
+    long len = 0;
+    TEST_INIT();
+
+    /* many small appends, each in O(log n) */
+    scm_object *s = scm_string_copy_new("", 0);
+    for (int i = 0; i < 10000; ++i) {
+        int k = snprintf(piece, sizeof(piece), "%d,", i);
+        memcpy(expected + len, piece, k);
+        len += k;
+        s = scm_string_append(s, scm_string_copy_new(piece, k));
+    }
+    REQUIRE_EQ(scm_string_length(s), len);
+    REQUIRE(!memcmp(scm_string_get_str(s), expected, len), "flattened");
+
+    /* substrings share the characters of the rope */
+    scm_object *sub = scm_substring(s, 1000, 30000);
+    REQUIRE_EQ(scm_string_length(sub), 29000);
+    REQUIRE(!memcmp(scm_string_get_str(sub), expected + 1000, 29000), "substring");
+    for (long i = 0; i < 29000; i += 997)
+        CHECK_EQ(scm_string_ref(sub, i), scm_chars[(int)expected[1000 + i]], "i=%ld", i);
+    CHECK_EXC("substring: ending index is out of range", scm_substring(s, 10, len + 1));
+    CHECK_EXC("substring: starting index is out of range", scm_substring(s, -1, 0));
+
+    /* changing a string doesn't change the ones made of it */
+    scm_object *t = scm_string_copy_new(expected, 1000);
+    scm_object *u = scm_string_append(t, t);
+    scm_object *v = scm_substring(u, 500, 1500);
+    scm_string_set(t, 0, '#');
+    scm_string_set(u, 1000, '$');
+    REQUIRE_EQ(scm_string_get_char(t, 0), '#');
+    REQUIRE_EQ(scm_string_get_char(u, 0), expected[0]);
+    REQUIRE_EQ(scm_string_get_char(u, 1000), '$');
+    REQUIRE_EQ(scm_string_get_char(v, 500), expected[0]);
+    REQUIRE(scm_equal(scm_string_append(v, scm_string_copy_new("", 0)), v), "copy");
+}
+
+TEST(string, slice) {
+    TEST_INIT();
+
+    scm_object *s = scm_string_copy_new("2024-01-01 INFO started", -1);
+    const char *buf = scm_string_get_str(s);
+
+    /* no copies of the characters */
+    scm_object *level = scm_substring(s, 11, 15);
+    scm_object *msg = scm_substring(level, 0, 4);
+    REQUIRE_EQ(scm_string_get_str(level), buf + 11);
+    REQUIRE_EQ(scm_string_get_str(msg), buf + 11);
+    REQUIRE_EQ(scm_string_get_str(scm_string_copy(s)), buf);
+
+    /* a change to either side copies first */
+    scm_string_set(level, 0, 'i');
+    REQUIRE_EQ(scm_string_get_char(level, 0), 'i');
+    REQUIRE_EQ(scm_string_get_char(s, 11), 'I');
+    REQUIRE_EQ(scm_string_get_char(msg, 0), 'I');
+    scm_string_set(s, 11, 'X');
+    REQUIRE_EQ(scm_string_get_char(s, 11), 'X');
+    REQUIRE_EQ(scm_string_get_char(msg, 0), 'I');
+    REQUIRE(scm_equal(msg, scm_string_copy_new("INFO", -1)), "unchanged slice");
+}
+
+TEST(string, utf8) {
+    char text[4096];
+    long size = 0;
+    TEST_INIT();
+
+    /* mixed widths over many index steps */
+    const char *pieces[] = { "a", "\xce\xbb", "\xe6\x88\x91", "\xf0\x9f\x98\x80" };
+    const int cps[] = { 'a', 0x3bb, 0x6211, 0x1f600 };
+    for (int i = 0; i < 1000; ++i) {
+        strcpy(text + size, pieces[i % 4]);
+        size += strlen(pieces[i % 4]);
+    }
+    scm_object *s = scm_string_copy_new(text, size);
+    REQUIRE_EQ(scm_string_length(s), 1000);
+    REQUIRE_EQ(scm_string_size(s), size);
+    for (int i = 999; i >= 0; --i)
+        CHECK_EQ(scm_string_get_char(s, i), cps[i % 4], "i=%d", i);
+    CHECK_EQ(scm_char_get_codepoint(scm_string_ref(s, 1)), 0x3bb);
+    CHECK_OBJ_EQV(scm_string_ref(s, 1), scm_string_ref(s, 5));
+
+    scm_object *sub = scm_substring(s, 401, 403);
+    REQUIRE_EQ(scm_string_length(sub), 2);
+    REQUIRE_EQ(scm_string_size(sub), 5);
+    REQUIRE(!memcmp(scm_string_get_str(sub), "\xce\xbb\xe6\x88\x91", 5), "substring");
+
+    /* characters of other widths move the rest */
+    scm_string_set(s, 2, 'x');
+    scm_string_set(s, 0, 0x1f600);
+    REQUIRE_EQ(scm_string_get_char(s, 0), 0x1f600);
+    REQUIRE_EQ(scm_string_get_char(s, 2), 'x');
+    REQUIRE_EQ(scm_string_get_char(s, 999), cps[3]);
+    REQUIRE_EQ(scm_string_size(s), size + 3 - 2);
+    REQUIRE_EQ(scm_string_get_char(sub, 0), 0x3bb);
+
+    /* ill-formed sequences are replaced */
+    scm_object *bad = scm_string_copy_new("a\xff\xe6\x88z", -1);
+    REQUIRE_EQ(scm_string_length(bad), 4);
+    REQUIRE_EQ(scm_string_get_char(bad, 1), 0xfffd);
+    REQUIRE_EQ(scm_string_get_char(bad, 2), 0xfffd);
+    REQUIRE_EQ(scm_string_get_char(bad, 3), 'z');
+}
+
+TEST(string, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(make-string 3 #\\a)", "\"aaa\""}, {"(string-length (make-string 2))", "2"},
+        {"(string #\\a #\\b)", "\"ab\""}, {"(string)", "\"\""},
+        {"(define s (make-string 3 #\\a)) (string-set! s 1 #\\b) s", "\"aba\""},
+        {"(string=? \"ab\" \"ab\" \"ab\")", "#t"}, {"(string=? \"ab\" \"abc\")", "#f"},
+        {"(string<? \"ab\" \"abc\" \"b\")", "#t"}, {"(string>? \"b\" \"a\" \"a\")", "#f"},
+        {"(string<=? \"a\" \"a\" \"b\")", "#t"}, {"(string>=? \"b\" \"ba\")", "#f"},
+        {"(string-ci=? \"AbC\" \"aBc\")", "#t"}, {"(string-ci<? \"a\" \"B\")", "#t"},
+        {"(string-ci>? \"a\" \"B\")", "#f"}, {"(string-ci<=? \"A\" \"a\")", "#t"},
+        {"(string-ci>=? \"a\" \"B\")", "#f"},
+        {"(substring \"hello\" 1 3)", "\"el\""}, {"(substring \"hello\" 2)", "\"llo\""},
+        {"(string-append \"a\" \"\" \"bc\" \"d\")", "\"abcd\""}, {"(string-append)", "\"\""},
+        {"(define s (make-string 2 #\\a)) (define t (string-append \"\" s)) (string-set! t 0 #\\z) (list s t)",
+         "(\"aa\" \"za\")"},
+        {"(string->list \"abc\")", "(#\\a #\\b #\\c)"}, {"(string->list \"abc\" 1 2)", "(#\\b)"},
+        {"(list->string '(#\\a #\\b))", "\"ab\""}, {"(list->string '())", "\"\""},
+        {"(define s \"abc\") (define c (string-copy s)) (string-set! c 0 #\\x) (list s c)", "(\"abc\" \"xbc\")"},
+        {"(string-copy \"hello\" 1 2)", "\"e\""},
+        {"(define s (make-string 2)) (string-fill! s #\\z) s", "\"zz\""},
+        {"(define p (open-output-string)) (write-char #\\a p) (write-string \"bcd\" p 1 2) "
+         "(newline p) (string=? (get-output-string p) (string #\\a #\\c #\\newline))", "#t"},
+        {"(define p (open-input-string \"ab\")) (read-char p) (list (peek-char p) (read-char p))", "(#\\b #\\b)"},
+        {"(read-char (open-input-string \"\"))", "#<eof-object>"},
+        {"(define s (string #\\a)) (define p (open-input-string s)) (string-set! s 0 #\\b) (read-char p)", "#\\a"},
+        {"(string-split \"a,b,,c\" #\\,)", "(\"a\" \"b\" \"\" \"c\")"},
+        {"(string-split \"  a b  c  \")", "(\"a\" \"b\" \"c\")"},
+        {"(string-split \"\" #\\,)", "(\"\")"}, {"(string-split \" \")", "()"},
+        {"(define l (string-split \"ab cd\")) (string-set! (car l) 0 #\\x) l", "(\"xb\" \"cd\")"},
+        {"(string-length \"\xce\xbb\xe6\x88\x91\")", "2"}, {"(string-ref \"a\xce\xbb\" 1)", "#\\\xce\xbb"},
+        {"(char->integer #\\\xce\xbb)", "955"}, {"(integer->char #x3bb)", "#\\\xce\xbb"},
+        {"(char->integer #\\x41)", "65"}, {"(eqv? #\\x3bb (integer->char 955))", "#t"},
+        {"(string->list \"\xce\xbbx\")", "(#\\\xce\xbb #\\x)"},
+        {"(list->string (list #\\x3bb #\\a))", "\"\xce\xbb" "a\""},
+        {"(make-string 2 #\\x3bb)", "\"\xce\xbb\xce\xbb\""},
+        {"(define s (make-string 2 #\\a)) (string-fill! s #\\x3bb) (string-length s)", "2"},
+        {"(string<? \"z\" \"\xce\xbb\")", "#t"}, {"(string-ci=? \"\xce\x9b\xce\xa3\" \"\xce\xbb\xcf\x83\")", "#t"},
+        {"(string-split \"a\xce\xbb" "b\xce\xbb\" #\\x3bb)", "(\"a\" \"b\" \"\")"},
+        {"(define p (open-input-string \"\xce\xbbz\")) (list (peek-char p) (read-char p) (read-char p))",
+         "(#\\\xce\xbb #\\\xce\xbb #\\z)"},
+        {"(define p (open-output-string)) (write-char #\\x3bb p) (write-string \"\xe6\x88\x91!\" p 1) "
+         "(get-output-string p)", "\"\xce\xbb!\""},
+        {"(char-upcase #\\x3bb)", "#\\\xce\x9b"}, {"(char-downcase #\\A)", "#\\a"},
+        {"(char-ci=? #\\x0100 #\\x0101)", "#t"}, {"(char<? #\\a #\\b #\\c)", "#t"},
+        {"(list (char-alphabetic? #\\x6211) (char-numeric? #\\x0665) (char-whitespace? #\\x3000))", "(#t #t #t)"},
+        {"(list (char-upper-case? #\\x0416) (char-lower-case? #\\x0436) (digit-value #\\7))", "(#t #t 7)"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("string-set!: index is out of range", eval_string("(string-set! (make-string 1) 1 #\\a)"));
+    REQUIRE_EXC("substring: starting index is out of range", eval_string("(substring \"ab\" 3)"));
+    REQUIRE_EXC("make-string: contract violation by argument #1\nexpected: exact-nonnegative-integer?",
+                eval_string("(make-string -1)"));
+    REQUIRE_EXC("list->string: contract violation by argument #1\nexpected: (listof char?)",
+                eval_string("(list->string '(1))"));
+    REQUIRE_EXC("write-string: ending index is out of range",
+                eval_string("(write-string \"ab\" (open-output-string) 0 3)"));
+}
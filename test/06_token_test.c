@@ -134,7 +134,7 @@ TEST(token, string) {
 TEST(token, integer) {
     int i;
     TEST_INIT();
-    scm_object *port = string_input_port_new("12 +1 -3 #b10 #o10 #d10 #x10 #e5.1 #e1e2", -1);
+    scm_object *port = string_input_port_new("12 +1 -3 #b10 #o10 #d10 #x10 #e5.0 #e1e2", -1);
     REQUIRE(port, "string_input_port_new");
 
     char *expected[] = 
@@ -193,6 +193,54 @@ TEST(token, float) {
     scm_object_free(port);
 }
 
+TEST(token, number_value) {
+    int i;
+    TEST_INIT();
+    scm_object *port = string_input_port_new(
+        "#o777777777777777777777 -9223372036854775808 #b-1010 #o777 #xCa 007 "
+        "#xff #x1f #xdead #xCAFE #x1e2 #x-Fd #e#xf "
+        "0.1 1.7976931348623157e308 4.9406564584124654e-324 2.2250738585072014E-308 "
+        "0.30000000000000004 123456789012345678901234567890. 1d2 -0.0 "
+        "0.1000000000000000055511151231257827021181583404541015625 "
+        "#i9223372036854775808 #e-2.5e1", -1);
+    REQUIRE(port, "string_input_port_new");
+
+    long integers[] = {
+        LONG_MAX, LONG_MIN, -10, 511, 202, 7,
+        255, 31, 57005, 51966, 482, -253, 15,
+    };
+    double floats[] = {
+        0.1, 1.7976931348623157e308, 4.9406564584124654e-324, 2.2250738585072014e-308,
+        0.30000000000000004, 123456789012345678901234567890.0, 100.0, -0.0,
+        0.1000000000000000055511151231257827021181583404541015625,
+        9223372036854775808.0,
+    };
+    int n1 = sizeof(integers) / sizeof(long);
+    int n2 = sizeof(floats) / sizeof(double);
+
+    scm_token *t;
+    scm_object *o;
+    for (i = 0; i < n1 + n2 + 1; ++i) {
+        REQUIRE_NOEXC(t = scm_token_read(port), "i=%d", i);
+        o = scm_token_get_obj(t);
+
+        REQUIRE_EQ(scm_token_get_type(t), scm_token_type_number, "i=%d", i);
+        if (i < n1 || i == n1 + n2) {
+            REQUIRE_EQ(o->type, scm_type_integer, "i=%d", i);
+            REQUIRE_EQ(scm_integer_get_val(o), i < n1 ? integers[i] : -25, "i=%d", i);
+        }
+        else {
+            REQUIRE_EQ(o->type, scm_type_float, "i=%d", i);
+            REQUIRE(!memcmp(&floats[i-n1], &(double){scm_float_get_val(o)}, sizeof(double)), "i=%d", i);
+        }
+
+        scm_object_free(o);
+        scm_token_free(t);
+    }
+
+    scm_object_free(port);
+}
+
 /* bad syntax */
 TEST(token, bad_char) {
     int i;
@@ -247,6 +295,39 @@ TEST(token, bad_string) {
     }
 }
 
+TEST(token, bignum) {
+    int i;
+    TEST_INIT();
+    scm_object *port = string_input_port_new(
+        "9223372036854775808 -9223372036854775809 +0000123456789012345678901234567890 "
+        "#x-10000000000000000 #e#x10000000000000000 #e1e20 #x#i10000000000000000", -1);
+    REQUIRE(port, "string_input_port_new");
+
+    char *expected[] = {
+        "9223372036854775808", "-9223372036854775809", "123456789012345678901234567890",
+        "-18446744073709551616", "18446744073709551616", "100000000000000000000", "1.8446744073709552e+19",
+    };
+    int n = sizeof(expected) / sizeof(char *);
+
+    scm_token *t;
+    scm_object *o;
+    char *str;
+    for (i = 0; i < n; ++i) {
+        REQUIRE_NOEXC(t = scm_token_read(port), "i=%d", i);
+        o = scm_token_get_obj(t);
+
+        REQUIRE_EQ(scm_token_get_type(t), scm_token_type_number, "i=%d", i);
+        str = scm_number_to_string(o, 10);
+        REQUIRE_STREQ(str, expected[i], "i=%d", i);
+
+        free(str);
+        scm_object_free(o);
+        scm_token_free(t);
+    }
+
+    scm_object_free(port);
+}
+
 TEST(token, bad_number) {
     int i;
     TEST_INIT();
@@ -255,9 +336,10 @@ TEST(token, bad_number) {
         "#e", "#d.", "#x12g", "1a", "#o9", "#b3", "+a", "-a", /* no digit, bad digit */
         /* sign must be at the begin, # must be after the digit(s) but no digit(s) after # */
         "++1", "+-1", "1+", "1.2.3", "-#", "-.#", "1#1", "1#.#0",
-        "#x1.2", "#o1#", "#b1e1", "#x1e2",   /* float must be decimal */ 
+        "#x1.2", "#o1#", "#b1e1", "#o1e2",   /* float must be decimal */
         "1e++1", "1e+-1", "1e1+", "1e1#", "1e1.2", "1e.1", "1e", "1e+", "1e1a", /* suffix */
-        "9223372036854775808", "-9223372036854775809", "1e1000", "1e-1000", /* out of range */
+        "1e1000", "1e-1000", "#e1e400", /* out of range */
+        "+inf", "+inf.00", "-nan.", "+infinity", "#e+inf.0", "#e-nan.0", /* infinities and nan */
     };
     int n = sizeof(inputs) / sizeof(char *);
 
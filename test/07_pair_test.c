@@ -137,3 +137,84 @@ TEST(pair, equivalence) {
         scm_object_free(pairs[i]);
     }
 }
+
+TEST(pair, equal_long_deep_cyclic) {
+    TEST_INIT();
+
+    scm_object *l1 = scm_null, *l2 = scm_null, *d1 = scm_null, *d2 = scm_null;
+    for (long i = 0; i < 1000000; ++i) {
+        l1 = scm_cons(INTEGER(i), l1);
+        l2 = scm_cons(INTEGER(i), l2);
+        d1 = scm_cons(d1, INTEGER(i));
+        d2 = scm_cons(d2, INTEGER(i));
+    }
+    REQUIRE(scm_equal(l1, l2), "long lists");
+    REQUIRE(scm_equal(d1, d2), "deep lists");
+    REQUIRE_EQ(scm_equal_hash(l1), scm_equal_hash(l2));
+    REQUIRE_EQ(scm_equal_hash(d1), scm_equal_hash(d2));
+    REQUIRE(!scm_equal(l1, scm_cdr(l2)), "lengths differ");
+    REQUIRE(!scm_equal(scm_vector_new(2, d1, l1), scm_vector_new(2, d2, scm_cdr(l2))), "in vectors");
+
+    /* #0=(1 . #0#) and #1=(1 1 . #1#) unfold alike */
+    scm_object *c1 = scm_cons(INTEGER(1), scm_null);
+    scm_set_cdr(c1, c1);
+    scm_object *c2 = scm_list(2, INTEGER(1), INTEGER(1));
+    scm_set_cdr(scm_cdr(c2), c2);
+    REQUIRE(scm_equal(c1, c2), "cdr cycles");
+    REQUIRE_EQ(scm_equal_hash(c1), scm_equal_hash(c2));
+    scm_object *c3 = scm_list(3, INTEGER(1), INTEGER(1), INTEGER(2));
+    scm_set_cdr(scm_cddr(c3), c3);
+    REQUIRE(!scm_equal(c1, c3), "different cdr cycles");
+
+    /* #0=(#0# . 1) */
+    scm_object *a1 = scm_cons(scm_null, INTEGER(1));
+    scm_set_car(a1, a1);
+    scm_object *a2 = scm_cons(scm_null, INTEGER(1));
+    scm_set_car(a2, scm_cons(a2, INTEGER(1)));
+    REQUIRE(scm_equal(a1, a2), "car cycles");
+    scm_object *a3 = scm_cons(scm_null, INTEGER(1));
+    scm_set_car(a3, scm_cons(a3, INTEGER(2)));
+    REQUIRE(!scm_equal(a1, a3), "different car cycles");
+}
+
+TEST(pair, list_primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(length '())", "0"}, {"(length '(1 2 3))", "3"},
+        {"(append)", "()"}, {"(append '(1))", "(1)"}, {"(append '() 3)", "3"},
+        {"(append '(1 2) '() '(3) 4)", "(1 2 3 . 4)"},
+        {"(define l '(3)) (eq? (cdr (append '(1) l)) l)", "#t"},
+        {"(reverse '())", "()"}, {"(reverse '(1 (2) 3))", "(3 (2) 1)"},
+        {"(list-tail '(1 2 3) 0)", "(1 2 3)"}, {"(list-tail '(1 2 . 3) 2)", "3"},
+        {"(list-ref '(a b c) 2)", "c"},
+        {"(memq 'c '(a b c d))", "(c d)"}, {"(memq 'e '(a b c))", "#f"},
+        {"(memv 1/2 '(1 1/2))", "(1/2)"}, {"(member \"b\" '(\"a\" \"b\"))", "(\"b\")"},
+        {"(assq 'b '((a 1) (b 2)))", "(b 2)"}, {"(assv 2 '((1 . a) (2 . b)))", "(2 . b)"},
+        {"(assoc '(1) '(((1) . x)))", "((1) . x)"}, {"(assoc 3 '((1 . a)))", "#f"},
+        {"(map car '((a 1) (b 2)))", "(a b)"}, {"(map + '(1 2 3) '(10 20))", "(11 22)"},
+        {"(map (lambda (x) (* x x)) '(1 2 3))", "(1 4 9)"},
+        {"(map (lambda (x y) (cons x y)) '(1 2) '(a b))", "((1 . a) (2 . b))"},
+        /* the argument lists of rest parameters aren't shared */
+        {"(map (lambda args args) '(1 2) '(3 4))", "((1 3) (2 4))"}, {"(map list '(1 2))", "((1) (2))"},
+        {"(define acc '()) (for-each (lambda (x) (set! acc (cons x acc))) '(1 2 3)) acc", "(3 2 1)"},
+        {"(for-each car '())", "#<void>"},
+        {"(map + '(1 2) '(1 2) '(1 2) '(1 2) '(1 2 3))", "(5 10)"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("length: contract violation by argument #1\nexpected: list?", eval_string("(length '(1 . 2))"));
+    REQUIRE_EXC("append: contract violation by argument #2\nexpected: list?", eval_string("(append '() 1 '())"));
+    REQUIRE_EXC("list-tail: index is too large for the list\nindex: 3", eval_string("(list-tail '(1 2) 3)"));
+    REQUIRE_EXC("list-ref: index is too large for the list\nindex: 2", eval_string("(list-ref '(1 2) 2)"));
+    REQUIRE_EXC("list-ref: contract violation by argument #2\nexpected: exact-nonnegative-integer?",
+                eval_string("(list-ref '(1 2) -1)"));
+    REQUIRE_EXC("memq: contract violation by argument #2\nexpected: list?", eval_string("(memq 3 '(1 . 2))"));
+    REQUIRE_EXC("assq: contract violation by argument #2\nexpected: (listof pair?)", eval_string("(assq 3 '(1))"));
+    REQUIRE_EXC("map: contract violation by argument #1\nexpected: procedure?", eval_string("(map 1 '(1))"));
+    REQUIRE_EXC("map: contract violation by argument #3\nexpected: list?", eval_string("(map + '(1 2) '(1 . 2))"));
+    REQUIRE_EXC("map: contract violation by argument #6\nexpected: list?",
+                eval_string("(map + '(1 2) '(1 2) '(1 2) '(1 2) '(1 . 2))"));
+    REQUIRE_EXC("+: contract violation", eval_string("(map + '(1) '(2) '(3) '(4) '(a))"));
+}
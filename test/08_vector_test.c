@@ -151,3 +151,68 @@ TEST(vector, equivalence) {
         scm_object_free(vecs[i]);
     }
 }
+
+TEST(vector, copy_convert) {
+    TEST_INIT();
+
+    scm_object *v = scm_vector_new(4, INTEGER(0), INTEGER(1), INTEGER(2), INTEGER(3));
+    scm_object *c = scm_vector_copy(v, 1, 3);
+    REQUIRE_EQ(scm_vector_length(c), 2);
+    REQUIRE_EQ(scm_integer_get_val(scm_vector_ref(c, 0)), 1);
+    REQUIRE_EQ(scm_integer_get_val(scm_vector_ref(c, 1)), 2);
+    scm_vector_set(c, 0, scm_true);
+    REQUIRE_EQ(scm_integer_get_val(scm_vector_ref(v, 1)), 1);
+    REQUIRE_EQ(scm_vector_copy(v, 2, 2), scm_empty_vector);
+
+    scm_object *l = scm_vector_to_list(v, 0, 4);
+    REQUIRE_EQ(scm_list_length(l), 4);
+    REQUIRE(scm_equal(scm_list_to_vector(l), v), "round trip");
+    REQUIRE_EQ(scm_vector_to_list(v, 3, 3), scm_null);
+    REQUIRE_EQ(scm_list_to_vector(scm_null), scm_empty_vector);
+    REQUIRE_EQ(scm_list_to_vector(scm_cons(scm_true, scm_false)), NULL);
+}
+
+TEST(vector, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(define v (vector 1 2 3 4)) (vector-fill! v 'x) v", "#(x x x x)"},
+        {"(define v (vector 1 2 3 4)) (vector-fill! v 'x 1 3) v", "#(1 x x 4)"},
+        {"(vector->list #(1 2 3))", "(1 2 3)"},
+        {"(vector->list #(1 2 3) 1)", "(2 3)"},
+        {"(vector->list #(1 2 3) 1 2)", "(2)"},
+        {"(list->vector '(1 (2) \"3\"))", "#(1 (2) \"3\")"},
+        {"(list->vector '())", "#()"},
+        {"(define v #(1 2 3)) (define c (vector-copy v)) (vector-set! c 0 'a) (list v c)", "(#(1 2 3) #(a 2 3))"},
+        {"(vector-copy #(1 2 3) 2)", "#(3)"},
+        {"(subvector #(1 2 3 4) 1 3)", "#(2 3)"},
+        {"(define v (vector 1 2 3 4 5)) (vector-copy! v 1 v 0 3) v", "#(1 1 2 3 5)"},
+        {"(define v (vector 1 2 3 4 5)) (vector-copy! v 0 v 2) v", "#(3 4 5 4 5)"},
+        {"(define v (vector 1 2)) (vector-copy! v 2 #()) v", "#(1 2)"},
+        {"(vector-append #(1) #() #(2 3))", "#(1 2 3)"},
+        {"(vector-append)", "#()"},
+        {"(vector-map + #(1 2 3) #(10 20))", "#(11 22)"},
+        {"(vector-map (lambda (x) (* x x)) #(1 2 3))", "#(1 4 9)"},
+        {"(vector-map list #(1 2))", "#((1) (2))"},
+        {"(vector-map + #(1 2) #(1 2) #(1 2) #(1 2) #(1 2 3))", "#(5 10)"},
+        {"(define n 0) (vector-for-each (lambda (x y) (set! n (+ n (* x y)))) #(1 2 3) #(4 5 6)) n", "32"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("make-vector: contract violation by argument #1\nexpected: exact-nonnegative-integer?",
+                eval_string("(make-vector -1)"));
+    REQUIRE_EXC("list->vector: contract violation by argument #1\nexpected: list?",
+                eval_string("(list->vector '(1 . 2))"));
+    REQUIRE_EXC("vector-copy: ending index is out of range\nending index: 4\nvalid range: [1, 3]",
+                eval_string("(vector-copy #(1 2 3) 1 4)"));
+    REQUIRE_EXC("subvector: starting index is out of range\nstarting index: 4\nvalid range: [0, 3]",
+                eval_string("(subvector #(1 2 3) 4 4)"));
+    REQUIRE_EXC("vector-copy!: not enough room in the destination\nindex: 1\nelements: 2",
+                eval_string("(vector-copy! (vector 1 2) 1 #(a b))"));
+    REQUIRE_EXC("vector-map: contract violation by argument #3\nexpected: vector?",
+                eval_string("(vector-map + #(1) '(2))"));
+    REQUIRE_EXC("+: contract violation", eval_string("(vector-map + #(1) #(2) #(3) #(4) #(a))"));
+    REQUIRE_EXC("vector-append: contract violation by argument #2\nexpected: vector?",
+                eval_string("(vector-append #() 1)"));
+}
@@ -203,3 +203,36 @@ TEST(read, invalid_token) {
         scm_object_free(ports[i]);
     }
 }
+
+TEST(read, parallel) {
+    scm_object *l1, *l2;
+    TEST_INIT();
+
+    /* tricky top-level boundaries: strings, comments, characters, quotes */
+    const char *unit = "(a \"b ) (\" #\\( ; c )\n d) 'e ` f\n, g ,@ (h)"
+                       " #(1 #\\) 2.5) \"\\\" (\" #\\space ; (\n-3\n";
+    long len = strlen(unit), n = 20000;
+    char *buf = malloc(len * n + 1);
+    for (long i = 0; i < n; ++i)
+        memcpy(buf + i * len, unit, len);
+    buf[len * n] = '\0';
+
+    REQUIRE_NOEXC(l1 = scm_read_buffer(buf, len * n, 1));
+    REQUIRE_EQ(scm_list_length(l1), 9 * n);
+    REQUIRE_NOEXC(l2 = scm_read_buffer(buf, -1, 8));
+    REQUIRE_EQ(scm_list_length(l2), 9 * n);
+    for (long i = 0; l1 != scm_null; ++i) {
+        REQUIRE_OBJ_EQUAL(scm_car(l1), scm_car(l2), "i=%ld", i);
+        l1 = scm_cdr(l1);
+        l2 = scm_cdr(l2);
+    }
+
+    /* errors are reported in order */
+    buf[len * (n - 1)] = ')';
+    REQUIRE_EXC("parser: unexpected `)`", scm_read_buffer(buf, len * n, 8));
+
+    REQUIRE_NOEXC(l1 = scm_read_buffer("", 0, 8));
+    REQUIRE_EQ(l1, scm_null);
+
+    free(buf);
+}
@@ -186,3 +186,134 @@ TEST(write, vector) {
 
     scm_object_free(oport);
 }
+
+TEST(write, labels) {
+    TEST_INIT();
+
+    scm_object *a = scm_list(3, SYM(a), SYM(b), SYM(c));
+    scm_set_cdr(scm_cddr(a), a);                /* (a b c a b c ...) */
+    scm_object *b = scm_cons(SYM(x), SYM(y));
+    scm_object *c = scm_list(2, b, b);          /* shared, no cycle */
+    scm_object *d = scm_vector_new(2, SYM(v), scm_null);
+    scm_vector_set(d, 1, d);
+    scm_object *e = scm_list(2, scm_cons(SYM(x), SYM(y)), scm_cons(SYM(x), SYM(y)));
+    scm_object *f = scm_list(2, SYM(q), SYM(r));
+    scm_set_car(f, f);
+
+    struct {
+        int (*fn)(scm_object *, scm_object *);
+        scm_object *obj;
+        char *expected;
+    } cases[] = {
+        { scm_write, a, "#0=(a b c . #0#)" },
+        { scm_write_shared, a, "#0=(a b c . #0#)" },
+        { scm_write, c, "((x . y) (x . y))" },
+        { scm_write_shared, c, "(#0=(x . y) #0#)" },
+        { scm_write_simple, c, "((x . y) (x . y))" },
+        { scm_write, d, "#0=#(v #0#)" },
+        { scm_write_shared, e, "((x . y) (x . y))" },
+        { scm_write, f, "#0=(#0# r)" },
+        { scm_write_shared, scm_list(2, scm_empty_vector, scm_empty_vector), "(#() #())" },
+    };
+
+    int n = sizeof(cases) / sizeof(cases[0]);
+    for (int i = 0; i < n; ++i) {
+        scm_object *oport = string_output_port_open();
+        size_t len = cases[i].fn(oport, cases[i].obj);
+        REQUIRE_EQ(len, strlen(cases[i].expected), "i=%d", i);
+        REQUIRE_STREQ(scm_output_port_string(oport, NULL), cases[i].expected, "i=%d", i);
+        scm_object_free(oport);
+    }
+}
+
+TEST(write, deep_nesting) {
+    TEST_INIT();
+
+    int depth = 1000000;
+    scm_object *obj = scm_null;
+    for (int i = 0; i < depth; ++i)
+        obj = scm_list(2, obj, scm_vector_new(1, scm_true));
+
+    scm_object *oport = string_output_port_open();
+    long len;
+    REQUIRE_EQ(scm_write(oport, obj), depth * 8 + 2);
+    const char *s = scm_output_port_string(oport, &len);
+    REQUIRE_EQ(len, depth * 8 + 2);
+    REQUIRE(!strncmp(s, "((((", 4));
+    REQUIRE(!strncmp(s + depth - 1, "(() #(#t))", 10));
+    scm_object_free(oport);
+
+    oport = string_output_port_open();
+    REQUIRE_EQ(scm_write_simple(oport, obj), depth * 8 + 2);
+    scm_object_free(oport);
+}
+
+TEST(write, pretty_print) {
+    TEST_INIT();
+
+    scm_object *nums = scm_null;
+    for (int i = 12; i > 0; --i)
+        nums = scm_cons(INTEGER(i), nums);
+    scm_object *cyc = scm_list(2, SYM(aaaa), SYM(bbbb));
+    scm_set_cdr(scm_cdr(cyc), cyc);
+
+    struct {
+        scm_object *obj;
+        int width;
+        char *expected;
+    } cases[] = {
+        { SYM(atom), 10, "atom" },
+        { scm_list(3, SYM(a), SYM(b), SYM(c)), 20, "(a b c)" },
+        /* atoms fill the lines */
+        { nums, 20, "(1 2 3 4 5 6 7 8 9\n 10 11 12)" },
+        /* a compound element puts every element on its own line */
+        { scm_list(3, SYM(define), scm_list(2, SYM(f), SYM(x)), scm_list(3, SYM(g), SYM(x), nums)), 20,
+          "(define\n (f x)\n (g\n  x\n  (1 2 3 4 5 6 7 8 9\n   10 11 12)))" },
+        { scm_vector_new(3, SYM(aaaaaa), SYM(bbbbbb), SYM(cccccc)), 12, "#(aaaaaa\n  bbbbbb\n  cccccc)" },
+        { scm_cons(SYM(aaaaaa), SYM(bbbbbb)), 10, "(aaaaaa\n . bbbbbb)" },
+        { cyc, 10, "#0=(aaaa\n    bbbb\n    . #0#)" },
+    };
+
+    int n = sizeof(cases) / sizeof(cases[0]);
+    for (int i = 0; i < n; ++i) {
+        scm_object *oport = string_output_port_open();
+        size_t len = scm_pretty_print(oport, cases[i].obj, cases[i].width);
+        REQUIRE_STREQ(scm_output_port_string(oport, NULL), cases[i].expected, "i=%d", i);
+        REQUIRE_EQ(len, strlen(cases[i].expected), "i=%d", i);
+        scm_object_free(oport);
+    }
+}
+
+TEST(write, pretty_print_large) {
+    TEST_INIT();
+    long len;
+
+    /* deep nesting keeps its indentation bounded */
+    int depth = 200000;
+    scm_object *obj = scm_null;
+    for (int i = 0; i < depth; ++i)
+        obj = scm_list(2, SYM(node), obj);
+
+    scm_object *oport = string_output_port_open();
+    scm_pretty_print(oport, obj, 40);
+    const char *s = scm_output_port_string(oport, &len);
+    REQUIRE(len < depth * 40L, "len=%ld", len);
+    REQUIRE(!strncmp(s, "(node\n (node\n  (node", 20));
+    scm_object_free(oport);
+
+    /* a long list is written in lines of at most the width */
+    obj = scm_null;
+    for (int i = 0; i < depth; ++i)
+        obj = scm_cons(INTEGER(i % 1000), obj);
+
+    oport = string_output_port_open();
+    scm_pretty_print(oport, obj, 40);
+    s = scm_output_port_string(oport, &len);
+    int col = 0, max_col = 0;
+    for (long i = 0; i < len; ++i) {
+        col = s[i] == '\n' ? 0 : col + 1;
+        max_col = col > max_col ? col : max_col;
+    }
+    REQUIRE(max_col <= 40, "max_col=%d", max_col);
+    scm_object_free(oport);
+}
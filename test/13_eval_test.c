@@ -383,3 +383,26 @@ TEST(eval, application) {
     REQUIRE_EQ(vec->type, scm_type_vector);
     REQUIRE_EQ(scm_vector_length(vec), 2);
 }
+
+TEST(eval, arguments) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        /* more arguments than fit the buffer on the stack */
+        {"(+ 1 2 3 4 5 6 7 8 9 10 11 12)", "78"},
+        {"(define (f a b c d e f g h i j) (list j i a)) (f 1 2 3 4 5 6 7 8 9 10)", "(10 9 1)"},
+        {"(define (f a . r) (cons r a)) (f 1 2 3 4 5 6 7 8 9 10)", "((2 3 4 5 6 7 8 9 10) . 1)"},
+        {"(define (f . r) r) (f)", "()"},
+        {"(define (f a b . r) r) (f 1 2)", "()"},
+        /* the arguments a primitive keeps are not overwritten by the next call */
+        {"(define (f . r) r) (define a (f 1 2)) (define b (list 3 4)) (f a b (list 5 6))", "((1 2) (3 4) (5 6))"},
+        {"(define (f . r) r) (map f '(1 2) '(3 4) '(5 6))", "((1 3 5) (2 4 6))"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("f: arity mismatch", eval_string("(define (f a b) a) (f 1 2 3 4 5 6 7 8 9 10)"));
+    /* an operand throwing after the arguments moved off the stack */
+    REQUIRE_EXC("car: contract violation", eval_string("(+ 1 2 3 4 5 6 7 8 9 (car 1))"));
+    REQUIRE_NOEXC(eval_string("(+ 1 2 3 4 5 6 7 8 9 10)"), "after a throw");
+}
@@ -96,35 +96,56 @@ TEST(proc, check_arity) {
 
 }
 
+static scm_object *scm_is_a(scm_object *obj) {
+    return scm_boolean(obj == scm_chars['a']);
+}
+define_primitive_1(is_a);
+
 TEST(proc, check_contract) {
     TEST_INIT();
 
+    scm_object *pred_a = scm_primitive_new("a?", prim_is_a, 1, 1, NULL);
+
     scm_object *p1 = scm_primitive_new("p1", NULL, 3, 3, pred_boolean);
-    REQUIRE_NOEXC(scm_procedure_check_contract(p1, scm_list(3, scm_true, scm_true, scm_true)));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p1, 3, (scm_object *[]){scm_true, scm_true, scm_true}));
     REQUIRE_EXC("p1: contract violation by argument #1\nexpected: boolean?\ngiven: ()",
-                scm_procedure_check_contract(p1, scm_list(3, scm_null, scm_true, scm_true)));
+                scm_procedure_check_contract(p1, 3, (scm_object *[]){scm_null, scm_true, scm_true}));
     REQUIRE_EXC("p1: contract violation by argument #2\nexpected: boolean?\ngiven: ()",
-                scm_procedure_check_contract(p1, scm_list(3, scm_true, scm_null, scm_true)));
+                scm_procedure_check_contract(p1, 3, (scm_object *[]){scm_true, scm_null, scm_true}));
     REQUIRE_EXC("p1: contract violation by argument #3\nexpected: boolean?\ngiven: ()",
-                scm_procedure_check_contract(p1, scm_list(3, scm_true, scm_true, scm_null)));
+                scm_procedure_check_contract(p1, 3, (scm_object *[]){scm_true, scm_true, scm_null}));
 
     scm_object *p2 = scm_primitive_new("p2", NULL, 3, 3, scm_cons(pred_boolean, pred_char));
-    REQUIRE_NOEXC(scm_procedure_check_contract(p2, scm_list(3, scm_true, scm_chars['a'], scm_chars['b'])));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p2, 3, (scm_object *[]){scm_true, scm_chars['a'], scm_chars['b']}));
     REQUIRE_EXC("p2: contract violation by argument #1\nexpected: boolean?\ngiven: ()",
-                scm_procedure_check_contract(p2, scm_list(3, scm_null, scm_chars['a'], scm_chars['b'])));
+                scm_procedure_check_contract(p2, 3, (scm_object *[]){scm_null, scm_chars['a'], scm_chars['b']}));
     REQUIRE_EXC("p2: contract violation by argument #2\nexpected: char?\ngiven: ()",
-                scm_procedure_check_contract(p2, scm_list(3, scm_true, scm_null, scm_chars['b'])));
+                scm_procedure_check_contract(p2, 3, (scm_object *[]){scm_true, scm_null, scm_chars['b']}));
     REQUIRE_EXC("p2: contract violation by argument #3\nexpected: char?\ngiven: ()",
-                scm_procedure_check_contract(p2, scm_list(3, scm_true, scm_chars['a'], scm_null)));
+                scm_procedure_check_contract(p2, 3, (scm_object *[]){scm_true, scm_chars['a'], scm_null}));
 
     scm_object *p3 = scm_primitive_new("p3", NULL, 3, 3, scm_list(2, pred_boolean, pred_char));
-    REQUIRE_NOEXC(scm_procedure_check_contract(p3, scm_list(3, scm_true, scm_chars['a'], scm_true)));
-    REQUIRE_NOEXC(scm_procedure_check_contract(p3, scm_list(3, scm_true, scm_chars['a'], scm_chars['b'])));
-    REQUIRE_NOEXC(scm_procedure_check_contract(p3, scm_list(3, scm_true, scm_chars['a'], scm_null)));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p3, 3, (scm_object *[]){scm_true, scm_chars['a'], scm_true}));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p3, 3, (scm_object *[]){scm_true, scm_chars['a'], scm_chars['b']}));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p3, 3, (scm_object *[]){scm_true, scm_chars['a'], scm_null}));
     REQUIRE_EXC("p3: contract violation by argument #1\nexpected: boolean?\ngiven: ()",
-                scm_procedure_check_contract(p3, scm_list(3, scm_null, scm_chars['a'], scm_null)));
+                scm_procedure_check_contract(p3, 3, (scm_object *[]){scm_null, scm_chars['a'], scm_null}));
     REQUIRE_EXC("p3: contract violation by argument #2\nexpected: char?\ngiven: ()",
-                scm_procedure_check_contract(p3, scm_list(3, scm_true, scm_null, scm_null)));
+                scm_procedure_check_contract(p3, 3, (scm_object *[]){scm_true, scm_null, scm_null}));
+
+    /* a predicate not made by its types is called */
+    scm_object *p4 = scm_primitive_new("p4", NULL, 1, -1, scm_cons(pred_integer, pred_a));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p4, 3, (scm_object *[]){INTEGER(1), scm_chars['a'], scm_chars['a']}));
+    REQUIRE_EXC("p4: contract violation by argument #1\nexpected: integer?\ngiven: #\\a",
+                scm_procedure_check_contract(p4, 2, (scm_object *[]){scm_chars['a'], scm_chars['a']}));
+    REQUIRE_EXC("p4: contract violation by argument #3\nexpected: a?\ngiven: #\\b",
+                scm_procedure_check_contract(p4, 3, (scm_object *[]){INTEGER(1), scm_chars['a'], scm_chars['b']}));
+
+    scm_object *p5 = scm_primitive_new("p5", NULL, 0, -1, pred_number);
+    REQUIRE_NOEXC(scm_procedure_check_contract(p5, 0, NULL));
+    REQUIRE_NOEXC(scm_procedure_check_contract(p5, 2, (scm_object *[]){INTEGER(1), scm_number_new_float("0.5")}));
+    REQUIRE_EXC("p5: contract violation by argument #2\nexpected: number?\ngiven: \"1\"",
+                scm_procedure_check_contract(p5, 2, (scm_object *[]){INTEGER(1), scm_string_copy_new("1", 1)}));
 }
 
 static scm_object *scm_0() {
@@ -147,23 +168,30 @@ static scm_object *scm_3(scm_object *p1, scm_object *p2, scm_object *p3) {
 }
 define_primitive_3(3);
 
-static scm_object *scm_0n(int n, scm_object *l) {
-    return scm_cons(INTEGER(n), l);
+static scm_object *rest_list(int n, scm_object **rest) {
+    scm_object *l = scm_null;
+    while (n--)
+        l = scm_cons(rest[n], l);
+    return l;
+}
+
+static scm_object *scm_0n(int n, scm_object **rest) {
+    return scm_cons(INTEGER(n), rest_list(n, rest));
 }
 define_primitive_0n(0n);
 
-static scm_object *scm_1n(int n, scm_object *p1, scm_object *l) {
-    return scm_cons(INTEGER(n), scm_cons(p1, l));
+static scm_object *scm_1n(int n, scm_object *p1, scm_object **rest) {
+    return scm_cons(INTEGER(n), scm_cons(p1, rest_list(n - 1, rest)));
 }
 define_primitive_1n(1n);
 
-static scm_object *scm_2n(int n, scm_object *p1, scm_object *p2, scm_object *l) {
-    return scm_cons(INTEGER(n), scm_cons(p1, scm_cons(p2, l)));
+static scm_object *scm_2n(int n, scm_object *p1, scm_object *p2, scm_object **rest) {
+    return scm_cons(INTEGER(n), scm_cons(p1, scm_cons(p2, rest_list(n - 2, rest))));
 }
 define_primitive_2n(2n);
 
-static scm_object *scm_3n(int n, scm_object *p1, scm_object *p2, scm_object *p3, scm_object *l) {
-    return scm_cons(INTEGER(n), scm_cons(p1, scm_cons(p2, scm_cons(p3, l))));
+static scm_object *scm_3n(int n, scm_object *p1, scm_object *p2, scm_object *p3, scm_object **rest) {
+    return scm_cons(INTEGER(n), scm_cons(p1, scm_cons(p2, scm_cons(p3, rest_list(n - 3, rest)))));
 }
 define_primitive_3n(3n);
 
@@ -174,16 +202,11 @@ TEST(proc, primitive_apply) {
         scm_primitive_new("2", prim_2, 2, 2, NULL),
         scm_primitive_new("3", prim_3, 3, 3, NULL),
     };
-    scm_object *args[] = {
-        scm_null,
-        scm_list(1, scm_true),
-        scm_list(2, scm_true, scm_false),
-        scm_list(3, scm_true, scm_false, scm_null),
-    };
+    scm_object *args[] = {scm_true, scm_false, scm_null, scm_void};
 
     int n = sizeof(procs) / sizeof(scm_object *);
     for (int i = 0; i < n; ++i) {
-        REQUIRE_OBJ_EQUAL(scm_primitive_apply(procs[i], i, args[i]), args[i], "i=%d", i);
+        REQUIRE_OBJ_EQUAL(scm_primitive_apply(procs[i], i, args), rest_list(i, args), "i=%d", i);
     }
 
     scm_object *procs2[] = {
@@ -193,26 +216,17 @@ TEST(proc, primitive_apply) {
         scm_primitive_new("3n", prim_3n, 3, -1, NULL),
     };
 
-    scm_object *args2[] = {
-        scm_null,
-        scm_list(1, scm_true),
-        scm_list(2, scm_true, scm_false),
-        scm_list(3, scm_true, scm_false, scm_null),
-        scm_list(4, scm_true, scm_false, scm_null, scm_void),
-    };
-
     n = sizeof(procs2) / sizeof(scm_object *);
     scm_object *o;
     for (int i = 0; i < n; ++i) {
-        o = scm_primitive_apply(procs2[i], i, args2[i]);
+        o = scm_primitive_apply(procs2[i], i, args);
         REQUIRE_OBJ_EQUAL(scm_car(o), INTEGER(i), "i=%d", i);
-        REQUIRE_OBJ_EQUAL(scm_cdr(o), args2[i], "i=%d", i);
+        REQUIRE_OBJ_EQUAL(scm_cdr(o), rest_list(i, args), "i=%d", i);
 
-        o = scm_primitive_apply(procs2[i], i+1, args2[i+1]);
+        o = scm_primitive_apply(procs2[i], i+1, args);
         REQUIRE_OBJ_EQUAL(scm_car(o), INTEGER(i+1), "i=%d", i);
-        REQUIRE_OBJ_EQUAL(scm_cdr(o), args2[i+1], "i=%d", i);
+        REQUIRE_OBJ_EQUAL(scm_cdr(o), rest_list(i+1, args), "i=%d", i);
     }
-
 }
 
 TEST(proc, compound_apply) {
@@ -229,7 +243,7 @@ TEST(proc, compound_apply) {
                                         scm_list(2, scm_list(3, set, a, scm_true),
                                                  scm_list(3, cons, x, b)), env);
     scm_object *o;
-    o = scm_compound_apply(comp, scm_list(1, scm_null)); 
+    o = scm_compound_apply(comp, 1, (scm_object *[]){scm_null}); 
     /* return the value of the last expression */
     REQUIRE_OBJ_EQUAL(o, scm_cons(scm_null, scm_cons(scm_true, scm_false)));
     /* the whole body gets evaluated */
@@ -237,7 +251,7 @@ TEST(proc, compound_apply) {
 
     /* variadic parameter */
     scm_object *comp2 = scm_compound_new(scm_cons(x, y), scm_list(1, scm_list(3, cons, y, x)), env);
-    o = scm_compound_apply(comp2, scm_list(3, scm_chars['a'], scm_chars['b'], scm_chars['c']));
+    o = scm_compound_apply(comp2, 3, (scm_object *[]){scm_chars['a'], scm_chars['b'], scm_chars['c']});
     REQUIRE_OBJ_EQUAL(o, scm_cons(scm_list(2, scm_chars['b'], scm_chars['c']), scm_chars['a']));
 }
 
@@ -0,0 +1,134 @@
+#include "test.h"
+
+TAU_MAIN()
+
+TEST(hashtable, hash) {
+    TEST_INIT();
+
+    scm_object *objs[][2] = {
+        { INTEGER(42), INTEGER(42) },
+        { scm_number_new_float("-0.0"), scm_number_new_float("0.0") },
+        { scm_bignum_from_string("123456789012345678901234567890", 30, 10),
+          scm_bignum_from_string("123456789012345678901234567890", 30, 10) },
+        { scm_rational_new(INTEGER(2), INTEGER(6)), scm_rational_new(INTEGER(-1), INTEGER(-3)) },
+        { SYM(abc), SYM(abc) },
+    };
+    int n = sizeof(objs) / sizeof(objs[0]);
+    for (int i = 0; i < n; ++i) {
+        CHECK(scm_eqv(objs[i][0], objs[i][1]), "i=%d", i);
+        CHECK_EQ(scm_eqv_hash(objs[i][0]), scm_eqv_hash(objs[i][1]), "i=%d", i);
+        CHECK_EQ(scm_equal_hash(objs[i][0]), scm_equal_hash(objs[i][1]), "i=%d", i);
+    }
+
+    scm_object *s1 = scm_string_copy_new("abc", 3);
+    scm_object *s2 = scm_string_copy_new("abc", 3);
+    scm_object *l1 = scm_list(3, INTEGER(1), s1, scm_vector_new(2, SYM(x), scm_chars['c']));
+    scm_object *l2 = scm_list(3, INTEGER(1), s2, scm_vector_new(2, SYM(x), scm_chars['c']));
+    REQUIRE(scm_equal(l1, l2), "equal lists");
+    REQUIRE_EQ(scm_equal_hash(s1), scm_equal_hash(s2));
+    REQUIRE_EQ(scm_equal_hash(l1), scm_equal_hash(l2));
+
+    /* only a bounded prefix of a cyclic list is hashed */
+    scm_object *cycle = scm_list(2, INTEGER(1), INTEGER(2));
+    scm_set_cdr(scm_cdr(cycle), cycle);
+    REQUIRE_NOEXC(scm_equal_hash(cycle));
+}
+
+TEST(hashtable, ref_set_delete) {
+    scm_object *keys[1000];
+    char name[16];
+    TEST_INIT();
+
+    scm_object *t = scm_eqv_hashtable_new();
+    REQUIRE_EQ(t->type, scm_type_hashtable);
+    REQUIRE_EQ(scm_hashtable_ref(t, SYM(a), NULL), NULL);
+
+    /* keys equal to the ones stored but of other objects */
+    for (int i = 0; i < 1000; ++i) {
+        snprintf(name, sizeof(name), "k%d", i);
+        keys[i] = scm_symbol_new(name, -1);
+        scm_hashtable_set(t, keys[i], INTEGER(i));
+    }
+    REQUIRE_EQ(scm_hashtable_count(t), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        snprintf(name, sizeof(name), "k%d", i);
+        scm_object *v = scm_hashtable_ref(t, scm_symbol_new(name, -1), NULL);
+        REQUIRE(v, "i=%d", i);
+        REQUIRE_EQ(scm_integer_get_val(v), i);
+    }
+
+    for (int i = 0; i < 1000; i += 2)
+        REQUIRE(scm_hashtable_delete(t, keys[i]), "i=%d", i);
+    REQUIRE(!scm_hashtable_delete(t, keys[0]), "deleted twice");
+    REQUIRE_EQ(scm_hashtable_count(t), 500);
+    for (int i = 0; i < 1000; ++i)
+        CHECK_EQ(scm_hashtable_ref(t, keys[i], NULL) != NULL, i % 2, "i=%d", i);
+
+    scm_hashtable_set(t, keys[1], scm_true);
+    REQUIRE_EQ(scm_hashtable_ref(t, keys[1], NULL), scm_true);
+    REQUIRE_EQ(scm_hashtable_count(t), 500);
+    REQUIRE_EQ(scm_list_length(scm_hashtable_to_alist(t)), 500);
+
+    scm_object *c = scm_hashtable_copy(t);
+    scm_hashtable_clear(t);
+    REQUIRE_EQ(scm_hashtable_count(t), 0);
+    REQUIRE_EQ(scm_hashtable_ref(t, keys[1], NULL), NULL);
+    REQUIRE_EQ(scm_hashtable_count(c), 500);
+    REQUIRE_EQ(scm_hashtable_ref(c, keys[1], NULL), scm_true);
+
+    scm_object_free(t);
+    scm_object_free(c);
+}
+
+TEST(hashtable, equal_keys) {
+    TEST_INIT();
+
+    scm_object *eqv = scm_eqv_hashtable_new();
+    scm_object *equal = scm_equal_hashtable_new();
+    scm_object *k1 = scm_list(2, scm_string_copy_new("a", 1), INTEGER(1));
+    scm_object *k2 = scm_list(2, scm_string_copy_new("a", 1), INTEGER(1));
+
+    scm_hashtable_set(eqv, k1, scm_true);
+    scm_hashtable_set(equal, k1, scm_true);
+    REQUIRE_EQ(scm_hashtable_ref(eqv, k2, scm_false), scm_false);
+    REQUIRE_EQ(scm_hashtable_ref(equal, k2, scm_false), scm_true);
+
+    scm_object_free(eqv);
+    scm_object_free(equal);
+}
+
+TEST(hashtable, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(hash-table? (make-hash-table))", "#t"}, {"(hash-table? '())", "#f"},
+        {"(define h (make-eq-hash-table)) (hash-table-set! h 'a 1) (hash-table-ref h 'a)", "1"},
+        {"(hash-table-ref (make-hash-table) 'a (lambda () 'none))", "none"},
+        {"(hash-table-ref/default (make-eqv-hash-table) 1 #f)", "#f"},
+        {"(define h (make-hash-table)) (hash-table-set! h \"k\" 1) (hash-table-ref/default h \"k\" #f)", "1"},
+        {"(define h (make-hash-table eqv?)) (hash-table-set! h \"k\" 1) (hash-table-ref/default h \"k\" #f)", "#f"},
+        {"(define h (make-equal-hash-table)) (hash-table-set! h '(1 #(2)) 1) (hash-table-exists? h (list 1 (vector 2)))", "#t"},
+        {"(define h (make-eqv-hash-table)) (hash-table-set! h 1/2 'x) (hash-table-delete! h 2/4) (hash-table-size h)", "0"},
+        {"(define h (make-hash-table)) (hash-table-update! h 'a (lambda (x) (+ x 1)) (lambda () 0)) "
+         "(hash-table-update!/default h 'a (lambda (x) (* x 10)) 0) (hash-table-ref h 'a)", "10"},
+        {"(hash-table->alist (alist->hash-table '((a . 1) (a . 2))))", "((a . 1))"},
+        {"(hash-table-keys (alist->hash-table '((a . 1))))", "(a)"},
+        {"(hash-table-values (alist->hash-table '((a . 1))))", "(1)"},
+        {"(hash-table-fold (alist->hash-table '((a . 1) (b . 2) (c . 3))) (lambda (k v acc) (+ v acc)) 0)", "6"},
+        {"(define h (alist->hash-table '((a . 1) (b . 2)))) "
+         "(hash-table-walk h (lambda (k v) (hash-table-delete! h k))) (hash-table-size h)", "0"},
+        {"(define h (make-hash-table (lambda (a b) (= a b)) (lambda (x) (exact->inexact x)))) "
+         "(hash-table-set! h 1 'one) (hash-table-ref h 1.0)", "one"},
+        {"(= (hash '(1 \"a\")) (hash (list 1 \"a\")))", "#t"},
+        {"(< (hash-by-identity 'abc 10) 10)", "#t"}, {"(= (string-hash \"ab\") (string-hash \"ab\"))", "#t"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("hash-table-ref: no value found for key\nkey: a", eval_string("(hash-table-ref (make-hash-table) 'a)"));
+    REQUIRE_EXC("hash-table-set!: contract violation by argument #1\nexpected: hash-table?",
+                eval_string("(hash-table-set! '() 1 2)"));
+    REQUIRE_EXC("make-hash-table: contract violation by argument #1\nexpected: procedure?",
+                eval_string("(make-hash-table 1)"));
+    REQUIRE_EXC("hash: contract violation by argument #2", eval_string("(hash 'a 0)"));
+}
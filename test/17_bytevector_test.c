@@ -0,0 +1,70 @@
+#include "test.h"
+
+TAU_MAIN()
+
+TEST(bytevector, new) {
+    TEST_INIT();
+
+    scm_object *bv = scm_bytevector_new(16);
+    REQUIRE_EQ(bv->type, scm_type_bytevector);
+    REQUIRE_EQ(scm_bytevector_size(bv), 16);
+    for (int i = 0; i < 16; ++i)
+        CHECK_EQ(scm_bytevector_data(bv)[i], 0, "i=%d", i);
+
+    scm_object *c1 = scm_bytevector_copy_new("abc", 3);
+    scm_object *c2 = scm_bytevector_copy_new("abc", 3);
+    REQUIRE(!scm_eqv(c1, c2), "eqv");
+    REQUIRE(scm_equal(c1, c2), "equal");
+    REQUIRE_EQ(scm_equal_hash(c1), scm_equal_hash(c2));
+    REQUIRE(!scm_equal(c1, scm_bytevector_copy_new("abd", 3)), "not equal");
+
+    scm_object_free(bv);
+    scm_object_free(c1);
+    scm_object_free(c2);
+}
+
+TEST(bytevector, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(bytevector? (bytevector))", "#t"}, {"(bytevector? (vector))", "#f"},
+        {"(make-bytevector 3 7)", "#u8(7 7 7)"}, {"(bytevector 1 2 255)", "#u8(1 2 255)"},
+        {"(bytevector-length (make-bytevector 5))", "5"},
+        {"(define b (bytevector 1 2 3)) (bytevector-u8-set! b 0 9) (bytevector-u8-ref b 0)", "9"},
+        {"(define b (make-bytevector 8 0)) (bytevector-u16-native-set! b 1 65535) "
+         "(list (bytevector-u16-native-ref b 1) (bytevector-u8-ref b 1) (bytevector-u8-ref b 3))", "(65535 255 0)"},
+        {"(define b (make-bytevector 8 0)) (bytevector-u32-native-set! b 3 4294967295) "
+         "(bytevector-u32-native-ref b 3)", "4294967295"},
+        {"(define b (make-bytevector 9 0)) (bytevector-ieee-double-native-set! b 1 1/4) "
+         "(bytevector-ieee-double-native-ref b 1)", "0.25"},
+        {"(bytevector-copy (bytevector 1 2 3 4) 1 3)", "#u8(2 3)"}, {"(bytevector-copy (bytevector 1 2) 2)", "#u8()"},
+        {"(define b (bytevector 1 2 3 4 5)) (bytevector-copy! b 1 b 0 3) b", "#u8(1 1 2 3 5)"},
+        {"(define b (bytevector 1 2 3 4 5)) (bytevector-copy! b 0 b 2) b", "#u8(3 4 5 4 5)"},
+        {"(bytevector-append (bytevector 1) (bytevector) (bytevector 2 3))", "#u8(1 2 3)"},
+        {"(define b (make-bytevector 4 0)) (bytevector-fill! b 6 1 3) b", "#u8(0 6 6 0)"},
+        {"(bytevector=? (bytevector 1 2) (bytevector 1 2) (bytevector 1 2))", "#t"},
+        {"(bytevector=? (bytevector 1 2) (bytevector 1))", "#f"},
+        {"(list (bytevector-compare (bytevector 1 2) (bytevector 1 3)) (bytevector-compare (bytevector 1 2) (bytevector 1)) "
+         "(bytevector-compare (bytevector 200) (bytevector 100)) (bytevector-compare (bytevector) (bytevector)))", "(-1 1 1 0)"},
+        {"(string->utf8 \"aλ\")", "#u8(97 206 187)"}, {"(utf8->string (bytevector 97 206 187 98) 1)", "\"λb\""},
+        {"(equal? (bytevector 1 2) (bytevector 1 2))", "#t"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("bytevector-u8-ref: index is out of range\nindex: 3\nvalid range: [0, 2]",
+                eval_string("(bytevector-u8-ref (bytevector 1 2 3) 3)"));
+    REQUIRE_EXC("bytevector-u32-native-ref: index is out of range\nindex: 1\nvalid range: [0, 0]",
+                eval_string("(bytevector-u32-native-ref (make-bytevector 4) 1)"));
+    REQUIRE_EXC("bytevector-u32-native-ref: index is out of range\nindex: 9223372036854775807\n"
+                "valid range: [0, 0]",
+                eval_string("(bytevector-u32-native-ref (make-bytevector 4 0) 9223372036854775807)"));
+    REQUIRE_EXC("bytevector-u8-set!: contract violation by argument #3\nexpected: byte?",
+                eval_string("(bytevector-u8-set! (bytevector 1) 0 256)"));
+    REQUIRE_EXC("bytevector-copy!: not enough room in the destination",
+                eval_string("(bytevector-copy! (make-bytevector 2) 1 (bytevector 1 2))"));
+    REQUIRE_EXC("bytevector-copy: ending index is out of range",
+                eval_string("(bytevector-copy (bytevector 1 2) 1 3)"));
+    REQUIRE_EXC("bytevector-length: contract violation by argument #1\nexpected: bytevector?",
+                eval_string("(bytevector-length \"a\")"));
+}
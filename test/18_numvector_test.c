@@ -0,0 +1,124 @@
+#include "test.h"
+
+TAU_MAIN()
+
+TEST(numvector, new) {
+    TEST_INIT();
+
+    scm_object *v = scm_numvector_new(SCM_F64VECTOR, 5);
+    REQUIRE_EQ(v->type, scm_type_numvector);
+    REQUIRE_EQ(scm_numvector_kind(v), SCM_F64VECTOR);
+    REQUIRE_EQ(scm_numvector_length(v), 5);
+    for (int i = 0; i < 5; ++i)
+        CHECK_EQ(((double *)scm_numvector_data(v))[i], 0.0, "i=%d", i);
+
+    /* the u8vectors are the bytevectors */
+    scm_object *u = scm_numvector_new(SCM_U8VECTOR, 3);
+    REQUIRE_EQ(u->type, scm_type_bytevector);
+    REQUIRE_EQ(scm_numvector_kind(u), SCM_U8VECTOR);
+    REQUIRE_EQ(scm_numvector_kind(scm_null), -1);
+
+    scm_object *s1 = scm_numvector_new(SCM_S64VECTOR, 2);
+    scm_object *s2 = scm_numvector_new(SCM_S64VECTOR, 2);
+    REQUIRE(scm_equal(s1, s2), "equal");
+    REQUIRE_EQ(scm_equal_hash(s1), scm_equal_hash(s2));
+    ((int64_t *)scm_numvector_data(s2))[1] = -1;
+    REQUIRE(!scm_equal(s1, s2), "not equal");
+
+    scm_object_free(v);
+    scm_object_free(u);
+    scm_object_free(s1);
+    scm_object_free(s2);
+}
+
+/* the vector loops against the scalar tails, over lengths around the lanes */
+TEST(numvector, kernels) {
+    TEST_INIT();
+
+    for (long len = 1; len < 40; ++len) {
+        scm_object *a = scm_numvector_new(SCM_F64VECTOR, len), *b = scm_numvector_new(SCM_F64VECTOR, len);
+        scm_object *u = scm_numvector_new(SCM_U8VECTOR, len), *s = scm_numvector_new(SCM_S64VECTOR, len);
+        double *x = scm_numvector_data(a), *y = scm_numvector_data(b), dot = 0, sum = 0;
+        uint8_t *p = scm_numvector_data(u);
+        int64_t *q = scm_numvector_data(s);
+        long usum = 0, ssum = 0, umax = 0;
+
+        for (long i = 0; i < len; ++i) {
+            x[i] = (i * 7) % 11 - 5;
+            y[i] = i + 1;
+            p[i] = (i * 37) % 256;
+            q[i] = (i % 2 ? -1 : 1) * i * 1000;
+            dot += x[i] * y[i];
+            sum += x[i];
+            usum += p[i];
+            umax = p[i] > umax ? p[i] : umax;
+            ssum += q[i];
+        }
+        scm_env_define_var(scm_global_env(), SYM(a), a);
+        scm_env_define_var(scm_global_env(), SYM(b), b);
+        scm_env_define_var(scm_global_env(), SYM(u), u);
+        scm_env_define_var(scm_global_env(), SYM(s), s);
+
+        CHECK_EQ(scm_float_get_val(eval_string("(f64vector-dot a b)")), dot, "len=%ld", len);
+        CHECK_EQ(scm_float_get_val(eval_string("(f64vector-sum a)")), sum, "len=%ld", len);
+        CHECK_EQ(scm_float_get_val(eval_string("(f64vector-min a)")), len > 1 ? -5.0 : x[0], "len=%ld", len);
+        CHECK_EQ(scm_float_get_val(eval_string("(f64vector-max b)")), (double)len, "len=%ld", len);
+        CHECK_EQ(scm_integer_get_val(eval_string("(u8vector-sum u)")), usum, "len=%ld", len);
+        CHECK_EQ(scm_integer_get_val(eval_string("(s64vector-sum s)")), ssum, "len=%ld", len);
+        CHECK_EQ(scm_integer_get_val(eval_string("(u8vector-max u)")), umax, "len=%ld", len);
+
+        scm_object *r = eval_string("(f64vector-add a b)");
+        scm_object *d = eval_string("(u8vector-sub u (u8vector-add u u))");
+        scm_object *m = eval_string("(s64vector-mul s s)");
+        for (long i = 0; i < len; ++i) {
+            CHECK_EQ(((double *)scm_numvector_data(r))[i], x[i] + y[i], "len=%ld i=%ld", len, i);
+            CHECK_EQ(((uint8_t *)scm_numvector_data(d))[i], (uint8_t)-p[i], "len=%ld i=%ld", len, i);
+            CHECK_EQ(((int64_t *)scm_numvector_data(m))[i], q[i] * q[i], "len=%ld i=%ld", len, i);
+        }
+    }
+}
+
+TEST(numvector, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(f64vector? (f64vector 1))", "#t"}, {"(f64vector? (s64vector 1))", "#f"},
+        {"(u8vector? (bytevector 1))", "#t"}, {"(make-u8vector 2 7)", "#u8(7 7)"},
+        {"(make-f64vector 2 1/2)", "#f64(0.5 0.5)"}, {"(s64vector -1 0 9223372036854775807)", "#s64(-1 0 9223372036854775807)"},
+        {"(f64vector)", "#f64()"}, {"(s64vector-length (make-s64vector 4))", "4"},
+        {"(define v (f64vector 1 2 3)) (f64vector-set! v 1 -1) (f64vector-ref v 1)", "-1.0"},
+        {"(s64vector->list (s64vector 1 2))", "(1 2)"}, {"(list->f64vector '(1 2.5))", "#f64(1.0 2.5)"},
+        {"(f64vector-div (f64vector 1 3) (f64vector 2 4))", "#f64(0.5 0.75)"},
+        {"(u8vector-mul (u8vector 16 3) (u8vector 16 4))", "#u8(0 12)"},
+        {"(s64vector-add (s64vector 9223372036854775807) (s64vector 1))", "#s64(-9223372036854775808)"},
+        {"(s64vector-sum (s64vector 9223372036854775807 9223372036854775807 -9223372036854775807))",
+         "9223372036854775807"},
+        {"(s64vector-sum (s64vector 9223372036854775807 1))", "9223372036854775808"},
+        {"(s64vector-dot (s64vector 4294967296 1) (s64vector 4294967296 -1))", "18446744073709551615"},
+        {"(u8vector-dot (u8vector 255 255) (u8vector 255 255))", "130050"},
+        {"(s64vector-min (s64vector 3 -7 2))", "-7"}, {"(u8vector-min (u8vector 3 1 2))", "1"},
+        {"(f64vector-map (lambda (x y) (* x y)) (f64vector 1 2 3) (f64vector 4 5))", "#f64(4.0 10.0)"},
+        {"(s64vector-map (lambda (x) (- x)) (s64vector 1 2))", "#s64(-1 -2)"},
+        {"(equal? (f64vector 1 2) (f64vector 1 2))", "#t"}, {"(equal? (f64vector 1) (s64vector 1))", "#f"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("f64vector-ref: index is out of range\nindex: 2\nvalid range: [0, 1]",
+                eval_string("(f64vector-ref (f64vector 1 2) 2)"));
+    REQUIRE_EXC("s64vector-ref: index is out of range for empty vector\nindex: 0",
+                eval_string("(s64vector-ref (s64vector) 0)"));
+    REQUIRE_EXC("u8vector-set!: contract violation by argument #3\nexpected: byte?",
+                eval_string("(u8vector-set! (u8vector 1) 0 -1)"));
+    REQUIRE_EXC("s64vector: contract violation by argument #2\nexpected: fixnum?",
+                eval_string("(s64vector 1 1.5)"));
+    REQUIRE_EXC("f64vector-add: vectors of different lengths\nlength: 1",
+                eval_string("(f64vector-add (f64vector 1) (f64vector 1 2))"));
+    REQUIRE_EXC("f64vector-add: contract violation by argument #2\nexpected: f64vector?",
+                eval_string("(f64vector-add (f64vector 1) (s64vector 1))"));
+    REQUIRE_EXC("f64vector-max: empty vector", eval_string("(f64vector-max (f64vector))"));
+    REQUIRE_EXC("u8vector-map: result of the wrong type\nexpected: byte?",
+                eval_string("(u8vector-map (lambda (x) 256) (u8vector 1))"));
+    REQUIRE_EXC("list->s64vector: element of the wrong type\nexpected: fixnum?",
+                eval_string("(list->s64vector '(1 a))"));
+}
@@ -0,0 +1,68 @@
+#include "test.h"
+
+TAU_MAIN()
+
+TEST(record, type) {
+    TEST_INIT();
+
+    scm_object *rtd = scm_record_type_new(SYM(<point>), scm_list(2, SYM(x), SYM(y)));
+    REQUIRE_EQ(rtd->type, scm_type_record_type);
+    REQUIRE_STREQ(scm_record_type_name(rtd), "<point>");
+    REQUIRE_EQ(scm_record_type_field_count(rtd), 2);
+    REQUIRE_EQ(scm_record_type_field_index(rtd, SYM(y)), 1);
+    REQUIRE_EQ(scm_record_type_field_index(rtd, SYM(z)), -1);
+
+    /* the constructor may leave out fields and take them in any order */
+    scm_object *make = scm_record_constructor(rtd, SYM(make-point), scm_list(1, SYM(y)));
+    scm_object *r = scm_apply(make, 1, (scm_object *[]){INTEGER(2)});
+    REQUIRE_EQ(r->type, scm_type_record);
+    REQUIRE_EQ(scm_record_type(r), rtd);
+    REQUIRE_EQ(scm_record_ref(r, 0), scm_false);
+    REQUIRE_EQ(scm_integer_get_val(scm_record_ref(r, 1)), 2);
+    scm_record_set(r, 0, scm_true);
+    REQUIRE_EQ(scm_apply(scm_record_accessor(rtd, SYM(point-x), 0), 1, (scm_object *[]){r}), scm_true);
+    REQUIRE_EQ(scm_apply(scm_record_predicate(rtd, SYM(point?)), 1, (scm_object *[]){r}), scm_true);
+    REQUIRE(!scm_equal(r, scm_apply(make, 1, (scm_object *[]){INTEGER(2)})), "equal");
+}
+
+TEST(record, define_record_type) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) (y point-y)) "
+         "(define p (make-point 1 2)) (list (point? p) (point-x p) (point-y p))", "(#t 1 2)"},
+        {"(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) (y point-y)) "
+         "(define p (make-point 1 2)) (set-point-x! p 'a) (point-x p)", "a"},
+        {"(define-record-type <point> (make-point x y) point? (x point-x) (y point-y)) "
+         "(list (point? (vector 1 2)) (point? 1))", "(#f #f)"},
+        {"(define-record-type node (make-node value) node? (next node-next set-node-next!) (value node-value)) "
+         "(define n (make-node 'v)) (list (node-next n) (node-value n))", "(#f v)"},
+        {"(define-record-type <a> (make-a) a? (f a-f)) (define-record-type <b> (make-b) b? (f b-f)) "
+         "(list (a? (make-b)) (b? (make-b)))", "(#f #t)"},
+        {"(define-record-type <point> (make-point x y) point? (x point-x) (y point-y)) (make-point 1 2)",
+         "#<record <point>>"},
+        {"(define-record-type <point> (make-point x y) point? (x point-x) (y point-y)) <point>",
+         "#<record-type <point>>"},
+        {"(define-record-type <box> (box v) box? (v unbox)) (define b (box 1)) (equal? b (box 1))", "#f"},
+        {"(define-record-type <box> (box v) box? (v unbox)) (map unbox (list (box 1) (box 2)))", "(1 2)"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    eval_string("(define-record-type <point> (make-point x y) point? (x point-x set-point-x!) (y point-y)) "
+                "(define-record-type <a> (make-a) a? (f a-f))");
+    REQUIRE_EXC("point-x: contract violation by argument #1\nexpected: point?\ngiven: #<record <a>>",
+                eval_string("(point-x (make-a))"));
+    REQUIRE_EXC("set-point-x!: contract violation by argument #1\nexpected: point?\ngiven: 1",
+                eval_string("(set-point-x! 1 2)"));
+    REQUIRE_EXC("make-point: arity mismatch", eval_string("(make-point 1)"));
+    REQUIRE_EXC("define-record-type: bad syntax", eval_string("(define-record-type <p> (make-p))"));
+    REQUIRE_EXC("define-record-type: not an identifier in: 1",
+                eval_string("(define-record-type <p> (make-p) p? (1 p-1))"));
+    REQUIRE_EXC("define-record-type: bad field spec in: (x)",
+                eval_string("(define-record-type <p> (make-p) p? (x))"));
+    REQUIRE_EXC("define-record-type: not a field of the record type in: z",
+                eval_string("(define-record-type <p> (make-p z) p? (x p-x))"));
+    REQUIRE_EXC("define-record-type: duplicate field in: x",
+                eval_string("(define-record-type <p> (make-p) p? (x p-x) (x p-x2))"));
+}
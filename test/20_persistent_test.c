@@ -0,0 +1,163 @@
+#include "test.h"
+
+TAU_MAIN()
+
+#define N 20000
+
+TEST(persistent, pmap) {
+    static scm_object *versions[N + 1];
+    char name[16];
+    TEST_INIT();
+
+    versions[0] = scm_eqv_pmap_new();
+    REQUIRE_EQ(versions[0]->type, scm_type_pmap);
+    for (int i = 0; i < N; ++i)
+        versions[i + 1] = scm_pmap_set(versions[i], INTEGER(i), INTEGER(i * 2));
+    REQUIRE_EQ(scm_pmap_count(versions[N]), N);
+
+    /* every version still has exactly its own keys */
+    for (int v = 0; v <= N; v += 997) {
+        REQUIRE_EQ(scm_pmap_count(versions[v]), v);
+        for (int i = 0; i < N; i += 7) {
+            scm_object *val = scm_pmap_ref(versions[v], INTEGER(i), NULL);
+            CHECK_EQ(val != NULL, i < v, "v=%d i=%d", v, i);
+            if (val)
+                CHECK_EQ(scm_integer_get_val(val), i * 2, "v=%d i=%d", v, i);
+        }
+    }
+
+    scm_object *m = scm_pmap_set(versions[N], INTEGER(5), SYM(five));
+    REQUIRE_EQ(scm_pmap_count(m), N);
+    REQUIRE_EQ(scm_integer_get_val(scm_pmap_ref(versions[N], INTEGER(5), NULL)), 10);
+
+    /* deleting the keys in another order, and one which isn't there */
+    scm_object *d = scm_pmap_delete(m, INTEGER(-1));
+    REQUIRE_EQ(scm_pmap_count(d), N);
+    for (int i = 0; i < N; ++i) {
+        scm_object *nd = scm_pmap_delete(d, INTEGER((i * 7919) % N));
+        scm_object_free(d);
+        d = nd;
+        REQUIRE_EQ(scm_pmap_count(d), N - i - 1);
+    }
+    REQUIRE_EQ(scm_pmap_to_alist(d), scm_null);
+    REQUIRE(same_id(scm_pmap_ref(m, INTEGER(5), NULL), SYM(five)), "m");
+    REQUIRE_EQ(scm_list_length(scm_pmap_to_alist(m)), N);
+
+    /* equal keys of other objects */
+    scm_object *e = scm_equal_pmap_new();
+    for (int i = 0; i < 100; ++i) {
+        snprintf(name, sizeof(name), "k%d", i);
+        e = scm_pmap_set(e, scm_string_copy_new(name, -1), INTEGER(i));
+    }
+    for (int i = 0; i < 100; ++i) {
+        snprintf(name, sizeof(name), "k%d", i);
+        scm_object *val = scm_pmap_ref(e, scm_string_copy_new(name, -1), NULL);
+        REQUIRE(val, "i=%d", i);
+        REQUIRE_EQ(scm_integer_get_val(val), i);
+    }
+
+    /* keys which differ only past the reach of the hash all collide */
+    scm_object *c = scm_equal_pmap_new(), *keys[50];
+    for (int i = 0; i < 50; ++i) {
+        keys[i] = scm_cons(INTEGER(i), scm_null);
+        for (int j = 0; j < 100; ++j)
+            keys[i] = scm_cons(INTEGER(j), keys[i]);
+        c = scm_pmap_set(c, keys[i], INTEGER(i));
+    }
+    REQUIRE_EQ(scm_equal_hash(keys[0]), scm_equal_hash(keys[1]));
+    REQUIRE_EQ(scm_pmap_count(c), 50);
+    for (int i = 0; i < 50; ++i)
+        REQUIRE_EQ(scm_integer_get_val(scm_pmap_ref(c, keys[i], NULL)), i);
+    for (int i = 0; i < 50; i += 2)
+        c = scm_pmap_delete(c, keys[i]);
+    REQUIRE_EQ(scm_pmap_count(c), 25);
+    for (int i = 0; i < 50; ++i)
+        REQUIRE_EQ(scm_pmap_ref(c, keys[i], NULL) != NULL, i % 2);
+
+    scm_object_free(d);
+    scm_object_free(m);
+    for (int v = N; v >= 0; --v)
+        scm_object_free(versions[v]);
+}
+
+TEST(persistent, pvector) {
+    static scm_object *versions[N + 1];
+    TEST_INIT();
+
+    versions[0] = scm_empty_pvector;
+    for (int i = 0; i < N; ++i)
+        versions[i + 1] = scm_pvector_push(versions[i], INTEGER(i));
+    REQUIRE_EQ(versions[N]->type, scm_type_pvector);
+    for (int v = 0; v <= N; v += 331) {
+        REQUIRE_EQ(scm_pvector_length(versions[v]), v);
+        for (int i = 0; i < v; ++i)
+            CHECK_EQ(scm_integer_get_val(scm_pvector_ref(versions[v], i)), i, "v=%d i=%d", v, i);
+    }
+
+    /* a set in the trie and one in the tail leave the old version alone */
+    scm_object *s = scm_pvector_set(versions[N], 1000, SYM(a));
+    scm_object *t = scm_pvector_set(s, N - 1, SYM(b));
+    REQUIRE(same_id(scm_pvector_ref(t, 1000), SYM(a)), "trie");
+    REQUIRE(same_id(scm_pvector_ref(t, N - 1), SYM(b)), "tail");
+    REQUIRE_EQ(scm_integer_get_val(scm_pvector_ref(versions[N], 1000)), 1000);
+    REQUIRE_EQ(scm_integer_get_val(scm_pvector_ref(s, N - 1)), N - 1);
+
+    /* popping down through the levels */
+    scm_object *p = t;
+    for (int len = N; len > 0; --len) {
+        if (len % 97 == 0 || len < 70) {
+            for (int i = 0; i < len; i += 13) {
+                if (i != 1000 && i != N - 1)
+                    CHECK_EQ(scm_integer_get_val(scm_pvector_ref(p, i)), i, "len=%d i=%d", len, i);
+            }
+        }
+        scm_object *np = scm_pvector_pop(p);
+        if (p != t && p != s)
+            scm_object_free(p);
+        p = np;
+        REQUIRE_EQ(scm_pvector_length(p), len - 1);
+    }
+    REQUIRE_EQ(p, scm_empty_pvector);
+
+    scm_object_free(t);
+    scm_object_free(s);
+    for (int v = N; v >= 0; --v)
+        scm_object_free(versions[v]);
+}
+
+TEST(persistent, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(pmap? (make-pmap))", "#t"}, {"(pmap? (make-hash-table))", "#f"},
+        {"(define m (pmap-set (make-pmap) 'a 1)) (define m2 (pmap-set m 'a 2)) (list (pmap-ref m 'a) (pmap-ref m2 'a))",
+         "(1 2)"},
+        {"(define m (pmap-set (make-equal-pmap) \"k\" 1)) (pmap-ref/default m (string #\\k) #f)", "1"},
+        {"(define m (pmap-set (make-eqv-pmap) \"k\" 1)) (pmap-ref/default m (string #\\k) #f)", "#f"},
+        {"(pmap-ref (make-pmap) 'a (lambda () 'none))", "none"},
+        {"(define m (alist->pmap '((a . 1) (b . 2) (a . 3)))) (list (pmap-size m) (pmap-ref m 'a))", "(2 1)"},
+        {"(define m (alist->pmap '((a . 1) (b . 2)))) (define d (pmap-delete m 'a)) "
+         "(list (pmap-contains? m 'a) (pmap-contains? d 'a) (pmap-size d))", "(#t #f 1)"},
+        {"(pmap->alist (pmap-set (make-pmap) 1 2))", "((1 . 2))"},
+        {"(pmap-fold (alist->pmap '((a . 1) (b . 2))) (lambda (k v acc) (+ v acc)) 0)", "3"},
+        {"(pvector? (pvector))", "#t"}, {"(pvector? (vector))", "#f"},
+        {"(pvector->list (pvector 1 2 3))", "(1 2 3)"}, {"(pvector-length (make-pvector 100 'x))", "100"},
+        {"(define v (pvector 1 2 3)) (define w (pvector-set v 0 'a)) (list (pvector->list v) (pvector->list w))",
+         "((1 2 3) (a 2 3))"},
+        {"(pvector->list (pvector-pop (pvector-push (pvector 1) 2)))", "(1)"},
+        {"(pvector->vector (list->pvector '(1 2)))", "#(1 2)"},
+        {"(pvector-ref (vector->pvector (make-vector 40 7)) 39)", "7"},
+        {"(list (pmap-set (make-pmap) 1 1) (pvector))", "(#<pmap> #<pvector>)"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("pmap-ref: no value found for key\nkey: a", eval_string("(pmap-ref (make-pmap) 'a)"));
+    REQUIRE_EXC("pmap-set: contract violation by argument #1\nexpected: pmap?",
+                eval_string("(pmap-set (make-hash-table) 1 2)"));
+    REQUIRE_EXC("pvector-ref: index is out of range\nindex: 3\nvalid range: [0, 2]",
+                eval_string("(pvector-ref (pvector 1 2 3) 3)"));
+    REQUIRE_EXC("pvector-set: index is out of range for empty pvector\nindex: 0",
+                eval_string("(pvector-set (pvector) 0 1)"));
+    REQUIRE_EXC("pvector-pop: empty pvector", eval_string("(pvector-pop (pvector))"));
+}
@@ -0,0 +1,141 @@
+#include "test.h"
+
+TAU_MAIN()
+
+#define N 5000
+
+/* pairs (key . position) with few distinct keys, in runs of every kind */
+static void fill(scm_object **elts, long n, int pattern) {
+    for (long i = 0; i < n; ++i) {
+        long key;
+        switch (pattern) {
+        case 0:  key = (i * 7919) % 97; break;
+        case 1:  key = i / 3; break;
+        case 2:  key = (n - i) / 3; break;
+        default: key = (i / 100) % 2 ? (n - i) % 50 : i % 50; break;
+        }
+        elts[i] = scm_cons(INTEGER(key), INTEGER(i));
+    }
+}
+
+TEST(sort, stable) {
+    static scm_object *elts[N];
+    TEST_INIT();
+
+    scm_object *by_car = eval_string("(lambda (a b) (< (car a) (car b)))");
+    for (int pattern = 0; pattern < 4; ++pattern) {
+        for (long n = 0; n <= N; n = n * 3 + 1) {
+            fill(elts, n, pattern);
+            scm_sort(elts, n, by_car);
+            for (long i = 1; i < n; ++i) {
+                long k1 = scm_integer_get_val(scm_car(elts[i - 1])), k2 = scm_integer_get_val(scm_car(elts[i]));
+                long p1 = scm_integer_get_val(scm_cdr(elts[i - 1])), p2 = scm_integer_get_val(scm_cdr(elts[i]));
+                REQUIRE(k1 < k2 || (k1 == k2 && p1 < p2), "pattern=%d n=%ld i=%ld", pattern, n, i);
+            }
+        }
+    }
+}
+
+TEST(sort, direct) {
+    static scm_object *elts[N];
+    TEST_INIT();
+
+    scm_object *lt = eval_string("<"), *gt = eval_string(">");
+    for (long i = 0; i < N; ++i)
+        elts[i] = INTEGER((i * 7919) % N - N / 2);
+    scm_sort(elts, N, lt);
+    for (long i = 0; i < N; ++i)
+        REQUIRE_EQ(scm_integer_get_val(elts[i]), i - N / 2);
+    scm_sort(elts, N, gt);
+    for (long i = 0; i < N; ++i)
+        REQUIRE_EQ(scm_integer_get_val(elts[i]), N / 2 - i - 1);
+
+    /* mixed numbers are compared by < itself */
+    for (long i = 0; i < N; ++i)
+        elts[i] = i % 2 ? FLOAT((i * 7919) % N + 0.5) : INTEGER((i * 7919) % N);
+    scm_sort(elts, N, lt);
+    for (long i = 1; i < N; ++i)
+        REQUIRE(scm_number_to_double(elts[i - 1]) <= scm_number_to_double(elts[i]), "i=%ld", i);
+}
+
+/* the same order as on one thread, equal elements included */
+TEST(sort, parallel) {
+    enum { n = 100003 };
+    static scm_object *elts[n], *expected[n];
+    char buf[16];
+    TEST_INIT();
+
+    const char *names[] = { "<", ">", "string<?", "string>?", "char<?" };
+    for (int k = 0; k < 5; ++k) {
+        scm_object *less = eval_string(names[k]);
+        for (long i = 0; i < n; ++i) {
+            long key = (i * 7919) % 1000;
+            if (k < 2)
+                elts[i] = i % 2 ? INTEGER(key) : INTEGER(key * 1000);
+            else if (k < 4) {
+                snprintf(buf, sizeof(buf), "s%ld", key);
+                /* some of them ropes */
+                elts[i] = i % 3 ? scm_string_copy_new(buf, -1)
+                                : scm_string_append(scm_string_copy_new(buf, 1), scm_string_copy_new(buf + 1, -1));
+            }
+            else
+                elts[i] = scm_char_new('a' + key % 26);
+            expected[i] = elts[i];
+        }
+        scm_sort_parallel(expected, n, less, 1);
+        for (int nthreads = 2; nthreads <= 8; nthreads *= 2) {
+            scm_object **copy = malloc(n * sizeof(scm_object *));
+            memcpy(copy, elts, n * sizeof(scm_object *));
+            scm_sort_parallel(copy, n, less, nthreads);
+            for (long i = 0; i < n; ++i)
+                REQUIRE_EQ(copy[i], expected[i], "%s nthreads=%d i=%ld", names[k], nthreads, i);
+            free(copy);
+        }
+    }
+
+    for (long i = 0; i < n; ++i)
+        elts[i] = FLOAT((i * 7919) % n / 8.0);
+    scm_sort_parallel(elts, n, eval_string("<"), 8);
+    for (long i = 0; i < n; ++i)
+        REQUIRE_EQ(scm_float_get_val(elts[i]), i / 8.0);
+}
+
+TEST(sort, primitives) {
+    TEST_INIT();
+
+    const char *cases[][2] = {
+        {"(list-sort < '())", "()"},
+        {"(list-sort < '(3 1 2))", "(1 2 3)"},
+        {"(sort '(3 1 2) >)", "(3 2 1)"},
+        {"(list-sort < '(2.5 -1.0 2.0))", "(-1.0 2.0 2.5)"},
+        {"(list-sort < '(2 1.5 1))", "(1 1.5 2)"},
+        {"(list-sort string<? '(\"b\" \"ab\" \"a\" \"λ\" \"\"))", "(\"\" \"a\" \"ab\" \"b\" \"λ\")"},
+        {"(list-sort string>? '(\"b\" \"ab\" \"a\"))", "(\"b\" \"ab\" \"a\")"},
+        {"(list-sort char<? '(#\\c #\\a #\\b))", "(#\\a #\\b #\\c)"},
+        {"(list-sort (lambda (a b) (< (car a) (car b))) '((1 . a) (0 . b) (1 . c) (0 . d)))",
+         "((0 . b) (0 . d) (1 . a) (1 . c))"},
+        {"(define l '(3 2 1)) (list-sort < l) l", "(3 2 1)"},
+        {"(vector-sort < #(5 3 9 1))", "#(1 3 5 9)"},
+        {"(vector-sort < #(5 3 9 1) 1 3)", "#(3 9)"},
+        {"(vector-sort < #(5 3 9 1) 2 2)", "#()"},
+        {"(define v (vector 5 3 9 1 0)) (vector-sort! v < 1 4) v", "#(5 1 3 9 0)"},
+        {"(define v (vector 5 3 9 1 0)) (vector-sort! v >) v", "#(9 5 3 1 0)"},
+        {"(define v (vector)) (vector-sort! v <) v", "#()"},
+        {"(list-merge < '(1 3 5) '(2 4 6 8))", "(1 2 3 4 5 6 8)"},
+        {"(list-merge (lambda (a b) (< (car a) (car b))) '((1 . a) (2 . a)) '((1 . b) (2 . b)))",
+         "((1 . a) (1 . b) (2 . a) (2 . b))"},
+        {"(list-merge < '() '(1))", "(1)"},
+        {"(vector-merge < #(1 4) #(2 3 5))", "#(1 2 3 4 5)"},
+        {"(vector-merge < #() #())", "#()"},
+    };
+
+    REQUIRE_EVAL_CASES(cases);
+
+    REQUIRE_EXC("list-sort: contract violation by argument #2\nexpected: list?",
+                eval_string("(list-sort < '(1 . 2))"));
+    REQUIRE_EXC("sort: contract violation by argument #2\nexpected: procedure?",
+                eval_string("(sort '(1 2) 1)"));
+    REQUIRE_EXC("<: contract violation", eval_string("(list-sort < '(1 a))"));
+    REQUIRE_EXC("vector-sort!: ending index is out of range\nending index: 5\nvalid range: [1, 2]",
+                eval_string("(vector-sort! (vector 1 2) < 1 5)"));
+}
@@ -7,11 +7,20 @@
 #include "../src/err.h"
 #include "../src/char.h"
 #include "../src/number.h"
+#include "../src/bignum.h"
+#include "../src/rational.h"
 #include "../src/string.h"
 #include "../src/symbol.h"
 #include "../src/token.h"
 #include "../src/pair.h"
 #include "../src/vector.h"
+#include "../src/hashtable.h"
+#include "../src/bytevector.h"
+#include "../src/numvector.h"
+#include "../src/record.h"
+#include "../src/pmap.h"
+#include "../src/pvector.h"
+#include "../src/sort.h"
 #include "../src/exp.h"
 #include "../src/read.h"
 #include "../src/write.h"
@@ -193,6 +202,20 @@
         REQUIRE(!res, "scm_pair_init"); \
         res = scm_vector_init(); \
         REQUIRE(!res, "scm_vector_init"); \
+        res = scm_hashtable_init(); \
+        REQUIRE(!res, "scm_hashtable_init"); \
+        res = scm_bytevector_init(); \
+        REQUIRE(!res, "scm_bytevector_init"); \
+        res = scm_numvector_init(); \
+        REQUIRE(!res, "scm_numvector_init"); \
+        res = scm_record_init(); \
+        REQUIRE(!res, "scm_record_init"); \
+        res = scm_pmap_init(); \
+        REQUIRE(!res, "scm_pmap_init"); \
+        res = scm_pvector_init(); \
+        REQUIRE(!res, "scm_pvector_init"); \
+        res = scm_sort_init(); \
+        REQUIRE(!res, "scm_sort_init"); \
         res = scm_exp_init(); \
         REQUIRE(!res, "scm_exp_init"); \
         res = scm_proc_init(); \
@@ -203,5 +226,29 @@
         REQUIRE(!res, "scm_eval_init"); \
     } while (0)
 
+/* the value of the last expression in @text */
+static inline scm_object *eval_string(const char *text) {
+    scm_object *port = string_input_port_new(text, -1);
+    scm_object *exp, *val = scm_void;
+    while ((exp = scm_read(port)) != scm_eof)
+        val = scm_eval(exp, scm_global_env());
+    scm_object_free(port);
+    return val;
+}
+
+/* @cases: a table of {expression, written value}, each expression is
+ * required to evaluate to what is written as the value */
+#define REQUIRE_EVAL_CASES(cases) \
+    do { \
+        for (size_t i_ = 0; i_ < sizeof(cases) / sizeof(cases[0]); ++i_) { \
+            scm_object *oport = string_output_port_open(); \
+            scm_object *obj = NULL; \
+            REQUIRE_NOEXC(obj = eval_string(cases[i_][0]), "%s", cases[i_][0]); \
+            scm_write(oport, obj); \
+            REQUIRE_STREQ(scm_output_port_string(oport, NULL), cases[i_][1], "%s", cases[i_][0]); \
+            scm_object_free(oport); \
+        } \
+    } while (0)
+
 #endif /* SCHEME_TEST_H */
 